@@ -0,0 +1,597 @@
+/*
+ *
+ * pnpBench.c - micro-benchmarks for the pick and place machine: the instruction handshake through
+ * shared memory, reading the centroid file, ordering and planning the parts, and the Display printing
+ * the simulator and controller output from the log ring. The results are written as JSON so that releases
+ * can be compared.
+ *
+ * Usage: Assgn2_2024_Benchmark [-h] [results file]
+ * The results file defaults to benchmark.json.
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include "pnpBench.h"
+
+extern PnP *pnp;    // the controller interface's shared memory, pointed at a private copy for the benchmark
+
+static double sample[IPC_ROUND_TRIPS];  // large enough for every benchmark's samples
+
+
+/*
+ Function: getElapsedMicroseconds
+ --------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: gets the time between two readings of CLOCK_MONOTONIC
+ Argument(s):
+ const struct timespec *start, *finish - the two readings
+ Return Value: the time from start to finish in microseconds
+ Usage: double us = getElapsedMicroseconds(&start, &finish);
+ */
+double getElapsedMicroseconds(const struct timespec *start, const struct timespec *finish)
+{
+    return (finish -> tv_sec - start -> tv_sec) * 1000000.0 + (finish -> tv_nsec - start -> tv_nsec) / 1000.0;
+}
+
+/*
+ Function: compareSamples
+ ------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: qsort compare function putting samples in ascending order
+ Argument(s):
+ const void *a, const void *b - pointers to the two samples to compare
+ Return Value: negative, zero or positive as sample a is less than, equal to or greater than sample b
+ Usage: qsort(samples, n, sizeof(double), compareSamples);
+ */
+static int compareSamples(const void *a, const void *b)
+{
+    double sa = *(const double*)a, sb = *(const double*)b;
+
+    return (sa > sb) - (sa < sb);
+}
+
+/*
+ Function: addResult
+ -------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ summarises a set of samples (mean, median, 99th percentile and maximum) and adds them to the report
+ Argument(s):
+ BenchmarkReport *report - the report
+ const char *name - the name of the result, which must stay the same between releases
+ const char *unit - the unit of the samples, e.g. "us" or "lines/s"
+ double samples[] - the samples, which are sorted
+ int number_of_samples - the number of samples
+ const char *parameter_name - what the result varies with, e.g. "parts", else ""
+ int parameter - the value of the parameter for this result
+ Return Value: none
+ Usage: addResult(&report, "plan_build", "us", sample, SORT_REPEATS, "parts", 100);
+ */
+void addResult(BenchmarkReport *report, const char *name, const char *unit, double samples[], int number_of_samples,
+               const char *parameter_name, int parameter)
+{
+    BenchmarkResult *result;
+    double total = 0.0;
+
+    if (report -> number_of_results >= MAX_RESULTS || number_of_samples <= 0) return;
+    result = &report -> result[report -> number_of_results++];
+
+    qsort(samples, number_of_samples, sizeof(double), compareSamples);
+    for (int i = 0; i < number_of_samples; i++) total += samples[i];
+
+    snprintf(result -> name, sizeof(result -> name), "%s", name);
+    snprintf(result -> unit, sizeof(result -> unit), "%s", unit);
+    snprintf(result -> parameter_name, sizeof(result -> parameter_name), "%s", parameter_name);
+    result -> parameter = parameter;
+    result -> samples = number_of_samples;
+    result -> mean = total / number_of_samples;
+    result -> p50 = samples[number_of_samples / 2];
+    result -> p99 = samples[(number_of_samples * 99) / 100 < number_of_samples ? (number_of_samples * 99) / 100 : number_of_samples - 1];
+    result -> max = samples[number_of_samples - 1];
+
+    printf("  %-32s %-8s %6d %12.3f %-8s (median %.3f, 99%% %.3f)\n", name, parameter_name, parameter, result -> mean, unit,
+           result -> p50, result -> p99);
+}
+
+/*
+ Function: runResponder
+ ----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ stands in for the simulator at the other end of shared memory, taking each instruction from the slot and
+ reporting it finished straight away, so that only the handshake is timed and not the simulator's poll loop.
+ A RUN_PROGRAM instruction has every step of the program up to PROGRAM_END counted as carried out.
+ Runs until the quit flag is set.
+ Argument(s):
+ volatile PnP *shared - the shared memory
+ Return Value: none
+ Usage: runResponder(pnp);
+ */
+static void runResponder(volatile PnP *shared)
+{
+    while (shared -> quit == FALSE)
+    {
+        int instruction = shared -> instruction_to_execute;
+
+        if (instruction == NO_INSTRUCTION)
+        {
+            sched_yield();
+            continue;
+        }
+        shared -> ready_for_next_instruction = FALSE;
+        shared -> instruction_to_execute = NO_INSTRUCTION;
+        if (instruction == RUN_PROGRAM)
+        {
+            int steps = 0;
+
+            shared -> program.status = PROGRAM_RUNNING;
+            while (steps < shared -> program.length && shared -> program.step[steps].opcode != PROGRAM_END) steps++;
+            shared -> program.steps_executed = steps;
+            shared -> program.status = PROGRAM_FINISHED;
+        }
+        shared -> ready_for_next_instruction = TRUE;
+    }
+}
+
+/*
+ Function: waitForInstructionTaken
+ ---------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ waits, as the controller would, until the last instruction has been taken from the slot and carried out
+ Argument(s): none
+ Return Value: none
+ Usage: waitForInstructionTaken();
+ */
+static void waitForInstructionTaken()
+{
+    while (pnp -> instruction_to_execute != NO_INSTRUCTION || isSimulatorReadyForNextInstruction() == FALSE) sched_yield();
+}
+
+/*
+ Function: benchmarkInstructionRoundTrip
+ ---------------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ times instructions passed to a stand-in simulator through the controller interface, one at a time through
+ the single instruction slot, and queued as a micro-program which is uploaded and run with one handshake
+ Argument(s):
+ BenchmarkReport *report - the report the results are added to
+ Return Value: none
+ Usage: benchmarkInstructionRoundTrip(&report);
+ */
+void benchmarkInstructionRoundTrip(BenchmarkReport *report)
+{
+    const int program_instructions = MAX_PROGRAM_LENGTH - 1;  // the last step is PROGRAM_END
+    struct timespec start, finish;
+    pid_t responder_pid;
+
+    pnp = (PnP *)mmap(0, sizeof(PnP), (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_ANONYMOUS), -1, (off_t)0);
+    if (pnp == MAP_FAILED)
+    {
+        perror("memory mapping for the instruction benchmark failed");
+        return;
+    }
+    memset(pnp, 0, sizeof(PnP));
+    pnp -> ready_for_next_instruction = TRUE;
+
+    responder_pid = fork();
+    if (responder_pid < 0)
+    {
+        perror("fork of the stand-in simulator failed");
+        munmap(pnp, sizeof(PnP));
+        return;
+    }
+    if (responder_pid == 0)
+    {
+        runResponder(pnp);
+        _exit(0);
+    }
+
+    for (int i = 0; i < IPC_WARM_UP; i++)
+    {
+        lowerNozzle(0);
+        waitForInstructionTaken();
+    }
+    for (int i = 0; i < IPC_ROUND_TRIPS; i++)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (i % 2 == 0) lowerNozzle(0);
+        else raiseNozzle(0);
+        waitForInstructionTaken();
+        clock_gettime(CLOCK_MONOTONIC, &finish);
+        sample[i] = getElapsedMicroseconds(&start, &finish);
+    }
+    addResult(report, "ipc_single_slot_round_trip", "us", sample, IPC_ROUND_TRIPS, "", 0);
+
+    for (int i = 0; i < IPC_PROGRAM_RUNS; i++)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        clearProgram();
+        for (int step = 0; step < program_instructions; step++)
+        {
+            addProgramStep(step % 2 == 0 ? LOWER_NOZZLE : RAISE_NOZZLE, 0.0, 0.0, 0, 0);
+        }
+        addProgramStep(PROGRAM_END, 0.0, 0.0, 0, 0);
+        runProgram();
+        waitForInstructionTaken();
+        clock_gettime(CLOCK_MONOTONIC, &finish);
+        if (getProgramStatus() != PROGRAM_FINISHED || pnp -> program.steps_executed != program_instructions)
+        {
+            printf("  stand-in simulator did not run the whole program\n");
+        }
+        sample[i] = getElapsedMicroseconds(&start, &finish);
+    }
+    addResult(report, "ipc_program_run", "us", sample, IPC_PROGRAM_RUNS, "instructions", program_instructions);
+    for (int i = 0; i < IPC_PROGRAM_RUNS; i++) sample[i] /= program_instructions;
+    addResult(report, "ipc_program_per_instruction", "us", sample, IPC_PROGRAM_RUNS, "instructions", program_instructions);
+
+    pnp -> quit = TRUE;
+    waitpid(responder_pid, NULL, 0);
+    munmap(pnp, sizeof(PnP));
+    pnp = NULL;
+}
+
+/*
+ Function: makeBoard
+ -------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ makes up the placements of a board, spread over the default machine's feeders and a 300 x 200 board,
+ from a fixed seed so that every run benchmarks the same boards
+ Argument(s):
+ PlacementInfo pi[] - receives the placements
+ int number_of_components - the number of placements to make
+ unsigned int *seed - the random number seed, updated
+ Return Value: none
+ Usage: makeBoard(pi, 100, &seed);
+ */
+static void makeBoard(PlacementInfo pi[], int number_of_components, unsigned int *seed)
+{
+    for (int i = 0; i < number_of_components; i++)
+    {
+        snprintf(pi[i].component_designation, sizeof(pi[i].component_designation), "R%d", (i + 1) % 100000);
+        snprintf(pi[i].component_footprint, sizeof(pi[i].component_footprint), "0603");
+        pi[i].component_value = (rand_r(seed) % 1000) / 10.0;
+        pi[i].x_target = (rand_r(seed) % 30000) / 100.0;
+        pi[i].y_target = (rand_r(seed) % 20000) / 100.0;
+        pi[i].theta_target = 90.0 * (rand_r(seed) % 4);
+        pi[i].feeder = rand_r(seed) % DEFAULT_NUMBER_OF_FEEDERS;
+        pi[i].package = NO_PACKAGE;
+    }
+}
+
+/*
+ Function: benchmarkCentroidFileParsing
+ --------------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ times getCentroidFileContents reading 1k, 10k and 100k placement lines. A centroid file holds at most
+ MAX_NUMBER_OF_COMPONENTS_TO_PLACE placements, so each line count is made up of a full file read repeatedly.
+ Argument(s):
+ BenchmarkReport *report - the report the results are added to
+ Return Value: none
+ Usage: benchmarkCentroidFileParsing(&report);
+ */
+void benchmarkCentroidFileParsing(BenchmarkReport *report)
+{
+    const int line_count[3] = {PARSE_LINES_SMALL, PARSE_LINES_MEDIUM, PARSE_LINES_LARGE};
+    const int repeats = 5;
+    PlacementInfo pi[MAX_NUMBER_OF_COMPONENTS_TO_PLACE];
+    char filename[] = "/tmp/pnp_bench_centroid_XXXXXX";
+    unsigned int seed = BENCHMARK_SEED;
+    struct timespec start, finish;
+    int operation_mode, number_of_components_to_place;
+    FILE *fp;
+
+    int fd = mkstemp(filename);
+    if (fd < 0 || (fp = fdopen(fd, "w")) == NULL)
+    {
+        perror("creation of the benchmark centroid file failed");
+        return;
+    }
+    makeBoard(pi, MAX_NUMBER_OF_COMPONENTS_TO_PLACE, &seed);
+    fprintf(fp, "A\n%d\n", MAX_NUMBER_OF_COMPONENTS_TO_PLACE);
+    for (int i = 0; i < MAX_NUMBER_OF_COMPONENTS_TO_PLACE; i++)
+    {
+        fprintf(fp, "%s\t%s\t%.1f\t%.2f\t%.2f\t%.0f\t%d\n", pi[i].component_designation, pi[i].component_footprint,
+                pi[i].component_value, pi[i].x_target, pi[i].y_target, pi[i].theta_target, pi[i].feeder);
+    }
+    fclose(fp);
+    setenv(CENTROID_FILE_ENV, filename, 1);
+
+    for (int c = 0; c < 3; c++)
+    {
+        for (int r = 0; r < repeats; r++)
+        {
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int lines = 0; lines < line_count[c]; lines += MAX_NUMBER_OF_COMPONENTS_TO_PLACE)
+            {
+                if (getCentroidFileContents(&operation_mode, &number_of_components_to_place, pi) != CENTROID_FILE_PRESENT_AND_READ)
+                {
+                    printf("  benchmark centroid file could not be read\n");
+                    unlink(filename);
+                    return;
+                }
+            }
+            clock_gettime(CLOCK_MONOTONIC, &finish);
+            sample[r] = line_count[c] / (getElapsedMicroseconds(&start, &finish) / 1000000.0);
+        }
+        addResult(report, "centroid_file_parse", "lines/s", sample, repeats, "lines", line_count[c]);
+    }
+
+    unsetenv(CENTROID_FILE_ENV);
+    unlink(filename);
+}
+
+/*
+ Function: benchmarkPickOrderAndPlanning
+ ---------------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ times putting a board's parts in pick order as the autonomous control mode does, and building the whole
+ board plan of the planned control mode, for boards of increasing part count on the default machine
+ Argument(s):
+ BenchmarkReport *report - the report the results are added to
+ Return Value: none
+ Usage: benchmarkPickOrderAndPlanning(&report);
+ */
+void benchmarkPickOrderAndPlanning(BenchmarkReport *report)
+{
+    const int part_count[4] = {10, 25, 50, MAX_NUMBER_OF_COMPONENTS_TO_PLACE};
+    static Plan plan;  //too large for the stack
+    PlacementInfo pi[MAX_NUMBER_OF_COMPONENTS_TO_PLACE];
+    int component_list[MAX_NUMBER_OF_COMPONENTS_TO_PLACE];
+    MachineConfig machine;
+    ComponentLibrary library;
+    unsigned int seed = BENCHMARK_SEED;
+    struct timespec start, finish;
+
+    setDefaultMachineConfig(&machine);
+    setDefaultComponentLibrary(&library);
+
+    for (int c = 0; c < 4; c++)
+    {
+        makeBoard(pi, part_count[c], &seed);
+
+        for (int r = 0; r < SORT_REPEATS; r++)
+        {
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            sortPickList(pi, part_count[c], component_list);
+            clock_gettime(CLOCK_MONOTONIC, &finish);
+            sample[r] = getElapsedMicroseconds(&start, &finish);
+        }
+        addResult(report, "autonomous_sort", "us", sample, SORT_REPEATS, "parts", part_count[c]);
+
+        for (int r = 0; r < SORT_REPEATS; r++)
+        {
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            buildPlan(pi, part_count[c], &machine, &library, PLAN_ORDER_BY_FEEDER, &plan);
+            clock_gettime(CLOCK_MONOTONIC, &finish);
+            sample[r] = getElapsedMicroseconds(&start, &finish);
+        }
+        addResult(report, "plan_build", "us", sample, SORT_REPEATS, "parts", part_count[c]);
+    }
+}
+
+/*
+ Function: writeDisplayLines
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.2
+ Purpose:
+ writes timestamped lines to the log ring as the simulator or controller would. Unlike them, it waits for
+ room in the ring rather than dropping lines, so that the Display is kept busy for the whole benchmark.
+ Argument(s):
+ LogRing *ring - the log ring the Display reads
+ int source - LOG_SOURCE_SIMULATOR or LOG_SOURCE_CONTROLLER
+ Return Value: none
+ Usage: writeDisplayLines(ring, LOG_SOURCE_SIMULATOR);
+ */
+static void writeDisplayLines(LogRing *ring, int source)
+{
+    char line[DISPLAY_LINE_LENGTH + 1];
+
+    for (int i = 0; i < DISPLAY_LINES_PER_WRITER; i++)
+    {
+        if (snprintf(line, sizeof(line), "Time: %7.2f  %s benchmark line %d\n", i / 100.0,
+                     source == LOG_SOURCE_SIMULATOR ? "Simulator" : "Controller", i) >= (int) sizeof(line))
+        {
+            line[sizeof(line) - 2] = '\n';  // a line cut short still ends where the Display expects
+        }
+        while (getLogBacklog(ring) >= LOG_RING_SIZE) sched_yield();
+        writeLogMessage(ring, source, line);
+    }
+}
+
+/*
+ Function: benchmarkDisplayLog
+ -----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.2
+ Purpose:
+ times the Display executable printing the simulator and controller output from the log ring, with both
+ written as fast as the ring allows and the Display's own output discarded. Lines that two writers racing
+ for the last free slot still manage to drop are not counted.
+ Argument(s):
+ BenchmarkReport *report - the report the results are added to
+ Return Value: none
+ Usage: benchmarkDisplayLog(&report);
+ */
+void benchmarkDisplayLog(BenchmarkReport *report)
+{
+    const int repeats = 3;
+    const int lines = 2 * DISPLAY_LINES_PER_WRITER;
+    char display_path[PATH_MAX];
+    struct timespec start, finish;
+    int completed = 0;
+
+    getExecutablePath("Assgn2_2024_Display", "../Assgn2_2024_Display/bin/Release/Assgn2_2024_Display", display_path);
+    if (access(display_path, X_OK) != 0)
+    {
+        printf("  Display executable not found, set %s to the directory holding it\n", BIN_DIR_ENV);
+        return;
+    }
+
+    for (int r = 0; r < repeats; r++)
+    {
+        pid_t pid[3];
+        int status = 0;
+        unsigned long dropped = 0;
+        LogRing *ring = createLogRing();
+
+        if (ring == NULL)
+        {
+            perror("log ring creation for the display benchmark failed");
+            return;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        pid[0] = fork();
+        if (pid[0] == 0)
+        {
+            int null_fd = open("/dev/null", O_WRONLY);
+
+            dup2(null_fd, STDOUT_FILENO);
+            execl(display_path, "Assgn2_2024_Display", (char *) NULL);
+            _exit(127);
+        }
+        for (int p = 1; p < 3; p++)
+        {
+            pid[p] = fork();
+            if (pid[p] == 0)
+            {
+                writeDisplayLines(ring, p == 1 ? LOG_SOURCE_SIMULATOR : LOG_SOURCE_CONTROLLER);
+                _exit(0);
+            }
+        }
+        for (int p = 1; p < 3; p++) waitpid(pid[p], NULL, 0);
+        finishLogRing(ring);
+
+        /* wait for the Display to finish, killing it if it is stuck */
+        while (waitpid(pid[0], &status, WNOHANG) == 0)
+        {
+            clock_gettime(CLOCK_MONOTONIC, &finish);
+            if (finish.tv_sec - start.tv_sec > DISPLAY_TIMEOUT)
+            {
+                printf("  Display did not finish within %d s\n", DISPLAY_TIMEOUT);
+                kill(pid[0], SIGKILL);
+                waitpid(pid[0], &status, 0);
+                status = -1;
+                break;
+            }
+            sleepMilliseconds(1);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &finish);
+        for (int source = 0; source < NUMBER_OF_LOG_SOURCES; source++) dropped += ring -> dropped[source];
+        closeLogRing(ring);
+        sem_unlink(LOG_DOORBELL);
+        unsetenv(LOG_RING_FD_ENV);
+        if (status == -1) return;
+        sample[completed++] = (lines - dropped) / (getElapsedMicroseconds(&start, &finish) / 1000000.0);
+    }
+    addResult(report, "display_log", "lines/s", sample, completed, "lines", lines);
+}
+
+/*
+ Function: writeReport
+ ---------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ writes the results as JSON, with when and where they were measured
+ Argument(s):
+ const BenchmarkReport *report - the results
+ const char *filename - the file to write
+ Return Value: 0 if the file was written, else -1
+ Usage: writeReport(&report, "benchmark.json");
+ */
+int writeReport(const BenchmarkReport *report, const char *filename)
+{
+    FILE *fp = fopen(filename, "w");
+    struct utsname host;
+    char date[32];
+    time_t now = time(NULL);
+
+    if (fp == NULL) return -1;
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    if (uname(&host) != 0) strcpy(host.machine, "unknown");
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"format_version\": %d,\n", BENCHMARK_FORMAT_VERSION);
+    fprintf(fp, "  \"date\": \"%s\",\n", date);
+    fprintf(fp, "  \"system\": \"%s %s %s\",\n", host.sysname, host.release, host.machine);
+#ifdef __VERSION__
+    fprintf(fp, "  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+    fprintf(fp, "  \"results\": [\n");
+    for (int i = 0; i < report -> number_of_results; i++)
+    {
+        const BenchmarkResult *result = &report -> result[i];
+
+        fprintf(fp, "    {\"name\": \"%s\", \"unit\": \"%s\", ", result -> name, result -> unit);
+        if (result -> parameter_name[0] != '\0') fprintf(fp, "\"%s\": %d, ", result -> parameter_name, result -> parameter);
+        fprintf(fp, "\"samples\": %d, \"mean\": %.6g, \"p50\": %.6g, \"p99\": %.6g, \"max\": %.6g}%s\n",
+                result -> samples, result -> mean, result -> p50, result -> p99, result -> max,
+                i < report -> number_of_results - 1 ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+
+    fclose(fp);
+    return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+    static BenchmarkReport report;
+    const char *filename = argc > 1 ? argv[1] : RESULTS_FILE;
+
+    if (argc > 2 || (argc == 2 && argv[1][0] == '-'))
+    {  //an option is not a file name, -h and --help ask for the usage
+        int help = argc == 2 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0);
+
+        fprintf(help ? stdout : stderr, "Usage: %s [-h] [results file]\n       the results file defaults to %s\n", argv[0], RESULTS_FILE);
+        exit(help ? 0 : 1);
+    }
+
+    printf("Instruction round trip through shared memory\n");
+    benchmarkInstructionRoundTrip(&report);
+    printf("Centroid file reading\n");
+    benchmarkCentroidFileParsing(&report);
+    printf("Pick order and planning\n");
+    benchmarkPickOrderAndPlanning(&report);
+    printf("Display log ring\n");
+    benchmarkDisplayLog(&report);
+
+    if (writeReport(&report, filename) != 0)
+    {
+        perror("writing the results failed");
+        exit(1);
+    }
+    printf("Results written to %s\n", filename);
+    return 0;
+}
@@ -0,0 +1,72 @@
+/*
+ *
+ * pnpBench.h - declarations for the pick and place micro-benchmarks
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include <sys/wait.h>
+#include <sys/utsname.h>
+#include <signal.h>
+#include <sched.h>
+#include <limits.h>
+#include <errno.h>
+#include "../Assgn2_2024_Controller/pnpControl.h"
+
+#define BENCHMARK_FORMAT_VERSION 2    // bump when a result is renamed or its meaning changes
+
+#define RESULTS_FILE "benchmark.json"
+
+#define IPC_ROUND_TRIPS 20000
+#define IPC_PROGRAM_RUNS 2000
+#define IPC_WARM_UP 1000
+
+#define PARSE_LINES_SMALL 1000
+#define PARSE_LINES_MEDIUM 10000
+#define PARSE_LINES_LARGE 100000
+
+#define SORT_REPEATS 2000             // sorts and plans timed for each part count
+#define BENCHMARK_SEED 12345          // fixed so every release sorts and plans the same boards
+
+#define DISPLAY_LINES_PER_WRITER 50000
+#define DISPLAY_LINE_LENGTH 50        // the longest line written, about as long as the simulator's messages
+#define DISPLAY_TIMEOUT 60            // seconds before a stuck Display is killed
+
+#define MAX_RESULTS 32
+
+typedef struct
+{
+    char name[48];
+    char unit[16];
+    int samples;
+    double mean;
+    double p50;
+    double p99;
+    double max;
+    int parameter;           // the part count, line count, ... the result is for, else 0
+    char parameter_name[24];
+
+} BenchmarkResult;
+
+typedef struct
+{
+    int number_of_results;
+    BenchmarkResult result[MAX_RESULTS];
+
+} BenchmarkReport;
+
+double getElapsedMicroseconds(const struct timespec*, const struct timespec*);
+
+void addResult(BenchmarkReport*, const char*, const char*, double[], int, const char*, int);
+
+void benchmarkInstructionRoundTrip(BenchmarkReport*);
+
+void benchmarkCentroidFileParsing(BenchmarkReport*);
+
+void benchmarkPickOrderAndPlanning(BenchmarkReport*);
+
+void benchmarkDisplayLog(BenchmarkReport*);
+
+int writeReport(const BenchmarkReport*, const char*);
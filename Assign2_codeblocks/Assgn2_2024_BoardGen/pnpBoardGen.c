@@ -0,0 +1,237 @@
+/*
+ *
+ * pnpBoardGen.c - generates synthetic centroid files for the controller, with the number of parts, how
+ * they are spread over the feeders, the board extents and the spread of rotations given on the command line.
+ * The same options and seed always give the same board.
+ *
+ * Usage: Assgn2_2024_BoardGen [-n parts] [-m A|P] [-f feeders] [-d uniform|skewed|round-robin]
+ *                             [-x min_x,max_x] [-y min_y,max_y] [-r degrees] [-q] [-s seed] [-o file]
+ * The board is checked against the machine config file the simulator would use, and written to stdout
+ * unless -o is given.
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include "pnpBoardGen.h"
+
+const char part_type_footprint[NUMBER_OF_PART_TYPES][10] = {"0402", "0603", "0805", "SOT23", "SOIC8", "QFN32"};
+const char part_type_prefix[NUMBER_OF_PART_TYPES][3] = {"C", "R", "C", "Q", "U", "U"};
+
+
+/*
+ Function: checkBoardSpec
+ ------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ checks that a board can be placed on the machine: every placement must be within the machine limits and
+ at or above (0, 0), where the simulator accepts placements, and every feeder used must be fitted
+ Argument(s):
+ const BoardSpec *spec - the board to check
+ const MachineConfig *machine - the machine description
+ Return Value: TRUE if the board can be generated, else FALSE with the reason printed to stderr
+ Usage: if (checkBoardSpec(&spec, &machine) == FALSE) exit(2);
+ */
+int checkBoardSpec(const BoardSpec *spec, const MachineConfig *machine)
+{
+    if (spec -> number_of_parts < 1 || spec -> number_of_parts > MAX_NUMBER_OF_COMPONENTS_TO_PLACE)
+    {
+        fprintf(stderr, "Number of parts must be from 1 to %d\n", MAX_NUMBER_OF_COMPONENTS_TO_PLACE);
+        return FALSE;
+    }
+    if (spec -> number_of_feeders < 1 || spec -> number_of_feeders > machine -> number_of_feeders)
+    {
+        fprintf(stderr, "Number of feeders must be from 1 to %d, the feeders fitted to the machine\n", machine -> number_of_feeders);
+        return FALSE;
+    }
+    if (spec -> min_x > spec -> max_x || spec -> min_y > spec -> max_y
+        || spec -> min_x < 0.0 || spec -> min_y < 0.0 || spec -> min_x < machine -> min_x || spec -> min_y < machine -> min_y
+        || spec -> max_x > machine -> max_x || spec -> max_y > machine -> max_y)
+    {
+        fprintf(stderr, "Board extents must be within (%.2f, %.2f) to (%.2f, %.2f)\n",
+                fmax(0.0, machine -> min_x), fmax(0.0, machine -> min_y), machine -> max_x, machine -> max_y);
+        return FALSE;
+    }
+    if (spec -> rotation_spread < 0.0 || spec -> rotation_spread > 180.0)
+    {
+        fprintf(stderr, "Rotation spread must be from 0 to 180 degrees\n");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ Function: chooseFeeder
+ ----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: chooses the feeder a part comes from, following the board's feeder distribution
+ Argument(s):
+ const BoardSpec *spec - the board being generated
+ int part - the number of the part
+ unsigned int *seed - the random number seed, updated
+ Return Value: the feeder
+ Usage: pi[i].feeder = chooseFeeder(spec, i, &seed);
+ */
+static int chooseFeeder(const BoardSpec *spec, int part, unsigned int *seed)
+{
+    double total = 0.0, choice;
+
+    switch (spec -> feeder_distribution)
+    {
+        case FEEDER_DISTRIBUTION_ROUND_ROBIN:
+            return part % spec -> number_of_feeders;
+
+        case FEEDER_DISTRIBUTION_SKEWED:
+            for (int k = 0; k < spec -> number_of_feeders; k++) total += 1.0 / (k + 1);
+            choice = total * rand_r(seed) / ((double) RAND_MAX + 1.0);
+            for (int k = 0; k < spec -> number_of_feeders; k++)
+            {
+                choice -= 1.0 / (k + 1);
+                if (choice < 0.0) return k;
+            }
+            return spec -> number_of_feeders - 1;
+
+        default:
+            return rand_r(seed) % spec -> number_of_feeders;
+    }
+}
+
+/*
+ Function: generateBoard
+ -----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ makes up the placements of a board. Each feeder holds one type of part (capacitors, resistors,
+ transistors or ICs), which gives the footprint of the parts taken from it and the letter of their designation.
+ Argument(s):
+ const BoardSpec *spec - the board to generate, already checked by checkBoardSpec
+ PlacementInfo pi[] - receives the placements
+ Return Value: none
+ Usage: generateBoard(&spec, pi);
+ */
+void generateBoard(const BoardSpec *spec, PlacementInfo pi[])
+{
+    unsigned int seed = spec -> seed;
+
+    for (int i = 0; i < spec -> number_of_parts; i++)
+    {
+        int feeder = chooseFeeder(spec, i, &seed);
+        int type = feeder % NUMBER_OF_PART_TYPES;
+        double theta = spec -> rotation_spread * (2.0 * rand_r(&seed) / RAND_MAX - 1.0);
+
+        snprintf(pi[i].component_designation, sizeof(pi[i].component_designation), "%s%d", part_type_prefix[type], (i + 1) % 10000);
+        snprintf(pi[i].component_footprint, sizeof(pi[i].component_footprint), "%s", part_type_footprint[type]);
+        pi[i].component_value = round(1000.0 * rand_r(&seed) / RAND_MAX) / 10.0;
+        pi[i].x_target = round(100.0 * (spec -> min_x + (spec -> max_x - spec -> min_x) * rand_r(&seed) / RAND_MAX)) / 100.0;
+        pi[i].y_target = round(100.0 * (spec -> min_y + (spec -> max_y - spec -> min_y) * rand_r(&seed) / RAND_MAX)) / 100.0;
+        pi[i].theta_target = spec -> quarter_turns == TRUE ? 90.0 * round(theta / 90.0) : round(10.0 * theta) / 10.0;
+        pi[i].feeder = feeder;
+    }
+}
+
+/*
+ Function: writeCentroidFile
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: writes a board in the centroid file format read by getCentroidFileContents
+ Argument(s):
+ FILE *fp - the file to write to
+ const BoardSpec *spec - the board, for the operation mode and number of parts
+ const PlacementInfo pi[] - the placements
+ Return Value: 0 if the file was written, else -1
+ Usage: writeCentroidFile(stdout, &spec, pi);
+ */
+int writeCentroidFile(FILE *fp, const BoardSpec *spec, const PlacementInfo pi[])
+{
+    fprintf(fp, "%c\n%d\n", spec -> operation_mode, spec -> number_of_parts);
+    for (int i = 0; i < spec -> number_of_parts; i++)
+    {
+        fprintf(fp, "%s\t%s\t%.1f\t%.2f\t%.2f\t%.1f\t%d\n", pi[i].component_designation, pi[i].component_footprint,
+                pi[i].component_value, pi[i].x_target, pi[i].y_target, pi[i].theta_target, pi[i].feeder);
+    }
+    return ferror(fp) ? -1 : 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+    PlacementInfo pi[MAX_NUMBER_OF_COMPONENTS_TO_PLACE];
+    MachineConfig machine;
+    BoardSpec spec;
+    const char *filename = NULL;
+    FILE *fp = stdout;
+    int option, machine_config_res;
+
+    machine_config_res = getMachineConfigFileContents(getMachineConfigFileName(), &machine);
+    if (machine_config_res != MACHINE_CONFIG_FILE_PRESENT_AND_READ && machine_config_res != MACHINE_CONFIG_FILE_NOT_PRESENT)
+    {
+        fprintf(stderr, "Problem with machine config file %s, error code %d\n", getMachineConfigFileName(), machine_config_res);
+        exit(3);
+    }
+
+    spec.number_of_parts = DEFAULT_BOARD_PARTS;
+    spec.operation_mode = 'A';
+    spec.number_of_feeders = machine.number_of_feeders;
+    spec.feeder_distribution = FEEDER_DISTRIBUTION_UNIFORM;
+    spec.min_x = fmax(0.0, machine.min_x);
+    spec.min_y = fmax(0.0, machine.min_y);
+    spec.max_x = fmin(spec.min_x + DEFAULT_BOARD_WIDTH, machine.max_x);
+    spec.max_y = fmin(spec.min_y + DEFAULT_BOARD_HEIGHT, machine.max_y);
+    spec.rotation_spread = DEFAULT_ROTATION_SPREAD;
+    spec.quarter_turns = FALSE;
+    spec.seed = DEFAULT_BOARD_SEED;
+
+    while ((option = getopt(argc, argv, "n:m:f:d:x:y:r:qs:o:")) != -1)
+    {
+        int res = 1;
+
+        switch (option)
+        {
+            case 'n': res = sscanf(optarg, "%d", &spec.number_of_parts); break;
+            case 'm': spec.operation_mode = optarg[0] == 'p' || optarg[0] == 'P' ? 'P' : 'A'; break;
+            case 'f': res = sscanf(optarg, "%d", &spec.number_of_feeders); break;
+            case 'd':
+                if (strcmp(optarg, "uniform") == 0) spec.feeder_distribution = FEEDER_DISTRIBUTION_UNIFORM;
+                else if (strcmp(optarg, "skewed") == 0) spec.feeder_distribution = FEEDER_DISTRIBUTION_SKEWED;
+                else if (strcmp(optarg, "round-robin") == 0) spec.feeder_distribution = FEEDER_DISTRIBUTION_ROUND_ROBIN;
+                else res = 0;
+                break;
+            case 'x': res = sscanf(optarg, "%lf,%lf", &spec.min_x, &spec.max_x) == 2; break;
+            case 'y': res = sscanf(optarg, "%lf,%lf", &spec.min_y, &spec.max_y) == 2; break;
+            case 'r': res = sscanf(optarg, "%lf", &spec.rotation_spread); break;
+            case 'q': spec.quarter_turns = TRUE; break;
+            case 's': res = sscanf(optarg, "%u", &spec.seed); break;
+            case 'o': filename = optarg; break;
+            default: res = 0; break;
+        }
+        if (res != 1)
+        {
+            fprintf(stderr, "Usage: %s [-n parts] [-m A|P] [-f feeders] [-d uniform|skewed|round-robin]\n"
+                            "       [-x min_x,max_x] [-y min_y,max_y] [-r degrees] [-q] [-s seed] [-o file]\n", argv[0]);
+            exit(1);
+        }
+    }
+    if (checkBoardSpec(&spec, &machine) == FALSE) exit(2);
+
+    generateBoard(&spec, pi);
+    if (filename != NULL && (fp = fopen(filename, "w")) == NULL)
+    {
+        perror("creation of the centroid file failed");
+        exit(4);
+    }
+    if (writeCentroidFile(fp, &spec, pi) != 0 || (fp != stdout && fclose(fp) != 0))
+    {
+        perror("writing the centroid file failed");
+        exit(4);
+    }
+    return 0;
+}
@@ -0,0 +1,43 @@
+/*
+ *
+ * pnpBoardGen.h - declarations for the synthetic board (centroid file) generator
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include <unistd.h>
+#include "../Assgn2_2024_Controller/pnpControl.h"
+
+#define FEEDER_DISTRIBUTION_UNIFORM 0     // every part is equally likely to come from any feeder used
+#define FEEDER_DISTRIBUTION_SKEWED 1      // feeder k supplies parts in proportion to 1/(k+1), like a board of mostly passives
+#define FEEDER_DISTRIBUTION_ROUND_ROBIN 2 // the feeders used take turns
+
+#define DEFAULT_BOARD_PARTS 50
+#define DEFAULT_BOARD_WIDTH 300.0         // default extents, from (0, 0), clipped to the machine limits
+#define DEFAULT_BOARD_HEIGHT 200.0
+#define DEFAULT_ROTATION_SPREAD 180.0     // rotations are spread evenly over +/- this many degrees
+#define DEFAULT_BOARD_SEED 1
+
+#define NUMBER_OF_PART_TYPES 6
+
+typedef struct
+{
+    int number_of_parts;
+    char operation_mode;          // 'A' for autonomous or 'P' for planned
+    int number_of_feeders;        // parts come from feeders 0 to number_of_feeders-1
+    int feeder_distribution;      // FEEDER_DISTRIBUTION_UNIFORM, ...
+    double min_x, max_x;          // board extents the placements are spread over, in machine coordinates
+    double min_y, max_y;
+    double rotation_spread;       // placements are rotated by up to +/- this many degrees
+    int quarter_turns;            // TRUE to round the rotations to multiples of 90 degrees
+    unsigned int seed;
+
+} BoardSpec;
+
+int checkBoardSpec(const BoardSpec*, const MachineConfig*);
+
+void generateBoard(const BoardSpec*, PlacementInfo[]);
+
+int writeCentroidFile(FILE*, const BoardSpec*, const PlacementInfo[]);
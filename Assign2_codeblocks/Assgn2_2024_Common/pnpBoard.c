@@ -0,0 +1,144 @@
+/*
+ *
+ * pnpBoard.c - converts between board and machine coordinates, and fits the board position
+ * from lookdown photos of its fiducials
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include "pnpShared.h"
+
+#define DEGREES_TO_RADIANS (M_PI / 180.0)
+
+/*
+ Function: setIdentityBoardTransform
+ -----------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: sets a board transform for a board loaded exactly in position, so that board and machine
+ coordinates are the same
+ Argument(s):
+ BoardTransform *board - the transform to set
+ Return Value: none
+ Usage: setIdentityBoardTransform(&board);
+ */
+void setIdentityBoardTransform(BoardTransform *board)
+{
+
+    board -> offset_x = 0.0;
+    board -> offset_y = 0.0;
+    board -> rotation = 0.0;
+    board -> scale = 1.0;
+
+}
+
+/*
+ Function: boardToMachine
+ ------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: converts a position on the board to the machine position it is at
+ Argument(s):
+ const BoardTransform *board - the position of the board in the machine
+ double board_x, board_y - the position in board coordinates
+ double *machine_x, *machine_y - set to the position in machine coordinates
+ Return Value: none
+ Usage: boardToMachine(&board, pi[i].x_target, pi[i].y_target, &x, &y);
+ */
+void boardToMachine(const BoardTransform *board, double board_x, double board_y, double *machine_x, double *machine_y)
+{
+
+    double c = board -> scale * cos(board -> rotation * DEGREES_TO_RADIANS);
+    double s = board -> scale * sin(board -> rotation * DEGREES_TO_RADIANS);
+
+    *machine_x = c * board_x - s * board_y + board -> offset_x;
+    *machine_y = s * board_x + c * board_y + board -> offset_y;
+
+}
+
+/*
+ Function: machineToBoard
+ ------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: converts a machine position to the position on the board underneath it
+ Argument(s):
+ const BoardTransform *board - the position of the board in the machine
+ double machine_x, machine_y - the position in machine coordinates
+ double *board_x, *board_y - set to the position in board coordinates
+ Return Value: none
+ Usage: machineToBoard(&board, x, y, &board_x, &board_y);
+ */
+void machineToBoard(const BoardTransform *board, double machine_x, double machine_y, double *board_x, double *board_y)
+{
+
+    double c = cos(board -> rotation * DEGREES_TO_RADIANS) / board -> scale;
+    double s = sin(board -> rotation * DEGREES_TO_RADIANS) / board -> scale;
+    double dx = machine_x - board -> offset_x, dy = machine_y - board -> offset_y;
+
+    *board_x = c * dx + s * dy;
+    *board_y = -s * dx + c * dy;
+
+}
+
+/*
+ Function: fitBoardTransform
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: finds the offset, rotation and scale of the board which best maps the nominal fiducial positions
+ onto their measured machine positions, in the least squares sense. Two fiducials give an exact fit, more
+ average out measurement error.
+ Argument(s):
+ const double nominal_x[], nominal_y[] - the fiducial positions in board coordinates
+ const double measured_x[], measured_y[] - the fiducial positions measured in machine coordinates
+ int number_of_fiducials - the number of fiducials measured
+ BoardTransform *board - set to the fitted transform
+ Return Value:
+ one of:
+ BOARD_TRANSFORM_FITTED (0)
+ BOARD_TRANSFORM_DEGENERATE (-1)
+ Usage: int res = fitBoardTransform(fiducial_x, fiducial_y, measured_x, measured_y, number_of_fiducials, &board);
+ */
+int fitBoardTransform(const double nominal_x[], const double nominal_y[], const double measured_x[], const double measured_y[], int number_of_fiducials, BoardTransform *board)
+{
+
+    double nominal_centre_x = 0.0, nominal_centre_y = 0.0, measured_centre_x = 0.0, measured_centre_y = 0.0;
+    double a = 0.0, b = 0.0, spread = 0.0;
+
+    if (number_of_fiducials < 2) return BOARD_TRANSFORM_DEGENERATE;
+
+    for (int i = 0; i < number_of_fiducials; i++)
+    {
+        nominal_centre_x += nominal_x[i] / number_of_fiducials;
+        nominal_centre_y += nominal_y[i] / number_of_fiducials;
+        measured_centre_x += measured_x[i] / number_of_fiducials;
+        measured_centre_y += measured_y[i] / number_of_fiducials;
+    }
+    for (int i = 0; i < number_of_fiducials; i++)
+    {
+        double nx = nominal_x[i] - nominal_centre_x, ny = nominal_y[i] - nominal_centre_y;
+        double mx = measured_x[i] - measured_centre_x, my = measured_y[i] - measured_centre_y;
+        a += nx * mx + ny * my;
+        b += nx * my - ny * mx;
+        spread += nx * nx + ny * ny;
+    }
+    if (spread < 1e-9) return BOARD_TRANSFORM_DEGENERATE;
+
+    /* a / spread and b / spread are scale * cos(rotation) and scale * sin(rotation) */
+    board -> scale = hypot(a, b) / spread;
+    board -> rotation = atan2(b, a) / DEGREES_TO_RADIANS;
+    board -> offset_x = 0.0;
+    board -> offset_y = 0.0;
+    boardToMachine(board, nominal_centre_x, nominal_centre_y, &board -> offset_x, &board -> offset_y);
+    board -> offset_x = measured_centre_x - board -> offset_x;
+    board -> offset_y = measured_centre_y - board -> offset_y;
+    return BOARD_TRANSFORM_FITTED;
+
+}
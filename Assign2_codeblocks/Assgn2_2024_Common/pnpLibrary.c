@@ -0,0 +1,278 @@
+/*
+ *
+ * pnpLibrary.c - reads the component library, which describes how each footprint is handled (its pick and
+ * place timings, the nozzles that can carry it and how it is photographed), and answers the simulator and
+ * planner from it, so that both time a part the same way
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include "pnpShared.h"
+
+#define COMPONENT_LIBRARY_KEYWORD_LENGTH 32
+#define NOZZLE_TYPE_LIST_LENGTH 64
+
+/*
+ Function: setDefaultComponentLibrary
+ ------------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: sets a component library with no packages, so that every part is handled as the machine defaults
+ Argument(s):
+ ComponentLibrary *library - pointer to the library to be set
+ Return Value: none
+ Usage: setDefaultComponentLibrary(&library);
+ */
+void setDefaultComponentLibrary(ComponentLibrary *library)
+{
+
+    memset(library, 0, sizeof(ComponentLibrary));
+    library -> number_of_packages = 0;
+
+}
+
+/*
+ Function: getComponentLibraryFileName
+ -------------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the name of the component library file, which is COMPONENT_LIBRARY_FILE in the current working
+ directory unless overridden by the COMPONENT_LIBRARY_FILE_ENV environment variable
+ Argument(s): none
+ Return Value: the name of the component library file
+ Usage: const char *filename = getComponentLibraryFileName();
+ */
+const char *getComponentLibraryFileName()
+{
+
+    const char *filename = getenv(COMPONENT_LIBRARY_FILE_ENV);
+
+    if (filename == NULL || filename[0] == '\0') return COMPONENT_LIBRARY_FILE;
+    return filename;
+
+}
+
+/*
+ Function: getNozzlesOfTypes
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: finds the nozzles of a machine fitted with any of a list of nozzle types
+ Argument(s):
+ const MachineConfig *machine - the machine description
+ const char *types - the nozzle types, separated by commas, or * for any nozzle
+ Return Value: bit n set if nozzle n has one of the types or has no type, so carries any part
+ Usage: package -> nozzles = getNozzlesOfTypes(machine, "small,medium");
+ */
+static unsigned int getNozzlesOfTypes(const MachineConfig *machine, const char *types)
+{
+
+    unsigned int nozzles = 0;
+
+    for (int n = 0; n < machine -> number_of_nozzles; n++)
+    {
+        const char *type = types;
+        size_t length = strlen(machine -> nozzle_type[n]);
+
+        if (strcmp(types, "*") == 0 || length == 0) nozzles |= 1u << n;
+        while (*type != '\0' && (nozzles & (1u << n)) == 0)
+        {
+            size_t type_length = strcspn(type, ",");
+
+            if (type_length == length && strncmp(type, machine -> nozzle_type[n], length) == 0) nozzles |= 1u << n;
+            type += type_length;
+            if (*type == ',') type++;
+        }
+    }
+    return nozzles;
+
+}
+
+/*
+ Function: getComponentLibraryFileContents
+ -----------------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the component library from the component library file if it exists and if its contents are valid. The
+ file holds one package per line, with # starting a comment:
+   package <footprint> <pick z time> <place z time> <vacuum dwell> <nozzle types> <fly_over or stationary>
+ The times are in seconds: each lower and raise of the nozzle when picking the part, the same when placing it,
+ and the time given to the vacuum to seal on the part or let go of it. The nozzle types are separated by commas,
+ or * for any nozzle, and are matched against the nozzle types of the machine, so the machine must be read
+ first. A footprint given again replaces its package, and one no nozzle of the machine can carry is an error.
+ Argument(s):
+ const char *filename - the name of the component library file
+ const MachineConfig *machine - the machine the library is for
+ ComponentLibrary *library - pointer to the library to be filled in
+ Return Value:
+ one of:
+ COMPONENT_LIBRARY_FILE_PRESENT_AND_READ (0)
+ COMPONENT_LIBRARY_FILE_NOT_PRESENT (-1)
+ COMPONENT_LIBRARY_FILE_PRESENT_BUT_CONTENT_ISSUE (-2)
+ COMPONENT_LIBRARY_FILE_HAS_TOO_MANY_ENTRIES (-3)
+ Usage:
+ int res = getComponentLibraryFileContents(getComponentLibraryFileName(), &machine, &library);
+ */
+int getComponentLibraryFileContents(const char *filename, const MachineConfig *machine, ComponentLibrary *library)
+{
+
+    char keyword[COMPONENT_LIBRARY_KEYWORD_LENGTH], types[NOZZLE_TYPE_LIST_LENGTH], vision[COMPONENT_LIBRARY_KEYWORD_LENGTH];
+    int res = COMPONENT_LIBRARY_FILE_PRESENT_AND_READ;
+    ComponentPackage package;
+
+    setDefaultComponentLibrary(library);
+
+    FILE *fp = fopen(filename, "r");
+
+    if (fp == NULL) return COMPONENT_LIBRARY_FILE_NOT_PRESENT;
+
+    while (res == COMPONENT_LIBRARY_FILE_PRESENT_AND_READ && fscanf(fp, "%31s", keyword) == 1)
+    {
+        if (keyword[0] == '#')
+        {   /* skip the rest of a comment line */
+            int c;
+            do { c = fgetc(fp); } while (c != '\n' && c != EOF);
+        }
+        else if (strcmp(keyword, "package") == 0)
+        {
+            memset(&package, 0, sizeof(package));
+            if (fscanf(fp, "%9s %lf %lf %lf %63s %31s", package.footprint, &package.pick_z_time, &package.place_z_time,
+                       &package.vacuum_dwell, types, vision) != 6
+                || package.pick_z_time < 0.0 || package.place_z_time < 0.0 || package.vacuum_dwell < 0.0) res = COMPONENT_LIBRARY_FILE_PRESENT_BUT_CONTENT_ISSUE;
+            else
+            {
+                int p = findComponentPackage(library, package.footprint);
+
+                if (strcmp(vision, "fly_over") == 0) package.vision = VISION_FLY_OVER;
+                else if (strcmp(vision, "stationary") == 0) package.vision = VISION_STATIONARY;
+                else res = COMPONENT_LIBRARY_FILE_PRESENT_BUT_CONTENT_ISSUE;
+                package.nozzles = getNozzlesOfTypes(machine, types);
+                if (package.nozzles == 0) res = COMPONENT_LIBRARY_FILE_PRESENT_BUT_CONTENT_ISSUE;
+
+                if (p == NO_PACKAGE && library -> number_of_packages == MAX_NUMBER_OF_PACKAGES) res = COMPONENT_LIBRARY_FILE_HAS_TOO_MANY_ENTRIES;
+                else if (res == COMPONENT_LIBRARY_FILE_PRESENT_AND_READ)
+                {
+                    if (p == NO_PACKAGE) p = library -> number_of_packages++;
+                    library -> package[p] = package;
+                }
+            }
+        }
+        else res = COMPONENT_LIBRARY_FILE_PRESENT_BUT_CONTENT_ISSUE;
+    }
+    fclose(fp);
+    if (res != COMPONENT_LIBRARY_FILE_PRESENT_AND_READ) setDefaultComponentLibrary(library);
+    return res;
+
+}
+
+/*
+ Function: findComponentPackage
+ ------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ interns a footprint as the index of its package in the component library. Called once for each placement as
+ the board is read, so the simulator and planner only ever index the library.
+ Argument(s):
+ const ComponentLibrary *library - the component library
+ const char *footprint - the footprint, as in the centroid file
+ Return Value: the index of the package, else NO_PACKAGE (-1) if the footprint is not in the library
+ Usage: pi[i].package = findComponentPackage(library, pi[i].component_footprint);
+ */
+int findComponentPackage(const ComponentLibrary *library, const char *footprint)
+{
+
+    for (int p = 0; p < library -> number_of_packages; p++)
+    {
+        if (strcmp(library -> package[p].footprint, footprint) == 0) return p;
+    }
+    return NO_PACKAGE;
+
+}
+
+/*
+ Function: getPackageInstructionTime
+ -----------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets how long the machine takes to lower or raise a nozzle, or to apply or release its vacuum, picking or
+ placing a part of a package. Any other instruction, and any part without a package, takes the machine's time.
+ Argument(s):
+ const ComponentLibrary *library - the component library
+ const MachineConfig *machine - the machine description
+ int package - the package of the part, else NO_PACKAGE
+ int instruction - LOWER_NOZZLE, RAISE_NOZZLE, APPLY_VACUUM or RELEASE_VACUUM
+ int placing - TRUE if the nozzle is placing the part, FALSE if picking it
+ Return Value: the time in seconds, else 0 for any other instruction
+ Usage: instruction_finish_time = sim_time + getPackageInstructionTime(&library, &machine, package, LOWER_NOZZLE, FALSE);
+ */
+double getPackageInstructionTime(const ComponentLibrary *library, const MachineConfig *machine, int package, int instruction, int placing)
+{
+
+    const ComponentPackage *p = package >= 0 && package < library -> number_of_packages ? &library -> package[package] : NULL;
+
+    switch (instruction)
+    {
+        case LOWER_NOZZLE:      if (p == NULL) return machine -> nozzle_lower_time; break;
+        case RAISE_NOZZLE:      if (p == NULL) return machine -> nozzle_raise_time; break;
+        case APPLY_VACUUM:      return p == NULL ? machine -> vacuum_apply_time : p -> vacuum_dwell;
+        case RELEASE_VACUUM:    return p == NULL ? machine -> vacuum_release_time : p -> vacuum_dwell;
+        default:                return 0.0;
+    }
+    return placing ? p -> place_z_time : p -> pick_z_time;
+
+}
+
+/*
+ Function: getPackageNozzles
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: gets the nozzles of the machine which can carry a part of a package
+ Argument(s):
+ const ComponentLibrary *library - the component library
+ const MachineConfig *machine - the machine description
+ int package - the package of the part, else NO_PACKAGE
+ Return Value: bit n set if nozzle n can carry the part, every nozzle for a part without a package
+ Usage: if (getPackageNozzles(library, machine, pi[part].package) & (1u << nozzle)) {...}
+ */
+unsigned int getPackageNozzles(const ComponentLibrary *library, const MachineConfig *machine, int package)
+{
+
+    if (package < 0 || package >= library -> number_of_packages) return (1u << machine -> number_of_nozzles) - 1;
+    return library -> package[package].nozzles;
+
+}
+
+/*
+ Function: getPackageVision
+ --------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: gets how a part of a package must be photographed by the lookup camera
+ Argument(s):
+ const ComponentLibrary *library - the component library
+ int package - the package of the part, else NO_PACKAGE
+ Return Value: VISION_FLY_OVER or VISION_STATIONARY, VISION_FLY_OVER for a part without a package
+ Usage: if (getPackageVision(library, pi[part].package) == VISION_STATIONARY) {...}
+ */
+int getPackageVision(const ComponentLibrary *library, int package)
+{
+
+    if (package < 0 || package >= library -> number_of_packages) return VISION_FLY_OVER;
+    return library -> package[package].vision;
+
+}
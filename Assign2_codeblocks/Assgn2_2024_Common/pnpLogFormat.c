@@ -0,0 +1,372 @@
+/*
+ *
+ * pnpLogFormat.c - formatting of the log messages of the simulator and controller into a fixed size line,
+ * without sprintf. Numbers are written in fixed point whatever the locale, and nothing is ever written past
+ * the end of the line: a message too long for it is cut short, as the log ring would cut it.
+ *
+ * A message is built up from a template for its start, such as formatLogMessage for "Time: %7.2f  text",
+ * then the add functions for the rest, so the type of every argument is checked by the compiler.
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include "pnpShared.h"
+
+static const double power_of_ten[LOG_MAX_DECIMALS + 1] = {1.0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+/*
+ Function: addLogBytes
+ ---------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: adds characters to a log line, as many as there is room for
+ Argument(s):
+ LogLine *line - the line
+ const char *text - the characters, which need not be null terminated
+ int length - how many
+ Return Value: none
+ Usage: addLogBytes(line, digits + start, LOG_NUMBER_SIZE - start);
+ */
+static void addLogBytes(LogLine *line, const char *text, int length)
+{
+
+    int room = LOG_MESSAGE_SIZE - 1 - line -> length;
+
+    if (length > room) length = room;
+    if (length <= 0) return;
+    memcpy(line -> text + line -> length, text, length);
+    line -> length += length;
+    line -> text[line -> length] = '\0';
+
+}
+
+/*
+ Function: clearLogLine
+ ----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: empties a log line, for a message that does not start with the time
+ Argument(s):
+ LogLine *line - the line
+ Return Value: none
+ Usage: clearLogLine(&log_line);
+ */
+void clearLogLine(LogLine *line)
+{
+
+    line -> length = 0;
+    line -> text[0] = '\0';
+
+}
+
+/*
+ Function: addLogText
+ --------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: adds a string to a log line, as %s would
+ Argument(s):
+ LogLine *line - the line
+ const char *text - the string
+ Return Value: none
+ Usage: addLogText(&log_line, " nozzle lowered\n");
+ */
+void addLogText(LogLine *line, const char *text)
+{
+
+    int room = LOG_MESSAGE_SIZE - 1 - line -> length;
+    char *end = line -> text + line -> length;
+
+    while (room > 0 && *text != '\0')
+    {
+        *end++ = *text++;
+        room--;
+    }
+    *end = '\0';
+    line -> length = (int) (end - line -> text);
+
+}
+
+/*
+ Function: addLogString
+ ----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: adds at most the first few characters of a string to a log line, as %.<n>s would
+ Argument(s):
+ LogLine *line - the line
+ const char *text - the string
+ int max_length - the most characters to add
+ Return Value: none
+ Usage: addLogString(&log_line, state_name[state], 20);
+ */
+void addLogString(LogLine *line, const char *text, int max_length)
+{
+
+    int length = 0;
+
+    while (length < max_length && text[length] != '\0') length++;
+    addLogBytes(line, text, length);
+
+}
+
+/*
+ Function: addLogChar
+ --------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: adds one character to a log line, as %c would
+ Argument(s):
+ LogLine *line - the line
+ char c - the character
+ Return Value: none
+ Usage: addLogChar(&log_line, c);
+ */
+void addLogChar(LogLine *line, char c)
+{
+
+    addLogBytes(line, &c, 1);
+
+}
+
+/*
+ Function: addLogInteger
+ -----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: adds a whole number to a log line, as %d or %ld would
+ Argument(s):
+ LogLine *line - the line
+ long value - the number
+ Return Value: none
+ Usage: addLogInteger(&log_line, pi[component_num].feeder);
+ */
+void addLogInteger(LogLine *line, long value)
+{
+
+    char digits[LOG_NUMBER_SIZE];
+    int start = LOG_NUMBER_SIZE;
+    unsigned long magnitude = value < 0 ? 0UL - (unsigned long) value : (unsigned long) value;
+
+    /* written backwards from the end of the buffer */
+    do
+    {
+        digits[--start] = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) digits[--start] = '-';
+    addLogBytes(line, digits + start, LOG_NUMBER_SIZE - start);
+
+}
+
+/*
+ Function: addLogFixed
+ ---------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ adds a number to a log line in fixed point, as %<width>.<decimals>f would but without the locale, rounding
+ halves away from zero. A value which rounds to zero is written without a sign. A value too big to scale to
+ a whole number, or not a number at all, falls back to snprintf.
+ Argument(s):
+ LogLine *line - the line
+ double value - the number
+ int width - the least number of characters, padded with spaces on the left
+ int decimals - the number of decimal places, 0 to LOG_MAX_DECIMALS
+ Return Value: none
+ Usage: addLogFixed(&log_line, sim_time, 7, 2);
+ */
+void addLogFixed(LogLine *line, double value, int width, int decimals)
+{
+
+    char digits[LOG_NUMBER_SIZE];
+    int start = LOG_NUMBER_SIZE, length;
+    double scaled;
+    unsigned long long whole;
+
+    if (decimals < 0) decimals = 0;
+    if (decimals > LOG_MAX_DECIMALS) decimals = LOG_MAX_DECIMALS;
+    scaled = fabs(value) * power_of_ten[decimals] + 0.5;
+    if (!(scaled < LOG_MAX_FIXED))  // also true of NaN
+    {
+        length = snprintf(digits, sizeof(digits), "%*.*f", width, decimals, value);
+        addLogBytes(line, digits, length < (int) sizeof(digits) ? length : (int) sizeof(digits) - 1);
+        return;
+    }
+
+    /* written backwards from the end of the buffer: the decimal places, the point, then the whole part */
+    whole = (unsigned long long) scaled;
+    for (int i = 0; i < decimals; i++)
+    {
+        digits[--start] = (char) ('0' + whole % 10);
+        whole /= 10;
+    }
+    if (decimals > 0) digits[--start] = '.';
+    do
+    {
+        digits[--start] = (char) ('0' + whole % 10);
+        whole /= 10;
+    } while (whole > 0);
+    if (value < 0.0 && (unsigned long long) scaled > 0) digits[--start] = '-';
+    while (LOG_NUMBER_SIZE - start < width && start > 0) digits[--start] = ' ';
+    addLogBytes(line, digits + start, LOG_NUMBER_SIZE - start);
+
+}
+
+/*
+ Function: addLogPoint
+ ---------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: adds a position to a log line, as "(%.<decimals>f, %.<decimals>f)" would
+ Argument(s):
+ LogLine *line - the line
+ double x, y - the position
+ int decimals - the number of decimal places
+ Return Value: none
+ Usage: addLogPoint(&log_line, x, y, 2);
+ */
+void addLogPoint(LogLine *line, double x, double y, int decimals)
+{
+
+    addLogChar(line, '(');
+    addLogFixed(line, x, 0, decimals);
+    addLogText(line, ", ");
+    addLogFixed(line, y, 0, decimals);
+    addLogChar(line, ')');
+
+}
+
+/*
+ Function: startLogLine
+ ----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: starts a log line with the simulation time, as "Time: %7.2f  " would
+ Argument(s):
+ LogLine *line - the line
+ double time - the simulation time
+ Return Value: none
+ Usage: startLogLine(line, time);
+ */
+static void startLogLine(LogLine *line, double time)
+{
+
+    clearLogLine(line);
+    addLogBytes(line, "Time: ", 6);
+    addLogFixed(line, time, 7, 2);
+    addLogBytes(line, "  ", 2);
+
+}
+
+/*
+ Function: formatLogMessage
+ --------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: starts a log line with the simulation time and the start of the message, "Time: %7.2f  %s"
+ Argument(s):
+ LogLine *line - the line
+ double time - the simulation time
+ const char *text - the message, or its start if more is added after
+ Return Value: none
+ Usage: formatLogMessage(&log_line, sim_time, "PCB has been unloaded\n");
+ */
+void formatLogMessage(LogLine *line, double time, const char *text)
+{
+
+    startLogLine(line, time);
+    addLogText(line, text);
+
+}
+
+/*
+ Function: formatStateLog
+ ------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: starts a log line of the controller entering a new state, "Time: %7.2f  New state: %.20s  %s"
+ Argument(s):
+ LogLine *line - the line
+ double time - the simulation time
+ const char *state - the name of the new state
+ const char *text - the message, or its start if more is added after
+ Return Value: none
+ Usage: formatStateLog(&log_line, getSimulationTime(), state_name[state], "Raising nozzle\n");
+ */
+void formatStateLog(LogLine *line, double time, const char *state, const char *text)
+{
+
+    startLogLine(line, time);
+    addLogBytes(line, "New state: ", 11);
+    addLogString(line, state, CONTROLLER_STATE_NAME_LENGTH);
+    addLogBytes(line, "  ", 2);
+    addLogText(line, text);
+
+}
+
+/*
+ Function: formatNozzleLog
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: starts a log line of the simulator about one nozzle, "Time: %7.2f  %s nozzle %s"
+ Argument(s):
+ LogLine *line - the line
+ double time - the simulation time
+ const char *nozzle - the name of the nozzle
+ const char *text - the message, or its start if more is added after
+ Return Value: none
+ Usage: formatNozzleLog(&log_line, sim_time, machine.nozzle_name[nozzle], "lowered\n");
+ */
+void formatNozzleLog(LogLine *line, double time, const char *nozzle, const char *text)
+{
+
+    startLogLine(line, time);
+    addLogText(line, nozzle);
+    addLogBytes(line, " nozzle ", 8);
+    addLogText(line, text);
+
+}
+
+/*
+ Function: formatHeadMoveLog
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: starts a log line of the simulator moving the head, "Time: %7.2f  Head moving from (%.2f, %.2f) to (%.2f, %.2f)%s"
+ Argument(s):
+ LogLine *line - the line
+ double time - the simulation time
+ double x, y - where the head is moving from
+ double x_target, y_target - where it is moving to
+ const char *text - the end of the message
+ Return Value: none
+ Usage: formatHeadMoveLog(&log_line, sim_time, x, y, x_target, y_target, "\n");
+ */
+void formatHeadMoveLog(LogLine *line, double time, double x, double y, double x_target, double y_target, const char *text)
+{
+
+    startLogLine(line, time);
+    addLogBytes(line, "Head moving from ", 17);
+    addLogPoint(line, x, y, 2);
+    addLogBytes(line, " to ", 4);
+    addLogPoint(line, x_target, y_target, 2);
+    addLogText(line, text);
+
+}
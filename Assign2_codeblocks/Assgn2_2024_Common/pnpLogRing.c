@@ -0,0 +1,467 @@
+/*
+ *
+ * pnpLogRing.c - the ring of log messages from the simulator, controller and Startup to the Display, in a
+ * shared memory segment created by Startup and inherited by the others across fork and exec
+ *
+ * The ring is a bounded queue for several writers and one reader. A writer claims a position by moving the
+ * tail on, fills the slot at that position and marks it written. The Display prints the slot at the head
+ * once it is marked written, and frees it for the writer that comes round to it next. A slot whose writer
+ * takes too long is skipped and poisoned, so that no other writer can claim it while the first may still be
+ * filling it; the first writer frees it when it finishes, or the Display does once that writer has died.
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pnpShared.h"
+
+static sem_t *log_doorbell = SEM_FAILED;     // this process's handle on LOG_DOORBELL
+static int log_ring_fd = -1;
+static int log_writer = 0;                   // this process's id, kept so that writing a message makes no system call
+
+static LogRing *display_log = NULL;          // used by writeDisplayLog, else...
+static int display_log_fd = -1;              // ...the file descriptor it writes to instead
+static int display_log_source = LOG_SOURCE_STARTUP;
+
+/*
+ Function: getLogWallTime
+ ------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: gets the real time, which the slot timeout is measured in whatever the simulation time scale
+ Argument(s): none
+ Return Value: seconds from an arbitrary fixed point
+ Usage: double now = getLogWallTime();
+ */
+static double getLogWallTime()
+{
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+
+}
+
+/*
+ Function: createLogRing
+ -----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ creates an empty log ring and its doorbell semaphore, replacing any doorbell left over from an earlier run,
+ and puts the ring's file descriptor in LOG_RING_FD_ENV for the processes started after it
+ Argument(s): none
+ Return Value: the ring, else NULL with errno set
+ Usage: log_ring = createLogRing();
+ */
+LogRing *createLogRing()
+{
+
+    char fd_str[16];
+    LogRing *ring;
+
+    ring = createSharedMemory(sizeof(LogRing), &log_ring_fd);
+    if (ring == MAP_FAILED) return NULL;
+
+    sem_unlink(LOG_DOORBELL);
+    log_doorbell = sem_open(LOG_DOORBELL, O_CREAT, 0666, 0);
+    if (log_doorbell == SEM_FAILED)
+    {
+        int error = errno;
+
+        munmap(ring, sizeof(LogRing));
+        close(log_ring_fd);
+        errno = error;
+        return NULL;
+    }
+
+    log_writer = (int) getpid();
+    ring -> layout_size = sizeof(LogRing);
+    for (unsigned long position = 0; position < LOG_RING_SIZE; position++) ring -> message[position].sequence = position;
+    snprintf(fd_str, sizeof(fd_str), "%d", log_ring_fd);
+    setenv(LOG_RING_FD_ENV, fd_str, 1);
+    return ring;
+
+}
+
+/*
+ Function: openLogRing
+ ---------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose: maps the log ring created by Startup, from the file descriptor given in LOG_RING_FD_ENV, and opens its doorbell
+ Argument(s): none
+ Return Value: the ring, else NULL if there is none or it was made for a different layout
+ Usage: log_ring = openLogRing();
+ */
+LogRing *openLogRing()
+{
+
+    const char *fd_str = getenv(LOG_RING_FD_ENV);
+    struct stat st;
+    LogRing *ring;
+
+    if (fd_str == NULL || sscanf(fd_str, "%d", &log_ring_fd) != 1) return NULL;
+    if (fstat(log_ring_fd, &st) != 0 || st.st_size < (off_t) sizeof(LogRing)) return NULL;
+
+    ring = mapSharedMemory(log_ring_fd, sizeof(LogRing));
+    if (ring == MAP_FAILED) return NULL;
+    log_doorbell = sem_open(LOG_DOORBELL, 0);
+    if (ring -> layout_size != sizeof(LogRing) || log_doorbell == SEM_FAILED)
+    {
+        munmap(ring, sizeof(LogRing));
+        return NULL;
+    }
+    log_writer = (int) getpid();
+    return ring;
+
+}
+
+/*
+ Function: closeLogRing
+ ----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: unmaps the log ring and closes its file descriptor and doorbell
+ Argument(s):
+ LogRing *ring - the ring
+ Return Value: none
+ Usage: closeLogRing(log_ring);
+ */
+void closeLogRing(LogRing *ring)
+{
+
+    munmap(ring, sizeof(LogRing));
+    if (log_ring_fd >= 0) close(log_ring_fd);
+    if (log_doorbell != SEM_FAILED) sem_close(log_doorbell);
+    log_ring_fd = -1;
+    log_doorbell = SEM_FAILED;
+
+}
+
+/*
+ Function: writeLogMessage
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ writes a message to the ring without ever waiting for the Display. A message is dropped, and counted against
+ its source, if the ring is full, and cut short if longer than LOG_MESSAGE_SIZE. It is also dropped if the
+ Display skipped the slot as this writer took too long, and the slot is then freed for the next writer. The
+ doorbell is only posted if the Display is asleep, so a writer normally makes no system call at all.
+ Argument(s):
+ LogRing *ring - the ring
+ int source - LOG_SOURCE_STARTUP, LOG_SOURCE_SIMULATOR or LOG_SOURCE_CONTROLLER
+ const char *text - the message
+ Return Value: TRUE if it was written, else FALSE if it was dropped
+ Usage: writeLogMessage(log_ring, LOG_SOURCE_SIMULATOR, Sim_str_array);
+ */
+int writeLogMessage(LogRing *ring, int source, const char *text)
+{
+
+    unsigned long position = ring -> tail;
+    LogMessage *slot;
+    size_t length;
+
+    /* claim the slot at the tail, unless the Display has not yet freed it */
+    while (1)
+    {
+        slot = &ring -> message[position & (LOG_RING_SIZE - 1)];
+        long difference = (long) (slot -> sequence - position);
+
+        if (difference == 0 && __sync_bool_compare_and_swap(&ring -> tail, position, position + 1)) break;
+        if (difference < 0)
+        {
+            __sync_add_and_fetch(&ring -> dropped[source], 1);
+            return FALSE;
+        }
+        position = ring -> tail;  // another writer claimed it first
+    }
+    slot -> writer = log_writer;
+
+    length = strlen(text);
+    if (length > LOG_MESSAGE_SIZE - 1) length = LOG_MESSAGE_SIZE - 1;
+    memcpy(slot -> text, text, length);
+    slot -> text[length] = '\0';
+    slot -> length = (short) length;
+    slot -> source = (short) source;
+
+    /* mark it written, unless the Display gave up on it as this writer took too long, when only this writer can free it */
+    if (__sync_bool_compare_and_swap(&slot -> sequence, position, position + 1) == FALSE)
+    {
+        slot -> writer = 0;
+        __sync_bool_compare_and_swap(&slot -> sequence, LOG_SLOT_POISONED(position), position + LOG_RING_SIZE);
+        __sync_add_and_fetch(&ring -> dropped[source], 1);
+        return FALSE;
+    }
+
+    if (ring -> display_waiting == TRUE && __sync_bool_compare_and_swap(&ring -> display_waiting, TRUE, FALSE))
+    {
+        sem_post(log_doorbell);
+    }
+    return TRUE;
+
+}
+
+/*
+ Function: peekLogMessage
+ ------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ gets the message at the head of the ring, for the Display to print straight from the slot. A slot that was
+ claimed but has not been written for LOG_SLOT_TIMEOUT seconds is skipped so that it does not hold up the
+ ring, and left poisoned, as its writer may be stalled rather than killed and still be filling it. Its writer
+ frees it when it finishes; if the ring has come round to it again and the writer has died, it is freed here.
+ Argument(s):
+ LogRing *ring - the ring
+ Return Value: the message, else NULL if there is none yet
+ Usage: while ((message = peekLogMessage(log_ring)) != NULL) {...; releaseLogMessage(log_ring);}
+ */
+const LogMessage *peekLogMessage(LogRing *ring)
+{
+
+    static unsigned long waiting_position = 0;
+    static double waiting_since = -1.0;
+    unsigned long position = ring -> head;
+    LogMessage *slot = &ring -> message[position & (LOG_RING_SIZE - 1)];
+
+    if (slot -> sequence == position + 1)
+    {
+        __sync_synchronize();  // read the message only after seeing it marked written
+        waiting_since = -1.0;
+        return slot;
+    }
+    if (ring -> tail == position)
+    {  //empty, or the writers are held up by a skipped slot whose writer may have died
+        LogMessage *poisoned = &ring -> message[position & (LOG_RING_SIZE - 1)];
+
+        if (poisoned -> sequence == LOG_SLOT_POISONED(position - LOG_RING_SIZE)
+            && (poisoned -> writer == 0 || (kill(poisoned -> writer, 0) != 0 && errno == ESRCH))
+            && __sync_bool_compare_and_swap(&poisoned -> sequence, LOG_SLOT_POISONED(position - LOG_RING_SIZE), position))
+        {
+            poisoned -> writer = 0;
+        }
+        return NULL;
+    }
+
+    /* claimed but not yet written */
+    if (waiting_since < 0.0 || waiting_position != position)
+    {
+        waiting_position = position;
+        waiting_since = getLogWallTime();
+    }
+    else if (getLogWallTime() - waiting_since > LOG_SLOT_TIMEOUT
+             && __sync_bool_compare_and_swap(&slot -> sequence, position, LOG_SLOT_POISONED(position)))
+    {
+        ring -> skipped++;
+        ring -> head = position + 1;
+        waiting_since = -1.0;
+    }
+    return NULL;
+
+}
+
+/*
+ Function: releaseLogMessage
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose: frees the slot at the head of the ring once its message has been printed, and moves on to the next
+ Argument(s):
+ LogRing *ring - the ring
+ Return Value: none
+ Usage: releaseLogMessage(log_ring);
+ */
+void releaseLogMessage(LogRing *ring)
+{
+
+    unsigned long position = ring -> head;
+
+    __sync_synchronize();  // finish with the message before a writer can reuse the slot
+    ring -> message[position & (LOG_RING_SIZE - 1)].writer = 0;
+    ring -> message[position & (LOG_RING_SIZE - 1)].sequence = position + LOG_RING_SIZE;
+    ring -> head = position + 1;
+
+}
+
+/*
+ Function: waitForLogMessage
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ puts the Display to sleep on the doorbell until a message is written or the timeout passes. The ring is
+ checked again after saying it is waiting, so a message written in between is not slept through. A slot that
+ is claimed but not yet written is slept on as well, as its writer posts the doorbell once it has written it.
+ Argument(s):
+ LogRing *ring - the ring
+ double timeout - the longest to sleep, in wall seconds
+ Return Value: none
+ Usage: waitForLogMessage(log_ring, DISPLAY_POLL_TIMEOUT);
+ */
+void waitForLogMessage(LogRing *ring, double timeout)
+{
+
+    struct timespec deadline;
+
+    ring -> display_waiting = TRUE;
+    __sync_synchronize();
+    if (ring -> message[ring -> head & (LOG_RING_SIZE - 1)].sequence == ring -> head + 1 || isLogRingFinished(ring) == TRUE)
+    {
+        ring -> display_waiting = FALSE;
+        return;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += (time_t) timeout;
+    deadline.tv_nsec += (long) ((timeout - (time_t) timeout) * 1e9);
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    while (sem_timedwait(log_doorbell, &deadline) != 0 && errno == EINTR);
+    ring -> display_waiting = FALSE;
+
+}
+
+/*
+ Function: getLogBacklog
+ -----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: gets how far the Display is behind
+ Argument(s):
+ const LogRing *ring - the ring
+ Return Value: the messages written or being written that the Display has not yet printed
+ Usage: unsigned long backlog = getLogBacklog(log_ring);
+ */
+unsigned long getLogBacklog(const LogRing *ring)
+{
+
+    return ring -> tail - ring -> head;
+
+}
+
+/*
+ Function: finishLogRing
+ -----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: tells the Display that nothing more will be written, so that it terminates once it has printed the rest
+ Argument(s):
+ LogRing *ring - the ring
+ Return Value: none
+ Usage: finishLogRing(log_ring);
+ */
+void finishLogRing(LogRing *ring)
+{
+
+    ring -> finished = TRUE;
+    __sync_synchronize();
+    if (__sync_bool_compare_and_swap(&ring -> display_waiting, TRUE, FALSE)) sem_post(log_doorbell);
+
+}
+
+/*
+ Function: isLogRingFinished
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: checks whether the Display has printed everything there will be
+ Argument(s):
+ const LogRing *ring - the ring
+ Return Value: TRUE once finishLogRing has been called and the ring is empty, else FALSE
+ Usage: if (isLogRingFinished(log_ring) == TRUE) exit(10);
+ */
+int isLogRingFinished(const LogRing *ring)
+{
+
+    return ring -> finished == TRUE && ring -> tail == ring -> head;
+
+}
+
+/*
+ Function: openDisplayLog
+ ------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ sets up writeDisplayLog for the simulator or controller. The log ring is used when the process was started
+ by Startup, else the messages are written to the file descriptor it was given, as the harness expects.
+ Argument(s):
+ int source - LOG_SOURCE_SIMULATOR or LOG_SOURCE_CONTROLLER
+ int fd - the file descriptor to write to when there is no log ring
+ Return Value: none
+ Usage: openDisplayLog(LOG_SOURCE_SIMULATOR, atoi(argv[1]));
+ */
+void openDisplayLog(int source, int fd)
+{
+
+    display_log = openLogRing();
+    display_log_fd = fd;
+    display_log_source = source;
+
+}
+
+/*
+ Function: writeDisplayLog
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: writes a message for the Display, through the log ring or to the file descriptor given to openDisplayLog
+ Argument(s):
+ const char *text - the message
+ Return Value: none
+ Usage: writeDisplayLog(Sim_str_array);
+ */
+void writeDisplayLog(const char *text)
+{
+
+    if (display_log != NULL) writeLogMessage(display_log, display_log_source, text);
+    else if (display_log_fd >= 0) write(display_log_fd, text, strlen(text));
+
+}
+
+/*
+ Function: closeDisplayLog
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: closes the log ring or the file descriptor given to openDisplayLog, once the last message is written
+ Argument(s): none
+ Return Value: none
+ Usage: closeDisplayLog();
+ */
+void closeDisplayLog()
+{
+
+    if (display_log != NULL) closeLogRing(display_log);
+    if (display_log_fd >= 0) close(display_log_fd);
+    display_log = NULL;
+    display_log_fd = -1;
+
+}
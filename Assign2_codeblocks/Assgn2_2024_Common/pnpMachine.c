@@ -0,0 +1,488 @@
+/*
+ *
+ * pnpMachine.c - reads the machine description (feeder bank, head layout, camera location
+ * and timings) shared by the simulator and controller, paces both to the same time scale and
+ * starts them together, names the instructions, and finds the executables of the tools
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include <limits.h>
+#include <unistd.h>
+#include "pnpShared.h"
+
+#define MACHINE_CONFIG_KEYWORD_LENGTH 32
+
+/*
+ Function: setDefaultMachineConfig
+ ---------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.2
+ Purpose:
+ sets a machine description to the original machine, ten feeders spaced 100 units apart
+ along y = -100 and a left, centre and right nozzle on the head
+ Argument(s):
+ MachineConfig *machine - pointer to the machine description to be set
+ Return Value: none
+ Usage: setDefaultMachineConfig(&machine);
+ */
+void setDefaultMachineConfig(MachineConfig *machine)
+{
+
+    const char default_nozzle_name[DEFAULT_NUMBER_OF_NOZZLES][NOZZLE_NAME_LENGTH] = {"Left", "Centre", "Right"};
+
+    memset(machine, 0, sizeof(MachineConfig));
+    machine -> home_x = DEFAULT_HOME_X;
+    machine -> home_y = DEFAULT_HOME_Y;
+    machine -> min_x = DEFAULT_MIN_X;
+    machine -> min_y = DEFAULT_MIN_Y;
+    machine -> max_x = DEFAULT_MAX_X;
+    machine -> max_y = DEFAULT_MAX_Y;
+
+    machine -> number_of_feeders = DEFAULT_NUMBER_OF_FEEDERS;
+    for (int i = 0; i < DEFAULT_NUMBER_OF_FEEDERS; i++)
+    {
+        machine -> feeder_x[i] = DEFAULT_FIRST_FEEDER_X + i * DEFAULT_FEEDER_X_SEPARATION;
+        machine -> feeder_y[i] = DEFAULT_FEEDER_Y;
+    }
+    for (int i = 0; i < MAX_NUMBER_OF_FEEDERS; i++)
+    {   /* every feeder, including any given in the machine config file, starts with the default tape */
+        machine -> feeder_pitch[i] = DEFAULT_FEEDER_PITCH;
+        machine -> feeder_advance_time[i] = DEFAULT_FEEDER_ADVANCE_TIME;
+        machine -> feeder_parts_per_reel[i] = DEFAULT_FEEDER_PARTS_PER_REEL;
+    }
+    machine -> splice_time = DEFAULT_SPLICE_TIME;
+
+    machine -> number_of_nozzles = DEFAULT_NUMBER_OF_NOZZLES;
+    for (int i = 0; i < DEFAULT_NUMBER_OF_NOZZLES; i++)
+    {
+        strcpy(machine -> nozzle_name[i], default_nozzle_name[i]);
+        machine -> nozzle_x_offset[i] = (i - DEFAULT_NUMBER_OF_NOZZLES / 2) * DEFAULT_NOZZLE_X_SEPARATION;
+        machine -> nozzle_y_offset[i] = 0.0;
+    }
+
+    machine -> lookup_camera_x = DEFAULT_LOOKUP_CAMERA_X;
+    machine -> lookup_camera_y = DEFAULT_LOOKUP_CAMERA_Y;
+    machine -> lookup_camera_window = DEFAULT_LOOKUP_CAMERA_WINDOW;
+    machine -> lookup_camera_fly_over = DEFAULT_LOOKUP_CAMERA_FLY_OVER;
+    machine -> lookdown_camera_window = DEFAULT_LOOKDOWN_CAMERA_WINDOW;
+    machine -> number_of_fiducials = DEFAULT_NUMBER_OF_FIDUCIALS;
+    machine -> board_max_offset = DEFAULT_BOARD_MAX_OFFSET;
+    machine -> board_max_rotation = DEFAULT_BOARD_MAX_ROTATION;
+    machine -> board_max_scale_error = DEFAULT_BOARD_MAX_SCALE_ERROR;
+    machine -> head_full_speed = DEFAULT_HEAD_FULL_SPEED;
+    machine -> nozzle_rotate_speed = DEFAULT_NOZZLE_ROTATE_SPEED;
+    machine -> nozzle_lower_time = DEFAULT_NOZZLE_LOWER_TIME;
+    machine -> nozzle_raise_time = DEFAULT_NOZZLE_RAISE_TIME;
+    machine -> vacuum_apply_time = DEFAULT_VACUUM_APPLY_TIME;
+    machine -> vacuum_release_time = DEFAULT_VACUUM_RELEASE_TIME;
+    machine -> photo_take_time = DEFAULT_PHOTO_TAKE_TIME;
+    machine -> pcb_load_unload_time = DEFAULT_PCB_LOAD_UNLOAD_TIME;
+    machine -> placement_tolerance = DEFAULT_PLACEMENT_TOLERANCE;
+    machine -> rotation_tolerance = DEFAULT_ROTATION_TOLERANCE;
+    machine -> rotation_correction_band = DEFAULT_ROTATION_CORRECTION_BAND;
+    machine -> number_of_correction_bands = 0;
+
+}
+
+/*
+ Function: getMachineConfigFileName
+ ----------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the name of the machine config file, which is MACHINE_CONFIG_FILE in the current working
+ directory unless overridden by the MACHINE_CONFIG_FILE_ENV environment variable (so that machine
+ variants can be swept without editing files or recompiling)
+ Argument(s): none
+ Return Value: the name of the machine config file
+ Usage: const char *filename = getMachineConfigFileName();
+ */
+const char *getMachineConfigFileName()
+{
+
+    const char *filename = getenv(MACHINE_CONFIG_FILE_ENV);
+
+    if (filename == NULL || filename[0] == '\0') return MACHINE_CONFIG_FILE;
+    return filename;
+
+}
+
+/*
+ Function: getMachineConfigFileContents
+ --------------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.6
+ Purpose:
+ gets the machine description from the machine config file if it exists and if its contents are valid.
+ The file holds one setting per line as a keyword followed by its values, with # starting a comment:
+   home <x> <y>
+   limits <min_x> <min_y> <max_x> <max_y>
+   feeder <number> <x> <y>
+   feeder_tape <number> <pitch> <advance time in seconds> <parts per reel, 0 for an endless reel>
+   nozzle <number> <name> <x_offset> <y_offset>
+   nozzle_type <number> <type of tip fitted, matched against the nozzle types of the component library>
+   lookup_camera <x> <y>
+   lookup_camera_window <radius of the field of view>
+   lookup_camera_fly_over <1 if photos can be taken with the head moving, else 0>
+   lookdown_camera_window <radius of the field of view>
+   fiducial <number> <x> <y> in board coordinates
+   board_load_error <max offset> <max rotation in degrees> <max scale error as a fraction>
+   placement_tolerance <largest error in x and y> <largest rotation error in degrees>
+   correction_band <footprint, or * for all others> <smallest rotation in degrees worth correcting>
+   head_full_speed <units per second>
+   nozzle_rotate_speed <degrees per second>
+   nozzle_lower_time, nozzle_raise_time, vacuum_apply_time, vacuum_release_time,
+   photo_take_time, pcb_load_unload_time, splice_time <seconds>
+ Any setting not given keeps its default value. If any feeder (or nozzle) lines are given they replace
+ the whole default feeder bank (or head), and must be numbered from 0 without gaps. A nozzle without a type
+ carries any part. A correction band must be less than the rotation tolerance, as a part left uncorrected
+ would otherwise be placed out of specification.
+ Argument(s):
+ const char *filename - the name of the machine config file
+ MachineConfig *machine - pointer to the machine description to be filled in
+ Return Value:
+ one of:
+ MACHINE_CONFIG_FILE_PRESENT_AND_READ (0)
+ MACHINE_CONFIG_FILE_NOT_PRESENT (-1)
+ MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE (-2)
+ MACHINE_CONFIG_FILE_HAS_TOO_MANY_ENTRIES (-3)
+ Usage:
+ int res = getMachineConfigFileContents(getMachineConfigFileName(), &machine);
+ */
+int getMachineConfigFileContents(const char *filename, MachineConfig *machine)
+{
+
+    char keyword[MACHINE_CONFIG_KEYWORD_LENGTH];
+    char feeder_defined[MAX_NUMBER_OF_FEEDERS] = {FALSE};
+    char feeder_tape_defined[MAX_NUMBER_OF_FEEDERS] = {FALSE};
+    char nozzle_defined[MAX_NUMBER_OF_NOZZLES] = {FALSE};
+    char nozzle_type_defined[MAX_NUMBER_OF_NOZZLES] = {FALSE};
+    char fiducial_defined[MAX_NUMBER_OF_FIDUCIALS] = {FALSE};
+    int number, highest_feeder = -1, highest_nozzle = -1, highest_fiducial = -1, res = MACHINE_CONFIG_FILE_PRESENT_AND_READ;
+    double value;
+
+    setDefaultMachineConfig(machine);
+
+    FILE *fp = fopen(filename, "r");
+
+    if (fp == NULL) return MACHINE_CONFIG_FILE_NOT_PRESENT;
+
+    while (res == MACHINE_CONFIG_FILE_PRESENT_AND_READ && fscanf(fp, "%31s", keyword) == 1)
+    {
+        if (keyword[0] == '#')
+        {   /* skip the rest of a comment line */
+            int c;
+            do { c = fgetc(fp); } while (c != '\n' && c != EOF);
+        }
+        else if (strcmp(keyword, "home") == 0)
+        {
+            if (fscanf(fp, "%lf %lf", &machine -> home_x, &machine -> home_y) != 2) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+        }
+        else if (strcmp(keyword, "limits") == 0)
+        {
+            if (fscanf(fp, "%lf %lf %lf %lf", &machine -> min_x, &machine -> min_y, &machine -> max_x, &machine -> max_y) != 4) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+        }
+        else if (strcmp(keyword, "feeder") == 0)
+        {
+            if (fscanf(fp, "%i", &number) != 1 || number < 0) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+            else if (number >= MAX_NUMBER_OF_FEEDERS) res = MACHINE_CONFIG_FILE_HAS_TOO_MANY_ENTRIES;
+            else if (fscanf(fp, "%lf %lf", &machine -> feeder_x[number], &machine -> feeder_y[number]) != 2) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+            else
+            {
+                feeder_defined[number] = TRUE;
+                if (number > highest_feeder) highest_feeder = number;
+            }
+        }
+        else if (strcmp(keyword, "feeder_tape") == 0)
+        {
+            if (fscanf(fp, "%i", &number) != 1 || number < 0) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+            else if (number >= MAX_NUMBER_OF_FEEDERS) res = MACHINE_CONFIG_FILE_HAS_TOO_MANY_ENTRIES;
+            else if (fscanf(fp, "%lf %lf %i", &machine -> feeder_pitch[number], &machine -> feeder_advance_time[number], &machine -> feeder_parts_per_reel[number]) != 3
+                     || machine -> feeder_pitch[number] <= 0.0 || machine -> feeder_advance_time[number] < 0.0 || machine -> feeder_parts_per_reel[number] < 0) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+            else feeder_tape_defined[number] = TRUE;
+        }
+        else if (strcmp(keyword, "nozzle") == 0)
+        {
+            if (fscanf(fp, "%i", &number) != 1 || number < 0) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+            else if (number >= MAX_NUMBER_OF_NOZZLES) res = MACHINE_CONFIG_FILE_HAS_TOO_MANY_ENTRIES;
+            else if (fscanf(fp, "%9s %lf %lf", machine -> nozzle_name[number], &machine -> nozzle_x_offset[number], &machine -> nozzle_y_offset[number]) != 3) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+            else
+            {
+                nozzle_defined[number] = TRUE;
+                if (number > highest_nozzle) highest_nozzle = number;
+            }
+        }
+        else if (strcmp(keyword, "nozzle_type") == 0)
+        {
+            if (fscanf(fp, "%i", &number) != 1 || number < 0) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+            else if (number >= MAX_NUMBER_OF_NOZZLES) res = MACHINE_CONFIG_FILE_HAS_TOO_MANY_ENTRIES;
+            else if (fscanf(fp, "%9s", machine -> nozzle_type[number]) != 1) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+            else nozzle_type_defined[number] = TRUE;
+        }
+        else if (strcmp(keyword, "lookup_camera") == 0)
+        {
+            if (fscanf(fp, "%lf %lf", &machine -> lookup_camera_x, &machine -> lookup_camera_y) != 2) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+        }
+        else if (strcmp(keyword, "fiducial") == 0)
+        {
+            if (fscanf(fp, "%i", &number) != 1 || number < 0) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+            else if (number >= MAX_NUMBER_OF_FIDUCIALS) res = MACHINE_CONFIG_FILE_HAS_TOO_MANY_ENTRIES;
+            else if (fscanf(fp, "%lf %lf", &machine -> fiducial_x[number], &machine -> fiducial_y[number]) != 2) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+            else
+            {
+                fiducial_defined[number] = TRUE;
+                if (number > highest_fiducial) highest_fiducial = number;
+            }
+        }
+        else if (strcmp(keyword, "board_load_error") == 0)
+        {
+            if (fscanf(fp, "%lf %lf %lf", &machine -> board_max_offset, &machine -> board_max_rotation, &machine -> board_max_scale_error) != 3
+                || machine -> board_max_offset < 0.0 || machine -> board_max_rotation < 0.0 || machine -> board_max_scale_error < 0.0) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+        }
+        else if (strcmp(keyword, "placement_tolerance") == 0)
+        {
+            if (fscanf(fp, "%lf %lf", &machine -> placement_tolerance, &machine -> rotation_tolerance) != 2
+                || machine -> placement_tolerance <= 0.0 || machine -> rotation_tolerance <= 0.0) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+        }
+        else if (strcmp(keyword, "correction_band") == 0)
+        {
+            char footprint[FOOTPRINT_NAME_LENGTH];
+            int band = 0;
+
+            if (fscanf(fp, "%9s %lf", footprint, &value) != 2 || value < 0.0) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+            else if (strcmp(footprint, "*") == 0) machine -> rotation_correction_band = value;
+            else
+            {   /* a footprint given again replaces its band */
+                while (band < machine -> number_of_correction_bands && strcmp(machine -> correction_band_footprint[band], footprint) != 0) band++;
+                if (band == MAX_NUMBER_OF_CORRECTION_BANDS) res = MACHINE_CONFIG_FILE_HAS_TOO_MANY_ENTRIES;
+                else
+                {
+                    strcpy(machine -> correction_band_footprint[band], footprint);
+                    machine -> correction_band[band] = value;
+                    if (band == machine -> number_of_correction_bands) machine -> number_of_correction_bands++;
+                }
+            }
+        }
+        else if (strcmp(keyword, "lookup_camera_fly_over") == 0)
+        {
+            if (fscanf(fp, "%i", &machine -> lookup_camera_fly_over) != 1
+                || (machine -> lookup_camera_fly_over != TRUE && machine -> lookup_camera_fly_over != FALSE)) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+        }
+        else
+        {   /* the remaining settings are all a single positive value */
+            double *setting = NULL;
+            if (strcmp(keyword, "head_full_speed") == 0) setting = &machine -> head_full_speed;
+            else if (strcmp(keyword, "nozzle_rotate_speed") == 0) setting = &machine -> nozzle_rotate_speed;
+            else if (strcmp(keyword, "nozzle_lower_time") == 0) setting = &machine -> nozzle_lower_time;
+            else if (strcmp(keyword, "nozzle_raise_time") == 0) setting = &machine -> nozzle_raise_time;
+            else if (strcmp(keyword, "vacuum_apply_time") == 0) setting = &machine -> vacuum_apply_time;
+            else if (strcmp(keyword, "vacuum_release_time") == 0) setting = &machine -> vacuum_release_time;
+            else if (strcmp(keyword, "photo_take_time") == 0) setting = &machine -> photo_take_time;
+            else if (strcmp(keyword, "pcb_load_unload_time") == 0) setting = &machine -> pcb_load_unload_time;
+            else if (strcmp(keyword, "splice_time") == 0) setting = &machine -> splice_time;
+            else if (strcmp(keyword, "lookup_camera_window") == 0) setting = &machine -> lookup_camera_window;
+            else if (strcmp(keyword, "lookdown_camera_window") == 0) setting = &machine -> lookdown_camera_window;
+
+            if (setting == NULL || fscanf(fp, "%lf", &value) != 1 || value < 0.0) res = MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+            else *setting = value;
+        }
+    }
+    fclose(fp);
+    if (res != MACHINE_CONFIG_FILE_PRESENT_AND_READ) return res;
+
+    /* feeder and nozzle lines replace the defaults and must be numbered without gaps */
+    if (highest_feeder >= 0)
+    {
+        for (int i = 0; i <= highest_feeder; i++)
+        {
+            if (feeder_defined[i] == FALSE) return MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+        }
+        machine -> number_of_feeders = highest_feeder + 1;
+    }
+    for (int i = machine -> number_of_feeders; i < MAX_NUMBER_OF_FEEDERS; i++)
+    {   /* tape can only be given for a feeder that is fitted */
+        if (feeder_tape_defined[i] == TRUE) return MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+    }
+    if (highest_nozzle >= 0)
+    {
+        for (int i = 0; i <= highest_nozzle; i++)
+        {
+            if (nozzle_defined[i] == FALSE) return MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+        }
+        machine -> number_of_nozzles = highest_nozzle + 1;
+    }
+    for (int i = machine -> number_of_nozzles; i < MAX_NUMBER_OF_NOZZLES; i++)
+    {   /* a type can only be given for a nozzle that is fitted */
+        if (nozzle_type_defined[i] == TRUE) return MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+    }
+    for (int i = 0; i <= highest_fiducial; i++)
+    {
+        if (fiducial_defined[i] == FALSE) return MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+    }
+    machine -> number_of_fiducials = highest_fiducial + 1;
+    if (machine -> head_full_speed <= 0.0 || machine -> nozzle_rotate_speed <= 0.0) return MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+    if (machine -> rotation_correction_band >= machine -> rotation_tolerance) return MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+    for (int i = 0; i < machine -> number_of_correction_bands; i++)
+    {
+        if (machine -> correction_band[i] >= machine -> rotation_tolerance) return MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE;
+    }
+
+    return MACHINE_CONFIG_FILE_PRESENT_AND_READ;
+
+}
+
+/*
+ Function: getTimeScale
+ ----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets how many times faster than real time the simulation runs, 1 unless the TIME_SCALE_ENV environment
+ variable gives a number from 1 to MAX_TIME_SCALE. The simulator and controller must both run at the same
+ scale, so it is read from the environment they share rather than the machine config file.
+ Argument(s): none
+ Return Value: the time scale
+ Usage: double time_scale = getTimeScale();
+ */
+double getTimeScale()
+{
+
+    const char *value = getenv(TIME_SCALE_ENV);
+    double time_scale;
+
+    if (value == NULL || sscanf(value, "%lf", &time_scale) != 1 || time_scale < 1.0) return 1.0;
+    if (time_scale > MAX_TIME_SCALE) return MAX_TIME_SCALE;
+    return time_scale;
+
+}
+
+/*
+ Function: sleepSimulatedTime
+ ----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: puts the calling thread to sleep for the real time that a period of simulated time takes at the time scale
+ Argument(s):
+ double seconds - the simulated time in seconds
+ Return Value: none
+ Usage: sleepSimulatedTime((double) 1 / POLL_LOOP_RATE);
+ */
+void sleepSimulatedTime(double seconds)
+{
+
+    static double time_scale = 0.0;
+    struct timespec ts;
+
+    if (time_scale == 0.0) time_scale = getTimeScale();
+    seconds /= time_scale;
+    ts.tv_sec = (time_t) seconds;
+    ts.tv_nsec = (long) ((seconds - ts.tv_sec) * 1000000000.0);
+    nanosleep(&ts, NULL);
+
+}
+
+/*
+ Function: waitAtStartupBarrier
+ ------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ called by the simulator and by the controller once its shared memory, pipes and (for the controller) board
+ are ready, and returns when both are. Each arrival is counted in shared memory, and the last to arrive
+ posts the semaphore once for every party, itself included, so neither waits any longer than it must.
+ The process starting them must clear parties_ready and create the semaphore at 0 first.
+ Argument(s):
+ PnP *pnp - the shared memory segment
+ sem_t *sem_Startup - the semaphore the parties wait on
+ Return Value: none
+ Usage: waitAtStartupBarrier(pnp, sem_Startup);
+ */
+void waitAtStartupBarrier(PnP *pnp, sem_t *sem_Startup)
+{
+
+    if (__sync_add_and_fetch(&pnp -> parties_ready, 1) == NUMBER_OF_STARTUP_PARTIES)
+    {
+        for (int i = 0; i < NUMBER_OF_STARTUP_PARTIES; i++) sem_post(sem_Startup);
+    }
+    sem_wait(sem_Startup);
+
+}
+
+/*
+ Function: getInstructionName
+ ----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ gets the name of an instruction, for display purposes and metric labels
+ Argument(s):
+ int instruction - the instruction, e.g. MOVE_HEAD
+ Return Value: the name of the instruction, else "UNKNOWN"
+ Usage: sprintf(str, "%s", getInstructionName(plan.step[i].instruction));
+ */
+const char *getInstructionName(int instruction)
+{
+    static const char instruction_name[NUMBER_OF_INSTRUCTIONS][21] = {"NO_INSTRUCTION", "MOVE_HEAD", "ROTATE_NOZZLE", "LOWER_NOZZLE",
+                                                                      "RAISE_NOZZLE", "APPLY_VACUUM", "RELEASE_VACUUM", "TAKE_PHOTO",
+                                                                      "AMEND_HEAD_POSITION", "LOAD_PCB", "UNLOAD_PCB", "MOVE_HEAD_VIA_CAMERA",
+                                                                      "MOVE_CORRECT_LOWER", "RUN_PROGRAM"};
+
+    if (instruction < NO_INSTRUCTION || instruction > RUN_PROGRAM) return "UNKNOWN";
+    return instruction_name[instruction];
+}
+
+/*
+ Function: getExecutablePath
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ finds the executable of one of the tools, e.g. for Startup to run its children. It is looked for in the
+ directory given by the PNP_BIN_DIR environment variable if set, else beside the running executable (as the
+ native build lays them out), and failing that in the Code::Blocks project layout.
+ Argument(s):
+ const char *name - the name of the executable, e.g. "Assgn2_2024_Simulator"
+ const char *codeblocks_path - where the Code::Blocks build puts it, relative to the calling project
+ char *path - receives the path of the executable, PATH_MAX characters long
+ Return Value: none
+ Usage: getExecutablePath("Assgn2_2024_Simulator", "../Assgn2_2024_Simulator/bin/Release/Assgn2_2024_Simulator", sim_path);
+ */
+void getExecutablePath(const char *name, const char *codeblocks_path, char *path)
+{
+
+    const char *bin_dir = getenv(BIN_DIR_ENV);
+    char self[PATH_MAX];
+    ssize_t length;
+
+    if (bin_dir != NULL && bin_dir[0] != '\0')
+    {
+        snprintf(path, PATH_MAX, "%s/%s", bin_dir, name);
+        return;
+    }
+
+    length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (length > 0)
+    {
+        self[length] = '\0';
+        char *last_slash = strrchr(self, '/');
+        if (last_slash != NULL)
+        {
+            *last_slash = '\0';
+            if (snprintf(path, PATH_MAX, "%s/%s", self, name) < PATH_MAX && access(path, X_OK) == 0) return;
+        }
+    }
+
+    snprintf(path, PATH_MAX, "%s", codeblocks_path);
+
+}
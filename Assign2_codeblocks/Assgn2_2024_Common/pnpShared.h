@@ -0,0 +1,573 @@
+/*
+ *
+ * pnpShared.h - declarations shared by the pick and place machine simulator and controller,
+ * including the layout of the shared memory segment and the machine description
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#ifndef PNP_SHARED_H
+#define PNP_SHARED_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <semaphore.h>
+
+#define SHARED_MEMORY_NAME "/pnp_shared"   // shared memory object used by a simulator or controller started on its own
+#define SHARED_MEMORY_FD_ENV "PNP_SHM_FD"   // environment variable giving the shared memory segment inherited from Startup or the harness
+#define MACHINE_CONFIG_FILE "machine.txt"
+#define MACHINE_CONFIG_FILE_ENV "PNP_MACHINE_FILE"   // environment variable which overrides MACHINE_CONFIG_FILE
+#define COMPONENT_LIBRARY_FILE "components.txt"
+#define COMPONENT_LIBRARY_FILE_ENV "PNP_COMPONENT_LIBRARY"  // environment variable which overrides COMPONENT_LIBRARY_FILE
+#define TIME_SCALE_ENV "PNP_TIME_SCALE"              // environment variable running the simulation this many times faster than real time
+#define MAX_TIME_SCALE 1000.0
+#define SIMULATION_SEED_ENV "PNP_SEED"               // environment variable seeding the simulated pick, preplace and board errors, else from the clock
+#define SHARED_MEMORY_OPTIONS_ENV "PNP_SHM_OPTIONS"  // environment variable listing mapping options, any of "populate,lock,hugetlb"
+#define BIN_DIR_ENV "PNP_BIN_DIR"                    // environment variable giving the directory holding the executables of the tools
+
+/*
+ * The shared memory segment is laid out so that data written by the controller, data the simulator rewrites
+ * every poll loop and data it writes as each instruction finishes are in separate cache lines, and neither
+ * process's writes invalidate the lines the other is writing. 128 bytes covers the pairs of 64 byte lines
+ * that some processors fetch together.
+ */
+#define PNP_LAYOUT_VERSION 7              // bump whenever a field of PnP is added, removed or moved
+#define PNP_CACHE_LINE_SIZE 128
+#define PNP_CACHE_ALIGNED _Alignas(PNP_CACHE_LINE_SIZE)
+
+#define SHARED_MEMORY_POPULATE 1          // fault the whole segment in when it is mapped
+#define SHARED_MEMORY_LOCK 2              // lock it into RAM so it is never paged out
+#define SHARED_MEMORY_HUGETLB 4           // back it with huge pages where the mapping allows
+
+/* written by the simulator to the Display as it terminates, and read back by the throughput harness */
+#define SIMULATION_SUMMARY_FORMAT "Time: %7.2f  Simulation summary: %d parts placed, %d dropped, PCB loaded at %.2f and unloaded at %.2f\n"
+#define SIMULATION_SUMMARY_SCAN_FORMAT "Time: %lf  Simulation summary: %d parts placed, %d dropped, PCB loaded at %lf and unloaded at %lf"
+#define NUMBER_OF_FIELDS_IN_SIMULATION_SUMMARY 5
+#define NO_PCB_TIME -1.0                             // the PCB has not been loaded, or not unloaded
+
+#define NO_INSTRUCTION_HOLD -1.0                     // the instruction is taken as soon as the simulator is free
+
+#define NUMBER_OF_STARTUP_PARTIES 2                  // the simulator and controller meet at the startup barrier before either begins
+
+/*
+ * Log messages for the Display go through a ring of message slots in a shared memory segment of their own,
+ * created by Startup, rather than through pipes. The simulator, controller and Startup each write a whole
+ * message into a slot and never wait: when the ring is full the message is dropped and counted, so a slow
+ * Display cannot hold up the simulator. The Display prints straight out of the slots and frees them, and
+ * sleeps on the LOG_DOORBELL semaphore when the ring is empty, which writers only post when it is asleep.
+ */
+#define LOG_RING_FD_ENV "PNP_LOG_FD"   // environment variable giving the log ring segment inherited from Startup
+#define LOG_DOORBELL "/sem_Display"
+#define LOG_RING_SIZE 1024             // message slots, a power of two
+#define LOG_MESSAGE_SIZE 240           // longest message, with its terminating null
+#define LOG_SLOT_TIMEOUT 1.0           // wall seconds before a slot claimed by a writer that never finished it is skipped
+#define LOG_SLOT_POISONED(position) ((position) + LOG_RING_SIZE - 1)  // sequence of a skipped slot, which no writer can claim
+
+#define LOG_MAX_DECIMALS 9              // most decimal places written by addLogFixed
+#define LOG_MAX_FIXED 1e18             // values scaling to this or more are written by snprintf instead
+#define LOG_NUMBER_SIZE 32             // longest number written by addLogInteger or addLogFixed
+
+#define LOG_SOURCE_STARTUP 0
+#define LOG_SOURCE_SIMULATOR 1
+#define LOG_SOURCE_CONTROLLER 2
+#define NUMBER_OF_LOG_SOURCES 3
+
+#define MACHINE_CONFIG_FILE_PRESENT_AND_READ 0
+#define MACHINE_CONFIG_FILE_NOT_PRESENT -1
+#define MACHINE_CONFIG_FILE_PRESENT_BUT_CONTENT_ISSUE -2
+#define MACHINE_CONFIG_FILE_HAS_TOO_MANY_ENTRIES -3
+
+#define COMPONENT_LIBRARY_FILE_PRESENT_AND_READ 0
+#define COMPONENT_LIBRARY_FILE_NOT_PRESENT -1
+#define COMPONENT_LIBRARY_FILE_PRESENT_BUT_CONTENT_ISSUE -2
+#define COMPONENT_LIBRARY_FILE_HAS_TOO_MANY_ENTRIES -3
+
+#define MAX_NUMBER_OF_COMPONENTS_TO_PLACE 100
+#define COMPONENT_DESIGNATION_LENGTH 10
+
+#define TRUE 1
+#define FALSE 0
+
+#define MAX_NUMBER_OF_FEEDERS 256        // upper limit for a feeder bank, the actual number is read from the machine config file
+#define NO_PICKED_PART -1
+#define NO_TAPE_FEEDER_AT_THIS_LOCATION -1
+#define FEEDER_PARTS_UNLIMITED -1        // parts_remaining of a feeder that never runs out
+
+#define FEEDER_EVENT_QUEUE_LENGTH 32     // feeder events kept in shared memory for the controller to read
+#define FEEDER_EVENT_EMPTY 1             // the last part on a reel has been picked
+#define FEEDER_EVENT_SPLICED 2           // a new reel has been spliced onto an empty feeder
+
+#define MAX_NUMBER_OF_NOZZLES 12         // upper limit for a turret head, the actual number is read from the machine config file
+#define NOZZLE_NAME_LENGTH 10
+
+#define MAX_NUMBER_OF_FIDUCIALS 4        // board fiducials given in the machine config file
+#define MAX_NUMBER_OF_CORRECTION_BANDS 16  // footprints given their own rotation correction band in the machine config file
+#define FOOTPRINT_NAME_LENGTH 10           // as in the centroid file
+#define MAX_NUMBER_OF_PACKAGES 32          // footprints described by the component library file
+#define NO_PACKAGE -1                      // a footprint not in the component library, timed and handled as the machine defaults
+#define VISION_FLY_OVER 0                  // the part can be photographed by the lookup camera in flight
+#define VISION_STATIONARY 1                // the part is too large for the strobed camera, so the head must stop over it
+#define NO_FIDUCIAL -1
+
+#define BOARD_TRANSFORM_FITTED 0
+#define BOARD_TRANSFORM_DEGENERATE -1    // fewer than two distinct fiducials
+
+#define PHOTO_LOOKUP 0
+#define PHOTO_LOOKDOWN 1
+
+#define NO_INSTRUCTION 0
+#define MOVE_HEAD 1
+#define ROTATE_NOZZLE 2
+#define LOWER_NOZZLE 3
+#define RAISE_NOZZLE 4
+#define APPLY_VACUUM 5
+#define RELEASE_VACUUM 6
+#define TAKE_PHOTO 7
+#define AMEND_HEAD_POSITION 8
+#define LOAD_PCB 9
+#define UNLOAD_PCB 10
+#define MOVE_HEAD_VIA_CAMERA 11          // move the head, sweeping the nozzles over the lookup camera in flight on the way
+#define MOVE_CORRECT_LOWER 12            // move the head, take a lookdown photo, correct the head position and lower a nozzle in one instruction
+#define RUN_PROGRAM 13                   // run the micro-program in the program area of shared memory
+#define NUMBER_OF_INSTRUCTIONS (RUN_PROGRAM + 1)
+
+#define MAX_SEQUENCE_LENGTH 8            // steps in an instruction the simulator carries out as a sequence of simpler instructions
+#define NO_SEQUENCE_STEP -1
+#define SEQUENCE_STEP_NOT_RUN 0
+#define SEQUENCE_STEP_DONE 1
+#define SEQUENCE_STEP_REJECTED -1        // the step was not valid, so it and the rest of the sequence were not carried out
+
+/*
+ * A micro-program is a list of steps, each either one of the instructions above (other than RUN_PROGRAM)
+ * or one of the opcodes below, which the simulator carries out without waiting for the controller in between
+ */
+#define MAX_PROGRAM_LENGTH 64
+#define MAX_PROGRAM_STEPS_EXECUTED 4096   // a program still running after this many steps is stopped as faulty
+#define PROGRAM_END 20
+#define PROGRAM_JUMP 21                   // jump to step target
+#define PROGRAM_JUMP_IF_REJECTED 22       // jump to step target if the simulator rejected the last instruction
+#define PROGRAM_JUMP_IF_NOZZLE_EMPTY 23   // jump to step target if nozzle argument_3 is not holding a part
+#define PROGRAM_WAIT_FOR_FEEDER 24        // wait until feeder argument_3 has a part in the pick position
+#define PROGRAM_SET_INDEX 25              // set the index register to argument_3
+#define PROGRAM_LOOP 26                   // add 1 to the index register, then jump to step target if it is less than argument_3
+#define PROGRAM_INDEX -1000               // as argument_3 of any step, stands for the value of the index register
+
+#define PROGRAM_IDLE 0
+#define PROGRAM_RUNNING 1
+#define PROGRAM_WAITING 2                 // held at a PROGRAM_WAIT_FOR_FEEDER step
+#define PROGRAM_FINISHED 3
+#define PROGRAM_FAULTED -1                // not a valid program, or stopped part way through
+
+/*
+ * Running totals kept in shared memory for the metrics endpoint of Startup. The handshake latency is the
+ * simulation time from the simulator finishing an instruction to it taking the controller's next one, counted
+ * in buckets of at most HANDSHAKE_BUCKET_LIMITS seconds, with a last bucket for anything longer.
+ */
+#define NUMBER_OF_HANDSHAKE_BUCKETS 7
+#define HANDSHAKE_BUCKET_LIMITS {0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0}
+#define MAX_CONTROLLER_STATES 32
+#define CONTROLLER_STATE_NAME_LENGTH 20
+#define NO_CONTROLLER_STATE -1
+
+/* the original machine, used for anything not given in the machine config file */
+#define DEFAULT_HOME_X 0.0
+#define DEFAULT_HOME_Y 0.0
+#define DEFAULT_MIN_X -200.0
+#define DEFAULT_MIN_Y -200.0
+#define DEFAULT_MAX_X +1000.0
+#define DEFAULT_MAX_Y +1000.0
+#define DEFAULT_NUMBER_OF_FEEDERS 10
+#define DEFAULT_FIRST_FEEDER_X +50.0
+#define DEFAULT_FEEDER_X_SEPARATION 100.0
+#define DEFAULT_FEEDER_Y -100.0
+#define DEFAULT_FEEDER_PITCH 4.0          // 4 mm between parts on 8 mm tape
+#define DEFAULT_FEEDER_ADVANCE_TIME 0.08  // 0.08 seconds to index the tape to the next part after a pick
+#define DEFAULT_FEEDER_PARTS_PER_REEL 0   // 0 is an endless reel, the feeder never runs out
+#define DEFAULT_SPLICE_TIME 20.0          // 20 seconds for the operator to splice a new reel onto an empty feeder
+#define DEFAULT_NUMBER_OF_NOZZLES 3      // left, centre and right nozzles
+#define DEFAULT_NOZZLE_X_SEPARATION 20
+#define DEFAULT_LOOKUP_CAMERA_X -100
+#define DEFAULT_LOOKUP_CAMERA_Y +100
+#define DEFAULT_LOOKUP_CAMERA_WINDOW 5.0  // a nozzle passing within 5 units of the lookup camera is in its field of view
+#define DEFAULT_LOOKUP_CAMERA_FLY_OVER FALSE // the original camera can only photograph a stationary head
+#define DEFAULT_LOOKDOWN_CAMERA_WINDOW 15.0 // a fiducial within 15 units of the head centre is in view of the lookdown camera
+#define DEFAULT_NUMBER_OF_FIDUCIALS 0     // no fiducials, every placement needs its own lookdown photo
+#define DEFAULT_BOARD_MAX_OFFSET 0.0      // the original board always loads exactly in position
+#define DEFAULT_BOARD_MAX_ROTATION 0.0
+#define DEFAULT_BOARD_MAX_SCALE_ERROR 0.0
+#define DEFAULT_HEAD_FULL_SPEED 1000.0    // 1000 units per second
+#define DEFAULT_NOZZLE_ROTATE_SPEED 360.0 // 360 degrees per second
+#define DEFAULT_NOZZLE_LOWER_TIME 0.1     // 0.1 seconds
+#define DEFAULT_NOZZLE_RAISE_TIME 0.1     // 0.1 seconds
+#define DEFAULT_VACUUM_APPLY_TIME 0.05    // 0.05 seconds
+#define DEFAULT_VACUUM_RELEASE_TIME 0.05  // 0.05 seconds
+#define DEFAULT_PHOTO_TAKE_TIME 0.05      // 0.05 seconds
+#define DEFAULT_PCB_LOAD_UNLOAD_TIME 1.5  // 1.5 seconds
+#define DEFAULT_PLACEMENT_TOLERANCE 0.1   // a part within 0.1 units of its target in x and y...
+#define DEFAULT_ROTATION_TOLERANCE 1.0    // ...and 1 degree of its rotation is placed within specification
+#define DEFAULT_ROTATION_CORRECTION_BAND 0.25  // rotations of less than a quarter of a degree are left uncorrected
+
+typedef struct
+{
+    double home_x;
+    double home_y;
+    double min_x;
+    double min_y;
+    double max_x;
+    double max_y;
+    int number_of_feeders;
+    double feeder_x[MAX_NUMBER_OF_FEEDERS];
+    double feeder_y[MAX_NUMBER_OF_FEEDERS];
+    double feeder_pitch[MAX_NUMBER_OF_FEEDERS];
+    double feeder_advance_time[MAX_NUMBER_OF_FEEDERS];
+    int feeder_parts_per_reel[MAX_NUMBER_OF_FEEDERS];
+    double splice_time;
+    int number_of_nozzles;
+    char nozzle_name[MAX_NUMBER_OF_NOZZLES][NOZZLE_NAME_LENGTH];
+    char nozzle_type[MAX_NUMBER_OF_NOZZLES][NOZZLE_NAME_LENGTH];  // the tip fitted, empty for one that carries any part
+    double nozzle_x_offset[MAX_NUMBER_OF_NOZZLES];
+    double nozzle_y_offset[MAX_NUMBER_OF_NOZZLES];
+    double lookup_camera_x;
+    double lookup_camera_y;
+    double lookup_camera_window;
+    int lookup_camera_fly_over;
+    double lookdown_camera_window;
+    int number_of_fiducials;
+    double fiducial_x[MAX_NUMBER_OF_FIDUCIALS];    // in board coordinates
+    double fiducial_y[MAX_NUMBER_OF_FIDUCIALS];
+    double board_max_offset;                       // largest error in x and y of the board as loaded
+    double board_max_rotation;                     // degrees
+    double board_max_scale_error;                  // fraction, e.g. 0.001 for 0.1% stretch
+    double head_full_speed;
+    double nozzle_rotate_speed;
+    double nozzle_lower_time;
+    double nozzle_raise_time;
+    double vacuum_apply_time;
+    double vacuum_release_time;
+    double photo_take_time;
+    double pcb_load_unload_time;
+    double placement_tolerance;                    // the specification limits placements are judged against
+    double rotation_tolerance;                     // degrees
+    double rotation_correction_band;               // degrees, the controller skips smaller rotations, for footprints without a band of their own
+    int number_of_correction_bands;
+    char correction_band_footprint[MAX_NUMBER_OF_CORRECTION_BANDS][FOOTPRINT_NAME_LENGTH];
+    double correction_band[MAX_NUMBER_OF_CORRECTION_BANDS];
+
+} MachineConfig;
+
+/* the handling of one footprint, as described by the component library file */
+typedef struct
+{
+    char footprint[FOOTPRINT_NAME_LENGTH];
+    double pick_z_time;          // seconds for each lower and raise of the nozzle picking the part from its feeder
+    double place_z_time;         // seconds for each lower and raise placing it on the board
+    double vacuum_dwell;         // seconds for the vacuum to seal on the part when picked, and to let go of it when placed
+    unsigned int nozzles;        // bit n set if nozzle n of the machine can carry the part
+    int vision;                  // VISION_FLY_OVER or VISION_STATIONARY
+
+} ComponentPackage;
+
+/* footprints are interned as the index of their package, so nothing is looked up by name once a board is read */
+typedef struct
+{
+    int number_of_packages;
+    ComponentPackage package[MAX_NUMBER_OF_PACKAGES];
+
+} ComponentLibrary;
+
+/* machine position = scale * rotation(board position) + offset, rotating about the board origin */
+typedef struct
+{
+    double offset_x;
+    double offset_y;
+    double rotation;         // degrees
+    double scale;
+
+} BoardTransform;
+
+/* a placement on the board, as read from the centroid file, in board coordinates */
+typedef struct
+{
+    char designation[COMPONENT_DESIGNATION_LENGTH];
+    double x;
+    double y;
+    double theta;
+    int feeder;
+
+} PlacementTarget;
+
+typedef struct
+{
+    int parts_remaining;     // parts left on the reel, 0 while waiting for a splice, or FEEDER_PARTS_UNLIMITED
+    double ready_time;       // simulation time at which the next part is in the pick position
+    int number_of_picks;
+    int number_of_splices;
+
+} FeederStatus;
+
+typedef struct
+{
+    int type;                // FEEDER_EVENT_EMPTY or FEEDER_EVENT_SPLICED
+    int feeder;
+    double time;
+
+} FeederEvent;
+
+typedef struct
+{
+    int number_of_steps;
+    int instruction[MAX_SEQUENCE_LENGTH];
+    int result[MAX_SEQUENCE_LENGTH];         // SEQUENCE_STEP_NOT_RUN, SEQUENCE_STEP_DONE or SEQUENCE_STEP_REJECTED
+    double finish_time[MAX_SEQUENCE_LENGTH];
+
+} SequenceReport;
+
+typedef struct
+{
+    int opcode;              // an instruction, e.g. LOWER_NOZZLE, or a program opcode, e.g. PROGRAM_LOOP
+    double argument_1;       // the instruction arguments, as they would be passed in shared memory
+    double argument_2;
+    int argument_3;
+    int target;              // the step jumped to by PROGRAM_JUMP, PROGRAM_JUMP_IF_... and PROGRAM_LOOP
+
+} ProgramStep;
+
+typedef struct
+{
+    int length;                          // written by the controller, with the steps, before RUN_PROGRAM
+    ProgramStep step[MAX_PROGRAM_LENGTH];
+    int status;                          // written by the simulator, PROGRAM_IDLE, PROGRAM_RUNNING, ...
+    int program_counter;
+    int steps_executed;
+    int instructions_rejected;
+
+} ProgramArea;
+
+typedef struct
+{
+    unsigned long parts_placed;
+    unsigned long parts_dropped;
+    unsigned long boards_completed;                         // PCBs unloaded
+    unsigned long instruction_count[NUMBER_OF_INSTRUCTIONS]; // instructions carried out, including the steps of sequences and programs
+    double instruction_time[NUMBER_OF_INSTRUCTIONS];         // simulation seconds spent carrying them out
+    unsigned long handshake_count;
+    double handshake_time;                                   // simulation seconds, summed over handshake_count
+    unsigned long handshake_bucket[NUMBER_OF_HANDSHAKE_BUCKETS + 1];
+
+} SimulatorStats;
+
+typedef struct
+{
+    int number_of_states;                // published once, with the state names
+    char state_name[MAX_CONTROLLER_STATES][CONTROLLER_STATE_NAME_LENGTH];
+    int state;                           // the current state, or NO_CONTROLLER_STATE
+    double state_time[MAX_CONTROLLER_STATES];  // simulation seconds spent in each state
+
+} ControllerStats;
+
+typedef struct
+{
+    /* written by whichever process creates the segment, see initialisePnP */
+    unsigned int layout_version;         // PNP_LAYOUT_VERSION
+    unsigned int layout_size;            // sizeof(PnP), which also catches builds with different limits
+
+    /* written by the controller: the instruction slot, its heartbeat and the quit flag */
+    PNP_CACHE_ALIGNED int instruction_to_execute;
+    double instruction_argument_1;
+    double instruction_argument_2;
+    int instruction_argument_3;
+    double instruction_not_before;       // the instruction is only taken after this simulation time when replaying a recording, else NO_INSTRUCTION_HOLD
+    int quit;
+    unsigned int controller_heartbeat;
+
+    /* written by the simulator on every poll loop */
+    PNP_CACHE_ALIGNED double sim_time;
+    unsigned int simulator_heartbeat;    // bumped every poll loop, so the supervisor in Startup can tell a stalled process from a busy one
+
+    /* written by the simulator as each instruction finishes */
+    PNP_CACHE_ALIGNED int ready_for_next_instruction;  // also cleared by the controller as it issues an instruction
+    double theta_pick_error[MAX_NUMBER_OF_NOZZLES];
+    double x_preplace_error;
+    double y_preplace_error;
+    double head_x;
+    double head_y;
+    int fiducial_in_view;    // the fiducial seen by the last lookdown photo, or NO_FIDUCIAL
+    double fiducial_offset_x;
+    double fiducial_offset_y;
+    SequenceReport sequence_report;  // the outcome of each step of the last sequence instruction
+
+    /* the startup barrier, counted up by each process as it arrives */
+    PNP_CACHE_ALIGNED int parties_ready;
+
+    /* written by the simulator once, as it starts */
+    PNP_CACHE_ALIGNED int machine_config_published;
+    MachineConfig machine;
+    ComponentLibrary library;
+    unsigned int random_seed;            // the seed of the simulated errors, kept with a recording so it can be replayed
+
+    /* written by the simulator as feeders are picked from and spliced */
+    PNP_CACHE_ALIGNED int number_of_feeder_events;           // total events posted, the latest is at (number_of_feeder_events - 1) % FEEDER_EVENT_QUEUE_LENGTH
+    FeederEvent feeder_event[FEEDER_EVENT_QUEUE_LENGTH];
+    FeederStatus feeder_status[MAX_NUMBER_OF_FEEDERS];
+
+    /* written by the controller before RUN_PROGRAM, then reported on by the simulator */
+    PNP_CACHE_ALIGNED ProgramArea program;
+
+    /* written by the controller once, before the startup barrier: the board it is going to place */
+    PNP_CACHE_ALIGNED int number_of_targets;
+    PlacementTarget target[MAX_NUMBER_OF_COMPONENTS_TO_PLACE];
+    int feeder_package[MAX_NUMBER_OF_FEEDERS];   // the package loaded on each feeder, for the simulator's timings, else NO_PACKAGE
+
+    /* running totals for the metrics endpoint, written by the simulator and the controller respectively */
+    PNP_CACHE_ALIGNED SimulatorStats simulator_stats;
+    PNP_CACHE_ALIGNED ControllerStats controller_stats;
+
+} PnP;
+
+typedef struct
+{
+    volatile unsigned long sequence;     // the position of the slot while free, position + 1 once written, LOG_SLOT_POISONED if skipped
+    volatile int writer;                 // process id of the writer that claimed it, 0 while free
+    short source;                        // LOG_SOURCE_STARTUP, ...
+    short length;                        // so that a slot is still a whole number of cache lines
+    char text[LOG_MESSAGE_SIZE];
+
+} LogMessage;
+
+typedef struct
+{
+    int length;
+    char text[LOG_MESSAGE_SIZE];         // always null terminated, and cut short rather than overflowed
+
+} LogLine;
+
+typedef struct
+{
+    unsigned int layout_size;            // sizeof(LogRing)
+
+    /* claimed by the writers */
+    PNP_CACHE_ALIGNED volatile unsigned long tail;                   // the position the next message is written at
+    volatile unsigned long dropped[NUMBER_OF_LOG_SOURCES];           // messages dropped as the ring was full
+
+    /* written by the Display */
+    PNP_CACHE_ALIGNED volatile unsigned long head;                   // the position of the next message to print
+    volatile unsigned long skipped;                                  // slots skipped after LOG_SLOT_TIMEOUT
+    volatile int display_waiting;        // TRUE while the Display sleeps on the doorbell, cleared by the writer that posts it
+
+    /* written by Startup */
+    PNP_CACHE_ALIGNED volatile int finished;  // TRUE once nothing more will be written
+
+    PNP_CACHE_ALIGNED LogMessage message[LOG_RING_SIZE];
+
+} LogRing;
+
+void setDefaultMachineConfig(MachineConfig*);
+
+const char *getMachineConfigFileName();
+
+int getMachineConfigFileContents(const char*, MachineConfig*);
+
+void setDefaultComponentLibrary(ComponentLibrary*);
+
+const char *getComponentLibraryFileName();
+
+int getComponentLibraryFileContents(const char*, const MachineConfig*, ComponentLibrary*);
+
+int findComponentPackage(const ComponentLibrary*, const char*);
+
+double getPackageInstructionTime(const ComponentLibrary*, const MachineConfig*, int, int, int);
+
+unsigned int getPackageNozzles(const ComponentLibrary*, const MachineConfig*, int);
+
+int getPackageVision(const ComponentLibrary*, int);
+
+double getTimeScale();
+
+void sleepSimulatedTime(double);
+
+void waitAtStartupBarrier(PnP*, sem_t*);
+
+int getSharedMemoryOptions();
+
+void *mapSharedMemory(int, size_t);
+
+void *createSharedMemory(size_t, int*);
+
+void initialisePnP(PnP*);
+
+int isPnPLayoutValid(const PnP*);
+
+PnP *createPnP();
+
+PnP *openPnP(int);
+
+void removePnP();
+
+void closePnP(PnP*);
+
+LogRing *createLogRing();
+
+LogRing *openLogRing();
+
+void closeLogRing(LogRing*);
+
+int writeLogMessage(LogRing*, int, const char*);
+
+const LogMessage *peekLogMessage(LogRing*);
+
+void releaseLogMessage(LogRing*);
+
+void waitForLogMessage(LogRing*, double);
+
+unsigned long getLogBacklog(const LogRing*);
+
+void finishLogRing(LogRing*);
+
+int isLogRingFinished(const LogRing*);
+
+void openDisplayLog(int, int);
+
+void writeDisplayLog(const char*);
+
+void closeDisplayLog();
+
+void clearLogLine(LogLine*);
+
+void addLogText(LogLine*, const char*);
+
+void addLogString(LogLine*, const char*, int);
+
+void addLogChar(LogLine*, char);
+
+void addLogInteger(LogLine*, long);
+
+void addLogFixed(LogLine*, double, int, int);
+
+void addLogPoint(LogLine*, double, double, int);
+
+void formatLogMessage(LogLine*, double, const char*);
+
+void formatStateLog(LogLine*, double, const char*, const char*);
+
+void formatNozzleLog(LogLine*, double, const char*, const char*);
+
+void formatHeadMoveLog(LogLine*, double, double, double, double, double, const char*);
+
+const char *getInstructionName(int);
+
+void getExecutablePath(const char*, const char*, char*);
+
+void setIdentityBoardTransform(BoardTransform*);
+
+void boardToMachine(const BoardTransform*, double, double, double*, double*);
+
+void machineToBoard(const BoardTransform*, double, double, double*, double*);
+
+int fitBoardTransform(const double[], const double[], const double[], const double[], int, BoardTransform*);
+
+#endif
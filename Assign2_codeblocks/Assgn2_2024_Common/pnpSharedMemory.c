@@ -0,0 +1,382 @@
+/*
+ *
+ * pnpSharedMemory.c - creates, opens and maps the shared memory segment used by the simulator, controller
+ * and Startup, with the mapping options given in the environment, and initialises and checks the version
+ * of its layout.
+ *
+ * Startup and the harness create the segment as an anonymous memory file (memfd_create, or a POSIX shared
+ * memory object that is unlinked as soon as it is open where there is no memfd_create), so it never touches
+ * a filesystem and is gone when the last process using it exits. Its file descriptor is inherited by the
+ * simulator and controller across fork and exec, and passed to them in SHARED_MEMORY_FD_ENV.
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#define _GNU_SOURCE                 // for memfd_create
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pnpShared.h"
+
+#define SEGMENT_NAME_LENGTH 64
+#define SHARED_MEMORY_RETRY_INTERVAL 10000  // microseconds between looks for a named segment the simulator has not made yet
+
+/*
+ Function: getSharedMemoryOptions
+ --------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the mapping options listed in the SHARED_MEMORY_OPTIONS_ENV environment variable, e.g. "populate,lock".
+ None are used by default, as locking needs a large enough memory lock limit and huge pages need to be reserved.
+ Argument(s): none
+ Return Value: SHARED_MEMORY_POPULATE, SHARED_MEMORY_LOCK and SHARED_MEMORY_HUGETLB or'ed together
+ Usage: if (getSharedMemoryOptions() & SHARED_MEMORY_LOCK) ...
+ */
+int getSharedMemoryOptions()
+{
+
+    const char *value = getenv(SHARED_MEMORY_OPTIONS_ENV);
+    int options = 0;
+
+    if (value == NULL) return 0;
+    if (strstr(value, "populate") != NULL) options |= SHARED_MEMORY_POPULATE;
+    if (strstr(value, "lock") != NULL) options |= SHARED_MEMORY_LOCK;
+    if (strstr(value, "hugetlb") != NULL) options |= SHARED_MEMORY_HUGETLB;
+    return options;
+
+}
+
+/*
+ Function: mapSharedMemory
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ maps a shared memory segment, already sized, with the options from getSharedMemoryOptions. Huge pages are
+ only tried, as not every kind of file can be mapped with them, and the segment is mapped with normal pages
+ if they cannot be had. A segment that cannot be locked is still used, with a warning.
+ Argument(s):
+ int fd - the open shared memory file
+ size_t size - the size of the segment, e.g. sizeof(PnP)
+ Return Value: the mapped segment, else MAP_FAILED with errno set
+ Usage: pnp = mapSharedMemory(fd, sizeof(PnP));
+ */
+void *mapSharedMemory(int fd, size_t size)
+{
+
+    int options = getSharedMemoryOptions(), flags = MAP_SHARED;
+    void *segment = MAP_FAILED;
+
+#ifdef MAP_POPULATE
+    if (options & SHARED_MEMORY_POPULATE) flags |= MAP_POPULATE;
+#endif
+#ifdef MAP_HUGETLB
+    if (options & SHARED_MEMORY_HUGETLB) segment = mmap(0, size, (PROT_READ | PROT_WRITE), flags | MAP_HUGETLB, fd, (off_t)0);
+#endif
+    if (segment == MAP_FAILED) segment = mmap(0, size, (PROT_READ | PROT_WRITE), flags, fd, (off_t)0);
+    if (segment == MAP_FAILED) return MAP_FAILED;
+
+    if ((options & SHARED_MEMORY_LOCK) && mlock(segment, size) != 0)
+    {
+        perror("locking of the shared memory failed, continuing unlocked");
+    }
+    return segment;
+
+}
+
+/*
+ Function: initialisePnP
+ -----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ clears the shared memory segment and marks it with the version and size of the PnP layout it was set up
+ with, so that the processes attaching to it can check they were built with the same layout
+ Argument(s):
+ PnP *pnp - the shared memory segment
+ Return Value: none
+ Usage: initialisePnP(pnp);
+ */
+void initialisePnP(PnP *pnp)
+{
+
+    memset(pnp, 0, sizeof(PnP));
+    pnp -> layout_version = PNP_LAYOUT_VERSION;
+    pnp -> layout_size = sizeof(PnP);
+
+}
+
+/*
+ Function: isPnPLayoutValid
+ --------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ checks that the shared memory segment was set up with the same PnP layout as the caller was built with, so
+ that a simulator and controller built from different versions refuse to run rather than misread each other
+ Argument(s):
+ const PnP *pnp - the shared memory segment, after initialisePnP has been called on it
+ Return Value: TRUE if the layouts match, else FALSE
+ Usage: if (isPnPLayoutValid(pnp) == FALSE) exit(3);
+ */
+int isPnPLayoutValid(const PnP *pnp)
+{
+
+    return pnp -> layout_version == PNP_LAYOUT_VERSION && pnp -> layout_size == sizeof(PnP);
+
+}
+
+/*
+ Function: createSegmentFile
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ creates an anonymous memory file, which is not closed on exec so that it can be inherited. Huge pages are
+ asked for when the SHARED_MEMORY_HUGETLB option is set, and the file is sized up to a whole huge page for them.
+ Where there is no memfd_create, a POSIX shared memory object is created and unlinked straight away instead.
+ Argument(s):
+ size_t segment_size - the size of the segment it is to hold
+ int options - the mapping options from getSharedMemoryOptions
+ off_t *size - receives the size the file must be given
+ Return Value: the file descriptor, else -1 with errno set
+ Usage: fd = createSegmentFile(sizeof(PnP), options, &size);
+ */
+static int createSegmentFile(size_t segment_size, int options, off_t *size)
+{
+
+    int fd = -1;
+
+    *size = segment_size;
+#ifdef MFD_HUGETLB
+    if (options & SHARED_MEMORY_HUGETLB)
+    {
+        struct stat st;
+
+        fd = memfd_create(SHARED_MEMORY_NAME + 1, MFD_HUGETLB);
+        if (fd >= 0 && fstat(fd, &st) == 0)
+        {
+            *size = (segment_size + st.st_blksize - 1) / st.st_blksize * st.st_blksize;  // st_blksize is the huge page size
+            return fd;
+        }
+        if (fd >= 0) close(fd);
+        *size = segment_size;
+    }
+#endif
+#ifdef MFD_CLOEXEC
+    fd = memfd_create(SHARED_MEMORY_NAME + 1, 0);
+#else
+    char name[SEGMENT_NAME_LENGTH];
+
+    snprintf(name, sizeof(name), "%s.%ld", SHARED_MEMORY_NAME, (long) getpid());
+    fd = shm_open(name, (O_CREAT | O_EXCL | O_RDWR), 0600);
+    if (fd >= 0) shm_unlink(name);
+#endif
+    return fd;
+
+}
+
+/*
+ Function: createSharedMemory
+ ----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ creates and maps a new anonymous shared memory segment, to be inherited by the processes started after it.
+ A huge page segment that cannot be mapped, as no huge pages are reserved, is replaced by one with normal pages.
+ Argument(s):
+ size_t size - the size of the segment
+ int *fd - receives its file descriptor
+ Return Value: the mapped segment, filled with zeros, else MAP_FAILED with errno set
+ Usage: ring = createSharedMemory(sizeof(LogRing), &fd);
+ */
+void *createSharedMemory(size_t size, int *fd)
+{
+
+    int options = getSharedMemoryOptions();
+    void *segment = MAP_FAILED;
+    off_t file_size;
+
+    *fd = createSegmentFile(size, options, &file_size);
+    if (*fd >= 0 && ftruncate(*fd, file_size) == 0) segment = mapSharedMemory(*fd, size);
+    if (segment == MAP_FAILED && (options & SHARED_MEMORY_HUGETLB) && *fd >= 0)
+    {
+        close(*fd);
+        *fd = createSegmentFile(size, options & ~SHARED_MEMORY_HUGETLB, &file_size);
+        if (*fd >= 0 && ftruncate(*fd, file_size) == 0) segment = mapSharedMemory(*fd, size);
+    }
+    if (segment == MAP_FAILED && *fd >= 0)
+    {
+        int error = errno;
+
+        close(*fd);
+        errno = error;
+    }
+    return segment;
+
+}
+
+/*
+ Function: createPnP
+ -------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ creates and maps a new shared memory segment for a run, initialises it, and puts its file descriptor in
+ SHARED_MEMORY_FD_ENV for the simulator and controller started after it
+ Argument(s): none
+ Return Value: the mapped segment, else MAP_FAILED with errno set
+ Usage: pnp = createPnP();
+ */
+PnP *createPnP()
+{
+
+    char fd_str[SEGMENT_NAME_LENGTH];
+    PnP *pnp;
+    int fd;
+
+    pnp = createSharedMemory(sizeof(PnP), &fd);
+    if (pnp == MAP_FAILED) return MAP_FAILED;
+
+    initialisePnP(pnp);
+    snprintf(fd_str, sizeof(fd_str), "%d", fd);
+    setenv(SHARED_MEMORY_FD_ENV, fd_str, 1);
+    return pnp;
+
+}
+
+/*
+ Function: openPnP
+ -----------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ maps the shared memory segment created by Startup or the harness, from the file descriptor given in
+ SHARED_MEMORY_FD_ENV. A simulator or controller started on its own, e.g. from the IDE, uses the named
+ POSIX shared memory object SHARED_MEMORY_NAME instead. The simulator creates it afresh, removing any left
+ by an earlier run that did not finish, and removes it again with removePnP; the controller waits for it to
+ be created and sized before mapping it, so it never maps a segment of the wrong size.
+ Argument(s):
+ int create - TRUE for the simulator, which creates and initialises a named segment, else FALSE
+ Return Value: the mapped segment, else MAP_FAILED with errno set
+ Usage: pnp = openPnP(TRUE);
+ */
+PnP *openPnP(int create)
+{
+
+    const char *fd_str = getenv(SHARED_MEMORY_FD_ENV);
+    int fd;
+    struct stat st;
+    PnP *pnp;
+
+    if (fd_str != NULL && sscanf(fd_str, "%d", &fd) == 1)
+    {
+        if (fstat(fd, &st) != 0) return MAP_FAILED;
+        create = FALSE;
+    }
+    else if (create == TRUE)
+    {
+        shm_unlink(SHARED_MEMORY_NAME);
+        fd = shm_open(SHARED_MEMORY_NAME, (O_CREAT | O_EXCL | O_RDWR), 0666);
+        if (fd < 0) return MAP_FAILED;
+        if (ftruncate(fd, sizeof(PnP)) != 0 || fstat(fd, &st) != 0)
+        {
+            int error = errno;
+
+            close(fd);
+            shm_unlink(SHARED_MEMORY_NAME);
+            errno = error;
+            return MAP_FAILED;
+        }
+    }
+    else
+    {
+        /* the simulator may not have created the segment yet, or not yet given it its size */
+        while (TRUE)
+        {
+            fd = shm_open(SHARED_MEMORY_NAME, O_RDWR, 0666);
+            if (fd < 0 && errno != ENOENT) return MAP_FAILED;
+            if (fd >= 0)
+            {
+                if (fstat(fd, &st) != 0)
+                {
+                    close(fd);
+                    return MAP_FAILED;
+                }
+                if (st.st_size >= (off_t) sizeof(PnP)) break;
+                close(fd);
+            }
+            usleep(SHARED_MEMORY_RETRY_INTERVAL);
+        }
+    }
+    if (st.st_size < (off_t) sizeof(PnP))
+    {
+        errno = EINVAL;  // made for a smaller layout
+        return MAP_FAILED;
+    }
+
+    pnp = mapSharedMemory(fd, sizeof(PnP));
+    if (pnp != MAP_FAILED && create == TRUE) initialisePnP(pnp);
+    return pnp;
+
+}
+
+/*
+ Function: removePnP
+ -------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ removes the named shared memory object made by a simulator started on its own, once it has finished with it,
+ so that it does not last into the next run. A segment inherited from Startup or the harness has no name and
+ is left alone.
+ Argument(s): none
+ Return Value: none
+ Usage: removePnP();
+ */
+void removePnP()
+{
+
+    if (getenv(SHARED_MEMORY_FD_ENV) == NULL) shm_unlink(SHARED_MEMORY_NAME);
+
+}
+
+/*
+ Function: closePnP
+ ------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ unmaps a segment made by createPnP and closes its file descriptor, so that it is freed once the processes
+ that inherited it have exited
+ Argument(s):
+ PnP *pnp - the segment returned by createPnP
+ Return Value: none
+ Usage: closePnP(pnp);
+ */
+void closePnP(PnP *pnp)
+{
+
+    const char *fd_str = getenv(SHARED_MEMORY_FD_ENV);
+    int fd;
+
+    munmap(pnp, sizeof(PnP));
+    if (fd_str != NULL && sscanf(fd_str, "%d", &fd) == 1) close(fd);
+    unsetenv(SHARED_MEMORY_FD_ENV);
+
+}
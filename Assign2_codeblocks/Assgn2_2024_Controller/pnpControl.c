@@ -17,9 +17,9 @@
 #define HOME                0
 #define MOVE_TO_FEEDER      1
 #define WAIT_1              2
-#define LOWER_CNTR_NOZZLE   3       //lowering the centre nozzle
-#define VAC_CNTR_NOZZLE     4       //applying the vacuum for the centre nozzle
-#define RAISE_CNTR_NOZZLE   5       //raising the centre nozzle
+#define LOWERING_NOZZLE     3       //lowering the nozzle in use
+#define VACUUM_NOZZLE       4       //applying or releasing the vacuum for the nozzle in use
+#define RAISING_NOZZLE      5       //raising the nozzle in use
 #define MOVE_TO_CAMERA      6
 #define LOOK_UP_PHOTO       7
 #define MOVE_TO_PCB         8
@@ -29,24 +29,23 @@
 #define MOVE_TO_HOME        12
 #define FIX_NOZZLE_ERROR    13
 #define FIX_PREPLACE_ERROR  14
-#define LOWER_LEFT_NOZZLE   15
-#define VAC_LEFT_NOZZLE     16
-#define RAISE_LEFT_NOZZLE   17
-#define LOWER_RIGHT_NOZZLE  18
-#define VAC_RIGHT_NOZZLE    19
-#define RAISE_RIGHT_NOZZLE  20
-#define PCB                 21
+#define PCB                 15
+#define WAIT_FOR_FEEDER     16      //waiting for the tape to advance, or a new reel to be spliced on, before picking
+#define MOVE_VIA_CAMERA     17      //moving to the PCB, photographing the parts over the lookup camera in flight
+#define MOVE_TO_FIDUCIAL    18      //moving the lookdown camera over the next board fiducial
+#define LOOK_DOWN_FIDUCIAL  19      //taking a lookdown photo of a board fiducial
+#define MOVE_AND_CORRECT    20      //moving to the placement, correcting the head position from a lookdown photo and lowering the nozzle in one instruction
 
 #define holdingpart         1
 #define not_holdingpart     0
 
 /* state_names of up to 19 characters (the 20th character is a null terminator), only required for display purposes */
-const char state_name[22][20] = {"HOME               ",
+const char state_name[][CONTROLLER_STATE_NAME_LENGTH] = {"HOME               ",
                                 "MOVE TO FEEDER     ",
                                 "WAIT 1             ",
-                                "LOWER CNTR NOZZLE  ",
-                                "VAC CNTR NOZZLE    ",
-                                "RAISE CNTR NOZZLE  ",
+                                "LOWERING NOZZLE    ",
+                                "VACUUM NOZZLE      ",
+                                "RAISING NOZZLE     ",
                                 "MOVE TO CAMERA     ",
                                 "LOOK UP PHOTO      ",
                                 "MOVE TO PCB        ",
@@ -56,33 +55,297 @@ const char state_name[22][20] = {"HOME               ",
                                 "MOVE TO HOME       ",
                                 "FIX NOZZLE ERROR   ",
                                 "FIX PREPLACE ERROR ",
-                                "LOWER LEFT NOZZLE  ",
-                                "VAC LEFT NOZZLE    ",
-                                "RAISE LEFT NOZZLE  ",
-                                "LOWER RIGHT NOZZLE ",
-                                "VAC RIGHT NOZZLE   ",
-                                "RAISE RIGHT NOZZLE ",
-                                "PCB                "};
+                                "PCB                ",
+                                "WAIT FOR FEEDER    ",
+                                "MOVE VIA CAMERA    ",
+                                "MOVE TO FIDUCIAL   ",
+                                "LOOK DOWN FIDUCIAL ",
+                                "MOVE AND CORRECT   "};
 
-const double TAPE_FEEDER_X[NUMBER_OF_FEEDERS] = {FDR_0_X, FDR_1_X, FDR_2_X, FDR_3_X, FDR_4_X, FDR_5_X, FDR_6_X, FDR_7_X, FDR_8_X, FDR_9_X};
-const double TAPE_FEEDER_Y[NUMBER_OF_FEEDERS] = {FDR_0_Y, FDR_1_Y, FDR_2_Y, FDR_3_Y, FDR_4_Y, FDR_5_Y, FDR_6_Y, FDR_7_Y, FDR_8_Y, FDR_9_Y};
 
-const char nozzle_name[3][10] = {"left", "centre", "right"};
+/*
+ Function: moveNozzleToFeeder
+ ----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ instructs the simulator to move the head so that the specified nozzle (rather than the
+ centre of the head) is positioned over the specified tape feeder
+ Argument(s):
+ int nozzle - the nozzle to position over the feeder
+ int feeder - the tape feeder number
+ Return Value: none
+ Usage: moveNozzleToFeeder(nozzle, pi[component_num].feeder);
+ */
+void moveNozzleToFeeder(int nozzle, int feeder)
+{
+    const MachineConfig *machine = getMachineConfig();
+    setTargetPos(machine -> feeder_x[feeder] - getNozzleOffsetX(nozzle), machine -> feeder_y[feeder] - getNozzleOffsetY(nozzle));
+}
+
+/*
+ Function: runPickProgram
+ ------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ runs a micro-program in the simulator to pick a part with the nozzle positioned over the feeder: wait for the
+ feeder, lower the nozzle, apply the vacuum and raise the nozzle, trying again up to PICK_ATTEMPTS times if the
+ nozzle comes up empty
+ Argument(s):
+ int nozzle - the nozzle positioned over the feeder
+ int feeder - the tape feeder number
+ Return Value: none
+ Usage: runPickProgram(nozzle, pi[component_num].feeder);
+ */
+void runPickProgram(int nozzle, int feeder)
+{
+    clearProgram();
+    addProgramStep(PROGRAM_SET_INDEX, 0.0, 0.0, 0, 0);
+    int retry = addProgramStep(PROGRAM_WAIT_FOR_FEEDER, 0.0, 0.0, feeder, 0);
+    addProgramStep(LOWER_NOZZLE, 0.0, 0.0, nozzle, 0);
+    addProgramStep(APPLY_VACUUM, 0.0, 0.0, nozzle, 0);
+    addProgramStep(RAISE_NOZZLE, 0.0, 0.0, nozzle, 0);
+    addProgramStep(PROGRAM_JUMP_IF_NOZZLE_EMPTY, 0.0, 0.0, nozzle, retry + 6);  // on to the PROGRAM_LOOP after the PROGRAM_END
+    addProgramStep(PROGRAM_END, 0.0, 0.0, 0, 0);
+    addProgramStep(PROGRAM_LOOP, 0.0, 0.0, PICK_ATTEMPTS, retry);
+    runProgram();
+}
+
+/*
+ Function: runPlaceProgram
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ runs a micro-program in the simulator to place the part held by a nozzle positioned over its placement:
+ lower the nozzle (unless it is already down), release the vacuum and raise the nozzle
+ Argument(s):
+ int nozzle - the nozzle holding the part
+ int nozzle_is_down - TRUE if the nozzle has already been lowered
+ Return Value: none
+ Usage: runPlaceProgram(nozzle, FALSE);
+ */
+void runPlaceProgram(int nozzle, int nozzle_is_down)
+{
+    clearProgram();
+    if (nozzle_is_down == FALSE) addProgramStep(LOWER_NOZZLE, 0.0, 0.0, nozzle, 0);
+    addProgramStep(RELEASE_VACUUM, 0.0, 0.0, nozzle, 0);
+    addProgramStep(RAISE_NOZZLE, 0.0, 0.0, nozzle, 0);
+    runProgram();
+}
+
+/*
+ Function: getNextNozzleWithStatus
+ ---------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ finds the lowest numbered nozzle, starting from first_nozzle, which is either holding or not holding a part
+ Argument(s):
+ char nozzle_status[] - holdingpart or not_holdingpart for each nozzle
+ int number_of_nozzles - the number of nozzles on the head
+ int first_nozzle - the nozzle to start searching from
+ char status - the status to search for (holdingpart or not_holdingpart)
+ Return Value:
+ the number of the nozzle found, otherwise NO_NOZZLE (-1)
+ Usage: int nozzle = getNextNozzleWithStatus(nozzle_status, number_of_nozzles, 0, not_holdingpart);
+ */
+int getNextNozzleWithStatus(char nozzle_status[], int number_of_nozzles, int first_nozzle, char status)
+{
+    for (int i = first_nozzle; i < number_of_nozzles; i++)
+    {
+        if (nozzle_status[i] == status) return i;
+    }
+    return NO_NOZZLE;
+}
+
+/*
+ Function: getNozzleClosestToHeadCentre
+ --------------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ finds the nozzle with the smallest offset from the centre of the head, which is the nozzle used in manual mode
+ (the centre nozzle on the default three nozzle head)
+ Argument(s): none
+ Return Value: the number of the nozzle closest to the centre of the head
+ Usage: int manual_nozzle = getNozzleClosestToHeadCentre();
+ */
+int getNozzleClosestToHeadCentre()
+{
+    int closest = 0;
+    for (int i = 1; i < getNumberOfNozzles(); i++)
+    {
+        if (fabs(getNozzleOffsetX(i)) + fabs(getNozzleOffsetY(i)) < fabs(getNozzleOffsetX(closest)) + fabs(getNozzleOffsetY(closest))) closest = i;
+    }
+    return closest;
+}
+
+/*
+ Function: isFeederReadyByPickTime
+ ---------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ determines whether a part will be in the pick position of a feeder by the time a nozzle lowered now has
+ reached it and applied vacuum, so that the tape advance overlaps with lowering the nozzle
+ Argument(s):
+ int feeder - the tape feeder number
+ Return Value:
+ TRUE (1) if the nozzle can be lowered now, otherwise FALSE (0)
+ Usage: if (isFeederReadyByPickTime(pi[component_num].feeder)) lowerNozzle(nozzle);
+ */
+int isFeederReadyByPickTime(int feeder)
+{
+    const MachineConfig *machine = getMachineConfig();
+    return getFeederPartsRemaining(feeder) != 0
+        && getFeederReadyTime(feeder) <= getSimulationTime() + machine -> nozzle_lower_time + machine -> vacuum_apply_time;
+}
+
+/*
+ Function: chooseNextPick
+ ------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ looks ahead over the next PICK_LOOK_AHEAD parts in the pick list and moves the one which can be picked
+ soonest by the given nozzle to the front. The pick time of each part allows for moving the head from
+ its current position, lowering the nozzle and applying vacuum for the part's package and waiting for the
+ feeder tape to advance (or for a new reel to be spliced on), so consecutive picks from a slow feeder are
+ interleaved with picks from other feeders. Parts whose package the nozzle is not meant to carry are only
+ chosen if no part in the look-ahead is. Where there is nothing to gain the existing feeder order is kept.
+ Argument(s):
+ int component_list[] - the pick list, indexes into pi[]
+ int part_counter - the position in the pick list of the next part to be picked
+ int number_of_components_to_place - the length of the pick list
+ PlacementInfo pi[] - the placement info of all components
+ int nozzle - the nozzle which will pick the part
+ Return Value: none, component_list[part_counter] is the part to pick next
+ Usage: chooseNextPick(component_list, part_counter, number_of_components_to_place, pi, nozzle);
+ */
+void chooseNextPick(int component_list[], int part_counter, int number_of_components_to_place, PlacementInfo pi[], int nozzle)
+{
+    const MachineConfig *machine = getMachineConfig();
+    const ComponentLibrary *library = getComponentLibrary();
+    int best = part_counter, best_fits = FALSE, look_ahead_end = part_counter + PICK_LOOK_AHEAD;
+    double best_pick_time = 0.0;
+
+    if (look_ahead_end > number_of_components_to_place) look_ahead_end = number_of_components_to_place;
+    for (int i = part_counter; i < look_ahead_end; i++)
+    {
+        int feeder = pi[component_list[i]].feeder, package = pi[component_list[i]].package;
+        int fits = (getPackageNozzles(library, machine, package) & (1u << nozzle)) != 0;
+        double travel = hypot(machine -> feeder_x[feeder] - getNozzleOffsetX(nozzle) - getHeadPositionX(),
+                              machine -> feeder_y[feeder] - getNozzleOffsetY(nozzle) - getHeadPositionY()) / machine -> head_full_speed;
+        double lower_time = getPackageInstructionTime(library, machine, package, LOWER_NOZZLE, FALSE);
+        double pick_time = getSimulationTime() + travel + lower_time + getPackageInstructionTime(library, machine, package, APPLY_VACUUM, FALSE);
+
+        if (getFeederReadyTime(feeder) > pick_time) pick_time = getFeederReadyTime(feeder);
+        if (getFeederPartsRemaining(feeder) == 0 && pick_time < getFeederReadyTime(feeder) + lower_time) pick_time = getFeederReadyTime(feeder) + lower_time;
+        if (i == part_counter || fits > best_fits || (fits == best_fits && pick_time < best_pick_time - 1e-6))
+        {
+            best = i;
+            best_fits = fits;
+            best_pick_time = pick_time;
+        }
+    }
+    /* move the chosen part to the front, keeping the order of the parts it jumps */
+    int chosen = component_list[best];
+    for (int i = best; i > part_counter; i--) component_list[i] = component_list[i - 1];
+    component_list[part_counter] = chosen;
+}
+
+/*
+ Function: reportFeederEvents
+ ----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.2
+ Purpose:
+ writes any new feeder events (feeders running empty and new reels being spliced on) to the display
+ Argument(s): none
+ Return Value: none
+ Usage: reportFeederEvents();
+ */
+void reportFeederEvents()
+{
+    LogLine log_line;
+    FeederEvent event;
+
+    while (getNextFeederEvent(&event))
+    {
+        if (event.type == FEEDER_EVENT_EMPTY)
+        {
+            formatLogMessage(&log_line, getSimulationTime(), "Feeder ");
+            addLogInteger(&log_line, event.feeder);
+            addLogText(&log_line, " reported empty at ");
+            addLogFixed(&log_line, event.time, 0, 2);
+            addLogText(&log_line, ", waiting for a new reel\n");
+        }
+        else
+        {
+            formatLogMessage(&log_line, getSimulationTime(), "Feeder ");
+            addLogInteger(&log_line, event.feeder);
+            addLogText(&log_line, " has a new reel of ");
+            addLogInteger(&log_line, getFeederPartsRemaining(event.feeder));
+            addLogText(&log_line, " parts\n");
+        }
+        writeDisplayLog(log_line.text);
+    }
+}
+
+
+/*
+ Function: getRejectedSequenceStep
+ ---------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ finds the step of the last sequence instruction that did not finish
+ Argument(s):
+ none
+ Return Value:
+ the first step that was rejected or not run, else NO_SEQUENCE_STEP (-1) if every step finished. A sequence
+ instruction which was rejected outright has no steps, so returns 0
+ Usage: int step = getRejectedSequenceStep();
+ */
+int getRejectedSequenceStep()
+{
+    int number_of_steps = getSequenceLength();
+
+    if (number_of_steps == 0) return 0;
+    for (int step = 0; step < number_of_steps; step++)
+    {
+        if (getSequenceStepResult(step) != SEQUENCE_STEP_DONE) return step;
+    }
+    return NO_SEQUENCE_STEP;
+}
 
 
 int main(int argc, char *argv[])
 {
-    sleep(1); // give time for other processes to initialise
-    char Contrl_str_array[150];
-    int writeContrlToDisplayFd = atoi(argv[1]);  // the file descriptor to write from controller to Display
+    LogLine log_line;
+    int writeContrlToDisplayFd = atoi(argv[1]);  // the file descriptor to write to when not started with a log ring to the Display
     sem_t *sem_Startup = sem_open("/sem_Startup", 0);  // open the named semaphores
     sem_t *sem_Sim = sem_open("/sem_Sim", 0);
     sem_t *sem_Contrl = sem_open("/sem_Contrl", 0);
 
+    openDisplayLog(LOG_SOURCE_CONTROLLER, writeContrlToDisplayFd);
     pnpOpen();  // open the shared file with the simulator
+    publishControllerStates(state_name, sizeof(state_name) / sizeof(state_name[0]));
+    const MachineConfig *machine = getMachineConfig();  // feeder positions, head layout and camera location published by the simulator
 
-    sprintf(Contrl_str_array, "Time: %7.2f  Pick and place controller started successfully!\n", getSimulationTime());
-    write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+    formatLogMessage(&log_line, getSimulationTime(), "Pick and place controller started successfully!\n");
+    writeDisplayLog(log_line.text);
 
     int operation_mode, number_of_components_to_place, res;
     PlacementInfo pi[MAX_NUMBER_OF_COMPONENTS_TO_PLACE];
@@ -93,6 +356,11 @@ int main(int argc, char *argv[])
      */
     res = getCentroidFileContents(&operation_mode, &number_of_components_to_place, pi);
 
+    for (int i = 0; i < number_of_components_to_place && res == CENTROID_FILE_PRESENT_AND_READ; i++)
+    {  //every part must come from a feeder that is fitted to this machine
+        if (pi[i].feeder < 0 || pi[i].feeder >= machine -> number_of_feeders) res = CENTROID_FILE_HAS_UNKNOWN_FEEDER;
+    }
+
     if (res != CENTROID_FILE_PRESENT_AND_READ)
     {  //throw an error if the centroid file is unreadable or not present
         printf("Problem with centroid file, error code %d, press any key to continue\n", res);
@@ -100,8 +368,30 @@ int main(int argc, char *argv[])
         exit(res);
     }
 
-    // wait for startup to finish spawning processes and closing pipes
-    sem_wait(sem_Startup);
+    setPlacementPackages(pi, number_of_components_to_place, getComponentLibrary());
+    for (int f = 0; f < machine -> number_of_feeders; f++)
+    {  //the simulator times every part on a feeder as the first one listed for it, so point out a feeder given different footprints
+        int first = -1;
+        for (int i = 0; i < number_of_components_to_place; i++)
+        {
+            if (pi[i].feeder != f) continue;
+            if (first < 0) first = i;
+            else if (pi[i].package != pi[first].package)
+            {
+                formatLogMessage(&log_line, getSimulationTime(), "Feeder ");
+                addLogInteger(&log_line, f);
+                addLogText(&log_line, " is given more than one footprint, its parts are timed as ");
+                addLogText(&log_line, pi[first].component_footprint);
+                addLogText(&log_line, "\n");
+                writeDisplayLog(log_line.text);
+                break;
+            }
+        }
+    }
+
+    // wait for the simulator to be ready too, then start together
+    publishPlacementTargets(pi, number_of_components_to_place);
+    waitForStartup(sem_Startup);
 
     /*
     **********************************************
@@ -115,46 +405,72 @@ int main(int argc, char *argv[])
 
         /* initialization of variables and controller window */
         int state = HOME, finished = FALSE, part_counter = 0;
-        char c, part_placed, NozzleStatus = not_holdingpart;
+        char c, part_placed = FALSE, NozzleStatus = not_holdingpart;
         double requested_theta = 0;  //the required angle theta of the nozzle position
         double preplace_diff_x = 0, preplace_diff_y = 0;  //difference in required gantry position and actual gantry position for preplacement
-
-        sprintf(Contrl_str_array, "Time: %7.2f  Initial state: %.15s  Operating in manual control mode, there are %d parts to place\n\n", getSimulationTime(), state_name[HOME], number_of_components_to_place);
-        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+        int manual_nozzle = getNozzleClosestToHeadCentre();  //manual mode uses a single nozzle, the centre one on the default head
+        int manual_feeder = NO_TAPE_FEEDER_AT_THIS_LOCATION;  //the feeder the nozzle was last moved to
+
+        formatLogMessage(&log_line, getSimulationTime(), "Initial state: ");
+        addLogString(&log_line, state_name[HOME], 15);
+        addLogText(&log_line, "  Operating in manual control mode, there are ");
+        addLogInteger(&log_line, number_of_components_to_place);
+        addLogText(&log_line, " parts to place\n\n");
+        writeDisplayLog(log_line.text);
         /* print details of part 0 */
-        sprintf(Contrl_str_array, "Part 0 details:\nDesignation: %s\nFootprint: %s\nValue: %.2f\nx: %.2f\ny: %.2f\ntheta: %.2f\nFeeder: %d\n\n",
-               pi[0].component_designation, pi[0].component_footprint, pi[0].component_value, pi[0].x_target, pi[0].y_target, pi[0].theta_target, pi[0].feeder);
-        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+        clearLogLine(&log_line);
+        addLogText(&log_line, "Part 0 details:\nDesignation: ");
+        addLogText(&log_line, pi[0].component_designation);
+        addLogText(&log_line, "\nFootprint: ");
+        addLogText(&log_line, pi[0].component_footprint);
+        addLogText(&log_line, "\nValue: ");
+        addLogFixed(&log_line, pi[0].component_value, 0, 2);
+        addLogText(&log_line, "\nx: ");
+        addLogFixed(&log_line, pi[0].x_target, 0, 2);
+        addLogText(&log_line, "\ny: ");
+        addLogFixed(&log_line, pi[0].y_target, 0, 2);
+        addLogText(&log_line, "\ntheta: ");
+        addLogFixed(&log_line, pi[0].theta_target, 0, 2);
+        addLogText(&log_line, "\nFeeder: ");
+        addLogInteger(&log_line, pi[0].feeder);
+        addLogText(&log_line, "\n\n");
+        writeDisplayLog(log_line.text);
 
         /* loop until user quits */
         while(!isPnPSimulationQuitFlagOn())
         {
 
             c = getKey();  //saves the value of the key pressed by the user
+            reportFeederEvents();
 
             switch (state)
             {
                 case HOME:
                     //gantry in home position, waiting for input by user to initiate movement to feeder
 
-                    if (finished == FALSE && (c == '0' || c == '1' || c == '2' || c == '3' || c == '4' || c == '5' || c == '6' || c == '7' || c == '8' || c == '9'))
+                    if (finished == FALSE && c >= '0' && c <= '9' && (c - '0') < machine -> number_of_feeders)
                     {
                         //check if user inputs a feeder number that is not next in the centroid file
                         if ((c - '0') != pi[part_counter].feeder)
                         {   /* the expression (c - '0') obtains the integer value of the number key pressed */
-                            sprintf(Contrl_str_array, "Time: %7.2f  WARNING  The next part is in feeder %d.\n", getSimulationTime(), pi[part_counter].feeder);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                            formatLogMessage(&log_line, getSimulationTime(), "WARNING  The next part is in feeder ");
+                            addLogInteger(&log_line, pi[part_counter].feeder);
+                            addLogText(&log_line, ".\n");
+                            writeDisplayLog(log_line.text);
                         }
-                            setTargetPos(TAPE_FEEDER_X[c - '0'], TAPE_FEEDER_Y[c - '0']);
+                            moveNozzleToFeeder(manual_nozzle, c - '0');
+                            manual_feeder = c - '0';
                             state = MOVE_TO_FEEDER;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Issued instruction to move to tape feeder %c\n", getSimulationTime(), state_name[state], c);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "Issued instruction to move to tape feeder ");
+                            addLogChar(&log_line, c);
+                            addLogText(&log_line, "\n");
+                            writeDisplayLog(log_line.text);
                     }
                     if(finished == TRUE)
                     {
-                        sprintf(Contrl_str_array, "Time: %7.2f  Terminating...\n", getSimulationTime());
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                        close(writeContrlToDisplayFd);
+                        formatLogMessage(&log_line, getSimulationTime(), "Terminating...\n");
+                        writeDisplayLog(log_line.text);
+                        closeDisplayLog();
                         pnpClose();
                         sem_post(sem_Contrl); // allow simulator to terminate
                         sem_close(sem_Sim);
@@ -169,46 +485,58 @@ int main(int argc, char *argv[])
                     if (isSimulatorReadyForNextInstruction())
                     {
                         state = WAIT_1;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Arrived at feeder, waiting for next instruction\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Arrived at feeder, waiting for next instruction\n");
+                        writeDisplayLog(log_line.text);
                     }
                     break;
 
                 case WAIT_1:    //waiting for next key press
                     //'p' for pickup
-                    if((c == 'p') && (NozzleStatus == not_holdingpart))  //checking if the nozzle is empty
+                    if((c == 'p') && (NozzleStatus == not_holdingpart) && manual_feeder != NO_TAPE_FEEDER_AT_THIS_LOCATION && !isFeederReadyByPickTime(manual_feeder))
+                    {   //the tape has not finished advancing or the feeder is empty, so the pick would fail
+                        formatLogMessage(&log_line, getSimulationTime(), "WARNING  Feeder ");
+                        addLogInteger(&log_line, manual_feeder);
+                        addLogText(&log_line, " is not ready until ");
+                        addLogFixed(&log_line, getFeederReadyTime(manual_feeder), 0, 2);
+                        addLogText(&log_line, ", press 'p' again then\n");
+                        writeDisplayLog(log_line.text);
+                    }
+                    else if((c == 'p') && (NozzleStatus == not_holdingpart))  //checking if the nozzle is empty
                     {
-                        lowerNozzle(CENTRE_NOZZLE);
-                        state = LOWER_CNTR_NOZZLE;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Issued instruction to pick up part. Lowering centre nozzle\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        lowerNozzle(manual_nozzle);
+                        state = LOWERING_NOZZLE;
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Issued instruction to pick up part. Lowering ");
+                        addLogText(&log_line, getNozzleName(manual_nozzle));
+                        addLogText(&log_line, " nozzle\n");
+                        writeDisplayLog(log_line.text);
                     }
 
                     //'p' to place the part that the nozzle is currently holding
                     else if((c == 'p') && (NozzleStatus == holdingpart))
                     {
-                        lowerNozzle(CENTRE_NOZZLE);
-                        state = LOWER_CNTR_NOZZLE;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Issued instruction to place part on PCB. Lowering nozzle\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        lowerNozzle(manual_nozzle);
+                        state = LOWERING_NOZZLE;
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Issued instruction to place part on PCB. Lowering nozzle\n");
+                        writeDisplayLog(log_line.text);
                     }
 
                     //'c' for camera, should only go to the camera if the nozzle is holding a part
                     else if(c == 'c')
                     {
-                        setTargetPos(LOOKUP_CAMERA_X,LOOKUP_CAMERA_Y);  //the gantry will move to the position above the camera
+                        setTargetPos(machine -> lookup_camera_x, machine -> lookup_camera_y);  //the gantry will move to the position above the camera
+                        manual_feeder = NO_TAPE_FEEDER_AT_THIS_LOCATION;
                         state = MOVE_TO_CAMERA;      //after the nozzle picked up a part, send the gantry to the lookup camera
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Issued instruction to move to look-up camera\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Issued instruction to move to look-up camera\n");
+                        writeDisplayLog(log_line.text);
                     }
 
                     //'r' for rotate to fix the nozzle misalignment error
                     else if(c == 'r')
                     {
-                        rotateNozzle(CENTRE_NOZZLE, requested_theta);  //rotate the nozzle by the required calculated angle theta
+                        rotateNozzle(manual_nozzle, requested_theta);  //rotate the nozzle by the required calculated angle theta
                         state = CORRECT_ERRORS;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Correcting part misalignment on nozzle\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Correcting part misalignment on nozzle\n");
+                        writeDisplayLog(log_line.text);
                     }
 
                     //'a' for adjusting the position of the gantry for preplace misalignment error
@@ -216,68 +544,74 @@ int main(int argc, char *argv[])
                     {
                         amendPos(preplace_diff_x, preplace_diff_y); //corrects the position by the calculated difference x and y
                         state = CORRECT_ERRORS;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Correcting preplace misalignment of gantry\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Correcting preplace misalignment of gantry\n");
+                        writeDisplayLog(log_line.text);
                     }
                     // 'h' for home. This will move the gantry back to its home position
                     else if(c == 'h')
                     {
-                        setTargetPos(HOME_X,HOME_Y);
+                        setTargetPos(machine -> home_x, machine -> home_y);
+                        manual_feeder = NO_TAPE_FEEDER_AT_THIS_LOCATION;
                         state = MOVE_TO_HOME;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Moving to home position\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Moving to home position\n");
+                        writeDisplayLog(log_line.text);
                     }
                     // in case the user pressed the wrong number key and needs to change the feeder
-                    else if (c == '0' || c == '1' || c == '2' || c == '3' || c == '4' || c == '5' || c == '6' || c == '7' || c == '8' || c == '9')
+                    else if (c >= '0' && c <= '9' && (c - '0') < machine -> number_of_feeders)
                     {
                         //check if user inputs a feeder number that is not next in the centroid file
                         if ((c - '0') != pi[part_counter].feeder)
                         {   /* the expression (c - '0') obtains the integer value of the number key pressed */
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  WARNING  The next part is in feeder %d.\n", getSimulationTime(), state_name[state], pi[part_counter].feeder);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "WARNING  The next part is in feeder ");
+                            addLogInteger(&log_line, pi[part_counter].feeder);
+                            addLogText(&log_line, ".\n");
+                            writeDisplayLog(log_line.text);
                         }
-                            setTargetPos(TAPE_FEEDER_X[c - '0'], TAPE_FEEDER_Y[c - '0']);
+                            moveNozzleToFeeder(manual_nozzle, c - '0');
+                            manual_feeder = c - '0';
                             state = MOVE_TO_FEEDER;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Issued instruction to move to tape feeder %c\n", getSimulationTime(), state_name[state], c);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "Issued instruction to move to tape feeder ");
+                            addLogChar(&log_line, c);
+                            addLogText(&log_line, "\n");
+                            writeDisplayLog(log_line.text);
                     }
 
                     break;
 
-                case LOWER_CNTR_NOZZLE:
+                case LOWERING_NOZZLE:
                     //Need to wait until simulator is ready before moving on to vacuum
                     if (isSimulatorReadyForNextInstruction())
                     {
                         if(NozzleStatus == not_holdingpart)
                         {   //vacuum will apply when the nozzle is empty
-                            applyVacuum(CENTRE_NOZZLE);
-                            state = VAC_CNTR_NOZZLE;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Applying vacuum\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                            applyVacuum(manual_nozzle);
+                            state = VACUUM_NOZZLE;
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "Applying vacuum\n");
+                            writeDisplayLog(log_line.text);
                         }
                         if(NozzleStatus == holdingpart)
                         {   //vacuum will release the part when the nozzle is holding something
-                            releaseVacuum(CENTRE_NOZZLE);
+                            releaseVacuum(manual_nozzle);
                             part_placed = TRUE;  //counter to indicate the part has been placed
-                            state = VAC_CNTR_NOZZLE;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Releasing vacuum to place part\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                            state = VACUUM_NOZZLE;
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "Releasing vacuum to place part\n");
+                            writeDisplayLog(log_line.text);
                         }
                     }
                     break;
 
-                case VAC_CNTR_NOZZLE:
+                case VACUUM_NOZZLE:
                     //wait until the vacuum action is finished before raising the nozzle
                      if (isSimulatorReadyForNextInstruction())
                     {
-                        raiseNozzle(CENTRE_NOZZLE);
-                        state = RAISE_CNTR_NOZZLE;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Raising nozzle\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        raiseNozzle(manual_nozzle);
+                        state = RAISING_NOZZLE;
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Raising nozzle\n");
+                        writeDisplayLog(log_line.text);
                     }
                     break;
 
-                case RAISE_CNTR_NOZZLE:
+                case RAISING_NOZZLE:
                     //once nozzle is raised, if a part hasn't just been placed, then it is determined that a part has just been picked up
                     if (isSimulatorReadyForNextInstruction())
                     {
@@ -285,8 +619,8 @@ int main(int argc, char *argv[])
                         {
                             NozzleStatus = holdingpart;
                             state = WAIT_1;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Part acquired, ready for next instruction\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "Part acquired, ready for next instruction\n");
+                            writeDisplayLog(log_line.text);
                         }
                         //if the vacuum has just released a part, then the part has been placed and the nozzle is free again
                         if (part_placed==TRUE)
@@ -297,20 +631,37 @@ int main(int argc, char *argv[])
                             if (part_counter != number_of_components_to_place)
                             {   //since there are still components to be placed, go back to Home to cycle again. Display the next set of part details
                                 state = HOME;
-                                sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Part %d placed on PCB successfully\n\n", getSimulationTime(), state_name[state], (part_counter-1));
-                                write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                                sprintf(Contrl_str_array, "Part %d details:\nDesignation: %s\nFootprint: %s\nValue: %.2f\nx: %.2f\ny: %.2f\ntheta: %.2f\nFeeder: %d\n\n", part_counter,
-                                    pi[part_counter].component_designation, pi[part_counter].component_footprint, pi[part_counter].component_value, pi[part_counter].x_target,
-                                    pi[part_counter].y_target, pi[part_counter].theta_target, pi[part_counter].feeder);
-                                write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                                formatStateLog(&log_line, getSimulationTime(), state_name[state], "Part ");
+                                addLogInteger(&log_line, (part_counter-1));
+                                addLogText(&log_line, " placed on PCB successfully\n\n");
+                                writeDisplayLog(log_line.text);
+                                clearLogLine(&log_line);
+                                addLogText(&log_line, "Part ");
+                                addLogInteger(&log_line, part_counter);
+                                addLogText(&log_line, " details:\nDesignation: ");
+                                addLogText(&log_line, pi[part_counter].component_designation);
+                                addLogText(&log_line, "\nFootprint: ");
+                                addLogText(&log_line, pi[part_counter].component_footprint);
+                                addLogText(&log_line, "\nValue: ");
+                                addLogFixed(&log_line, pi[part_counter].component_value, 0, 2);
+                                addLogText(&log_line, "\nx: ");
+                                addLogFixed(&log_line, pi[part_counter].x_target, 0, 2);
+                                addLogText(&log_line, "\ny: ");
+                                addLogFixed(&log_line, pi[part_counter].y_target, 0, 2);
+                                addLogText(&log_line, "\ntheta: ");
+                                addLogFixed(&log_line, pi[part_counter].theta_target, 0, 2);
+                                addLogText(&log_line, "\nFeeder: ");
+                                addLogInteger(&log_line, pi[part_counter].feeder);
+                                addLogText(&log_line, "\n\n");
+                                writeDisplayLog(log_line.text);
                             }
                             else if(part_counter == number_of_components_to_place)
                             {
                                 finished = TRUE;
-                                setTargetPos(HOME_X,HOME_Y);
+                                setTargetPos(machine -> home_x, machine -> home_y);
                                 state = MOVE_TO_HOME;
-                                sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  All parts have been placed! Moving to home\n", getSimulationTime(), state_name[state]);
-                                write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                                formatStateLog(&log_line, getSimulationTime(), state_name[state], "All parts have been placed! Moving to home\n");
+                                writeDisplayLog(log_line.text);
                             }
                         }
                     }
@@ -322,8 +673,8 @@ int main(int argc, char *argv[])
                     {
                         takePhoto(PHOTO_LOOKUP);
                         state = LOOK_UP_PHOTO;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Arrived at camera. Taking look-up photo of part\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Arrived at camera. Taking look-up photo of part\n");
+                        writeDisplayLog(log_line.text);
                     }
                     break;
 
@@ -332,8 +683,8 @@ int main(int argc, char *argv[])
                     {   //once look-up photo is taken, move the gantry to the PCB for part placement
                         setTargetPos(pi[part_counter].x_target, pi[part_counter].y_target);
                         state = MOVE_TO_PCB;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Look-up photo acquired. Moving to PCB\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Look-up photo acquired. Moving to PCB\n");
+                        writeDisplayLog(log_line.text);
                     }
                     break;
 
@@ -342,8 +693,8 @@ int main(int argc, char *argv[])
                     if (isSimulatorReadyForNextInstruction())
                     {
                         state = LOOK_DOWN_PHOTO;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Now at PCB. Taking look-down photo\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Now at PCB. Taking look-down photo\n");
+                        writeDisplayLog(log_line.text);
                     }
                     break;
 
@@ -351,23 +702,29 @@ int main(int argc, char *argv[])
                     //take the look-down photo, then move on to check for errors
                     takePhoto(PHOTO_LOOKDOWN);
                     state = CHECK_ERROR;
-                    sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Look-down photo acquired. Checking for errors in alignment\n", getSimulationTime(), state_name[state]);
-                    write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                    formatStateLog(&log_line, getSimulationTime(), state_name[state], "Look-down photo acquired. Checking for errors in alignment\n");
+                    writeDisplayLog(log_line.text);
                     break;
 
                 case CHECK_ERROR:
                     //wait until the look-down photo is taken, then calculate errors
                     if (isSimulatorReadyForNextInstruction())
                     {
-                        double errortheta = getPickErrorTheta(CENTRE_NOZZLE);  //acquire the part misalignment from the look-up photo
+                        double errortheta = getPickErrorTheta(manual_nozzle);  //acquire the part misalignment from the look-up photo
                         requested_theta = pi[part_counter].theta_target - errortheta;  //calculate misalignment of the part on the nozzle
                         preplace_diff_x = pi[part_counter].x_target - (pi[part_counter].x_target+getPreplaceErrorX()); //calculate the difference between the required x position and the actual x position of the gantry
                         preplace_diff_y = pi[part_counter].y_target - (pi[part_counter].y_target+getPreplaceErrorY()); //calculate the difference between the required y position and the actual y position of the gantry
                         state = WAIT_1;  //display the errors to the user so they are aware and then wait for instruction
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Part misalignment error: %3.2f, preplace misalignment error: x=%3.2f y=%3.2f\n", getSimulationTime(),state_name[state], errortheta, getPreplaceErrorX(), getPreplaceErrorY());
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Waiting for next instruction. Recommend error correction\n", getSimulationTime(),state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Part misalignment error: ");
+                        addLogFixed(&log_line, errortheta, 3, 2);
+                        addLogText(&log_line, ", preplace misalignment error: x=");
+                        addLogFixed(&log_line, getPreplaceErrorX(), 3, 2);
+                        addLogText(&log_line, " y=");
+                        addLogFixed(&log_line, getPreplaceErrorY(), 3, 2);
+                        addLogText(&log_line, "\n");
+                        writeDisplayLog(log_line.text);
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Waiting for next instruction. Recommend error correction\n");
+                        writeDisplayLog(log_line.text);
                     }
                     break;
 
@@ -375,8 +732,8 @@ int main(int argc, char *argv[])
                     if (isSimulatorReadyForNextInstruction())
                     {  //once the nozzle or gantry position has been corrected, go back to wait for next instruction
                         state = WAIT_1;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Misalignment corrected, ready for next instruction\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Misalignment corrected, ready for next instruction\n");
+                        writeDisplayLog(log_line.text);
                     }
                     break;
 
@@ -384,17 +741,127 @@ int main(int argc, char *argv[])
                     if (isSimulatorReadyForNextInstruction())
                     {
                         state = HOME;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Gantry in Home position\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Gantry in Home position\n");
+                        writeDisplayLog(log_line.text);
                     }
                     break;
 
             }
-            sleepMilliseconds((long) 1000 / POLL_LOOP_RATE);
+            recordControllerState(state);
+            waitForNextPollLoop();
         } //end while loop
     } // end of manual mode
 
 
+    /*
+    *****************************************************
+    *
+    *Planned control mode
+    *
+    ***************************************************
+    */
+    else if (operation_mode == PLANNED_CONTROL)
+    {
+        static Plan plan;  //too large for the stack
+        int next_step = 0, waiting_for_feeder = FALSE;
+
+        if (buildPlan(pi, number_of_components_to_place, machine, getComponentLibrary(), PLAN_ORDER_BY_FEEDER, &plan) == PLAN_TOO_LONG)
+        {
+            formatLogMessage(&log_line, getSimulationTime(), "Too many parts to plan, at most ");
+            addLogInteger(&log_line, MAX_PLAN_LENGTH);
+            addLogText(&log_line, " plan steps\n");
+            writeDisplayLog(log_line.text);
+            plan.length = 0;
+        }
+        else
+        {
+            formatLogMessage(&log_line, getSimulationTime(), "Operating in planned mode. There are ");
+            addLogInteger(&log_line, number_of_components_to_place);
+            addLogText(&log_line, " parts to place in ");
+            addLogInteger(&log_line, plan.length);
+            addLogText(&log_line, " steps, predicted cycle time ");
+            addLogFixed(&log_line, plan.cycle_time, 0, 2);
+            addLogText(&log_line, " seconds\n\n");
+            writeDisplayLog(log_line.text);
+        }
+
+        /* loop until the plan is finished or the user quits, streaming the plan to the simulator */
+        while(!isPnPSimulationQuitFlagOn() && plan.length > 0)
+        {
+
+            reportFeederEvents();
+
+            if (isSimulatorReadyForNextInstruction() && next_step == plan.length)
+            {  // the PCB has been unloaded, terminate program
+                sem_wait(sem_Sim); // waiting for the simulator to finish unloading the PCB
+                formatLogMessage(&log_line, getSimulationTime(), "Plan finished, predicted cycle time was ");
+                addLogFixed(&log_line, plan.cycle_time, 0, 2);
+                addLogText(&log_line, " seconds\n");
+                writeDisplayLog(log_line.text);
+                formatLogMessage(&log_line, getSimulationTime(), "Terminating...\n");
+                writeDisplayLog(log_line.text);
+                closeDisplayLog();
+                pnpClose();
+                sem_post(sem_Contrl);  // allow the simulator to terminate
+                sem_close(sem_Sim);
+                sem_close(sem_Startup);
+                sem_close(sem_Contrl);
+                exit(30);
+            }
+            else if (isSimulatorReadyForNextInstruction())
+            {
+                const PlanStep *step = &plan.step[next_step];
+                int res = issuePlanStep(step, pi);
+
+                while (res == PLAN_STEP_SKIPPED)
+                {   //the rotation is within the correction band of the part, so go straight on to the next step
+                    formatLogMessage(&log_line, getSimulationTime(), "Plan step ");
+                    addLogInteger(&log_line, next_step + 1);
+                    addLogText(&log_line, " of ");
+                    addLogInteger(&log_line, plan.length);
+                    addLogText(&log_line, ": ");
+                    addLogText(&log_line, getInstructionName(step -> instruction));
+                    addLogText(&log_line, " skipped, ");
+                    addLogText(&log_line, getNozzleName(step -> argument_3));
+                    addLogText(&log_line, " nozzle is within the correction band\n");
+                    writeDisplayLog(log_line.text);
+                    if (++next_step == plan.length) break;
+                    step = &plan.step[next_step];
+                    res = issuePlanStep(step, pi);
+                }
+                if (res == TRUE)
+                {
+                    formatLogMessage(&log_line, getSimulationTime(), "Plan step ");
+                    addLogInteger(&log_line, next_step + 1);
+                    addLogText(&log_line, " of ");
+                    addLogInteger(&log_line, plan.length);
+                    addLogText(&log_line, ": ");
+                    addLogText(&log_line, getInstructionName(step -> instruction));
+                    addLogText(&log_line, " (predicted start ");
+                    addLogFixed(&log_line, step -> start_time, 0, 2);
+                    addLogText(&log_line, ")\n");
+                    writeDisplayLog(log_line.text);
+                    next_step++;
+                    waiting_for_feeder = FALSE;
+                }
+                else if (res == FALSE && waiting_for_feeder == FALSE)
+                {
+                    formatLogMessage(&log_line, getSimulationTime(), "Plan step ");
+                    addLogInteger(&log_line, next_step + 1);
+                    addLogText(&log_line, " of ");
+                    addLogInteger(&log_line, plan.length);
+                    addLogText(&log_line, ": waiting for feeder ");
+                    addLogInteger(&log_line, step -> feeder);
+                    addLogText(&log_line, "\n");
+                    writeDisplayLog(log_line.text);
+                    waiting_for_feeder = TRUE;
+                }
+            }
+            waitForNextPollLoop();
+        }
+    }
+
+
     /*
     *****************************************************
     *
@@ -405,72 +872,75 @@ int main(int argc, char *argv[])
     else
     {
         /* initialization of variables and controller window */
-        int state = HOME, part_counter = 0, nozzle_errors_to_check = 0, left_nozzle_part_num = 0,
-            centre_nozzle_part_num = 0, right_nozzle_part_num = 0, component_num, req_target = 0;
-        char part_placed = FALSE, Centre_NozzleStatus = not_holdingpart, Left_NozzleStatus = not_holdingpart,
-            Right_NozzleStatus = not_holdingpart, lookup_photo = FALSE, lookdown_photo = FALSE, loaded = 1, PCB_status = 0, unloaded = 0;
-        double requested_theta_left = 0, requested_theta_centre = 0, requested_theta_right = 0;  //the required angle theta of the nozzle position
+        int state = HOME, part_counter = 0, component_num = 0, req_target = 0;
+        int number_of_nozzles = getNumberOfNozzles(), nozzle = 0, check_nozzle = 0;
+        int nozzle_part_num[MAX_NUMBER_OF_NOZZLES];  //index of the part held on each nozzle
+        char nozzle_status[MAX_NUMBER_OF_NOZZLES];  //holdingpart or not_holdingpart for each nozzle
+        char part_placed = FALSE, lookup_photo = FALSE, lookdown_photo = FALSE, loaded = 1, PCB_status = 0, unloaded = 0;
+        char use_move_correct_lower = TRUE;  //place with the single MOVE_CORRECT_LOWER instruction until the simulator rejects one
+        char flown_over_camera = FALSE;  //the head is already over the first placement after a fly-over lookup photo
+        char batch_stationary = FALSE;  //a part on the nozzles must be photographed with the head stopped over the camera
+        char board_aligned = FALSE;  //the board position has been found from its fiducials, so placements need no lookdown photo
+        int fiducial_num = 0;
+        double fiducial_measured_x[MAX_NUMBER_OF_FIDUCIALS], fiducial_measured_y[MAX_NUMBER_OF_FIDUCIALS];
+        BoardTransform board;
+        double requested_theta = 0;  //the required angle theta of the nozzle position
         double preplace_diff_x = 0, preplace_diff_y = 0;  //difference in required gantry position and actual gantry position for preplacement
 
+        for (int n = 0; n < MAX_NUMBER_OF_NOZZLES; n++)
+        {
+            nozzle_part_num[n] = 0;
+            nozzle_status[n] = not_holdingpart;
+        }
 
-        sprintf(Contrl_str_array, "Time: %7.2f  Initial state: %.15s  Operating in automatic mode. There are %d parts to place\n\n", getSimulationTime(), state_name[HOME], number_of_components_to_place);
-        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+        formatLogMessage(&log_line, getSimulationTime(), "Initial state: ");
+        addLogString(&log_line, state_name[HOME], 15);
+        addLogText(&log_line, "  Operating in automatic mode. There are ");
+        addLogInteger(&log_line, number_of_components_to_place);
+        addLogText(&log_line, " parts to place with ");
+        addLogInteger(&log_line, number_of_nozzles);
+        addLogText(&log_line, " nozzles\n\n");
+        writeDisplayLog(log_line.text);
 
 
         /* reorder the centroid list by feeder in ascending order and print details */
 
         int component_list[number_of_components_to_place];
-        int feeder_num_compare[number_of_components_to_place];
-        int y_target_compare[number_of_components_to_place];
-        int i, j, hold_value;
+        double placement_x[number_of_components_to_place];  //machine position and rotation of each placement, corrected for the board position once known
+        double placement_y[number_of_components_to_place];
+        double placement_theta[number_of_components_to_place];
+        int i;
         for (i = 0; i < number_of_components_to_place; i++)
         {
-            feeder_num_compare[i] = pi[i].feeder;  //holds the feeder numbers in the centroid file
-            y_target_compare[i] = pi[i].y_target;  // holds the y coord values in the centroid file
-            component_list[i] = i;  //holds the indexes that correlate to the values
-        }
-        for (i = 0; i < number_of_components_to_place; i++)
-        {
-            for (j = i+1; j < number_of_components_to_place; j++)
-            {
-                if (feeder_num_compare[i] > feeder_num_compare[j])
-                {  //reorder the indexed numbers based on the feeder numbers. Swaps the y-coords so they correlate
-                    hold_value = component_list[i];
-                    component_list[i] = component_list[j];
-                    component_list[j] = hold_value;
-                    hold_value = feeder_num_compare[i];
-                    feeder_num_compare[i] = feeder_num_compare[j];
-                    feeder_num_compare[j] = hold_value;
-                    hold_value = y_target_compare[i];
-                    y_target_compare[i] = y_target_compare[j];
-                    y_target_compare[j] = hold_value;
-                }
-                // sort by ascending y-coordinates if the feeder numbers are the same
-                else if (feeder_num_compare[i] == feeder_num_compare[j])
-                {
-                    if (y_target_compare[i] > y_target_compare[j])
-                    {
-                        hold_value = component_list[i];
-                        component_list[i] = component_list[j];
-                        component_list[j] = hold_value;
-                        hold_value = y_target_compare[i];
-                        y_target_compare[i] = y_target_compare[j];
-                        y_target_compare[j] = hold_value;
-                        hold_value = feeder_num_compare[i];
-                        feeder_num_compare[i] = feeder_num_compare[j];
-                        feeder_num_compare[j] = hold_value;
-                    }
-                }
-            }
+            placement_x[i] = pi[i].x_target;
+            placement_y[i] = pi[i].y_target;
+            placement_theta[i] = pi[i].theta_target;
         }
+        sortPickList(pi, number_of_components_to_place, component_list);
+
         //display the new order of the part details
         for (int i = 0; i < number_of_components_to_place; i++)
         {
             component_num = component_list[i];
-            sprintf(Contrl_str_array, "Part %d:\nDesignation: %s  Footprint: %s  Value: %.2f  x: %.2f  y: %.2f  theta: %.2f  Feeder: %d\n\n", component_num,
-                pi[component_num].component_designation, pi[component_num].component_footprint, pi[component_num].component_value,
-                pi[component_num].x_target, pi[component_num].y_target, pi[component_num].theta_target, pi[component_num].feeder);
-            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+            clearLogLine(&log_line);
+            addLogText(&log_line, "Part ");
+            addLogInteger(&log_line, component_num);
+            addLogText(&log_line, ":\nDesignation: ");
+            addLogText(&log_line, pi[component_num].component_designation);
+            addLogText(&log_line, "  Footprint: ");
+            addLogText(&log_line, pi[component_num].component_footprint);
+            addLogText(&log_line, "  Value: ");
+            addLogFixed(&log_line, pi[component_num].component_value, 0, 2);
+            addLogText(&log_line, "  x: ");
+            addLogFixed(&log_line, pi[component_num].x_target, 0, 2);
+            addLogText(&log_line, "  y: ");
+            addLogFixed(&log_line, pi[component_num].y_target, 0, 2);
+            addLogText(&log_line, "  theta: ");
+            addLogFixed(&log_line, pi[component_num].theta_target, 0, 2);
+            addLogText(&log_line, "  Feeder: ");
+            addLogInteger(&log_line, pi[component_num].feeder);
+            addLogText(&log_line, "\n\n");
+            writeDisplayLog(log_line.text);
         }
 
 
@@ -478,6 +948,8 @@ int main(int argc, char *argv[])
         while(!isPnPSimulationQuitFlagOn())
         {
 
+            reportFeederEvents();
+
             switch (state)
             {
 
@@ -485,13 +957,12 @@ int main(int argc, char *argv[])
 
                     if(isSimulatorReadyForNextInstruction())
                     {
-                        component_num = component_list[part_counter];  //hold the value of the part to be placed. The counter starts at zero
                         if(part_counter == number_of_components_to_place)
                         {  // program is complete, terminate program
                             sem_wait(sem_Sim); // waiting for the simulator to finish unloading the PCB
-                            sprintf(Contrl_str_array, "Time: %7.2f  Terminating...\n", getSimulationTime());
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                            close(writeContrlToDisplayFd);
+                            formatLogMessage(&log_line, getSimulationTime(), "Terminating...\n");
+                            writeDisplayLog(log_line.text);
+                            closeDisplayLog();
                             pnpClose();
                             sem_post(sem_Contrl);  // allow the simulator to terminate
                             sem_close(sem_Sim);
@@ -499,12 +970,17 @@ int main(int argc, char *argv[])
                             sem_close(sem_Contrl);
                             exit(30);
                         }
-                        else if(PCB_status == loaded)
-                        {//program has cycled back around, go to the next feeder, +20 for the left nozzle positioning
-                            setTargetPos(TAPE_FEEDER_X[pi[component_num].feeder]+20, TAPE_FEEDER_Y[pi[component_num].feeder]);
+                        nozzle = getNextNozzleWithStatus(nozzle_status, number_of_nozzles, 0, not_holdingpart);
+                        chooseNextPick(component_list, part_counter, number_of_components_to_place, pi, nozzle);
+                        component_num = component_list[part_counter];  //hold the value of the part to be placed. The counter starts at zero
+                        if(PCB_status == loaded)
+                        {//program has cycled back around, go to the next feeder with the first empty nozzle positioned over it
+                            moveNozzleToFeeder(nozzle, pi[component_num].feeder);
                             state = MOVE_TO_FEEDER;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Moving to tape feeder %d\n", getSimulationTime(), state_name[state], pi[component_num].feeder);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "Moving to tape feeder ");
+                            addLogInteger(&log_line, pi[component_num].feeder);
+                            addLogText(&log_line, "\n");
+                            writeDisplayLog(log_line.text);
                         }
 
                         else if (PCB_status == unloaded)
@@ -512,8 +988,10 @@ int main(int argc, char *argv[])
                             loadPCB();
                             state = PCB;
                             PCB_status = loaded;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New State: %.15s  Loading PCB onto pick and place machine\n\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                            formatLogMessage(&log_line, getSimulationTime(), "New State: ");
+                            addLogString(&log_line, state_name[state], 15);
+                            addLogText(&log_line, "  Loading PCB onto pick and place machine\n\n");
+                            writeDisplayLog(log_line.text);
                         }
                     }
                     break;
@@ -521,300 +999,256 @@ int main(int argc, char *argv[])
                 case PCB:
                     if(isSimulatorReadyForNextInstruction())
                     {
-                        if(PCB_status == loaded)
-                        {//once PCB is loaded, go to the first feeder in the list, +20 for the left nozzle positioning
-                            setTargetPos(TAPE_FEEDER_X[pi[component_num].feeder]+20, TAPE_FEEDER_Y[pi[component_num].feeder]);
+                        if(PCB_status == loaded && machine -> number_of_fiducials >= 2)
+                        {//once PCB is loaded, find where it is from the fiducials, starting with the first
+                            fiducial_num = 0;
+                            setTargetPos(machine -> fiducial_x[fiducial_num], machine -> fiducial_y[fiducial_num]);
+                            state = MOVE_TO_FIDUCIAL;
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "Moving to fiducial ");
+                            addLogInteger(&log_line, fiducial_num);
+                            addLogText(&log_line, "\n");
+                            writeDisplayLog(log_line.text);
+                        }
+                        else if(PCB_status == loaded)
+                        {//once PCB is loaded, go to the first feeder in the list with the first nozzle positioned over it
+                            moveNozzleToFeeder(nozzle, pi[component_num].feeder);
                             state = MOVE_TO_FEEDER;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Moving to tape feeder %d\n", getSimulationTime(), state_name[state], pi[component_num].feeder);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "Moving to tape feeder ");
+                            addLogInteger(&log_line, pi[component_num].feeder);
+                            addLogText(&log_line, "\n");
+                            writeDisplayLog(log_line.text);
                         }
                         else if(PCB_status == unloaded)
                         {  // if the PCB has just been unloaded then program is complete, go to HOME to terminate
                             state = HOME;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  PCB unloaded successfully\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "PCB unloaded successfully\n");
+                            writeDisplayLog(log_line.text);
                         }
                     }
                     break;
 
 
-                case MOVE_TO_FEEDER:
-                    //waiting for the simulator to complete movement of the gantry
+                case MOVE_TO_FIDUCIAL:
                     if (isSimulatorReadyForNextInstruction())
                     {
-                        if (Left_NozzleStatus == not_holdingpart) // if the nozzle is already holding a part, then skip to the next nozzle
-                        {  //left nozzle goes first due to order of the parts ascending by feeder number
-                            lowerNozzle(LEFT_NOZZLE);
-                            state = LOWER_LEFT_NOZZLE;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Arrived at feeder, lowering left nozzle\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                        }
-                        else if (Centre_NozzleStatus == not_holdingpart)
-                        { // centre nozzle picks up part after left nozzle
-                            lowerNozzle(CENTRE_NOZZLE);
-                            state = LOWER_CNTR_NOZZLE;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Arrived at feeder, lowering centre nozzle\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                        }
-                        else if (Right_NozzleStatus == not_holdingpart)
-                        {  //right nozzle is last to pick up part as it is closest to the higher feeder number
-                            lowerNozzle(RIGHT_NOZZLE);
-                            state = LOWER_RIGHT_NOZZLE;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Arrived at feeder, lowering right nozzle\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                        }
-
+                        takePhoto(PHOTO_LOOKDOWN);
+                        state = LOOK_DOWN_FIDUCIAL;
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Taking look-down photo of fiducial ");
+                        addLogInteger(&log_line, fiducial_num);
+                        addLogText(&log_line, "\n");
+                        writeDisplayLog(log_line.text);
                     }
                     break;
 
-                case LOWER_LEFT_NOZZLE:
+                case LOOK_DOWN_FIDUCIAL:
                     if (isSimulatorReadyForNextInstruction())
                     {
-                        if(Left_NozzleStatus == not_holdingpart)
-                        {   //vacuum will apply when the nozzle is empty
-                            applyVacuum(LEFT_NOZZLE);
-                            state = VAC_LEFT_NOZZLE;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Applying vacuum\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        if (getFiducialInView() == fiducial_num)
+                        {   //the head was over the nominal fiducial position, so the fiducial is that plus the offset seen
+                            fiducial_measured_x[fiducial_num] = machine -> fiducial_x[fiducial_num] + getFiducialOffsetX();
+                            fiducial_measured_y[fiducial_num] = machine -> fiducial_y[fiducial_num] + getFiducialOffsetY();
+                            fiducial_num++;
                         }
-                        else if(Left_NozzleStatus == holdingpart)
-                        {   //vacuum will release the part when the nozzle is holding something
-                            releaseVacuum(LEFT_NOZZLE);
-                            part_placed = TRUE;  //counter to indicate the part has been placed
-                            state = VAC_LEFT_NOZZLE;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Releasing vacuum to place part\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        else
+                        {
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "Fiducial ");
+                            addLogInteger(&log_line, fiducial_num);
+                            addLogText(&log_line, " not found, using a look-down photo at every placement\n");
+                            writeDisplayLog(log_line.text);
+                            fiducial_num = machine -> number_of_fiducials + 1;
                         }
-                    }
 
-                    break;
-
-                case LOWER_CNTR_NOZZLE:
-                    if (isSimulatorReadyForNextInstruction())
-                    {
-                        if(Centre_NozzleStatus == not_holdingpart)
-                        {   //vacuum will apply when the nozzle is empty
-                            applyVacuum(CENTRE_NOZZLE);
-                            state = VAC_CNTR_NOZZLE;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Applying vacuum\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        if (fiducial_num < machine -> number_of_fiducials)
+                        {
+                            setTargetPos(machine -> fiducial_x[fiducial_num], machine -> fiducial_y[fiducial_num]);
+                            state = MOVE_TO_FIDUCIAL;
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "Moving to fiducial ");
+                            addLogInteger(&log_line, fiducial_num);
+                            addLogText(&log_line, "\n");
+                            writeDisplayLog(log_line.text);
                         }
-                        else if(Centre_NozzleStatus == holdingpart)
-                        {   //vacuum will release the part when the nozzle is holding something
-                            releaseVacuum(CENTRE_NOZZLE);
-                            part_placed = TRUE;  //counter to indicate the part has been placed
-                            state = VAC_CNTR_NOZZLE;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Releasing vacuum to place part\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        else
+                        {
+                            if (fiducial_num == machine -> number_of_fiducials
+                                && fitBoardTransform(machine -> fiducial_x, machine -> fiducial_y, fiducial_measured_x, fiducial_measured_y, fiducial_num, &board) == BOARD_TRANSFORM_FITTED)
+                            {   //correct every placement for the board position, so no look-down photos are needed when placing
+                                for (i = 0; i < number_of_components_to_place; i++)
+                                {
+                                    boardToMachine(&board, pi[i].x_target, pi[i].y_target, &placement_x[i], &placement_y[i]);
+                                    placement_theta[i] = pi[i].theta_target + board.rotation;
+                                }
+                                board_aligned = TRUE;
+                                formatLogMessage(&log_line, getSimulationTime(), "Board offset ");
+                                addLogPoint(&log_line, board.offset_x, board.offset_y, 3);
+                                addLogText(&log_line, " rotation ");
+                                addLogFixed(&log_line, board.rotation, 0, 3);
+                                addLogText(&log_line, " degrees scale ");
+                                addLogFixed(&log_line, board.scale, 0, 5);
+                                addLogText(&log_line, "\n");
+                                writeDisplayLog(log_line.text);
+                            }
+                            moveNozzleToFeeder(nozzle, pi[component_num].feeder);
+                            state = MOVE_TO_FEEDER;
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "Moving to tape feeder ");
+                            addLogInteger(&log_line, pi[component_num].feeder);
+                            addLogText(&log_line, "\n");
+                            writeDisplayLog(log_line.text);
                         }
                     }
-
                     break;
 
-                case LOWER_RIGHT_NOZZLE:
-                    if (isSimulatorReadyForNextInstruction())
-                    {
-                        if(Right_NozzleStatus == not_holdingpart)
-                        {   //vacuum will apply when the nozzle is empty
-                            applyVacuum(RIGHT_NOZZLE);
-                            state = VAC_RIGHT_NOZZLE;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Applying vacuum\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                        }
-                        else if(Right_NozzleStatus == holdingpart)
-                        {   //vacuum will release the part when the nozzle is holding something
-                            releaseVacuum(RIGHT_NOZZLE);
-                            part_placed = TRUE;  //counter to indicate the part has been placed
-                            state = VAC_RIGHT_NOZZLE;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Releasing vacuum to place part\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                        }
+                case MOVE_TO_FEEDER:
+                    //waiting for the simulator to complete movement of the gantry, the empty nozzle is now over the feeder
+                    if (isSimulatorReadyForNextInstruction() && isFeederReadyByPickTime(pi[component_num].feeder))
+                    {   //the simulator lowers, applies the vacuum and raises without waiting for the controller in between
+                        runPickProgram(nozzle, pi[component_num].feeder);
+                        state = RAISING_NOZZLE;
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Arrived at feeder, picking with ");
+                        addLogText(&log_line, getNozzleName(nozzle));
+                        addLogText(&log_line, " nozzle\n");
+                        writeDisplayLog(log_line.text);
+                    }
+                    else if (isSimulatorReadyForNextInstruction())
+                    {   //the tape is still advancing from the last pick, or the feeder is waiting for a new reel
+                        state = WAIT_FOR_FEEDER;
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Arrived at feeder ");
+                        addLogInteger(&log_line, pi[component_num].feeder);
+                        addLogText(&log_line, ", waiting until ");
+                        addLogFixed(&log_line, getFeederReadyTime(pi[component_num].feeder), 0, 2);
+                        addLogText(&log_line, " for the next part\n");
+                        writeDisplayLog(log_line.text);
                     }
-
                     break;
 
-                case VAC_LEFT_NOZZLE:
-                    //wait until the vacuum action is finished before raising the nozzle
-                    if (isSimulatorReadyForNextInstruction())
+                case WAIT_FOR_FEEDER:
+                    if (isFeederReadyByPickTime(pi[component_num].feeder))
                     {
-                        raiseNozzle(LEFT_NOZZLE);
-                        state = RAISE_LEFT_NOZZLE;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Raising left nozzle\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        runPickProgram(nozzle, pi[component_num].feeder);
+                        state = RAISING_NOZZLE;
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Feeder ready, picking with ");
+                        addLogText(&log_line, getNozzleName(nozzle));
+                        addLogText(&log_line, " nozzle\n");
+                        writeDisplayLog(log_line.text);
                     }
                     break;
 
-                case VAC_CNTR_NOZZLE:
-                    //wait until the vacuum action is finished before raising the nozzle
+                case LOWERING_NOZZLE:
                     if (isSimulatorReadyForNextInstruction())
                     {
-                        raiseNozzle(CENTRE_NOZZLE);
-                        state = RAISE_CNTR_NOZZLE;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Raising centre nozzle\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        if(nozzle_status[nozzle] == not_holdingpart)
+                        {   //vacuum will apply when the nozzle is empty
+                            applyVacuum(nozzle);
+                            state = VACUUM_NOZZLE;
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "Applying vacuum\n");
+                            writeDisplayLog(log_line.text);
+                        }
+                        else if(nozzle_status[nozzle] == holdingpart)
+                        {   //vacuum will release the part when the nozzle is holding something
+                            releaseVacuum(nozzle);
+                            part_placed = TRUE;  //counter to indicate the part has been placed
+                            state = VACUUM_NOZZLE;
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "Releasing vacuum to place part\n");
+                            writeDisplayLog(log_line.text);
+                        }
                     }
                     break;
 
-                case VAC_RIGHT_NOZZLE:
+                case VACUUM_NOZZLE:
                     //wait until the vacuum action is finished before raising the nozzle
                     if (isSimulatorReadyForNextInstruction())
                     {
-                        raiseNozzle(RIGHT_NOZZLE);
-                        state = RAISE_RIGHT_NOZZLE;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Raising right nozzle\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        raiseNozzle(nozzle);
+                        state = RAISING_NOZZLE;
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Raising ");
+                        addLogText(&log_line, getNozzleName(nozzle));
+                        addLogText(&log_line, " nozzle\n");
+                        writeDisplayLog(log_line.text);
                     }
                     break;
 
-                case RAISE_LEFT_NOZZLE:
+                case RAISING_NOZZLE:
 
                     if (isSimulatorReadyForNextInstruction())
                     {
                         if (part_placed==FALSE) // applies when the nozzle has not just placed a part
                         {
-                            left_nozzle_part_num = component_num;  //storing the index of the part number from the reordered list
+                            nozzle_part_num[nozzle] = component_num;  //storing the index of the part number from the reordered list
+                            nozzle_status[nozzle] = holdingpart; //if a part hasn't just been placed then it is determined that a part has just been picked up
+                            if (getPackageVision(getComponentLibrary(), pi[component_num].package) == VISION_STATIONARY) batch_stationary = TRUE;
                             part_counter++;  //incrementing the number of parts that have been picked
-                            component_num = component_list[part_counter];  //hold the index value of the next component
-                            Left_NozzleStatus = holdingpart; //if a part hasn't just been placed then it is determined that a part has just been picked up
-                            nozzle_errors_to_check++;  //the picked up part needs to be checked for alignment errors
-                            if (part_counter == number_of_components_to_place)
-                            {  //if there is no other feeder in the file, then go to the camera
-                                setTargetPos(LOOKUP_CAMERA_X,LOOKUP_CAMERA_Y);
+                            nozzle = getNextNozzleWithStatus(nozzle_status, number_of_nozzles, 0, not_holdingpart);
+                            if ((part_counter == number_of_components_to_place || nozzle == NO_NOZZLE) && machine -> lookup_camera_fly_over == TRUE && batch_stationary == FALSE)
+                            {  //if there are no more parts or no more empty nozzles, then head for the first placement, photographing the parts over the camera on the way
+                                nozzle = getNextNozzleWithStatus(nozzle_status, number_of_nozzles, 0, holdingpart);
+                                req_target = nozzle_part_num[nozzle];
+                                setTargetPosViaCamera(placement_x[req_target], placement_y[req_target]);
+                                state = MOVE_VIA_CAMERA;
+                                formatStateLog(&log_line, getSimulationTime(), state_name[state], "Part acquired, moving to PCB via look-up camera\n");
+                                writeDisplayLog(log_line.text);
+                            }
+                            else if (part_counter == number_of_components_to_place || nozzle == NO_NOZZLE)
+                            {  //if there are no more parts or no more empty nozzles, then go to the camera
+                                batch_stationary = FALSE;
+                                setTargetPos(machine -> lookup_camera_x, machine -> lookup_camera_y);
                                 state = MOVE_TO_CAMERA;
-                                sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Part acquired, moving to look-up camera\n", getSimulationTime(), state_name[state]);
-                                write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                                formatStateLog(&log_line, getSimulationTime(), state_name[state], "Part acquired, moving to look-up camera\n");
+                                writeDisplayLog(log_line.text);
                             }
                             else
                             {
-                                //if there is another feeder waiting, then go to the next feeder in the reordered list, positioned for the centre nozzle
-                                setTargetPos(TAPE_FEEDER_X[pi[component_num].feeder], TAPE_FEEDER_Y[pi[component_num].feeder]);
+                                //if there is another part waiting, then go to the feeder that can be picked from soonest, positioned for the next empty nozzle
+                                chooseNextPick(component_list, part_counter, number_of_components_to_place, pi, nozzle);
+                                component_num = component_list[part_counter];  //hold the index value of the next component
+                                moveNozzleToFeeder(nozzle, pi[component_num].feeder);
                                 state = MOVE_TO_FEEDER;
-                                sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Moving to feeder %d\n", getSimulationTime(), state_name[state], pi[component_num].feeder);
-                                write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                                formatStateLog(&log_line, getSimulationTime(), state_name[state], "Moving to feeder ");
+                                addLogInteger(&log_line, pi[component_num].feeder);
+                                addLogText(&log_line, "\n");
+                                writeDisplayLog(log_line.text);
                             }
                         }
 
                         else if (part_placed==TRUE)
                         {
-                            Left_NozzleStatus = not_holdingpart; //if the vacuum has just released a part, then the part has been placed and the nozzle is free again
+                            nozzle_status[nozzle] = not_holdingpart; //if the vacuum has just released a part, then the part has been placed and the nozzle is free again
                             part_placed = FALSE;  //reset the variable
                             lookdown_photo = FALSE;  //reset the photo variable
+                            nozzle = getNextNozzleWithStatus(nozzle_status, number_of_nozzles, 0, holdingpart);
 
-                            if (Centre_NozzleStatus == holdingpart)
-                            {  //if the centre nozzle has a part, then move to the required position on the PCB
-                                req_target = centre_nozzle_part_num; // this is required to obtain the correct alignment errors
-                                setTargetPos(pi[centre_nozzle_part_num].x_target, pi[centre_nozzle_part_num].y_target);
-                                state = MOVE_TO_PCB;
-                                sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Moving to next position x: %3.2f y: %3.2f\n", getSimulationTime(), state_name[state],pi[centre_nozzle_part_num].x_target, pi[centre_nozzle_part_num].y_target);
-                                write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                            if (nozzle != NO_NOZZLE)
+                            {  //if another nozzle has a part, then move to the required position on the PCB
+                                req_target = nozzle_part_num[nozzle]; // this is required to obtain the correct alignment errors
+                                if (board_aligned == FALSE && use_move_correct_lower == TRUE)
+                                {
+                                    moveCorrectAndLower(placement_x[req_target], placement_y[req_target], nozzle);
+                                    state = MOVE_AND_CORRECT;
+                                }
+                                else
+                                {
+                                    setTargetPos(placement_x[req_target], placement_y[req_target]);
+                                    state = MOVE_TO_PCB;
+                                }
+                                formatStateLog(&log_line, getSimulationTime(), state_name[state], "Moving to next position x: ");
+                                addLogFixed(&log_line, placement_x[req_target], 3, 2);
+                                addLogText(&log_line, " y: ");
+                                addLogFixed(&log_line, placement_y[req_target], 3, 2);
+                                addLogText(&log_line, "\n");
+                                writeDisplayLog(log_line.text);
                             }
 
                             else if(part_counter == number_of_components_to_place)
                             {  //there are no more parts to place, so move gantry to home
-                                setTargetPos(HOME_X,HOME_Y);
+                                setTargetPos(machine -> home_x, machine -> home_y);
                                 state = MOVE_TO_HOME;
-                                sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  All parts have been placed! Moving to home\n", getSimulationTime(), state_name[state]);
-                                write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                            }
-                        }
-                    }
-                    break;
-
-                case RAISE_CNTR_NOZZLE:
-
-                    if (isSimulatorReadyForNextInstruction())
-                    {
-                        if (part_placed==FALSE)  //applies if the nozzle has not just placed a part on the PCB
-                        {
-                            centre_nozzle_part_num = component_num;  //holding the indexed value of the component for the centre nozzle
-                            part_counter++;  //increment the part counter to ensure number of components are accounted for
-                            component_num = component_list[part_counter];  //hold the next part number index
-                            Centre_NozzleStatus = holdingpart; //if a part hasn't just been placed, then it is determined that a part has just been picked up
-                            nozzle_errors_to_check++;  //the part needs to be checked for alignment errors
-                            if (part_counter == number_of_components_to_place)
-                            {   //if no other feeder and no other parts to pick up, then go to the camera
-                                setTargetPos(LOOKUP_CAMERA_X,LOOKUP_CAMERA_Y);  //the gantry will move to the position above the camera
-                                state = MOVE_TO_CAMERA;
-                                sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Part acquired, moving to look-up camera\n", getSimulationTime(), state_name[state]);
-                                write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                                formatStateLog(&log_line, getSimulationTime(), state_name[state], "All parts have been placed! Moving to home\n");
+                                writeDisplayLog(log_line.text);
                             }
                             else
-                            {   //if there is another feeder number waiting, then go to the next feeder
-                                setTargetPos(TAPE_FEEDER_X[pi[component_num].feeder]-20, TAPE_FEEDER_Y[pi[component_num].feeder]);  //move to the next feeder for the right nozzle
-                                state = MOVE_TO_FEEDER;
-                                sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Moving to feeder %d\n", getSimulationTime(), state_name[state], pi[component_num].feeder);
-                                write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                            }
-                        }
-
-                        else if (part_placed==TRUE)
-                        {
-                            Centre_NozzleStatus = not_holdingpart; //if the vacuum has just released a part, then the part has been placed and the nozzle is free again
-                            lookdown_photo = FALSE;  //reset the photo variabla
-                            part_placed = FALSE;  //reset the variable
-
-                            if (Right_NozzleStatus == holdingpart)
-                            {  //if the right nozzle has a part then, move to the required position on the PCB
-                                req_target = right_nozzle_part_num;  // this is required in order to calculate preplace errors
-                                setTargetPos(pi[right_nozzle_part_num].x_target, pi[right_nozzle_part_num].y_target); //right nozzle holding part_counter-1
-                                state = MOVE_TO_PCB;
-                                sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Moving to next position x: %3.2f y: %3.2f\n", getSimulationTime(), state_name[state],pi[right_nozzle_part_num].x_target, pi[right_nozzle_part_num].y_target);
-                                write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                            }
-
-                            else if(part_counter == number_of_components_to_place)
-                            {  //if there are no more parts to place then go to home
-                                setTargetPos(HOME_X,HOME_Y);
-                                state = MOVE_TO_HOME;
-                                sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  All parts have been placed! Moving to home\n", getSimulationTime(), state_name[state]);
-                                write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                            }
-
-                        }
-                    }
-                    break;
-
-                case RAISE_RIGHT_NOZZLE:
-
-                    if (isSimulatorReadyForNextInstruction())
-                    {
-                        if (part_placed==FALSE)  // applies if the nozzle hasn't just placed a part on the PCB
-                        {
-                            right_nozzle_part_num = component_num;  //storing the indexed value of the component
-                            part_counter++;  //keeping a counter on the number of parts that have been picked up
-                            component_num = component_list[part_counter];  //storing the next part index
-                            Right_NozzleStatus = holdingpart;//once nozzle is raised, if a part hasn't just been placed, then it is determined that a part has just been picked up
-                            nozzle_errors_to_check++;  //right nozzle needs to be checked for alignment errors
-                            setTargetPos(LOOKUP_CAMERA_X,LOOKUP_CAMERA_Y);  //the right nozzle is the last to pick up a part, so the gantry will move to the camera
-                            state = MOVE_TO_CAMERA;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  All parts acquired, moving to look-up camera\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                        }
-
-                        else if (part_placed==TRUE)
-                        {
-                            Right_NozzleStatus = not_holdingpart; //if the vacuum has just released a part, then the part has been placed and the nozzle is free again
-                            lookdown_photo = FALSE;  //reset the photo variable
-                            part_placed = FALSE;  //reset the variable
-
-                            if(part_counter == number_of_components_to_place)
-                            {  //if there are no more parts to place, then go to home
-                                if (isSimulatorReadyForNextInstruction())
-                                {
-                                    setTargetPos(HOME_X,HOME_Y);
-                                    state = MOVE_TO_HOME;
-                                    sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  All parts have been placed! Moving to home.\n", getSimulationTime(), state_name[state]);
-                                    write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                                }
-
-                            }
-                            else
-                            {   // once the part is placed, if there are more parts then go to home to obtain details for the next feeder
+                            {   // once all the nozzles are empty, if there are more parts then go to home to obtain details for the next feeder
                                 state = HOME;
-                                sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Moving to next feeder\n", getSimulationTime(), state_name[state]);
-                                write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                                formatStateLog(&log_line, getSimulationTime(), state_name[state], "Moving to next feeder\n");
+                                writeDisplayLog(log_line.text);
                             }
-
                         }
                     }
                     break;
@@ -825,29 +1259,61 @@ int main(int argc, char *argv[])
                     {
                         takePhoto(PHOTO_LOOKUP);
                         state = LOOK_UP_PHOTO;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Arrived at camera. Taking look-up photo of part\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Arrived at camera. Taking look-up photo of part\n");
+                        writeDisplayLog(log_line.text);
+                    }
+                    break;
+
+                case MOVE_VIA_CAMERA:
+                    if (isSimulatorReadyForNextInstruction())
+                    {   //the parts were photographed in flight and the head is over the first placement, so calculate errors, starting from the first nozzle
+                        lookup_photo = TRUE;
+                        flown_over_camera = TRUE;
+                        check_nozzle = 0;
+                        state = CHECK_ERROR;
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Now at PCB. Checking errors and calculating corrections\n");
+                        writeDisplayLog(log_line.text);
                     }
                     break;
 
                 case LOOK_UP_PHOTO:
                     if (isSimulatorReadyForNextInstruction())
-                    {   //once look-up photo is taken, move on to calculate errors
+                    {   //once look-up photo is taken, move on to calculate errors, starting from the first nozzle
                         lookup_photo = TRUE;
+                        check_nozzle = 0;
                         state = CHECK_ERROR;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Checking errors and calculating corrections\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Checking errors and calculating corrections\n");
+                        writeDisplayLog(log_line.text);
                     }
                     break;
 
                 case MOVE_TO_PCB:
-                    //once the gantry has finished moving to the PCB, then it is ready to take a look-down photo
-                    if (isSimulatorReadyForNextInstruction())
+                    //once the gantry has finished moving to the PCB, the part can be placed if the board position is known, otherwise it is ready to take a look-down photo
+                    if (isSimulatorReadyForNextInstruction() && board_aligned == TRUE)
+                    {
+                        runPlaceProgram(nozzle, FALSE);
+                        part_placed = TRUE;
+                        state = RAISING_NOZZLE;
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Now at PCB. Placing part with ");
+                        addLogText(&log_line, getNozzleName(nozzle));
+                        addLogText(&log_line, " nozzle\n");
+                        writeDisplayLog(log_line.text);
+                    }
+                    else if (isSimulatorReadyForNextInstruction() && use_move_correct_lower == TRUE)
+                    {   //already over the placement, so this only takes the photo, corrects and lowers
+                        moveCorrectAndLower(placement_x[req_target], placement_y[req_target], nozzle);
+                        state = MOVE_AND_CORRECT;
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Now at PCB. Correcting position and lowering ");
+                        addLogText(&log_line, getNozzleName(nozzle));
+                        addLogText(&log_line, " nozzle\n");
+                        writeDisplayLog(log_line.text);
+                    }
+                    else if (isSimulatorReadyForNextInstruction())
                     {
                         state = LOOK_DOWN_PHOTO;
                         takePhoto(PHOTO_LOOKDOWN);
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Now at PCB. Taking look-down photo\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Now at PCB. Taking look-down photo\n");
+                        writeDisplayLog(log_line.text);
                     }
                     break;
 
@@ -856,58 +1322,79 @@ int main(int argc, char *argv[])
                     {
                         lookdown_photo = TRUE;
                         state = CHECK_ERROR;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Look-down photo acquired. Calculating corrections\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Look-down photo acquired. Calculating corrections\n");
+                        writeDisplayLog(log_line.text);
                     }
                     break;
 
                 case CHECK_ERROR:
                     //wait until the photo is taken, then calculate errors
                     if (isSimulatorReadyForNextInstruction() && lookup_photo == TRUE)
-                    {   //for look-up photos, cycle through and correct errors one by one using nozzle_errors_to_check as a counter
-                        if (nozzle_errors_to_check == 3)
-                        {   //since the right nozzle is last to pick up a part, it is the first to be corrected
-                            double errortheta = getPickErrorTheta(RIGHT_NOZZLE);  //acquire the part misalignment from the look-up photo
-                            requested_theta_right = pi[right_nozzle_part_num].theta_target - errortheta;  //calculate misalignment of the part on the nozzle
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Right part misalignment error: %3.2f  Correction required: %3.2f degrees\n", getSimulationTime(), state_name[state], errortheta, requested_theta_right);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                            state = FIX_NOZZLE_ERROR;
-                            rotateNozzle(RIGHT_NOZZLE, requested_theta_right);
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Correcting right nozzle rotation...\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                    {   //for look-up photos, cycle through the nozzles holding parts and correct errors one by one using check_nozzle as a counter
+                        double errortheta = 0.0;
+
+                        check_nozzle = getNextNozzleWithStatus(nozzle_status, number_of_nozzles, check_nozzle, holdingpart);
+                        while (check_nozzle != NO_NOZZLE)
+                        {   //skip the nozzles whose parts only need a rotation within the correction band of their footprint
+                            int part = nozzle_part_num[check_nozzle];
+
+                            errortheta = getPickErrorTheta(check_nozzle);  //acquire the part misalignment from the look-up photo
+                            if (getRotationCorrection(machine, pi[part].component_footprint, placement_theta[part], errortheta, &requested_theta) == TRUE) break;
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "");
+                            addLogText(&log_line, getNozzleName(check_nozzle));
+                            addLogText(&log_line, " part misalignment error: ");
+                            addLogFixed(&log_line, errortheta, 3, 2);
+                            addLogText(&log_line, "  Rotation of ");
+                            addLogFixed(&log_line, requested_theta, 3, 2);
+                            addLogText(&log_line, " degrees is within the correction band, skipped\n");
+                            writeDisplayLog(log_line.text);
+                            check_nozzle = getNextNozzleWithStatus(nozzle_status, number_of_nozzles, check_nozzle + 1, holdingpart);
                         }
-                        else if (nozzle_errors_to_check == 2)
-                        {  //the centre nozzle is second to pick a part and is second to have the alignment corrected
-                            double errortheta = getPickErrorTheta(CENTRE_NOZZLE);  //acquire the part misalignment from the look-up photo
-                            requested_theta_centre = pi[centre_nozzle_part_num].theta_target - errortheta;  //calculate misalignment of the part on the nozzle
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Centre part misalignment error: %3.2f  Correction required: %3.2f degrees\n", getSimulationTime(),state_name[state], errortheta, requested_theta_centre);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        if (check_nozzle != NO_NOZZLE)
+                        {   //the rotation turns the part to its placement angle and takes out the pick error in one move
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "");
+                            addLogText(&log_line, getNozzleName(check_nozzle));
+                            addLogText(&log_line, " part misalignment error: ");
+                            addLogFixed(&log_line, errortheta, 3, 2);
+                            addLogText(&log_line, "  Correction required: ");
+                            addLogFixed(&log_line, requested_theta, 3, 2);
+                            addLogText(&log_line, " degrees\n");
+                            writeDisplayLog(log_line.text);
                             state = FIX_NOZZLE_ERROR;
-                            rotateNozzle(CENTRE_NOZZLE, requested_theta_centre);
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Correcting centre nozzle rotation...\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                            rotateNozzle(check_nozzle, requested_theta);
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "Correcting ");
+                            addLogText(&log_line, getNozzleName(check_nozzle));
+                            addLogText(&log_line, " nozzle rotation...\n");
+                            writeDisplayLog(log_line.text);
                         }
 
-                        else if (nozzle_errors_to_check == 1)
-                        {  //the left nozzle was first to pick up a part, and if it is the only nozzle used then only one error to check
-                            double errortheta = getPickErrorTheta(LEFT_NOZZLE);  //acquire the part misalignment from the look-up photo
-                            requested_theta_left = pi[left_nozzle_part_num].theta_target - errortheta;  //calculate misalignment of the part on the nozzle
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Left part misalignment error: %3.2f  Correction required: %3.2f degrees\n", getSimulationTime(),state_name[state], errortheta, requested_theta_left);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                            state = FIX_NOZZLE_ERROR;
-                            rotateNozzle(LEFT_NOZZLE, requested_theta_left);
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Correcting left nozzle rotation\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        else if (flown_over_camera == TRUE)
+                        {  //if no more nozzle errors to check, the head is already over the first placement so carry straight on with the look-down photo
+                            lookup_photo = FALSE;
+                            flown_over_camera = FALSE;
+                            nozzle = getNextNozzleWithStatus(nozzle_status, number_of_nozzles, 0, holdingpart);
+                            req_target = nozzle_part_num[nozzle];
+                            state = MOVE_TO_PCB;
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "No further errors. Already at PCB\n");
+                            writeDisplayLog(log_line.text);
                         }
-
                         else
                         {  //if no more nozzle errors to check, then reset the photo variable and go to the PCB to place parts
                             lookup_photo = FALSE;
-                            req_target = left_nozzle_part_num;  //this is needed to obtain and calculate the relevant misalignment errors
-                            setTargetPos(pi[left_nozzle_part_num].x_target, pi[left_nozzle_part_num].y_target);
-                            state = MOVE_TO_PCB;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  No further errors. Moving to PCB\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                            nozzle = getNextNozzleWithStatus(nozzle_status, number_of_nozzles, 0, holdingpart);
+                            req_target = nozzle_part_num[nozzle];  //this is needed to obtain and calculate the relevant misalignment errors
+                            if (board_aligned == FALSE && use_move_correct_lower == TRUE)
+                            {
+                                moveCorrectAndLower(placement_x[req_target], placement_y[req_target], nozzle);
+                                state = MOVE_AND_CORRECT;
+                            }
+                            else
+                            {
+                                setTargetPos(placement_x[req_target], placement_y[req_target]);
+                                state = MOVE_TO_PCB;
+                            }
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "No further errors. Moving to PCB\n");
+                            writeDisplayLog(log_line.text);
                         }
                     }
 
@@ -915,74 +1402,68 @@ int main(int argc, char *argv[])
                     {  //calculate the difference  between the required target and the error of the gantry over the PCB
                         preplace_diff_x = pi[req_target].x_target - (pi[req_target].x_target+getPreplaceErrorX()); //calculate the difference between the required x position and the actual x position of the gantry
                         preplace_diff_y = pi[req_target].y_target - (pi[req_target].y_target+getPreplaceErrorY()); //calculate the difference between the required y position and the actual y position of the gantry
-                        //sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Preplace misalignment error: x=%3.2f y=%3.2f\n", getSimulationTime(), state_name[state], getPreplaceErrorX(), getPreplaceErrorY());
-                        //write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
                         amendPos(preplace_diff_x, preplace_diff_y);  //fix the gantry preplace position over the PCB
                         state = FIX_PREPLACE_ERROR;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Correcting gantry position...\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Correcting gantry position...\n");
+                        writeDisplayLog(log_line.text);
                     }
 
                     break;
 
                 case FIX_NOZZLE_ERROR:
                     if (isSimulatorReadyForNextInstruction())
-                    {
-                        if (nozzle_errors_to_check == 3)
-                        {   //using nozzle_errors_to_check as a counter to ensure the correct nozzle is addressed
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Correction made to right nozzle for part alignment\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                            nozzle_errors_to_check--;  //decrement to track the errors needed for correction
-                            state = CHECK_ERROR;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Checking for errors...\n", getSimulationTime(),state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                        }
-                        else if (nozzle_errors_to_check == 2)
-                        {   //centre nozzle is second to be corrected
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Correction made to centre nozzle for part alignment\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                            nozzle_errors_to_check--;
-                            state = CHECK_ERROR;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Checking for errors...\n", getSimulationTime(),state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                        }
-                        else if (nozzle_errors_to_check == 1)
-                        {   //since the left nozzle was first to pick up a part, it is last to be corrected. Applies if it is the only nozzle in use for a singular part
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Correction made to left nozzle for part alignment\n", getSimulationTime(), state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                            nozzle_errors_to_check--;
-                            state = CHECK_ERROR;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Checking for errors...\n", getSimulationTime(),state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                        }
+                    {   //using check_nozzle as a counter to ensure the correct nozzle is addressed
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Correction made to ");
+                        addLogText(&log_line, getNozzleName(check_nozzle));
+                        addLogText(&log_line, " nozzle for part alignment\n");
+                        writeDisplayLog(log_line.text);
+                        check_nozzle++;  //move on to the next nozzle needing correction
+                        state = CHECK_ERROR;
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Checking for errors...\n");
+                        writeDisplayLog(log_line.text);
                     }
                     break;
 
                 case FIX_PREPLACE_ERROR:
+                    if (isSimulatorReadyForNextInstruction())
+                    {  //the head is now over the target of the part on the nozzle being placed
+                        lowerNozzle(nozzle);
+                        state = LOWERING_NOZZLE;
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Now lowering ");
+                        addLogText(&log_line, getNozzleName(nozzle));
+                        addLogText(&log_line, " nozzle to place part on PCB\n");
+                        writeDisplayLog(log_line.text);
+                    }
+                    break;
+
+                case MOVE_AND_CORRECT:
                     if (isSimulatorReadyForNextInstruction())
                     {
-                        if (Left_NozzleStatus == holdingpart)
-                        {  //only need to apply correction if the nozzle is holding a part
-                            lowerNozzle(LEFT_NOZZLE);
-                            state = LOWER_LEFT_NOZZLE;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Now lowering left nozzle to place part on PCB\n", getSimulationTime(),state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        int step = getRejectedSequenceStep();
+                        if (step == NO_SEQUENCE_STEP)
+                        {   //the nozzle is down at the corrected position, so the part can be released
+                            runPlaceProgram(nozzle, TRUE);
+                            part_placed = TRUE;
+                            state = RAISING_NOZZLE;
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "Corrected by x=");
+                            addLogFixed(&log_line, -getPreplaceErrorX(), 3, 2);
+                            addLogText(&log_line, " y=");
+                            addLogFixed(&log_line, -getPreplaceErrorY(), 3, 2);
+                            addLogText(&log_line, ". Releasing part and raising nozzle\n");
+                            writeDisplayLog(log_line.text);
                         }
-                        else if (Centre_NozzleStatus == holdingpart)
-                        {//only need to apply correction if the nozzle is holding a part
-                            lowerNozzle(CENTRE_NOZZLE);
-                            state = LOWER_CNTR_NOZZLE;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Now lowering centre nozzle to place part on PCB\n", getSimulationTime(),state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-                        }
-                        else if (Right_NozzleStatus == holdingpart)
-                        {//only need to apply correction if the nozzle is holding a part
-                            lowerNozzle(RIGHT_NOZZLE);
-                            state = LOWER_RIGHT_NOZZLE;
-                            sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Now lowering right nozzle to place part on PCB\n", getSimulationTime(),state_name[state]);
-                            write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        else
+                        {   //fall back to separate instructions for this and every later placement, starting again with the move
+                            use_move_correct_lower = FALSE;
+                            setTargetPos(placement_x[req_target], placement_y[req_target]);
+                            state = MOVE_TO_PCB;
+                            formatStateLog(&log_line, getSimulationTime(), state_name[state], "Step ");
+                            addLogInteger(&log_line, step);
+                            addLogText(&log_line, " (instruction ");
+                            addLogInteger(&log_line, getSequenceStepInstruction(step));
+                            addLogText(&log_line, ") was rejected, placing with separate instructions\n");
+                            writeDisplayLog(log_line.text);
                         }
-
                     }
                     break;
 
@@ -992,19 +1473,20 @@ int main(int argc, char *argv[])
                         unloadPCB();  // then board can be unloaded from the machine
                         state = PCB;
                         PCB_status = unloaded;
-                        sprintf(Contrl_str_array, "Time: %7.2f  New state: %.20s  Gantry in Home position. Unloading PCB\n", getSimulationTime(), state_name[state]);
-                        write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
+                        formatStateLog(&log_line, getSimulationTime(), state_name[state], "Gantry in Home position. Unloading PCB\n");
+                        writeDisplayLog(log_line.text);
                     }
                     break;
 
                 } //closing switch
-            sleepMilliseconds((long) 1000 / POLL_LOOP_RATE);
+            recordControllerState(state);
+            waitForNextPollLoop();
             }//closing while loop
         }
     // if program is quit early, the controller needs to terminate before simulator to prevent program hanging
-    sprintf(Contrl_str_array, "Time: %7.2f  Terminating...\n", getSimulationTime());
-    write(writeContrlToDisplayFd, Contrl_str_array, strlen(Contrl_str_array));
-    close(writeContrlToDisplayFd);
+    formatLogMessage(&log_line, getSimulationTime(), "Terminating...\n");
+    writeDisplayLog(log_line.text);
+    closeDisplayLog();
     pnpClose();
     sem_post(sem_Contrl);  // now allow the simulator to terminate
     sem_close(sem_Startup);
@@ -18,97 +18,67 @@
 #include <math.h>
 #include <string.h>
 #include <semaphore.h>
+#include "../Assgn2_2024_Common/pnpShared.h"
 
 #define MANUAL_CONTROL 1
 #define AUTONOMOUS_CONTROL 2
+#define PLANNED_CONTROL 3          // autonomous, streaming an instruction schedule built for the whole board before starting
 
-#define MEMORY_MAPPED_FILE "pnp_shared_file"
 #define CENTROID_FILE "centroid.txt"
+#define CENTROID_FILE_ENV "PNP_CENTROID_FILE"   // environment variable which overrides CENTROID_FILE
 
-#define MAX_NUMBER_OF_COMPONENTS_TO_PLACE 100
 #define NUMBER_OF_FIELDS_IN_PLACEMENT_INFO 7
 
 #define CENTROID_FILE_PRESENT_AND_READ 0
 #define CENTROID_FILE_NOT_PRESENT -1
 #define CENTROID_FILE_PRESENT_BUT_CONTENT_ISSUE -2
 #define CENTROID_FILE_HAS_TOO_MANY_COMPONENTS -3
-
-#define HOME_X 0.0
-#define HOME_Y 0.0
-#define MIN_X -200.0
-#define MIN_Y -200.0
-#define MAX_X +1000.0
-#define MAX_Y +1000.0
-
-#define NUMBER_OF_FEEDERS 10
-#define NO_PICKED_PART -1
-#define NO_TAPE_FEEDER_AT_THIS_LOCATION -1
-#define FDR_0_X +50.0
-#define FDR_1_X +150.0
-#define FDR_2_X +250.0
-#define FDR_3_X +350.0
-#define FDR_4_X +450.0
-#define FDR_5_X +550.0
-#define FDR_6_X +650.0
-#define FDR_7_X +750.0
-#define FDR_8_X +850.0
-#define FDR_9_X +950.0
-#define FDR_0_Y -100.0
-#define FDR_1_Y -100.0
-#define FDR_2_Y -100.0
-#define FDR_3_Y -100.0
-#define FDR_4_Y -100.0
-#define FDR_5_Y -100.0
-#define FDR_6_Y -100.0
-#define FDR_7_Y -100.0
-#define FDR_8_Y -100.0
-#define FDR_9_Y -100.0
-
-#define LOOKUP_CAMERA_X -100
-#define LOOKUP_CAMERA_Y +100
-#define PHOTO_LOOKUP 0
-#define PHOTO_LOOKDOWN 1
+#define CENTROID_FILE_HAS_UNKNOWN_FEEDER -4
 
 #define POLL_LOOP_RATE 50          // poll loops per second - DANGER, changing this can result in unstable or incorrect operation
 
-#define TRUE 1
-#define FALSE 0
-
 #define NO_KEY 0
 
-#define NUMBER_OF_NOZZLES 3
-#define LEFT_NOZZLE 0
-#define CENTRE_NOZZLE 1
-#define RIGHT_NOZZLE 2
-
-#define NOZZLE_X_SEPARATION 20
-
-#define NO_INSTRUCTION 0
-#define MOVE_HEAD 1
-#define ROTATE_NOZZLE 2
-#define LOWER_NOZZLE 3
-#define RAISE_NOZZLE 4
-#define APPLY_VACUUM 5
-#define RELEASE_VACUUM 6
-#define TAKE_PHOTO 7
-#define AMEND_HEAD_POSITION 8
-#define LOAD_PCB 9
-#define UNLOAD_PCB 10
+#define NO_NOZZLE -1
 
-typedef struct
-{
-    int ready_for_next_instruction;
-    double sim_time;
-    double theta_pick_error[NUMBER_OF_NOZZLES];
-    double x_preplace_error;
-    double y_preplace_error;
-    int instruction_to_execute;
-    double instruction_argument_1;
-    double instruction_argument_2;
-    int instruction_argument_3;
-    int quit;
-
-} PnP;
+#define PICK_LOOK_AHEAD 8          // parts ahead in the pick list considered when choosing the next pick
+#define PICK_ATTEMPTS 3            // picks tried by the pick program before it gives up with the nozzle empty
+
+#define MAX_PLAN_LENGTH (16 * MAX_NUMBER_OF_COMPONENTS_TO_PLACE + 8)
+#define PLAN_TOO_LONG -1
+#define PLAN_HANDSHAKE_TIME 0.02   // predicted simulation time between one planned instruction finishing and the next starting
+#define PLAN_ARGUMENT_FIXED 0
+#define PLAN_ARGUMENT_PICK_CORRECTION 1     // argument_1 is the placement rotation, less the pick error seen by the lookup camera
+#define PLAN_ARGUMENT_PREPLACE_CORRECTION 2 // arguments 1 and 2 cancel the preplace error seen by the last lookdown photo
+#define PLAN_STEP_SKIPPED 2        // returned by issuePlanStep for a rotation within the correction band, so not issued
+#define NO_PLAN_FEEDER -1
+#define NO_PLAN_PART -1
+#define PLAN_ORDER_BY_FEEDER 0     // pick in feeder order, then by ascending y-coordinate, as the autonomous mode does
+#define PLAN_ORDER_AS_LISTED 1     // pick in centroid file order
+
+/*
+ * The controller records the instructions it issues, and the errors the simulator reports back, to the file
+ * named by TRACE_FILE_ENV if set. The file is a TraceHeader then fixed size TraceRecords, in the byte order
+ * of the machine, which the replay driver feeds back to the simulator without the controller.
+ */
+#define TRACE_FILE_ENV "PNP_RECORD"
+#define TRACE_MAGIC "PNPT"
+#define TRACE_FORMAT_VERSION 2     // bump when a record kind is added or its meaning changes
+#define TRACE_INSTRUCTION 0        // an instruction, with its arguments and the simulation time it was issued at
+#define TRACE_PROGRAM_STEP 1       // a step of the micro-program run by the next RUN_PROGRAM, in order
+#define TRACE_PICK_ERROR 2         // the pick error of nozzle argument_3 in argument_1, as first read by the controller
+#define TRACE_PREPLACE_ERROR 3     // the preplace error in argument_1 and argument_2, as first read by the controller
+#define TRACE_FEEDER_PACKAGE 4     // the package loaded on feeder argument_3 in code, recorded before the first instruction
+
+/* what each plan step is spent on, for cycle time breakdowns */
+#define PLAN_PHASE_PCB 0                 // loading and unloading the PCB
+#define PLAN_PHASE_FEEDER_TRAVEL 1       // moving to the feeders
+#define PLAN_PHASE_PICK 2                // lowering, applying the vacuum and raising at the feeders
+#define PLAN_PHASE_LOOKUP 3              // moving to and photographing at the lookup camera, or flying over it
+#define PLAN_PHASE_ROTATE 4              // rotating the parts to their placement angle
+#define PLAN_PHASE_PLACE_TRAVEL 5        // moving between placements, and home at the end
+#define PLAN_PHASE_PLACE 6               // lookdown photo, correction, lowering, releasing and raising at the placements
+#define NUMBER_OF_PLAN_PHASES 7
 
 typedef struct
 {
@@ -119,19 +89,83 @@ typedef struct
     double y_target;
     double theta_target;
     int feeder;
+    int package;             // the footprint interned in the component library, else NO_PACKAGE
 
 } PlacementInfo;
 
+typedef struct
+{
+    int instruction;         // MOVE_HEAD, LOWER_NOZZLE, ...
+    double argument_1;       // the instruction arguments, as they would be passed in shared memory
+    double argument_2;
+    int argument_3;
+    int argument_source;     // PLAN_ARGUMENT_FIXED, or the vision result the arguments are filled in from when issued
+    int feeder;              // the feeder which must have a part ready before the step is issued, else NO_PLAN_FEEDER
+    int part;                // the placement the step is for, else NO_PLAN_PART
+    int phase;               // PLAN_PHASE_PCB, PLAN_PHASE_FEEDER_TRAVEL, ...
+    double start_time;       // predicted
+    double finish_time;      // predicted
+
+} PlanStep;
+
+typedef struct
+{
+    int length;
+    PlanStep step[MAX_PLAN_LENGTH];
+    double cycle_time;       // predicted time from loading to unloading the PCB
+
+} Plan;
+
+typedef struct
+{
+    char magic[4];                // TRACE_MAGIC, without its terminating null
+    unsigned int format_version;  // TRACE_FORMAT_VERSION
+    unsigned int layout_version;  // PNP_LAYOUT_VERSION, as the instruction codes are those of the shared memory layout
+    unsigned int record_size;     // sizeof(TraceRecord)
+    unsigned int random_seed;     // the seed of the simulated errors, from the simulator
+
+} TraceHeader;
+
+typedef struct
+{
+    double time;             // the simulation time it was recorded at
+    double argument_1;
+    double argument_2;
+    int kind;                // TRACE_INSTRUCTION, ...
+    int code;                // the instruction, or the opcode of a program step
+    int argument_3;
+    int target;              // the step a program step jumps to
+
+} TraceRecord;
+
+void sortPickList(const PlacementInfo[], int, int[]);
+
+int buildPlan(const PlacementInfo[], int, const MachineConfig*, const ComponentLibrary*, int, Plan*);
+
+int issuePlanStep(const PlanStep*, const PlacementInfo[]);
+
+double getRotationCorrectionBand(const MachineConfig*, const char*);
+
+int getRotationCorrection(const MachineConfig*, const char*, double, double, double*);
+
 struct termios setTerminalSettings();
 
 void resetTerminalSettings(struct termios);
 
+const char *getCentroidFileName();
+
 int getCentroidFileContents(int*, int*, PlacementInfo[MAX_NUMBER_OF_COMPONENTS_TO_PLACE]);
 
+void setPlacementPackages(PlacementInfo[], int, const ComponentLibrary*);
+
 void setTargetPos(double, double);
 
+void setTargetPosViaCamera(double, double);
+
 void amendPos(double, double);
 
+void moveCorrectAndLower(double, double, int);
+
 void lowerNozzle(int);
 
 void raiseNozzle(int);
@@ -144,12 +178,24 @@ void releaseVacuum(int);
 
 void takePhoto(int);
 
+void clearProgram();
+
+int addProgramStep(int, double, double, int, int);
+
+void runProgram();
+
+int getProgramStatus();
+
+int getProgramInstructionsRejected();
+
 void loadPCB();
 
 void unloadPCB();
 
 void pnpOpen();
 
+void waitForStartup(sem_t*);
+
 void pnpClose();
 
 double getSimTime();
@@ -166,11 +212,55 @@ double getPickErrorY(int);
 
 double getPickErrorTheta(int);
 
+int getFiducialInView();
+
+double getFiducialOffsetX();
+
+double getFiducialOffsetY();
+
 int isSimulatorReadyForNextInstruction();
 
+const MachineConfig *getMachineConfig();
+
+const ComponentLibrary *getComponentLibrary();
+
+int getNumberOfNozzles();
+
+const char *getNozzleName(int);
+
+double getNozzleOffsetX(int);
+
+double getNozzleOffsetY(int);
+
+double getHeadPositionX();
+
+double getHeadPositionY();
+
+int getFeederPartsRemaining(int);
+
+double getFeederReadyTime(int);
+
+int isFeederReady(int);
+
+int getNextFeederEvent(FeederEvent*);
+
+int getSequenceLength();
+
+int getSequenceStepInstruction(int);
+
+int getSequenceStepResult(int);
+
 char getKey();
 
 int isPnPSimulationQuitFlagOn();
 
+void waitForNextPollLoop();
+
+void publishPlacementTargets(const PlacementInfo[], int);
+
+void publishControllerStates(const char[][CONTROLLER_STATE_NAME_LENGTH], int);
+
+void recordControllerState(int);
+
 void sleepMilliseconds(long);
 
@@ -3,7 +3,7 @@
  * pnpControlInterface.c - the interface routines for pick and place machine control, which simplify
  * interfacing to the simulator
  *
- * This program creates a shared memory segment with the simulator via a memory mapped file
+ * This program shares a memory segment with the simulator, created by Startup
  *
  * Platform: Any POSIX compliant platform
  * Intended for and tested on: Cygwin 64 bit
@@ -13,12 +13,132 @@
 #include "pnpControl.h"
 
 PnP *pnp;
-int fd;
+MachineConfig machine;
+ComponentLibrary library;
+int number_of_feeder_events_read = 0;
 struct termios old_term;
 pthread_t key_thread;
 char key_pressed;
 //sem_t *sem_Sim;
 
+static FILE *trace_file = NULL;  // the recording, if TRACE_FILE_ENV is set
+static double traced_pick_error[MAX_NUMBER_OF_NOZZLES];
+static double traced_preplace_error_x = 0.0, traced_preplace_error_y = 0.0;
+
+/*
+ Function: writeTraceRecord
+ --------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: adds a record to the recording, stamped with the simulation time, if recording
+ Argument(s):
+ int kind - TRACE_INSTRUCTION, ...
+ int code - the instruction or program step opcode
+ double argument_1, argument_2 - the arguments or values reported
+ int argument_3 - the nozzle, photo direction, feeder, index value or loop limit
+ int target - the step a program step jumps to
+ Return Value: none
+ Usage: writeTraceRecord(TRACE_PICK_ERROR, NO_INSTRUCTION, theta, 0.0, nozzle, 0);
+ */
+static void writeTraceRecord(int kind, int code, double argument_1, double argument_2, int argument_3, int target)
+{
+    TraceRecord record;
+
+    if (trace_file == NULL) return;
+    record.time = pnp -> sim_time;
+    record.argument_1 = argument_1;
+    record.argument_2 = argument_2;
+    record.kind = kind;
+    record.code = code;
+    record.argument_3 = argument_3;
+    record.target = target;
+    fwrite(&record, sizeof(record), 1, trace_file);
+}
+
+/*
+ Function: traceInstruction
+ --------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ records an instruction as it is issued, with the arguments already written to shared memory, and for
+ RUN_PROGRAM the steps of the program before it. Called just before the instruction itself is written, as
+ the simulator may clear it again as soon as it is.
+ Argument(s):
+ int instruction - the instruction, e.g. MOVE_HEAD
+ Return Value: none
+ Usage: traceInstruction(MOVE_HEAD);
+ */
+static void traceInstruction(int instruction)
+{
+    if (trace_file == NULL) return;
+    if (instruction == RUN_PROGRAM)
+    {
+        for (int i = 0; i < pnp -> program.length; i++)
+        {
+            const ProgramStep *step = &pnp -> program.step[i];
+            writeTraceRecord(TRACE_PROGRAM_STEP, step -> opcode, step -> argument_1, step -> argument_2, step -> argument_3, step -> target);
+        }
+    }
+    writeTraceRecord(TRACE_INSTRUCTION, instruction, pnp -> instruction_argument_1, pnp -> instruction_argument_2, pnp -> instruction_argument_3, 0);
+}
+
+/*
+ Function: openTraceRecording
+ ----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ starts recording to the file named by TRACE_FILE_ENV, if set, once the simulator has published its seed
+ Argument(s): none
+ Return Value: none
+ Usage: openTraceRecording();
+ */
+static void openTraceRecording()
+{
+    const char *filename = getenv(TRACE_FILE_ENV);
+    TraceHeader header;
+
+    if (filename == NULL || filename[0] == '\0') return;
+    trace_file = fopen(filename, "wb");
+    if (trace_file == NULL)
+    {
+        perror("Problem opening the recording file");
+        return;
+    }
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.format_version = TRACE_FORMAT_VERSION;
+    header.layout_version = PNP_LAYOUT_VERSION;
+    header.record_size = sizeof(TraceRecord);
+    header.random_seed = pnp -> random_seed;
+    fwrite(&header, sizeof(header), 1, trace_file);
+    for (int i = 0; i < MAX_NUMBER_OF_NOZZLES; i++) traced_pick_error[i] = 0.0;  // as the simulator resets them
+}
+
+/*
+ Function: tracePreplaceError
+ ----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: records the preplace error reported by the simulator the first time the controller reads it
+ Argument(s): none
+ Return Value: none
+ Usage: tracePreplaceError();
+ */
+static void tracePreplaceError()
+{
+    double x_error = pnp -> x_preplace_error, y_error = pnp -> y_preplace_error;
+
+    if (trace_file == NULL || (x_error == traced_preplace_error_x && y_error == traced_preplace_error_y)) return;
+    writeTraceRecord(TRACE_PREPLACE_ERROR, NO_INSTRUCTION, x_error, y_error, 0, 0);
+    traced_preplace_error_x = x_error;
+    traced_preplace_error_y = y_error;
+}
+
 /*
  Function: setTerminalSettings
  -----------------------------
@@ -72,18 +192,42 @@ void resetTerminalSettings(struct termios old_term) {
 
 }
 
+/*
+ Function: getCentroidFileName
+ -----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the name of the centroid file, which is CENTROID_FILE in the current working directory unless
+ overridden by the CENTROID_FILE_ENV environment variable
+ Argument(s): none
+ Return Value: the name of the centroid file
+ Usage: const char *filename = getCentroidFileName();
+ */
+const char *getCentroidFileName()
+{
+
+    const char *filename = getenv(CENTROID_FILE_ENV);
+
+    if (filename == NULL || filename[0] == '\0') return CENTROID_FILE;
+    return filename;
+
+}
+
 /*
  Function: getCentroidFileContents
  ---------------------------------
  Written by Jason Brown
  Date: 30/03/2024
- Version 1.0
+ Version 1.3
  Purpose:
  gets the contents of the centroid file (including placement info of components) if it exists in the
- current working directory and if its contents are valid.
+ current working directory (or wherever getCentroidFileName gives) and if its contents are valid.
+ The placements are left without a package until setPlacementPackages is called.
  Argument(s):
  The following arguments are passed by reference and so are available to the calling function:
- int *operation_mode - a pointer to an integer variable representing the operation mode (manual or auto)
+ int *operation_mode - a pointer to an integer variable representing the operation mode (manual, auto or planned)
  int *number_of_components_to_place - a pointer to an integer variable representing the number of components to place
  PlacementInfo pi[] - a pointer to an array of structures, with each structure representing the placement info of one component
  Return Value:
@@ -101,7 +245,7 @@ int getCentroidFileContents(int *operation_mode, int *number_of_components_to_pl
     char dummy_char = 'z';
     char * operation_mode_char = &dummy_char;
 
-    FILE *fp = fopen(CENTROID_FILE, "r");
+    FILE *fp = fopen(getCentroidFileName(), "r");
 
     if (fp == NULL) return CENTROID_FILE_NOT_PRESENT;
 
@@ -109,6 +253,7 @@ int getCentroidFileContents(int *operation_mode, int *number_of_components_to_pl
 
     if (*operation_mode_char == 'm' || *operation_mode_char == 'M') *operation_mode = MANUAL_CONTROL;
     else if (*operation_mode_char == 'a' || *operation_mode_char == 'A') *operation_mode = AUTONOMOUS_CONTROL;
+    else if (*operation_mode_char == 'p' || *operation_mode_char == 'P') *operation_mode = PLANNED_CONTROL;
     else {fclose(fp); return CENTROID_FILE_PRESENT_BUT_CONTENT_ISSUE;}
 
     if (fscanf(fp, "%i", number_of_components_to_place) != 1) {fclose(fp); return CENTROID_FILE_PRESENT_BUT_CONTENT_ISSUE;}
@@ -117,18 +262,43 @@ int getCentroidFileContents(int *operation_mode, int *number_of_components_to_pl
     for (int i = 0; i < *number_of_components_to_place; i++)
     {
         if (fscanf(fp, "%s %s %lf %lf %lf %lf %i", &pi[i].component_designation[0], &pi[i].component_footprint[0], &pi[i].component_value, &pi[i].x_target, &pi[i].y_target, &pi[i].theta_target, &pi[i].feeder) != NUMBER_OF_FIELDS_IN_PLACEMENT_INFO) {fclose(fp); return CENTROID_FILE_PRESENT_BUT_CONTENT_ISSUE;};
+        pi[i].package = NO_PACKAGE;
     }
     fclose(fp);
     return CENTROID_FILE_PRESENT_AND_READ;
 
 }
 
+/*
+ Function: setPlacementPackages
+ ------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ looks up the footprint of every placement in the component library once, as the board is read, so that the
+ planner and simulator work from the package index rather than the footprint name
+ Argument(s):
+ PlacementInfo pi[] - the placements, as read from the centroid file
+ int number_of_components_to_place - the number of placements
+ const ComponentLibrary *library - the component library
+ Return Value: none
+ Usage: setPlacementPackages(pi, number_of_components_to_place, getComponentLibrary());
+ */
+void setPlacementPackages(PlacementInfo pi[], int number_of_components_to_place, const ComponentLibrary *library)
+{
+    for (int i = 0; i < number_of_components_to_place; i++)
+    {
+        pi[i].package = findComponentPackage(library, pi[i].component_footprint);
+    }
+}
+
 /*
  Function: setTargetPos
  ----------------------
  Written by Jason Brown
  Date: 30/03/2024
- Version 1.0
+ Version 1.2
  Purpose:
  instructs the simulator to move the gantry head to the specified target position
  Argument(s):
@@ -146,16 +316,84 @@ void setTargetPos(double x_target, double y_target)
     pnp -> instruction_argument_1 = x_target;
     pnp -> instruction_argument_2 = y_target;
     pnp -> instruction_argument_3 = 0; // instruction_argument_3 is not used with the MOVE_HEAD instruction
+    pnp -> ready_for_next_instruction = FALSE;  // until the simulator has taken and carried out the instruction
+    traceInstruction(MOVE_HEAD);
     pnp -> instruction_to_execute = MOVE_HEAD;
 
 }
 
+/*
+ Function: setTargetPosViaCamera
+ -------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.2
+ Purpose:
+ instructs the simulator to move the gantry head to the specified target position, sweeping the row of nozzles
+ across the lookup camera on the way so that the parts held are photographed without stopping. The pick errors
+ are available from getPickErrorTheta once the move has finished. Only valid if the machine description has
+ lookup_camera_fly_over set.
+ Argument(s):
+ double x_target - the target x-coordinate of the gantry head
+ double y_target - the target y-coordinate of the gantry head
+ Return Value:
+ None, the instruction will always be passed to the simulator, check the simulator display output to see whether
+ or not the simulator acted upon the instruction
+ Usage:
+ setTargetPosViaCamera(x_target, y_target);
+ */
+void setTargetPosViaCamera(double x_target, double y_target)
+{
+
+    pnp -> instruction_argument_1 = x_target;
+    pnp -> instruction_argument_2 = y_target;
+    pnp -> instruction_argument_3 = 0; // instruction_argument_3 is not used with the MOVE_HEAD_VIA_CAMERA instruction
+    pnp -> ready_for_next_instruction = FALSE;
+    traceInstruction(MOVE_HEAD_VIA_CAMERA);
+    pnp -> instruction_to_execute = MOVE_HEAD_VIA_CAMERA;
+
+}
+
+/*
+ Function: moveCorrectAndLower
+ -----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.2
+ Purpose:
+ instructs the simulator to move the gantry head to the specified target position, take a lookdown photo, amend the
+ head position to cancel the preplace error seen and lower the specified nozzle, all as one instruction. The simulator
+ carries out the steps back to back and only becomes ready for the next instruction once they have all finished, or
+ once one of them has been rejected. The outcome of each step is available from getSequenceStepResult.
+ Argument(s):
+ double x_target - the target x-coordinate of the gantry head
+ double y_target - the target y-coordinate of the gantry head
+ int nozzle - the nozzle to lower once the head position has been corrected
+ Return Value:
+ None, the instruction will always be passed to the simulator, check getSequenceStepResult or the simulator display
+ output to see whether or not the simulator acted upon the instruction
+ Usage:
+ moveCorrectAndLower(x_target, y_target, nozzle);
+ */
+void moveCorrectAndLower(double x_target, double y_target, int nozzle)
+{
+
+    pnp -> sequence_report.number_of_steps = 0;  // so that a rejected instruction does not leave the last report in place
+    pnp -> instruction_argument_1 = x_target;
+    pnp -> instruction_argument_2 = y_target;
+    pnp -> instruction_argument_3 = nozzle;
+    pnp -> ready_for_next_instruction = FALSE;
+    traceInstruction(MOVE_CORRECT_LOWER);
+    pnp -> instruction_to_execute = MOVE_CORRECT_LOWER;
+
+}
+
 /*
  Function: amendPos
  ------------------
  Written by Jason Brown
  Date: 30/03/2024
- Version 1.0
+ Version 1.2
  Purpose:
  instructs the simulator to finely tune the gantry head position to eliminate alignment errors
  Argument(s):
@@ -173,6 +411,8 @@ void amendPos(double del_x, double del_y)
     pnp -> instruction_argument_1 = del_x;
     pnp -> instruction_argument_2 = del_y;
     pnp -> instruction_argument_3 = 0; // instruction_argument_3 is not used with the AMEND_HEAD instruction
+    pnp -> ready_for_next_instruction = FALSE;
+    traceInstruction(AMEND_HEAD_POSITION);
     pnp -> instruction_to_execute = AMEND_HEAD_POSITION;
 
 }
@@ -182,7 +422,7 @@ void amendPos(double del_x, double del_y)
  ---------------------
  Written by Jason Brown
  Date: 30/03/2024
- Version 1.0
+ Version 1.2
  Purpose:
  instructs the simulator to lower the specified nozzle
  Argument(s):
@@ -199,6 +439,8 @@ void lowerNozzle(int nozzle)
     pnp -> instruction_argument_1 = 0.0;    // instruction_argument_1 is not used with the LOWER_NOZZLE instruction
     pnp -> instruction_argument_2 = 0.0;    // instruction_argument_2 is not used with the LOWER_NOZZLE instruction
     pnp -> instruction_argument_3 = nozzle;
+    pnp -> ready_for_next_instruction = FALSE;
+    traceInstruction(LOWER_NOZZLE);
     pnp -> instruction_to_execute = LOWER_NOZZLE;
 
 }
@@ -208,7 +450,7 @@ void lowerNozzle(int nozzle)
  ---------------------
  Written by Jason Brown
  Date: 30/03/2024
- Version 1.0
+ Version 1.2
  Purpose:
  instructs the simulator to raise the specified nozzle
  Argument(s):
@@ -225,6 +467,8 @@ void raiseNozzle(int nozzle)
     pnp -> instruction_argument_1 = 0.0;    // instruction_argument_1 is not used with the RAISE_NOZZLE instruction
     pnp -> instruction_argument_2 = 0.0;    // instruction_argument_2 is not used with the RAISE_NOZZLE instruction
     pnp -> instruction_argument_3 = nozzle;
+    pnp -> ready_for_next_instruction = FALSE;
+    traceInstruction(RAISE_NOZZLE);
     pnp -> instruction_to_execute = RAISE_NOZZLE;
 
 }
@@ -234,7 +478,7 @@ void raiseNozzle(int nozzle)
  ----------------------
  Written by Jason Brown
  Date: 30/03/2024
- Version 1.0
+ Version 1.2
  Purpose:
  instructs the simulator to rotate the specified nozzle by a specified positive or negative angle in degrees
  Argument(s):
@@ -252,6 +496,8 @@ void rotateNozzle(int nozzle, double angleInDegrees)
     pnp -> instruction_argument_1 = angleInDegrees;
     pnp -> instruction_argument_2 = 0.0;    // instruction_argument_2 is not used with the ROTATE_NOZZLE instruction
     pnp -> instruction_argument_3 = nozzle;
+    pnp -> ready_for_next_instruction = FALSE;
+    traceInstruction(ROTATE_NOZZLE);
     pnp -> instruction_to_execute = ROTATE_NOZZLE;
 
 }
@@ -261,7 +507,7 @@ void rotateNozzle(int nozzle, double angleInDegrees)
  ---------------------
  Written by Jason Brown
  Date: 30/03/2024
- Version 1.0
+ Version 1.2
  Purpose:
  instructs the simulator to apply vacuum suction to the specified nozzle
  Argument(s):
@@ -278,6 +524,8 @@ void applyVacuum(int nozzle)
     pnp -> instruction_argument_1 = 0.0;    // instruction_argument_1 is not used with the APPLY_VACUUM instruction
     pnp -> instruction_argument_2 = 0.0;    // instruction_argument_2 is not used with the APPLY_VACUUM instruction
     pnp -> instruction_argument_3 = nozzle;
+    pnp -> ready_for_next_instruction = FALSE;
+    traceInstruction(APPLY_VACUUM);
     pnp -> instruction_to_execute = APPLY_VACUUM;
 
 }
@@ -287,7 +535,7 @@ void applyVacuum(int nozzle)
  -----------------------
  Written by Jason Brown
  Date: 30/03/2024
- Version 1.0
+ Version 1.2
  Purpose:
  instructs the simulator to release vacuum suction from the specified nozzle
  Argument(s):
@@ -304,6 +552,8 @@ void releaseVacuum(int nozzle)
     pnp -> instruction_argument_1 = 0.0;    // instruction_argument_1 is not used with the RELEASE_VACUUM instruction
     pnp -> instruction_argument_2 = 0.0;    // instruction_argument_2 is not used with the RELEASE_VACUUM instruction
     pnp -> instruction_argument_3 = nozzle;
+    pnp -> ready_for_next_instruction = FALSE;
+    traceInstruction(RELEASE_VACUUM);
     pnp -> instruction_to_execute = RELEASE_VACUUM;
 
 }
@@ -313,7 +563,7 @@ void releaseVacuum(int nozzle)
  -------------------
  Written by Jason Brown
  Date: 30/03/2024
- Version 1.0
+ Version 1.2
  Purpose:
  instructs the simulator to take a photo using the specified camera
  Argument(s):
@@ -330,6 +580,8 @@ void takePhoto(int camera)
     pnp -> instruction_argument_1 = 0.0;    // instruction_argument_1 is not used with the TAKE_PHOTO instruction
     pnp -> instruction_argument_2 = 0.0;    // instruction_argument_2 is not used with the TAKE_PHOTO instruction
     pnp -> instruction_argument_3 = camera;
+    pnp -> ready_for_next_instruction = FALSE;
+    traceInstruction(TAKE_PHOTO);
     pnp -> instruction_to_execute = TAKE_PHOTO;
 
 }
@@ -339,7 +591,7 @@ void takePhoto(int camera)
  -------------------
  Written by Kate Bowater
  Date: 21/07/2024
- Version 1.0
+ Version 1.2
  Purpose:
  Instructs the simulator to load a PCB onto the pick and place machine
  Argument(s):
@@ -355,15 +607,140 @@ void loadPCB()
     pnp -> instruction_argument_1 = 0.0;    // instruction_argument_1 is not used with the PCB instruction
     pnp -> instruction_argument_2 = 0.0;    // instruction_argument_2 is not used with the PCB instruction
     pnp -> instruction_argument_3 = 0;      // not needed
+    pnp -> ready_for_next_instruction = FALSE;
+    traceInstruction(LOAD_PCB);
     pnp -> instruction_to_execute = LOAD_PCB;
 }
 
+/*
+ Function: clearProgram
+ ----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ empties the micro-program area of shared memory ready for a new program to be written with addProgramStep.
+ Must not be called while a program is running.
+ Argument(s):
+ None
+ Return Value:
+ None
+ Usage:
+ clearProgram();
+ */
+void clearProgram()
+{
+    pnp -> program.length = 0;
+}
+
+/*
+ Function: addProgramStep
+ ------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ adds a step to the end of the micro-program in shared memory. A step is either an instruction, with the
+ arguments it would be passed in shared memory, or a program opcode (PROGRAM_JUMP, PROGRAM_WAIT_FOR_FEEDER, ...).
+ PROGRAM_INDEX as argument_3 stands for the value of the index register when the step is reached.
+ Argument(s):
+ int opcode - the instruction or program opcode
+ double argument_1 - the first instruction argument
+ double argument_2 - the second instruction argument
+ int argument_3 - the nozzle, photo direction, feeder, index value or loop limit
+ int target - the step to jump to, for the jump and loop opcodes
+ Return Value:
+ the number of the step added, else -1 if the program area is full
+ Usage:
+ int retry = addProgramStep(PROGRAM_WAIT_FOR_FEEDER, 0.0, 0.0, feeder, 0);
+ */
+int addProgramStep(int opcode, double argument_1, double argument_2, int argument_3, int target)
+{
+    int step = pnp -> program.length;
+
+    if (step >= MAX_PROGRAM_LENGTH) return -1;
+    pnp -> program.step[step].opcode = opcode;
+    pnp -> program.step[step].argument_1 = argument_1;
+    pnp -> program.step[step].argument_2 = argument_2;
+    pnp -> program.step[step].argument_3 = argument_3;
+    pnp -> program.step[step].target = target;
+    pnp -> program.length++;
+    return step;
+}
+
+/*
+ Function: runProgram
+ --------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.2
+ Purpose:
+ instructs the simulator to run the micro-program in shared memory. The simulator carries out every step
+ without waiting for the controller, and only becomes ready for the next instruction once the program ends.
+ Argument(s):
+ None
+ Return Value:
+ None, the instruction will always be passed to the simulator, check getProgramStatus to see how the program ended
+ Usage:
+ runProgram();
+ */
+void runProgram()
+{
+    pnp -> program.status = PROGRAM_IDLE;
+    pnp -> instruction_argument_1 = 0.0;    // instruction_argument_1 is not used with the RUN_PROGRAM instruction
+    pnp -> instruction_argument_2 = 0.0;    // instruction_argument_2 is not used with the RUN_PROGRAM instruction
+    pnp -> instruction_argument_3 = 0;      // instruction_argument_3 is not used with the RUN_PROGRAM instruction
+    pnp -> ready_for_next_instruction = FALSE;
+    traceInstruction(RUN_PROGRAM);
+    pnp -> instruction_to_execute = RUN_PROGRAM;
+}
+
+/*
+ Function: getProgramStatus
+ --------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the state of the last micro-program run
+ Argument(s):
+ None
+ Return Value:
+ one of PROGRAM_IDLE (0), PROGRAM_RUNNING (1), PROGRAM_WAITING (2), PROGRAM_FINISHED (3) or PROGRAM_FAULTED (-1)
+ Usage:
+ if (getProgramStatus() == PROGRAM_FINISHED) {...}
+ */
+int getProgramStatus()
+{
+    return pnp -> program.status;
+}
+
+/*
+ Function: getProgramInstructionsRejected
+ ----------------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the number of instructions of the last micro-program run that the simulator rejected
+ Argument(s):
+ None
+ Return Value:
+ the number of instructions rejected
+ Usage:
+ int rejected = getProgramInstructionsRejected();
+ */
+int getProgramInstructionsRejected()
+{
+    return pnp -> program.instructions_rejected;
+}
+
 /*
  Function: unloadPCB
  -------------------
  Written by Kate Bowater
  Date: 21/07/2024
- Version 1.0
+ Version 1.2
  Purpose:
  Instructs the simulator to unload the PCB from the pick and place machine
  Argument(s):
@@ -379,6 +756,8 @@ void unloadPCB()
     pnp -> instruction_argument_1 = 0.0;    // instruction_argument_1 is not used with the PCB instruction
     pnp -> instruction_argument_2 = 0.0;    // instruction_argument_2 is not used with the PCB instruction
     pnp -> instruction_argument_3 = 0;      // not needed
+    pnp -> ready_for_next_instruction = FALSE;
+    traceInstruction(UNLOAD_PCB);
     pnp -> instruction_to_execute = UNLOAD_PCB;
 }
 
@@ -388,19 +767,25 @@ void unloadPCB()
  ---------------------
  Written by Jason Brown
  Date: 30/03/2024
- Version 1.0
+ Version 1.1
  Purpose:
  thread function to handle keyboard input, called as part
- of creation of a new thread
+ of creation of a new thread. If there is no keyboard (standard
+ input is at end of file, as when run by the throughput harness)
+ the thread ends without quitting, rather than spinning
  Argument(s):  None
  Return Value: none
  Usage: not called directly but via pthread_create()
  */
 void *getKeyPress(void *arguments)
 {
+    int c;
+
     do {
 
-        key_pressed = getchar();
+        c = getchar();
+        if (c == EOF) return NULL;
+        key_pressed = c;
 
     } while ((key_pressed != 'q') && (key_pressed != 'Q'));
 
@@ -413,10 +798,12 @@ void *getKeyPress(void *arguments)
  -------------------
  Written by Jason Brown
  Date: 30/03/2024
- Version 1.0
+ Version 1.5
  Purpose: sets the terminal settings, creates a separate thread to handle
- keyboard input, initializes and memory maps a file so that a shared memory
- segment is created with the simulator
+ keyboard input, memory maps the shared memory segment it shares with the
+ simulator, then waits for the simulator to publish the machine description
+ and component library.
+ Exits if the simulator was built with a different shared memory layout.
  Argument(s): none
  Return Value: none
  Usage: pnpOpen();
@@ -434,23 +821,47 @@ void pnpOpen()
         exit(1);
     }
 
-    /* initialize file */
-    fd = open(MEMORY_MAPPED_FILE, (O_CREAT | O_RDWR), 0666);
-    if (fd < 0)
+    /* map the shared memory segment */
+    pnp = openPnP(FALSE);
+    if (pnp == MAP_FAILED)
     {
-        perror("creation/opening of file failed");
-        exit(1);
+        perror("opening/memory mapping of the shared memory segment failed");
+        exit(2);
     }
-    ftruncate(fd, sizeof(PnP));
 
-    /* map the file to memory */
-    pnp = (PnP *)mmap(0, sizeof(PnP), (PROT_READ | PROT_WRITE),  MAP_SHARED, fd, (off_t)0);
-    if (pnp == MAP_FAILED)
+    /* take a copy of the machine description once the simulator has published it */
+    while (pnp -> machine_config_published == FALSE)
     {
-        perror("memory mapping of file failed");
-        close(fd);
-        exit(2);
+        sleepSimulatedTime((double) 1 / POLL_LOOP_RATE);
+    }
+    if (isPnPLayoutValid(pnp) == FALSE)
+    {
+        fprintf(stderr, "The simulator uses shared memory layout version %u of %u bytes, the controller version %d of %d bytes\n",
+                pnp -> layout_version, pnp -> layout_size, PNP_LAYOUT_VERSION, (int) sizeof(PnP));
+        exit(3);
     }
+    machine = pnp -> machine;
+    library = pnp -> library;
+    openTraceRecording();
+}
+
+/*
+ Function: waitForStartup
+ ------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ waits at the startup barrier until the simulator is ready as well, once pnpOpen has mapped the shared memory
+ and the board has been read, so that the controller begins the moment both processes are up
+ Argument(s):
+ sem_t *sem_Startup - the startup semaphore created by Startup
+ Return Value: none
+ Usage: waitForStartup(sem_Startup);
+ */
+void waitForStartup(sem_t *sem_Startup)
+{
+    waitAtStartupBarrier(pnp, sem_Startup);
 }
 
 /*
@@ -458,10 +869,9 @@ void pnpOpen()
  ------------------
  Written by Jason Brown
  Date: 30/03/2024
- Version 1.0
+ Version 1.2
  Purpose: indicates to the simulator that the controller is quitting,
- unmaps the memory mapped file, closes the associated file descriptor
- and resets the terminal settings
+ unmaps the shared memory segment and resets the terminal settings
  Argument(s): none
  Return Value: none
  Usage: pnpClose();
@@ -469,8 +879,9 @@ void pnpOpen()
 void pnpClose()
 {
     pnp -> quit = TRUE;
+    if (trace_file != NULL) fclose(trace_file);
+    trace_file = NULL;
     munmap(pnp, sizeof(PnP));
-    close(fd);
 
     /* reset terminal settings to original values */
     resetTerminalSettings(old_term);
@@ -523,7 +934,7 @@ double getSimulationTime()
  ---------------------------
  Written by Jason Brown
  Date: 30/03/2024
- Version 1.0
+ Version 1.1
  Purpose:
  gets the error in the x-positioning of the gantry head when about to place a part (assuming a lookdown photo has already been taken)
  Argument(s):
@@ -535,6 +946,7 @@ double getSimulationTime()
  */
 double getPreplaceErrorX()
 {
+    tracePreplaceError();
     return pnp -> x_preplace_error;
 }
 
@@ -543,7 +955,7 @@ double getPreplaceErrorX()
  ---------------------------
  Written by Jason Brown
  Date: 30/03/2024
- Version 1.0
+ Version 1.1
  Purpose:
  gets the error in the y-positioning of the gantry head when about to place a part (assuming a lookdown photo has already been taken)
  Argument(s):
@@ -555,6 +967,7 @@ double getPreplaceErrorX()
  */
 double getPreplaceErrorY()
 {
+    tracePreplaceError();
     return pnp -> y_preplace_error;
 }
 
@@ -563,7 +976,7 @@ double getPreplaceErrorY()
  ---------------------------
  Written by Jason Brown
  Date: 30/03/2024
- Version 1.0
+ Version 1.1
  Purpose:
  gets the error in the angular rotation of the picked part on the specified nozzle (assuming a lookup photo has already been taken)
  Argument(s):
@@ -575,7 +988,74 @@ double getPreplaceErrorY()
  */
 double getPickErrorTheta(int nozzle)
 {
-    return pnp -> theta_pick_error[nozzle];
+    double theta = pnp -> theta_pick_error[nozzle];
+
+    if (trace_file != NULL && theta != traced_pick_error[nozzle])
+    {
+        writeTraceRecord(TRACE_PICK_ERROR, NO_INSTRUCTION, theta, 0.0, nozzle, 0);
+        traced_pick_error[nozzle] = theta;
+    }
+    return theta;
+}
+
+/*
+ Function: getFiducialInView
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets which board fiducial, if any, was seen by the last lookdown photo
+ Argument(s):
+ none
+ Return Value:
+ an int representing the number of the fiducial seen, or NO_FIDUCIAL (-1) if the photo was not of a fiducial
+ Usage:
+ int fiducial = getFiducialInView();
+ */
+int getFiducialInView()
+{
+    return pnp -> fiducial_in_view;
+}
+
+/*
+ Function: getFiducialOffsetX
+ ----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the x position of the fiducial seen by the last lookdown photo relative to the centre of the head
+ Argument(s):
+ none
+ Return Value:
+ a double representing the positive or negative x offset of the fiducial from the head
+ Usage:
+ double fiducial_x = x_head + getFiducialOffsetX();
+ */
+double getFiducialOffsetX()
+{
+    return pnp -> fiducial_offset_x;
+}
+
+/*
+ Function: getFiducialOffsetY
+ ----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the y position of the fiducial seen by the last lookdown photo relative to the centre of the head
+ Argument(s):
+ none
+ Return Value:
+ a double representing the positive or negative y offset of the fiducial from the head
+ Usage:
+ double fiducial_y = y_head + getFiducialOffsetY();
+ */
+double getFiducialOffsetY()
+{
+    return pnp -> fiducial_offset_y;
 }
 
 /*
@@ -602,6 +1082,328 @@ int isSimulatorReadyForNextInstruction()
     //else return 0;
 }
 
+/*
+ Function: getMachineConfig
+ --------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the machine description (feeder positions, head layout, camera location and timings) published by the simulator
+ Argument(s):
+ none
+ Return Value:
+ a pointer to the controller's copy of the machine description
+ Usage:
+ const MachineConfig *machine = getMachineConfig();
+ */
+const MachineConfig *getMachineConfig()
+{
+    return &machine;
+}
+
+/*
+ Function: getComponentLibrary
+ -----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the component library (the timings, nozzles and vision of each footprint) published by the simulator
+ Argument(s):
+ none
+ Return Value:
+ a pointer to the controller's copy of the component library
+ Usage:
+ const ComponentLibrary *library = getComponentLibrary();
+ */
+const ComponentLibrary *getComponentLibrary()
+{
+    return &library;
+}
+
+/*
+ Function: getNumberOfNozzles
+ ----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the number of nozzles fitted to the head, as given in the machine description
+ Argument(s):
+ none
+ Return Value:
+ an int representing the number of nozzles on the head (nozzles are numbered 0 to getNumberOfNozzles()-1)
+ Usage:
+ int number_of_nozzles = getNumberOfNozzles();
+ */
+int getNumberOfNozzles()
+{
+    return machine.number_of_nozzles;
+}
+
+/*
+ Function: getNozzleName
+ -----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the display name of the specified nozzle (e.g. "Left" on the default three nozzle head)
+ Argument(s):
+ int nozzle - the nozzle for which the name is required
+ Return Value:
+ a pointer to the null terminated name of the nozzle
+ Usage:
+ const char *name = getNozzleName(nozzle);
+ */
+const char *getNozzleName(int nozzle)
+{
+    return machine.nozzle_name[nozzle];
+}
+
+/*
+ Function: getNozzleOffsetX
+ --------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the x offset of the specified nozzle from the centre of the head, so that the head can be
+ positioned with that nozzle over a tape feeder
+ Argument(s):
+ int nozzle - the nozzle for which the offset is required
+ Return Value:
+ a double representing the positive or negative x offset of the nozzle
+ Usage:
+ double x_offset = getNozzleOffsetX(nozzle);
+ */
+double getNozzleOffsetX(int nozzle)
+{
+    return machine.nozzle_x_offset[nozzle];
+}
+
+/*
+ Function: getNozzleOffsetY
+ --------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the y offset of the specified nozzle from the centre of the head, so that the head can be
+ positioned with that nozzle over a tape feeder
+ Argument(s):
+ int nozzle - the nozzle for which the offset is required
+ Return Value:
+ a double representing the positive or negative y offset of the nozzle
+ Usage:
+ double y_offset = getNozzleOffsetY(nozzle);
+ */
+double getNozzleOffsetY(int nozzle)
+{
+    return machine.nozzle_y_offset[nozzle];
+}
+
+/*
+ Function: getHeadPositionX
+ --------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the x position of the centre of the head, as at the end of the last instruction executed by the simulator
+ Argument(s):
+ none
+ Return Value:
+ a double representing the x position of the head
+ Usage:
+ double head_x = getHeadPositionX();
+ */
+double getHeadPositionX()
+{
+    return pnp -> head_x;
+}
+
+/*
+ Function: getHeadPositionY
+ --------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the y position of the centre of the head, as at the end of the last instruction executed by the simulator
+ Argument(s):
+ none
+ Return Value:
+ a double representing the y position of the head
+ Usage:
+ double head_y = getHeadPositionY();
+ */
+double getHeadPositionY()
+{
+    return pnp -> head_y;
+}
+
+/*
+ Function: getFeederPartsRemaining
+ ---------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the number of parts left on the reel of the specified feeder
+ Argument(s):
+ int feeder - the tape feeder number
+ Return Value:
+ an int representing the parts left on the reel, 0 if the feeder is empty and waiting for a new reel to be
+ spliced on, or FEEDER_PARTS_UNLIMITED (-1) if the feeder never runs out
+ Usage:
+ int parts_remaining = getFeederPartsRemaining(feeder);
+ */
+int getFeederPartsRemaining(int feeder)
+{
+    return pnp -> feeder_status[feeder].parts_remaining;
+}
+
+/*
+ Function: getFeederReadyTime
+ ----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the simulation time at which the specified feeder will have the next part in the pick position, which
+ is after the tape has advanced following the last pick, or after a new reel has been spliced on if it is empty
+ Argument(s):
+ int feeder - the tape feeder number
+ Return Value:
+ a double representing the simulation time at which the feeder can next be picked from
+ Usage:
+ double ready_time = getFeederReadyTime(feeder);
+ */
+double getFeederReadyTime(int feeder)
+{
+    return pnp -> feeder_status[feeder].ready_time;
+}
+
+/*
+ Function: isFeederReady
+ -----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ determines whether a part can be picked from the specified feeder now
+ Argument(s):
+ int feeder - the tape feeder number
+ Return Value:
+ one of:
+ FALSE (0) - the tape is still advancing or the feeder is empty
+ TRUE (1) - a part is in the pick position
+ Usage:
+ if (isFeederReady(feeder)) lowerNozzle(nozzle);
+ */
+int isFeederReady(int feeder)
+{
+    return pnp -> feeder_status[feeder].parts_remaining != 0 && pnp -> sim_time >= pnp -> feeder_status[feeder].ready_time;
+}
+
+/*
+ Function: getNextFeederEvent
+ ----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the oldest feeder event (a feeder running empty or having a new reel spliced on) reported by the simulator
+ which has not already been returned. If the controller has fallen more than FEEDER_EVENT_QUEUE_LENGTH events
+ behind, the events which have been overwritten are skipped.
+ Argument(s):
+ FeederEvent *event - pointer to the structure to receive the event
+ Return Value:
+ one of:
+ FALSE (0) - there are no new feeder events
+ TRUE (1) - the next feeder event has been copied to *event
+ Usage:
+ while (getNextFeederEvent(&event)) {...}
+ */
+int getNextFeederEvent(FeederEvent *event)
+{
+    int number_of_feeder_events = pnp -> number_of_feeder_events;
+
+    if (number_of_feeder_events == number_of_feeder_events_read) return FALSE;
+    if (number_of_feeder_events - number_of_feeder_events_read > FEEDER_EVENT_QUEUE_LENGTH) number_of_feeder_events_read = number_of_feeder_events - FEEDER_EVENT_QUEUE_LENGTH;
+    __sync_synchronize();
+    *event = pnp -> feeder_event[number_of_feeder_events_read % FEEDER_EVENT_QUEUE_LENGTH];
+    number_of_feeder_events_read++;
+    return TRUE;
+}
+
+/*
+ Function: getSequenceLength
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the number of steps in the last sequence instruction (e.g. MOVE_CORRECT_LOWER) accepted by the simulator
+ Argument(s):
+ none
+ Return Value:
+ the number of steps, 0 if the last sequence instruction was rejected outright
+ Usage:
+ int steps = getSequenceLength();
+ */
+int getSequenceLength()
+{
+    return pnp -> sequence_report.number_of_steps;
+}
+
+/*
+ Function: getSequenceStepInstruction
+ ------------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the instruction carried out by one step of the last sequence instruction
+ Argument(s):
+ int step - the step, from 0 to getSequenceLength() - 1
+ Return Value:
+ the instruction, e.g. TAKE_PHOTO, or NO_INSTRUCTION if there is no such step
+ Usage:
+ int instruction = getSequenceStepInstruction(step);
+ */
+int getSequenceStepInstruction(int step)
+{
+    if (step < 0 || step >= pnp -> sequence_report.number_of_steps) return NO_INSTRUCTION;
+    return pnp -> sequence_report.instruction[step];
+}
+
+/*
+ Function: getSequenceStepResult
+ -------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the outcome of one step of the last sequence instruction
+ Argument(s):
+ int step - the step, from 0 to getSequenceLength() - 1
+ Return Value:
+ one of:
+ SEQUENCE_STEP_NOT_RUN (0) - the step has not been carried out, or there is no such step
+ SEQUENCE_STEP_DONE (1) - the step has finished
+ SEQUENCE_STEP_REJECTED (-1) - the simulator rejected the step, abandoning the rest of the sequence
+ Usage:
+ if (getSequenceStepResult(step) == SEQUENCE_STEP_REJECTED) {...}
+ */
+int getSequenceStepResult(int step)
+{
+    if (step < 0 || step >= pnp -> sequence_report.number_of_steps) return SEQUENCE_STEP_NOT_RUN;
+    return pnp -> sequence_report.result[step];
+}
+
 /*
  Function: getKey
  -------------------
@@ -650,6 +1452,122 @@ int isPnPSimulationQuitFlagOn()
     return pnp -> quit;
 }
 
+/*
+ Function: waitForNextPollLoop
+ -----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ ends a pass of the controller's poll loop. The controller heartbeat in shared memory is bumped, so the
+ supervisor in Startup can see the controller is still running, then the controller sleeps for one poll period
+ Argument(s): none
+ Return Value: none
+ Usage: waitForNextPollLoop();
+ */
+void waitForNextPollLoop()
+{
+    pnp -> controller_heartbeat++;
+    sleepSimulatedTime((double) 1 / POLL_LOOP_RATE);
+}
+
+/*
+ Function: publishPlacementTargets
+ ---------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ publishes the placements read from the centroid file in shared memory, so that the simulator can judge each part
+ it places against its target, and the package loaded on each feeder (that of the first placement listed for it),
+ so that it can time each part. Called before the startup barrier, so they are there before the simulator starts.
+ The feeder packages are recorded too, as the replay driver has to publish them in place of the controller.
+ Argument(s):
+ const PlacementInfo pi[] - the placements
+ int number_of_components_to_place - the number of placements
+ Return Value: none
+ Usage: publishPlacementTargets(pi, number_of_components_to_place);
+ */
+void publishPlacementTargets(const PlacementInfo pi[], int number_of_components_to_place)
+{
+    for (int i = 0; i < number_of_components_to_place && i < MAX_NUMBER_OF_COMPONENTS_TO_PLACE; i++)
+    {
+        memcpy(pnp -> target[i].designation, pi[i].component_designation, COMPONENT_DESIGNATION_LENGTH);
+        pnp -> target[i].designation[COMPONENT_DESIGNATION_LENGTH - 1] = '\0';
+        pnp -> target[i].x = pi[i].x_target;
+        pnp -> target[i].y = pi[i].y_target;
+        pnp -> target[i].theta = pi[i].theta_target;
+        pnp -> target[i].feeder = pi[i].feeder;
+    }
+    pnp -> number_of_targets = number_of_components_to_place;
+    for (int f = 0; f < MAX_NUMBER_OF_FEEDERS; f++) pnp -> feeder_package[f] = NO_PACKAGE;
+    for (int i = number_of_components_to_place - 1; i >= 0; i--) pnp -> feeder_package[pi[i].feeder] = pi[i].package;
+    for (int f = 0; f < machine.number_of_feeders; f++)
+    {
+        if (pnp -> feeder_package[f] != NO_PACKAGE) writeTraceRecord(TRACE_FEEDER_PACKAGE, pnp -> feeder_package[f], 0.0, 0.0, f, 0);
+    }
+}
+
+/*
+ Function: publishControllerStates
+ ---------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ publishes the names of the controller's states in shared memory, without their padding, so that the time spent
+ in each can be labelled by the metrics endpoint of Startup
+ Argument(s):
+ const char names[][CONTROLLER_STATE_NAME_LENGTH] - the state names, indexed by state
+ int number_of_states - the number of states, at most MAX_CONTROLLER_STATES are published
+ Return Value: none
+ Usage: publishControllerStates(state_name, sizeof(state_name) / sizeof(state_name[0]));
+ */
+void publishControllerStates(const char names[][CONTROLLER_STATE_NAME_LENGTH], int number_of_states)
+{
+    ControllerStats *stats = &pnp -> controller_stats;
+
+    if (number_of_states > MAX_CONTROLLER_STATES) number_of_states = MAX_CONTROLLER_STATES;
+    for (int i = 0; i < number_of_states; i++)
+    {
+        int length = strnlen(names[i], CONTROLLER_STATE_NAME_LENGTH - 1);
+
+        while (length > 0 && names[i][length - 1] == ' ') length--;
+        memcpy(stats -> state_name[i], names[i], length);
+        stats -> state_name[i][length] = '\0';
+    }
+    stats -> state = NO_CONTROLLER_STATE;
+    stats -> number_of_states = number_of_states;
+}
+
+/*
+ Function: recordControllerState
+ -------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ adds the simulation time since the last call to the time spent in the state the controller was in then, and
+ records the state it is in now, for the metrics endpoint of Startup. Called once every poll loop.
+ Argument(s):
+ int state - the controller's state, as published by publishControllerStates
+ Return Value: none
+ Usage: recordControllerState(state);
+ */
+void recordControllerState(int state)
+{
+    static double last_time = 0.0;
+    ControllerStats *stats = &pnp -> controller_stats;
+    double now = pnp -> sim_time;
+
+    if (stats -> state >= 0 && stats -> state < stats -> number_of_states && now > last_time)
+    {
+        stats -> state_time[stats -> state] += now - last_time;
+    }
+    last_time = now;
+    stats -> state = state;
+}
+
 /*
  Function: sleepMilliseconds
  ---------------------------
@@ -0,0 +1,59 @@
+/*
+ *
+ * pnpCorrection.c - the correction policy of the controller: the rotation each part needs, from its placement
+ * angle and the pick error seen by the lookup camera, as one move, and whether it is worth an instruction at all.
+ * A rotation within the correction band of the part's footprint is skipped, leaving the part that far out, so the
+ * bands come from the machine config file and are always less than the rotation tolerance.
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include "pnpControl.h"
+
+/*
+ Function: getRotationCorrectionBand
+ -----------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: gets the smallest rotation worth correcting for parts of a footprint
+ Argument(s):
+ const MachineConfig *machine - the machine description
+ const char *footprint - the footprint, as in the centroid file
+ Return Value: the band of the footprint in degrees, else the band for all other footprints
+ Usage: double band = getRotationCorrectionBand(machine, pi[part].component_footprint);
+ */
+double getRotationCorrectionBand(const MachineConfig *machine, const char *footprint)
+{
+    for (int i = 0; i < machine -> number_of_correction_bands; i++)
+    {
+        if (strcmp(machine -> correction_band_footprint[i], footprint) == 0) return machine -> correction_band[i];
+    }
+    return machine -> rotation_correction_band;
+}
+
+/*
+ Function: getRotationCorrection
+ -------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the rotation that turns a part from where it sits on the nozzle to its placement angle, taking out the pick
+ error and turning to the placement angle in the one move, and decides whether it is needed
+ Argument(s):
+ const MachineConfig *machine - the machine description
+ const char *footprint - the footprint of the part
+ double theta_target - the placement angle of the part in degrees
+ double theta_error - the pick error of the part in degrees
+ double *rotation - receives the rotation in degrees
+ Return Value: TRUE if the rotation is outside the correction band and should be made, else FALSE
+ Usage: if (getRotationCorrection(machine, pi[part].component_footprint, placement_theta[part], errortheta, &requested_theta)) {...}
+ */
+int getRotationCorrection(const MachineConfig *machine, const char *footprint, double theta_target, double theta_error, double *rotation)
+{
+    *rotation = theta_target - theta_error;
+    return fabs(*rotation) > getRotationCorrectionBand(machine, footprint);
+}
@@ -0,0 +1,404 @@
+/*
+ *
+ * pnpPlanner.c - puts the parts in pick order for the autonomous control mode, and builds the instruction
+ * schedule for a whole board before placing starts, issuing it to the simulator one step at a time, for the
+ * planned control mode
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include "pnpControl.h"
+
+static const PlacementInfo *pick_order_pi;  // the placements being sorted, qsort does not pass them to the compare function
+
+
+/*
+ Function: comparePickOrder
+ --------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ qsort compare function putting placements in pick order: by feeder, then by ascending y-coordinate,
+ keeping the centroid file order for placements which are otherwise the same
+ Argument(s):
+ const void *a, const void *b - pointers to the two placement numbers to compare
+ Return Value: negative, zero or positive as placement a is picked before, with or after placement b
+ Usage: qsort(order, n, sizeof(int), comparePickOrder);
+ */
+static int comparePickOrder(const void *a, const void *b)
+{
+    const PlacementInfo *pa = &pick_order_pi[*(const int*)a];
+    const PlacementInfo *pb = &pick_order_pi[*(const int*)b];
+
+    if (pa -> feeder != pb -> feeder) return pa -> feeder - pb -> feeder;
+    if (pa -> y_target != pb -> y_target) return pa -> y_target < pb -> y_target ? -1 : 1;
+    return *(const int*)a - *(const int*)b;
+}
+
+/*
+ Function: sortPickList
+ ----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ puts the parts in the order the autonomous control mode picks them: by feeder, then by ascending
+ y-coordinate (compared as whole numbers). Moved out of main unchanged so the benchmark can time it.
+ Argument(s):
+ const PlacementInfo pi[] - the placement info of all components
+ int number_of_components_to_place - the number of components
+ int component_list[] - receives the pick list, indexes into pi[]
+ Return Value: none
+ Usage: sortPickList(pi, number_of_components_to_place, component_list);
+ */
+void sortPickList(const PlacementInfo pi[], int number_of_components_to_place, int component_list[])
+{
+    int feeder_num_compare[number_of_components_to_place];
+    int y_target_compare[number_of_components_to_place];
+    int i, j, hold_value;
+    for (i = 0; i < number_of_components_to_place; i++)
+    {
+        feeder_num_compare[i] = pi[i].feeder;  //holds the feeder numbers in the centroid file
+        y_target_compare[i] = pi[i].y_target;  // holds the y coord values in the centroid file
+        component_list[i] = i;  //holds the indexes that correlate to the values
+    }
+    for (i = 0; i < number_of_components_to_place; i++)
+    {
+        for (j = i+1; j < number_of_components_to_place; j++)
+        {
+            if (feeder_num_compare[i] > feeder_num_compare[j])
+            {  //reorder the indexed numbers based on the feeder numbers. Swaps the y-coords so they correlate
+                hold_value = component_list[i];
+                component_list[i] = component_list[j];
+                component_list[j] = hold_value;
+                hold_value = feeder_num_compare[i];
+                feeder_num_compare[i] = feeder_num_compare[j];
+                feeder_num_compare[j] = hold_value;
+                hold_value = y_target_compare[i];
+                y_target_compare[i] = y_target_compare[j];
+                y_target_compare[j] = hold_value;
+            }
+            // sort by ascending y-coordinates if the feeder numbers are the same
+            else if (feeder_num_compare[i] == feeder_num_compare[j])
+            {
+                if (y_target_compare[i] > y_target_compare[j])
+                {
+                    hold_value = component_list[i];
+                    component_list[i] = component_list[j];
+                    component_list[j] = hold_value;
+                    hold_value = y_target_compare[i];
+                    y_target_compare[i] = y_target_compare[j];
+                    y_target_compare[j] = hold_value;
+                    hold_value = feeder_num_compare[i];
+                    feeder_num_compare[i] = feeder_num_compare[j];
+                    feeder_num_compare[j] = hold_value;
+                }
+            }
+        }
+    }
+}
+
+/*
+ Function: addPlanStep
+ ---------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ adds a step to the end of a plan, predicting its start time from the end of the plan so far (and, for a
+ step which must wait for a feeder, the time the feeder is predicted to be ready) and its finish time
+ from the duration given
+ Argument(s):
+ Plan *plan - the plan being built
+ int instruction - the instruction
+ double argument_1, argument_2, int argument_3 - the instruction arguments
+ int argument_source - PLAN_ARGUMENT_FIXED or the vision result the arguments are filled in from
+ int feeder - the feeder to wait for, else NO_PLAN_FEEDER
+ double feeder_ready_time - the time the feeder is predicted to be ready, ignored without a feeder
+ int part - the placement the step is for, else NO_PLAN_PART
+ int phase - what the step is spent on, PLAN_PHASE_PCB, PLAN_PHASE_FEEDER_TRAVEL, ...
+ double duration - predicted time to carry out the instruction
+ Return Value: the predicted finish time of the step, else PLAN_TOO_LONG (-1) if the plan is full
+ Usage: t = addPlanStep(plan, RAISE_NOZZLE, 0.0, 0.0, nozzle, PLAN_ARGUMENT_FIXED, NO_PLAN_FEEDER, 0.0, part, PLAN_PHASE_PICK, machine -> nozzle_raise_time);
+ */
+static double addPlanStep(Plan *plan, int instruction, double argument_1, double argument_2, int argument_3, int argument_source,
+                          int feeder, double feeder_ready_time, int part, int phase, double duration)
+{
+    PlanStep *step;
+    double start_time = plan -> cycle_time;
+
+    if (plan -> length >= MAX_PLAN_LENGTH) return PLAN_TOO_LONG;
+    if (plan -> length > 0) start_time += PLAN_HANDSHAKE_TIME;
+    if (feeder != NO_PLAN_FEEDER && feeder_ready_time > start_time) start_time = feeder_ready_time;
+    step = &plan -> step[plan -> length++];
+    step -> instruction = instruction;
+    step -> argument_1 = argument_1;
+    step -> argument_2 = argument_2;
+    step -> argument_3 = argument_3;
+    step -> argument_source = argument_source;
+    step -> feeder = feeder;
+    step -> part = part;
+    step -> phase = phase;
+    step -> start_time = start_time;
+    step -> finish_time = start_time + duration;
+    plan -> cycle_time = step -> finish_time;
+    return step -> finish_time;
+}
+
+/*
+ Function: chooseBatch
+ ---------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ chooses the parts picked in one trip of the head, taking the parts not yet picked in order and putting each on
+ a free nozzle which can carry it, until the nozzles are full or no part is left that fits. The first part sets
+ how the batch is photographed, and parts which need the other kind of lookup photo are left for a later batch,
+ so one large part does not stop the head at the camera for a batch of small ones. Each part takes the free
+ nozzle fewest of the remaining parts can use, leaving the others for the parts which need them.
+ Argument(s):
+ const PlacementInfo pi[] - the placements
+ const int order[] - the pick order, indexes into pi[]
+ char taken[] - TRUE for each placement already in a batch, updated
+ int number_of_components_to_place - the number of placements
+ const MachineConfig *machine - the machine to plan for
+ const ComponentLibrary *library - the handling of each package
+ int batch_part[], batch_nozzle[] - receive the parts of the batch in pick order, and the nozzle for each
+ int *vision - receives VISION_FLY_OVER or VISION_STATIONARY, how the batch is photographed
+ Return Value: the number of parts in the batch, at least 1 while any part is left
+ Usage: batch = chooseBatch(pi, order, taken, number_of_components_to_place, machine, library, batch_part, batch_nozzle, &vision);
+ */
+static int chooseBatch(const PlacementInfo pi[], const int order[], char taken[], int number_of_components_to_place, const MachineConfig *machine,
+                       const ComponentLibrary *library, int batch_part[], int batch_nozzle[], int *vision)
+{
+    unsigned int free_nozzles = (1u << machine -> number_of_nozzles) - 1;
+    int demand[MAX_NUMBER_OF_NOZZLES] = {0};
+    int batch = 0;
+
+    for (int i = 0; i < number_of_components_to_place; i++)
+    {
+        unsigned int nozzles = getPackageNozzles(library, machine, pi[order[i]].package);
+
+        if (taken[order[i]] == TRUE) continue;
+        for (int n = 0; n < machine -> number_of_nozzles; n++)
+        {
+            if (nozzles & (1u << n)) demand[n]++;
+        }
+    }
+
+    for (int i = 0; i < number_of_components_to_place && free_nozzles != 0; i++)
+    {
+        int part = order[i], nozzle = NO_NOZZLE;
+        unsigned int nozzles = getPackageNozzles(library, machine, pi[part].package) & free_nozzles;
+
+        if (taken[part] == TRUE) continue;
+        if (batch > 0 && getPackageVision(library, pi[part].package) != *vision) continue;
+        for (int n = 0; n < machine -> number_of_nozzles; n++)
+        {
+            if ((nozzles & (1u << n)) && (nozzle == NO_NOZZLE || demand[n] < demand[nozzle])) nozzle = n;
+        }
+        if (nozzle == NO_NOZZLE) continue;
+
+        if (batch == 0) *vision = getPackageVision(library, pi[part].package);
+        taken[part] = TRUE;
+        free_nozzles &= ~(1u << nozzle);
+        batch_part[batch] = part;
+        batch_nozzle[batch] = nozzle;
+        batch++;
+    }
+    return batch;
+}
+
+/*
+ Function: buildPlan
+ -------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ turns the placement list into the complete instruction schedule for the board, with a predicted start and
+ finish time for every step. Parts are picked in the order given, in batches of one part per nozzle chosen by
+ chooseBatch, then photographed by the lookup camera (in flight if the machine and every part of the batch allow
+ it) and placed one at a time, each after a lookdown photo. Picking and placing are timed for the package of each
+ part. The nozzle rotations and head corrections depend on those photos, so their steps are marked to be filled
+ in when issued.
+ Argument(s):
+ const PlacementInfo pi[] - the placements, as read from the centroid file, with their packages set
+ int number_of_components_to_place - the number of placements
+ const MachineConfig *machine - the machine to plan for
+ const ComponentLibrary *library - the handling of each package
+ int pick_order - PLAN_ORDER_BY_FEEDER or PLAN_ORDER_AS_LISTED
+ Plan *plan - receives the plan
+ Return Value: the number of steps in the plan, else PLAN_TOO_LONG (-1)
+ Usage: if (buildPlan(pi, number_of_components_to_place, machine, library, PLAN_ORDER_BY_FEEDER, &plan) == PLAN_TOO_LONG) {...}
+ */
+int buildPlan(const PlacementInfo pi[], int number_of_components_to_place, const MachineConfig *machine, const ComponentLibrary *library,
+              int pick_order, Plan *plan)
+{
+    int order[MAX_NUMBER_OF_COMPONENTS_TO_PLACE];
+    char taken[MAX_NUMBER_OF_COMPONENTS_TO_PLACE];
+    int batch_part[MAX_NUMBER_OF_NOZZLES], batch_nozzle[MAX_NUMBER_OF_NOZZLES], vision = VISION_FLY_OVER;
+    double feeder_ready_time[MAX_NUMBER_OF_FEEDERS];
+    double head_x = machine -> home_x, head_y = machine -> home_y, x, y, t = 0.0;
+
+    plan -> length = 0;
+    plan -> cycle_time = 0.0;
+    for (int i = 0; i < number_of_components_to_place; i++)
+    {
+        order[i] = i;
+        taken[i] = FALSE;
+    }
+    for (int f = 0; f < MAX_NUMBER_OF_FEEDERS; f++) feeder_ready_time[f] = 0.0;
+    if (pick_order == PLAN_ORDER_BY_FEEDER)
+    {
+        pick_order_pi = pi;
+        qsort(order, number_of_components_to_place, sizeof(int), comparePickOrder);
+    }
+
+    addPlanStep(plan, LOAD_PCB, 0.0, 0.0, 0, PLAN_ARGUMENT_FIXED, NO_PLAN_FEEDER, 0.0, NO_PLAN_PART, PLAN_PHASE_PCB, machine -> pcb_load_unload_time);
+
+    for (int picked = 0; picked < number_of_components_to_place; )
+    {
+        int batch = chooseBatch(pi, order, taken, number_of_components_to_place, machine, library, batch_part, batch_nozzle, &vision);
+
+        picked += batch;
+
+        /* pick each part onto its nozzle, the tape indexing to the next part after each pick */
+        for (int b = 0; b < batch; b++)
+        {
+            int part = batch_part[b], n = batch_nozzle[b], feeder = pi[part].feeder, package = pi[part].package;
+
+            x = machine -> feeder_x[feeder] - machine -> nozzle_x_offset[n];
+            y = machine -> feeder_y[feeder] - machine -> nozzle_y_offset[n];
+            addPlanStep(plan, MOVE_HEAD, x, y, 0, PLAN_ARGUMENT_FIXED, NO_PLAN_FEEDER, 0.0, part, PLAN_PHASE_FEEDER_TRAVEL, hypot(x - head_x, y - head_y) / machine -> head_full_speed);
+            head_x = x;
+            head_y = y;
+            addPlanStep(plan, LOWER_NOZZLE, 0.0, 0.0, n, PLAN_ARGUMENT_FIXED, feeder, feeder_ready_time[feeder], part, PLAN_PHASE_PICK,
+                        getPackageInstructionTime(library, machine, package, LOWER_NOZZLE, FALSE));
+            t = addPlanStep(plan, APPLY_VACUUM, 0.0, 0.0, n, PLAN_ARGUMENT_FIXED, NO_PLAN_FEEDER, 0.0, part, PLAN_PHASE_PICK,
+                            getPackageInstructionTime(library, machine, package, APPLY_VACUUM, FALSE));
+            feeder_ready_time[feeder] = t + machine -> feeder_advance_time[feeder];
+            addPlanStep(plan, RAISE_NOZZLE, 0.0, 0.0, n, PLAN_ARGUMENT_FIXED, NO_PLAN_FEEDER, 0.0, part, PLAN_PHASE_PICK,
+                        getPackageInstructionTime(library, machine, package, RAISE_NOZZLE, FALSE));
+        }
+
+        /* photograph the parts on the nozzles, flying over the camera to the first placement if possible */
+        x = pi[batch_part[0]].x_target;
+        y = pi[batch_part[0]].y_target;
+        if (machine -> lookup_camera_fly_over == TRUE && vision == VISION_FLY_OVER)
+        {
+            addPlanStep(plan, MOVE_HEAD_VIA_CAMERA, x, y, 0, PLAN_ARGUMENT_FIXED, NO_PLAN_FEEDER, 0.0, NO_PLAN_PART, PLAN_PHASE_LOOKUP,
+                        (hypot(machine -> lookup_camera_x - head_x, machine -> lookup_camera_y - head_y)
+                         + hypot(x - machine -> lookup_camera_x, y - machine -> lookup_camera_y)) / machine -> head_full_speed);
+            head_x = x;
+            head_y = y;
+        }
+        else
+        {
+            x = machine -> lookup_camera_x;
+            y = machine -> lookup_camera_y;
+            addPlanStep(plan, MOVE_HEAD, x, y, 0, PLAN_ARGUMENT_FIXED, NO_PLAN_FEEDER, 0.0, NO_PLAN_PART, PLAN_PHASE_LOOKUP, hypot(x - head_x, y - head_y) / machine -> head_full_speed);
+            head_x = x;
+            head_y = y;
+            addPlanStep(plan, TAKE_PHOTO, 0.0, 0.0, PHOTO_LOOKUP, PLAN_ARGUMENT_FIXED, NO_PLAN_FEEDER, 0.0, NO_PLAN_PART, PLAN_PHASE_LOOKUP, machine -> photo_take_time);
+        }
+
+        /* rotate each part to its placement angle, corrected for the pick error seen by the lookup camera */
+        for (int b = 0; b < batch; b++)
+        {
+            int part = batch_part[b];
+
+            addPlanStep(plan, ROTATE_NOZZLE, pi[part].theta_target, 0.0, batch_nozzle[b], PLAN_ARGUMENT_PICK_CORRECTION, NO_PLAN_FEEDER, 0.0, part, PLAN_PHASE_ROTATE,
+                        fabs(pi[part].theta_target) / machine -> nozzle_rotate_speed);
+        }
+
+        /* place each part, correcting the head position from a lookdown photo first */
+        for (int b = 0; b < batch; b++)
+        {
+            int part = batch_part[b], n = batch_nozzle[b], package = pi[part].package;
+
+            x = pi[part].x_target;
+            y = pi[part].y_target;
+            if (x != head_x || y != head_y)
+            {
+                addPlanStep(plan, MOVE_HEAD, x, y, 0, PLAN_ARGUMENT_FIXED, NO_PLAN_FEEDER, 0.0, part, PLAN_PHASE_PLACE_TRAVEL, hypot(x - head_x, y - head_y) / machine -> head_full_speed);
+                head_x = x;
+                head_y = y;
+            }
+            addPlanStep(plan, TAKE_PHOTO, 0.0, 0.0, PHOTO_LOOKDOWN, PLAN_ARGUMENT_FIXED, NO_PLAN_FEEDER, 0.0, part, PLAN_PHASE_PLACE, machine -> photo_take_time);
+            addPlanStep(plan, AMEND_HEAD_POSITION, 0.0, 0.0, 0, PLAN_ARGUMENT_PREPLACE_CORRECTION, NO_PLAN_FEEDER, 0.0, part, PLAN_PHASE_PLACE, 0.0);
+            addPlanStep(plan, LOWER_NOZZLE, 0.0, 0.0, n, PLAN_ARGUMENT_FIXED, NO_PLAN_FEEDER, 0.0, part, PLAN_PHASE_PLACE,
+                        getPackageInstructionTime(library, machine, package, LOWER_NOZZLE, TRUE));
+            addPlanStep(plan, RELEASE_VACUUM, 0.0, 0.0, n, PLAN_ARGUMENT_FIXED, NO_PLAN_FEEDER, 0.0, part, PLAN_PHASE_PLACE,
+                        getPackageInstructionTime(library, machine, package, RELEASE_VACUUM, TRUE));
+            addPlanStep(plan, RAISE_NOZZLE, 0.0, 0.0, n, PLAN_ARGUMENT_FIXED, NO_PLAN_FEEDER, 0.0, part, PLAN_PHASE_PLACE,
+                        getPackageInstructionTime(library, machine, package, RAISE_NOZZLE, TRUE));
+        }
+    }
+
+    x = machine -> home_x;
+    y = machine -> home_y;
+    addPlanStep(plan, MOVE_HEAD, x, y, 0, PLAN_ARGUMENT_FIXED, NO_PLAN_FEEDER, 0.0, NO_PLAN_PART, PLAN_PHASE_PLACE_TRAVEL, hypot(x - head_x, y - head_y) / machine -> head_full_speed);
+    t = addPlanStep(plan, UNLOAD_PCB, 0.0, 0.0, 0, PLAN_ARGUMENT_FIXED, NO_PLAN_FEEDER, 0.0, NO_PLAN_PART, PLAN_PHASE_PCB, machine -> pcb_load_unload_time);
+
+    if (t == PLAN_TOO_LONG) return PLAN_TOO_LONG;
+    return plan -> length;
+}
+
+/*
+ Function: issuePlanStep
+ -----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ passes one step of a plan to the simulator, filling in any arguments which depend on the last lookup or lookdown
+ photo. A step which must wait for a feeder is not issued until that feeder has a part ready, and a rotation
+ within the correction band of the part's footprint is not issued at all.
+ Argument(s):
+ const PlanStep *step - the step to issue
+ const PlacementInfo pi[] - the placement info of all components, for the footprint of the part
+ Return Value:
+ one of:
+ FALSE (0) - waiting for the feeder, the step has not been issued
+ TRUE (1) - the step has been passed to the simulator
+ PLAN_STEP_SKIPPED (2) - the rotation is not needed, so the next step can be issued straight away
+ Usage: if (isSimulatorReadyForNextInstruction() && issuePlanStep(&plan.step[next_step], pi) == TRUE) next_step++;
+ */
+int issuePlanStep(const PlanStep *step, const PlacementInfo pi[])
+{
+    double argument_1 = step -> argument_1, argument_2 = step -> argument_2;
+
+    if (step -> feeder != NO_PLAN_FEEDER && isFeederReady(step -> feeder) == FALSE) return FALSE;
+
+    if (step -> argument_source == PLAN_ARGUMENT_PICK_CORRECTION)
+    {
+        if (getRotationCorrection(getMachineConfig(), pi[step -> part].component_footprint, step -> argument_1,
+                                  getPickErrorTheta(step -> argument_3), &argument_1) == FALSE) return PLAN_STEP_SKIPPED;
+    }
+    else if (step -> argument_source == PLAN_ARGUMENT_PREPLACE_CORRECTION)
+    {
+        argument_1 = -getPreplaceErrorX();
+        argument_2 = -getPreplaceErrorY();
+    }
+
+    switch (step -> instruction)
+    {
+        case MOVE_HEAD:             setTargetPos(argument_1, argument_2); break;
+        case MOVE_HEAD_VIA_CAMERA:  setTargetPosViaCamera(argument_1, argument_2); break;
+        case ROTATE_NOZZLE:         rotateNozzle(step -> argument_3, argument_1); break;
+        case LOWER_NOZZLE:          lowerNozzle(step -> argument_3); break;
+        case RAISE_NOZZLE:          raiseNozzle(step -> argument_3); break;
+        case APPLY_VACUUM:          applyVacuum(step -> argument_3); break;
+        case RELEASE_VACUUM:        releaseVacuum(step -> argument_3); break;
+        case TAKE_PHOTO:            takePhoto(step -> argument_3); break;
+        case AMEND_HEAD_POSITION:   amendPos(argument_1, argument_2); break;
+        case LOAD_PCB:              loadPCB(); break;
+        case UNLOAD_PCB:            unloadPCB(); break;
+    }
+    return TRUE;
+}
@@ -3,124 +3,60 @@
 #include <unistd.h>
 #include <string.h>
 #include <semaphore.h>
+#include "pnpDisplay.h"
 
-#define READ_BLOCK_SIZE 50
-
+const char source_name[NUMBER_OF_LOG_SOURCES][11] = {"STARTUP", "SIMULATOR", "CONTROLLER"};
 
 
 int main(int argc, char *argv[])
 {
 
-    char readBufferStartup[READ_BLOCK_SIZE+1], readBufferSim[READ_BLOCK_SIZE+1], readBufferContrl[READ_BLOCK_SIZE+1];
-    ssize_t bytesReadStartup, bytesReadSim, bytesReadContrl;
-
-    // set up the file descriptors for each of the other processes to communicate
-    int readStartupFd = atoi(argv[1]);
-    int readSimFd = atoi(argv[2]);
-    int readContrlFd = atoi(argv[3]);
+    const LogMessage *message;
+    unsigned long dropped[NUMBER_OF_LOG_SOURCES] = {0}, skipped = 0;
 
-    printf("DISPLAY\nNow reading and printing from pipes\n");
-    //display process will stop here until there is a message to be read
-    bytesReadSim = read(readSimFd, readBufferSim, READ_BLOCK_SIZE);
-    bytesReadContrl = read(readContrlFd, readBufferContrl, READ_BLOCK_SIZE);
+    // the messages from Startup, the simulator and the controller all come through the one log ring, in the order they were written
+    LogRing *log_ring = openLogRing();
+    if (log_ring == NULL)
+    {
+        fprintf(stderr, "Display could not open the log ring, it is started by Startup\n");
+        exit(1);
+    }
 
+    printf("DISPLAY\nNow reading and printing from the log ring\n");
     while(1)
-    {	// check if there are bytes in the Startup buffer
-        bytesReadStartup = read(readStartupFd, readBufferStartup, READ_BLOCK_SIZE);
-
-        if (bytesReadStartup > 0) //if there are bytes to read
+    {
+        // print every message waiting straight from its slot, and flush them together rather than a line at a time
+        while ((message = peekLogMessage(log_ring)) != NULL)
         {
-            printf("STARTUP\n");
-            while(readBufferStartup[bytesReadStartup-1]!='\n') //keep printing until new line
-            {  // continue printing until the new line is specified
-                readBufferStartup[bytesReadStartup] = '\0';
-                printf("%s", readBufferStartup);
-                bytesReadStartup = read(readStartupFd, readBufferStartup,READ_BLOCK_SIZE);
-            }
-            //once a new line detected, print the remaining part of the message
-            readBufferStartup[bytesReadStartup] = '\0';
-            printf("%s", readBufferStartup);
-            bytesReadStartup = read(readStartupFd, readBufferStartup, READ_BLOCK_SIZE);
-        }
+            int source = message -> source >= 0 && message -> source < NUMBER_OF_LOG_SOURCES ? message -> source : LOG_SOURCE_STARTUP;
 
-        // otherwise if all pipes are closed, terminate the Display process
-        else if (bytesReadStartup == 0 && bytesReadSim == 0 && bytesReadContrl == 0)
-        {
-	       printf("DISPLAY\nFinished reading from pipes\nTerminating...\n");
-            close(readStartupFd);  //close all the pipes and terminate
-            close(readSimFd);
-            close(readContrlFd);
-            exit(10);
+            printf("%s\n%.*s", source_name[source], message -> length, message -> text);
+            releaseLogMessage(log_ring);
         }
-        // if there are no bytes from Startup, continue with program
 
-        //i.e. simulator has earlier simulation time
-        if(strncmp("Time", readBufferSim, 3) == 0 && strncmp("Time", readBufferContrl, 3) == 0)
-        { //Do comparison between simulation time to determine which came first
-          //strncmp will return <0 if readBufferSim is lower in value to readBufferContrl for the first 20 chars
-     		if(strncmp(readBufferSim, readBufferContrl, 20) < 0)
-            {
-                printf("SIMULATOR\n");
-                while (readBufferSim[bytesReadSim-1] != '\n')
-                {
-                    readBufferSim[bytesReadSim] = '\0';
-                    printf("%s", readBufferSim);
-                    bytesReadSim = read(readSimFd, readBufferSim, READ_BLOCK_SIZE);
-                }
-                readBufferSim[bytesReadSim] = '\0';
-                printf("%s", readBufferSim);
-                bytesReadSim = read(readSimFd, readBufferSim, READ_BLOCK_SIZE);
-            }
-		//might need to add another byte read here to compare next message sim time
-            // strncmp will return >0 if readBufferSim is higher in value to readBufferContrl for the first 20 chars
-            // i.e. the controller will have earlier simulation time
-            if (strncmp(readBufferSim, readBufferContrl, 20) > 0)
+        // a writer never waits for the Display, so say when messages were lost because it fell behind
+        for (int source = 0; source < NUMBER_OF_LOG_SOURCES; source++)
+        {
+            if (log_ring -> dropped[source] != dropped[source])
             {
-                printf("CONTROLLER\n");
-                while (readBufferContrl[bytesReadContrl-1] != '\n')
-                {
-                    readBufferContrl[bytesReadContrl] = '\0';
-                    printf("%s", readBufferContrl);
-                    bytesReadContrl = read(readContrlFd, readBufferContrl, READ_BLOCK_SIZE);
-                }
-                readBufferContrl[bytesReadContrl] = '\0';
-                printf("%s", readBufferContrl);
-                bytesReadContrl = read(readContrlFd, readBufferContrl, READ_BLOCK_SIZE);
+                printf("DISPLAY\n%lu messages from %s dropped as the log ring was full\n", log_ring -> dropped[source] - dropped[source], source_name[source]);
+                dropped[source] = log_ring -> dropped[source];
             }
-
         }
-
-
-        else
-        { // if the message from simulator or controller does not contain 'Time' or simulation time, print as usual
-            if (bytesReadSim > 0)
-            {
-                printf("SIMULATOR\n");
-                while (readBufferSim[bytesReadSim-1] != '\n')
-                {
-                    readBufferSim[bytesReadSim] = '\0';
-                    printf("%s", readBufferSim);
-                    bytesReadSim = read(readSimFd, readBufferSim, READ_BLOCK_SIZE);
-                }
-                readBufferSim[bytesReadSim] = '\0';
-                printf("%s", readBufferSim);
-                bytesReadSim = read(readSimFd, readBufferSim, READ_BLOCK_SIZE);
-            }
-
-            if (bytesReadContrl > 0)
-            {
-                printf("CONTROLLER\n");
-                while (readBufferContrl[bytesReadContrl-1] != '\n')
-                {
-                    readBufferContrl[bytesReadContrl] = '\0';
-                    printf("%s", readBufferContrl);
-                    bytesReadContrl = read(readContrlFd, readBufferContrl, READ_BLOCK_SIZE);
-                }
-                readBufferContrl[bytesReadContrl] = '\0';
-                printf("%s", readBufferContrl);
-                bytesReadContrl = read(readContrlFd, readBufferContrl, READ_BLOCK_SIZE);
-            }
+        if (log_ring -> skipped != skipped)
+        {
+            printf("DISPLAY\n%lu messages lost from processes stopped while writing them\n", log_ring -> skipped - skipped);
+            skipped = log_ring -> skipped;
         }
+        fflush(stdout);
 
+        // once Startup has finished the ring and everything is printed, terminate the Display process
+        if (isLogRingFinished(log_ring) == TRUE)
+        {
+            printf("DISPLAY\nFinished reading from the log ring\nTerminating...\n");
+            closeLogRing(log_ring);
+            exit(10);
+        }
+        waitForLogMessage(log_ring, DISPLAY_POLL_TIMEOUT);
     }//end while loop
 } // end main
@@ -0,0 +1,146 @@
+/*
+ *
+ * pnpEstimate.c - predicts the board cycle time for a centroid file on a machine without running the
+ * simulation, for the current pick strategy and the alternatives, with the time spent in each phase
+ *
+ * Usage: Assgn2_2024_Estimator [centroid file [machine config file [component library file]]]
+ * The files default to those the controller and simulator would use.
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include "pnpEstimate.h"
+
+const char phase_name[NUMBER_OF_PLAN_PHASES][24] = {"PCB load and unload",
+                                                    "Travel to feeders",
+                                                    "Picking",
+                                                    "Lookup camera",
+                                                    "Rotating parts",
+                                                    "Travel to placements",
+                                                    "Placing"};
+
+
+/*
+ Function: estimateCycleTime
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ totals the predicted time of a plan by phase, separating out the time spent waiting for feeders and the
+ handshake between instructions
+ Argument(s):
+ const Plan *plan - the plan, as built by buildPlan
+ CycleTimeEstimate *estimate - receives the totals
+ Return Value: none
+ Usage: estimateCycleTime(&plan, &estimate);
+ */
+void estimateCycleTime(const Plan *plan, CycleTimeEstimate *estimate)
+{
+    double previous_finish_time = 0.0;
+
+    estimate -> number_of_steps = plan -> length;
+    estimate -> cycle_time = plan -> cycle_time;
+    estimate -> feeder_wait_time = 0.0;
+    estimate -> handshake_time = 0.0;
+    for (int p = 0; p < NUMBER_OF_PLAN_PHASES; p++) estimate -> phase_time[p] = 0.0;
+
+    for (int i = 0; i < plan -> length; i++)
+    {
+        const PlanStep *step = &plan -> step[i];
+        double gap = step -> start_time - previous_finish_time;
+
+        if (i > 0)
+        {
+            estimate -> handshake_time += PLAN_HANDSHAKE_TIME;
+            if (gap > PLAN_HANDSHAKE_TIME + 1e-9) estimate -> feeder_wait_time += gap - PLAN_HANDSHAKE_TIME;
+        }
+        estimate -> phase_time[step -> phase] += step -> finish_time - step -> start_time;
+        previous_finish_time = step -> finish_time;
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    static Plan plan;  //too large for the stack
+    MachineConfig machine, what_if;
+    ComponentLibrary library;
+    PlacementInfo pi[MAX_NUMBER_OF_COMPONENTS_TO_PLACE];
+    CycleTimeEstimate estimate;
+    struct timespec start, finish;
+    int operation_mode, number_of_components_to_place, machine_config_res, component_library_res, res;
+
+    /* the files given on the command line replace those the controller and simulator would use */
+    if (argc > 1) setenv(CENTROID_FILE_ENV, argv[1], 1);
+    if (argc > 2) setenv(MACHINE_CONFIG_FILE_ENV, argv[2], 1);
+    if (argc > 3) setenv(COMPONENT_LIBRARY_FILE_ENV, argv[3], 1);
+
+    machine_config_res = getMachineConfigFileContents(getMachineConfigFileName(), &machine);
+    if (machine_config_res != MACHINE_CONFIG_FILE_PRESENT_AND_READ && machine_config_res != MACHINE_CONFIG_FILE_NOT_PRESENT)
+    {
+        printf("Problem with machine config file %s, error code %d\n", getMachineConfigFileName(), machine_config_res);
+        exit(3);
+    }
+    component_library_res = getComponentLibraryFileContents(getComponentLibraryFileName(), &machine, &library);
+    if (component_library_res != COMPONENT_LIBRARY_FILE_PRESENT_AND_READ && component_library_res != COMPONENT_LIBRARY_FILE_NOT_PRESENT)
+    {
+        printf("Problem with component library file %s, error code %d\n", getComponentLibraryFileName(), component_library_res);
+        exit(3);
+    }
+
+    res = getCentroidFileContents(&operation_mode, &number_of_components_to_place, pi);
+    for (int i = 0; i < number_of_components_to_place && res == CENTROID_FILE_PRESENT_AND_READ; i++)
+    {  //every part must come from a feeder that is fitted to this machine
+        if (pi[i].feeder < 0 || pi[i].feeder >= machine.number_of_feeders) res = CENTROID_FILE_HAS_UNKNOWN_FEEDER;
+    }
+    if (res != CENTROID_FILE_PRESENT_AND_READ)
+    {
+        printf("Problem with centroid file %s, error code %d\n", getCentroidFileName(), res);
+        exit(4);
+    }
+    setPlacementPackages(pi, number_of_components_to_place, &library);
+
+    const Strategy strategy[NUMBER_OF_STRATEGIES] = {{"feeder order, fly over camera", PLAN_ORDER_BY_FEEDER, TRUE},
+                                                     {"feeder order, stop at camera", PLAN_ORDER_BY_FEEDER, FALSE},
+                                                     {"file order, fly over camera", PLAN_ORDER_AS_LISTED, TRUE},
+                                                     {"file order, stop at camera", PLAN_ORDER_AS_LISTED, FALSE}};
+
+    printf("Centroid file: %s  Machine config file: %s%s\n", getCentroidFileName(), getMachineConfigFileName(),
+           machine_config_res == MACHINE_CONFIG_FILE_NOT_PRESENT ? " (not present, default machine)" : "");
+    printf("Component library file: %s%s\n", getComponentLibraryFileName(),
+           component_library_res == COMPONENT_LIBRARY_FILE_NOT_PRESENT ? " (not present, machine timings)" : "");
+    printf("%d parts, %d nozzles, %d feeders, lookup camera fly-over %s\n\n", number_of_components_to_place,
+           machine.number_of_nozzles, machine.number_of_feeders, machine.lookup_camera_fly_over == TRUE ? "fitted" : "not fitted");
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int s = 0; s < NUMBER_OF_STRATEGIES; s++)
+    {
+        what_if = machine;
+        what_if.lookup_camera_fly_over = strategy[s].fly_over;
+        if (buildPlan(pi, number_of_components_to_place, &what_if, &library, strategy[s].pick_order, &plan) == PLAN_TOO_LONG)
+        {
+            printf("Strategy: %s\n  Too many parts to plan\n\n", strategy[s].name);
+            continue;
+        }
+        estimateCycleTime(&plan, &estimate);
+
+        printf("Strategy: %s%s%s\n", strategy[s].name,
+               strategy[s].pick_order == PLAN_ORDER_BY_FEEDER && strategy[s].fly_over == machine.lookup_camera_fly_over ? " (current)" : "",
+               strategy[s].fly_over == TRUE && machine.lookup_camera_fly_over == FALSE ? " (needs fly-over camera)" : "");
+        printf("  %-22s %8.2f s  (%d instructions)\n", "Cycle time", estimate.cycle_time, estimate.number_of_steps);
+        for (int p = 0; p < NUMBER_OF_PLAN_PHASES; p++)
+        {
+            printf("  %-22s %8.2f s\n", phase_name[p], estimate.phase_time[p]);
+        }
+        printf("  %-22s %8.2f s\n", "Waiting for feeders", estimate.feeder_wait_time);
+        printf("  %-22s %8.2f s\n\n", "Instruction handshakes", estimate.handshake_time);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    printf("Estimated %d strategies in %.3f ms\n", NUMBER_OF_STRATEGIES,
+           (finish.tv_sec - start.tv_sec) * 1000.0 + (finish.tv_nsec - start.tv_nsec) / 1000000.0);
+    return 0;
+}
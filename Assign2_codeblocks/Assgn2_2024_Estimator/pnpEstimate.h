@@ -0,0 +1,32 @@
+/*
+ *
+ * pnpEstimate.h - declarations for the pick and place board cycle time estimator
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include "../Assgn2_2024_Controller/pnpControl.h"
+
+#define NUMBER_OF_STRATEGIES 4
+
+typedef struct
+{
+    const char *name;
+    int pick_order;          // PLAN_ORDER_BY_FEEDER or PLAN_ORDER_AS_LISTED
+    int fly_over;            // TRUE to photograph the parts flying over the lookup camera, FALSE to stop at it
+
+} Strategy;
+
+typedef struct
+{
+    int number_of_steps;
+    double cycle_time;
+    double phase_time[NUMBER_OF_PLAN_PHASES];
+    double feeder_wait_time;     // waiting for a tape to advance before a pick
+    double handshake_time;       // between one instruction finishing and the next starting
+
+} CycleTimeEstimate;
+
+void estimateCycleTime(const Plan*, CycleTimeEstimate*);
@@ -0,0 +1,417 @@
+/*
+ *
+ * pnpHarness.c - runs the simulator and controller end-to-end over one or more centroid files, faster than
+ * real time, and reports the simulated cycle time, parts per hour, dropped parts and wall time of each board.
+ * It takes the place of Startup and the Display, so nothing is shown while the boards run.
+ *
+ * Usage: Assgn2_2024_Harness [-t time scale] [-T timeout seconds] [-o results file] [-v] centroid file...
+ * Boards in manual mode cannot be run. The results file is JSON, as written by the benchmarks.
+ * Only one harness (or Startup) can run at a time, as they share the named semaphores.
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include "pnpHarness.h"
+
+/*
+ Function: readCentroidFileHeader
+ --------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: reads the operation mode and number of parts from the start of a centroid file
+ Argument(s):
+ const char *filename - the centroid file
+ char *operation_mode - receives the operation mode character, e.g. 'A'
+ int *number_of_parts - receives the number of parts
+ Return Value: TRUE if both were read, else FALSE
+ Usage: if (readCentroidFileHeader(filename, &mode, &parts)) {...}
+ */
+int readCentroidFileHeader(const char *filename, char *operation_mode, int *number_of_parts)
+{
+    FILE *fp = fopen(filename, "r");
+    int res;
+
+    if (fp == NULL) return FALSE;
+    res = fscanf(fp, " %c %d", operation_mode, number_of_parts);
+    fclose(fp);
+    return res == 2;
+}
+
+/*
+ Function: getWallTime
+ ---------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: gets the time from CLOCK_MONOTONIC in seconds
+ Argument(s): none
+ Return Value: the time in seconds
+ Usage: double start = getWallTime();
+ */
+static double getWallTime()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1000000000.0;
+}
+
+/*
+ Function: startProcess
+ ----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ starts the simulator or controller as Startup would, writing to the given pipe, with no keyboard and
+ its standard output discarded
+ Argument(s):
+ const char *path - the executable
+ const char *name - the name of the process, e.g. "Assgn2_2024_Simulator"
+ int pipe_fd[2] - the pipe the process writes its display output to
+ int other_read_fd - the read end of the other process's pipe, which the process does not need
+ Return Value: the process id, else -1 if the process could not be started
+ Usage: pid_t sim_pid = startProcess(sim_path, "Assgn2_2024_Simulator", pipe_Sim, pipe_Contrl[0]);
+ */
+static pid_t startProcess(const char *path, const char *name, int pipe_fd[2], int other_read_fd)
+{
+    char write_fd_str[12];
+    pid_t pid = fork();
+
+    if (pid != 0) return pid;
+
+    int null_fd = open("/dev/null", O_RDWR);
+    dup2(null_fd, STDIN_FILENO);
+    dup2(null_fd, STDOUT_FILENO);
+    close(null_fd);
+    close(pipe_fd[0]);
+    close(other_read_fd);
+    snprintf(write_fd_str, sizeof(write_fd_str), "%d", pipe_fd[1]);
+    execl(path, name, write_fd_str, (char *) NULL);
+    perror("overlay of the process failed");
+    _exit(5);
+}
+
+/*
+ Function: readOutputLines
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ reads what is waiting in a process's pipe and splits it into lines, passing each line to the board run
+ (to pick up the simulator summary) and echoing it if verbose
+ Argument(s):
+ OutputReader *reader - the pipe and the partial line read so far
+ BoardRun *run - the board run, which receives the simulator summary
+ int verbose - TRUE to echo the output
+ Return Value: none, reader -> open is set FALSE when the pipe is closed
+ Usage: readOutputLines(&reader[0], run, verbose);
+ */
+static void readOutputLines(OutputReader *reader, BoardRun *run, int verbose)
+{
+    char buffer[4096];
+    ssize_t bytes_read = read(reader -> fd, buffer, sizeof(buffer));
+
+    if (bytes_read <= 0)
+    {
+        reader -> open = FALSE;
+        return;
+    }
+    for (ssize_t i = 0; i < bytes_read; i++)
+    {
+        if (buffer[i] != '\n')
+        {
+            if (reader -> length < HARNESS_LINE_LENGTH - 1) reader -> line[reader -> length++] = buffer[i];
+            continue;
+        }
+        reader -> line[reader -> length] = '\0';
+        if (verbose) printf("%s\n", reader -> line);
+        if (sscanf(reader -> line, SIMULATION_SUMMARY_SCAN_FORMAT, &run -> simulation_time, &run -> number_of_placed_parts,
+                   &run -> number_of_dropped_parts, &run -> pcb_load_time, &run -> pcb_unload_time) == NUMBER_OF_FIELDS_IN_SIMULATION_SUMMARY)
+        {
+            run -> result = BOARD_RUN_OK;
+        }
+        reader -> length = 0;
+    }
+}
+
+/*
+ Function: runBoard
+ ------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.3
+ Purpose:
+ runs the simulator and controller over one centroid file, creating a fresh shared memory segment and setting
+ up the named semaphores as Startup does, and fills in the results from the summary the simulator writes as it terminates
+ Argument(s):
+ BoardRun *run - the board, with centroid_file, operation_mode and number_of_parts filled in; receives the results
+ const char *sim_path, *contrl_path - the simulator and controller executables
+ double timeout - wall seconds before the run is abandoned and both processes killed
+ int verbose - TRUE to echo the simulator and controller output
+ Return Value: none, run -> result gives the outcome
+ Usage: runBoard(&run, sim_path, contrl_path, DEFAULT_HARNESS_TIMEOUT, FALSE);
+ */
+void runBoard(BoardRun *run, const char *sim_path, const char *contrl_path, double timeout, int verbose)
+{
+    int pipe_Sim[2], pipe_Contrl[2], status;
+    OutputReader reader[2];
+    struct pollfd poll_fd[2];
+    pid_t sim_pid, contrl_pid;
+    double start;
+    PnP *pnp;
+
+    run -> result = BOARD_RUN_NOT_STARTED;
+    run -> simulator_status = run -> controller_status = -1;
+    run -> number_of_placed_parts = run -> number_of_dropped_parts = 0;
+    run -> pcb_load_time = run -> pcb_unload_time = NO_PCB_TIME;
+    run -> simulation_time = run -> cycle_time = run -> parts_per_hour = run -> wall_time = 0.0;
+
+    /* a fresh shared memory segment and semaphores, as Startup gives them */
+    pnp = createPnP();
+    if (pnp == MAP_FAILED)
+    {
+        perror("Shared memory creation failed");
+        return;
+    }
+    sem_unlink("/sem_Startup");
+    sem_unlink("/sem_Sim");
+    sem_unlink("/sem_Contrl");
+    sem_t *sem_Startup = sem_open("/sem_Startup", O_CREAT, 0666, 0);
+    sem_t *sem_Sim = sem_open("/sem_Sim", O_CREAT, 0666, 0);
+    sem_t *sem_Contrl = sem_open("/sem_Contrl", O_CREAT, 0666, 0);
+    if (sem_Startup == SEM_FAILED || sem_Sim == SEM_FAILED || sem_Contrl == SEM_FAILED)
+    {
+        perror("Semaphore creation failed");
+        closePnP(pnp);
+        return;
+    }
+    if (pipe(pipe_Sim) < 0 || pipe(pipe_Contrl) < 0)
+    {
+        perror("Pipe creation failed");
+        closePnP(pnp);
+        return;
+    }
+    setenv(CENTROID_FILE_ENV, run -> centroid_file, 1);
+
+    start = getWallTime();
+    sim_pid = startProcess(sim_path, "Assgn2_2024_Simulator", pipe_Sim, pipe_Contrl[0]);
+    contrl_pid = startProcess(contrl_path, "Assgn2_2024_Controller", pipe_Contrl, pipe_Sim[0]);
+    close(pipe_Sim[1]);
+    close(pipe_Contrl[1]);
+
+    run -> result = BOARD_RUN_FAILED;  // until the simulator summary is read
+    reader[0].fd = pipe_Sim[0];
+    reader[1].fd = pipe_Contrl[0];
+    for (int p = 0; p < 2; p++)
+    {
+        reader[p].open = TRUE;
+        reader[p].length = 0;
+    }
+    while (reader[0].open || reader[1].open)
+    {
+        if (getWallTime() - start > timeout)
+        {
+            kill(sim_pid, SIGKILL);
+            kill(contrl_pid, SIGKILL);
+            run -> result = BOARD_RUN_TIMED_OUT;
+            break;
+        }
+        for (int p = 0; p < 2; p++)
+        {
+            poll_fd[p].fd = reader[p].open ? reader[p].fd : -1;
+            poll_fd[p].events = POLLIN;
+        }
+        if (poll(poll_fd, 2, 100) <= 0) continue;
+        for (int p = 0; p < 2; p++)
+        {
+            if (reader[p].open && (poll_fd[p].revents & (POLLIN | POLLHUP | POLLERR))) readOutputLines(&reader[p], run, verbose);
+        }
+    }
+
+    if (waitpid(sim_pid, &status, 0) == sim_pid && WIFEXITED(status)) run -> simulator_status = WEXITSTATUS(status);
+    if (waitpid(contrl_pid, &status, 0) == contrl_pid && WIFEXITED(status)) run -> controller_status = WEXITSTATUS(status);
+    run -> wall_time = getWallTime() - start;
+    close(pipe_Sim[0]);
+    close(pipe_Contrl[0]);
+
+    if (run -> result == BOARD_RUN_OK && (run -> simulator_status != SIMULATOR_EXIT_CODE || run -> controller_status != CONTROLLER_EXIT_CODE))
+    {
+        run -> result = BOARD_RUN_FAILED;
+    }
+    else if (run -> result == BOARD_RUN_OK && run -> number_of_placed_parts + run -> number_of_dropped_parts != run -> number_of_parts)
+    {   // a part neither placed nor dropped has been lost, which a clean exit does not show
+        run -> result = BOARD_RUN_INCOMPLETE;
+    }
+    if (run -> pcb_load_time != NO_PCB_TIME && run -> pcb_unload_time != NO_PCB_TIME)
+    {
+        run -> cycle_time = run -> pcb_unload_time - run -> pcb_load_time;
+        if (run -> cycle_time > 0.0) run -> parts_per_hour = 3600.0 * run -> number_of_placed_parts / run -> cycle_time;
+    }
+
+    sem_close(sem_Startup);
+    sem_close(sem_Sim);
+    sem_close(sem_Contrl);
+    sem_unlink("/sem_Startup");
+    sem_unlink("/sem_Sim");
+    sem_unlink("/sem_Contrl");
+    closePnP(pnp);
+}
+
+/*
+ Function: getRunResultName
+ --------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose: gets a name for the outcome of a board run
+ Argument(s):
+ int result - BOARD_RUN_OK, ...
+ Return Value: the name
+ Usage: printf("%s\n", getRunResultName(run.result));
+ */
+static const char *getRunResultName(int result)
+{
+    switch (result)
+    {
+        case BOARD_RUN_OK: return "ok";
+        case BOARD_RUN_NOT_STARTED: return "not started";
+        case BOARD_RUN_TIMED_OUT: return "timed out";
+        case BOARD_RUN_INCOMPLETE: return "incomplete";
+        default: return "failed";
+    }
+}
+
+/*
+ Function: writeResults
+ ----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: writes the results of the board runs as JSON, with when and where they were measured
+ Argument(s):
+ const BoardRun run[] - the board runs
+ int number_of_boards - the number of board runs
+ double time_scale - the time scale the boards were run at
+ const char *filename - the file to write
+ Return Value: 0 if the file was written, else -1
+ Usage: writeResults(run, number_of_boards, time_scale, "throughput.json");
+ */
+int writeResults(const BoardRun run[], int number_of_boards, double time_scale, const char *filename)
+{
+    FILE *fp = fopen(filename, "w");
+    struct utsname host;
+    char date[32];
+    time_t now = time(NULL);
+
+    if (fp == NULL) return -1;
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    if (uname(&host) != 0) strcpy(host.machine, "unknown");
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"format_version\": %d,\n", HARNESS_FORMAT_VERSION);
+    fprintf(fp, "  \"date\": \"%s\",\n", date);
+    fprintf(fp, "  \"system\": \"%s %s %s\",\n", host.sysname, host.release, host.machine);
+    fprintf(fp, "  \"time_scale\": %g,\n", time_scale);
+    fprintf(fp, "  \"boards\": [\n");
+    for (int i = 0; i < number_of_boards; i++)
+    {
+        fprintf(fp, "    {\"centroid_file\": \"%s\", \"mode\": \"%c\", \"parts\": %d, \"result\": \"%s\", "
+                    "\"placed\": %d, \"dropped\": %d, \"cycle_time\": %.2f, \"parts_per_hour\": %.1f, \"wall_time\": %.3f}%s\n",
+                run[i].centroid_file, run[i].operation_mode, run[i].number_of_parts, getRunResultName(run[i].result),
+                run[i].number_of_placed_parts, run[i].number_of_dropped_parts, run[i].cycle_time, run[i].parts_per_hour,
+                run[i].wall_time, i < number_of_boards - 1 ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+
+int main(int argc, char *argv[])
+{
+    static BoardRun run[MAX_HARNESS_BOARDS];
+    char sim_path[PATH_MAX], contrl_path[PATH_MAX], time_scale_str[32];
+    double time_scale = DEFAULT_HARNESS_TIME_SCALE, timeout = DEFAULT_HARNESS_TIMEOUT;
+    const char *filename = NULL;
+    int number_of_boards = 0, verbose = FALSE, failures = 0, option;
+
+    while ((option = getopt(argc, argv, "t:T:o:v")) != -1)
+    {
+        int res = 1;
+
+        switch (option)
+        {
+            case 't': res = sscanf(optarg, "%lf", &time_scale) == 1 && time_scale >= 1.0 && time_scale <= MAX_TIME_SCALE; break;
+            case 'T': res = sscanf(optarg, "%lf", &timeout) == 1 && timeout > 0.0; break;
+            case 'o': filename = optarg; break;
+            case 'v': verbose = TRUE; break;
+            default: res = 0; break;
+        }
+        if (res != 1)
+        {
+            fprintf(stderr, "Usage: %s [-t time scale, 1 to %.0f] [-T timeout seconds] [-o results file] [-v] centroid file...\n", argv[0], MAX_TIME_SCALE);
+            exit(1);
+        }
+    }
+    if (optind >= argc || argc - optind > MAX_HARNESS_BOARDS)
+    {
+        fprintf(stderr, "Usage: %s [-t time scale, 1 to %.0f] [-T timeout seconds] [-o results file] [-v] centroid file...\n"
+                        "       at most %d centroid files\n", argv[0], MAX_TIME_SCALE, MAX_HARNESS_BOARDS);
+        exit(1);
+    }
+
+    getExecutablePath("Assgn2_2024_Simulator", "../Assgn2_2024_Simulator/bin/Release/Assgn2_2024_Simulator", sim_path);
+    getExecutablePath("Assgn2_2024_Controller", "../Assgn2_2024_Controller/bin/Release/Assgn2_2024_Controller", contrl_path);
+    if (access(sim_path, X_OK) != 0 || access(contrl_path, X_OK) != 0)
+    {
+        fprintf(stderr, "Simulator or controller not found, set %s to the directory holding them\n", BIN_DIR_ENV);
+        exit(2);
+    }
+    snprintf(time_scale_str, sizeof(time_scale_str), "%g", time_scale);
+    setenv(TIME_SCALE_ENV, time_scale_str, 1);
+
+    printf("Time scale %g, machine config file %s\n\n", time_scale, getMachineConfigFileName());
+    printf("%-32s %4s %6s %7s %8s %11s %11s %9s  %s\n", "Centroid file", "Mode", "Parts", "Placed", "Dropped",
+           "Cycle (s)", "Parts/hour", "Wall (s)", "Result");
+    for (int i = optind; i < argc; i++)
+    {
+        BoardRun *board = &run[number_of_boards++];
+
+        board -> centroid_file = argv[i];
+        board -> operation_mode = '?';
+        board -> number_of_parts = 0;
+        board -> result = BOARD_RUN_NOT_STARTED;
+        if (readCentroidFileHeader(argv[i], &board -> operation_mode, &board -> number_of_parts) == FALSE)
+        {
+            printf("%-32s  cannot be read\n", argv[i]);
+            failures++;
+            continue;
+        }
+        if (board -> operation_mode == 'm' || board -> operation_mode == 'M')
+        {
+            printf("%-32s  manual mode, skipped\n", argv[i]);
+            failures++;
+            continue;
+        }
+        runBoard(board, sim_path, contrl_path, timeout, verbose);
+        printf("%-32s %4c %6d %7d %8d %11.2f %11.1f %9.2f  %s\n", board -> centroid_file, board -> operation_mode,
+               board -> number_of_parts, board -> number_of_placed_parts, board -> number_of_dropped_parts, board -> cycle_time,
+               board -> parts_per_hour, board -> wall_time, getRunResultName(board -> result));
+        if (board -> result != BOARD_RUN_OK) failures++;
+    }
+
+    if (filename != NULL)
+    {
+        if (writeResults(run, number_of_boards, time_scale, filename) != 0)
+        {
+            perror("writing the results failed");
+            exit(4);
+        }
+        printf("\nResults written to %s\n", filename);
+    }
+    return failures == 0 ? 0 : 3;
+}
@@ -0,0 +1,69 @@
+/*
+ *
+ * pnpHarness.h - declarations for the end-to-end throughput harness
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <limits.h>
+#include <semaphore.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/utsname.h>
+#include "../Assgn2_2024_Controller/pnpControl.h"
+
+#define HARNESS_FORMAT_VERSION 2       // bump when a result is renamed or its meaning changes
+
+#define DEFAULT_HARNESS_TIME_SCALE 20.0
+#define DEFAULT_HARNESS_TIMEOUT 600.0  // wall seconds before a board's run is abandoned
+#define MAX_HARNESS_BOARDS 64
+#define HARNESS_LINE_LENGTH 512        // longest output line looked at, longer lines are cut short
+
+#define SIMULATOR_EXIT_CODE 20         // the exit codes of the simulator and controller when they finish normally
+#define CONTROLLER_EXIT_CODE 30
+
+#define BOARD_RUN_OK 0
+#define BOARD_RUN_NOT_STARTED -1
+#define BOARD_RUN_TIMED_OUT -2
+#define BOARD_RUN_FAILED -3            // a process exited abnormally or the simulator gave no summary
+#define BOARD_RUN_INCOMPLETE -4        // both exited normally, but not every part was placed or dropped
+
+typedef struct
+{
+    int fd;
+    int open;
+    int length;
+    char line[HARNESS_LINE_LENGTH];
+
+} OutputReader;
+
+typedef struct
+{
+    const char *centroid_file;
+    char operation_mode;
+    int number_of_parts;
+    int result;                 // BOARD_RUN_OK, ...
+    int simulator_status;       // exit codes, else -1 if killed
+    int controller_status;
+    int number_of_placed_parts;
+    int number_of_dropped_parts;
+    double pcb_load_time;       // simulated times from the simulator summary
+    double pcb_unload_time;
+    double simulation_time;
+    double cycle_time;          // PCB load to unload in simulated seconds
+    double parts_per_hour;
+    double wall_time;           // real seconds from starting the processes to both having exited
+
+} BoardRun;
+
+int readCentroidFileHeader(const char*, char*, int*);
+
+void runBoard(BoardRun*, const char*, const char*, double, int);
+
+int writeResults(const BoardRun[], int, double, const char*);
@@ -0,0 +1,461 @@
+/*
+ *
+ * pnpReplay.c - feeds an instruction stream recorded by the controller (with PNP_RECORD set) back to the
+ * simulator, without the controller, so that a run can be repeated exactly: the simulator is seeded as it was,
+ * and each instruction is handed over at the simulation time it was first issued at. The pick and preplace
+ * errors the simulator reports are checked against those the controller read, and any difference reported.
+ *
+ * Usage: Assgn2_2024_Replay [-t time scale] [-T timeout seconds] [-v] recording
+ * The simulator runs as fast as it can unless PNP_TIME_SCALE or -t says otherwise, and writes no analytics
+ * unless PNP_ANALYTICS is set, as the placement targets are not recorded.
+ * Only one replay (or harness, or Startup) can run at a time, as they share the named semaphores.
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include "pnpReplay.h"
+
+/*
+ Function: readTrace
+ -------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ reads a recording into memory, checking that it was written in this format for this shared memory layout.
+ A record cut short at the end, as when the controller was killed, is ignored.
+ Argument(s):
+ const char *filename - the recording
+ Trace *trace - receives the header and the records, which the caller frees
+ Return Value: TRACE_READ, else TRACE_NOT_PRESENT or TRACE_WRONG_FORMAT
+ Usage: if (readTrace(argv[optind], &trace) == TRACE_READ) {...}
+ */
+int readTrace(const char *filename, Trace *trace)
+{
+    FILE *fp = fopen(filename, "rb");
+    long size;
+
+    trace -> record = NULL;
+    trace -> number_of_records = 0;
+    if (fp == NULL) return TRACE_NOT_PRESENT;
+    if (fread(&trace -> header, sizeof(TraceHeader), 1, fp) != 1 || memcmp(trace -> header.magic, TRACE_MAGIC, sizeof(trace -> header.magic)) != 0
+        || trace -> header.format_version != TRACE_FORMAT_VERSION || trace -> header.layout_version != PNP_LAYOUT_VERSION
+        || trace -> header.record_size != sizeof(TraceRecord))
+    {
+        fclose(fp);
+        return TRACE_WRONG_FORMAT;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp) - (long) sizeof(TraceHeader);
+    fseek(fp, sizeof(TraceHeader), SEEK_SET);
+    if (size >= (long) sizeof(TraceRecord))
+    {
+        trace -> record = malloc(size);
+        if (trace -> record == NULL)
+        {
+            fclose(fp);
+            return TRACE_NOT_PRESENT;
+        }
+        trace -> number_of_records = (long) fread(trace -> record, sizeof(TraceRecord), size / sizeof(TraceRecord), fp);
+    }
+    fclose(fp);
+    return TRACE_READ;
+}
+
+/*
+ Function: getWallTime
+ ---------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: gets the time from CLOCK_MONOTONIC in seconds
+ Argument(s): none
+ Return Value: the time in seconds
+ Usage: double start = getWallTime();
+ */
+static double getWallTime()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1000000000.0;
+}
+
+/*
+ Function: startSimulator
+ ------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ starts the simulator as Startup would but with no keyboard, writing its display output to standard output,
+ which is discarded unless verbose
+ Argument(s):
+ const char *path - the executable
+ int verbose - TRUE to keep the display output
+ Return Value: the process id, else -1 if the simulator could not be started
+ Usage: pid_t sim_pid = startSimulator(sim_path, verbose);
+ */
+static pid_t startSimulator(const char *path, int verbose)
+{
+    pid_t pid;
+
+    fflush(stdout);
+    pid = fork();
+    if (pid != 0) return pid;
+
+    int null_fd = open("/dev/null", O_RDWR);
+    dup2(null_fd, STDIN_FILENO);
+    if (verbose == FALSE) dup2(null_fd, STDOUT_FILENO);
+    close(null_fd);
+    execl(path, "Assgn2_2024_Simulator", "1", (char *) NULL);
+    perror("overlay of the process failed");
+    _exit(5);
+}
+
+/*
+ Function: waitForSimulator
+ --------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ waits until the simulator has taken the last instruction handed to it and either is ready for the next or has
+ reached the simulation time of a record, as the controller sometimes issued an instruction before the one before
+ it had finished. For a reported value it waits for both, as the value only settles once the simulator is ready.
+ It sleeps while the time of the record is far off, but spins close to it, as at the higher time scales a sleep
+ can outlast several of the simulator's poll loops.
+ Argument(s):
+ PnP *pnp - the shared memory segment
+ pid_t sim_pid - the simulator process
+ double deadline - the wall time at which the replay is abandoned
+ double record_time - the simulation time the record was made at
+ int wait_for_both - TRUE to wait until the simulator is ready and has reached record_time
+ Return Value: REPLAY_OK, else REPLAY_TIMED_OUT or REPLAY_SIMULATOR_EXITED
+ Usage: if (waitForSimulator(pnp, sim_pid, deadline, record -> time, FALSE) != REPLAY_OK) {...}
+ */
+static int waitForSimulator(PnP *pnp, pid_t sim_pid, double deadline, double record_time, int wait_for_both)
+{
+    double time_scale = getTimeScale();
+
+    while (TRUE)
+    {
+        int ready = pnp -> ready_for_next_instruction == TRUE, time_reached = pnp -> sim_time >= record_time;
+        double time_left = record_time - pnp -> sim_time;
+
+        if (pnp -> instruction_to_execute == NO_INSTRUCTION && (wait_for_both ? ready && time_reached : ready || time_reached)) return REPLAY_OK;
+        if (getWallTime() > deadline) return REPLAY_TIMED_OUT;
+        if (waitpid(sim_pid, NULL, WNOHANG) == sim_pid) return REPLAY_SIMULATOR_EXITED;
+        if (time_left / time_scale > REPLAY_SPIN_TIME) sleepSimulatedTime(time_left / 2);
+        else sched_yield();
+    }
+}
+
+/*
+ Function: replayInstruction
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ hands a recorded instruction to the simulator as the controller's interface functions did, held back until
+ just after the simulation time it was recorded at so that the simulator takes it on the same poll loop
+ Argument(s):
+ PnP *pnp - the shared memory segment
+ const TraceRecord *record - the instruction
+ Return Value: TRUE if it was handed over too late to be held, else FALSE
+ Usage: if (replayInstruction(pnp, &trace -> record[i])) result -> late_instructions++;
+ */
+static int replayInstruction(PnP *pnp, const TraceRecord *record)
+{
+    int late = pnp -> sim_time > record -> time;
+
+    if (record -> code == MOVE_CORRECT_LOWER) pnp -> sequence_report.number_of_steps = 0;
+    if (record -> code == RUN_PROGRAM) pnp -> program.status = PROGRAM_IDLE;
+    pnp -> instruction_argument_1 = record -> argument_1;
+    pnp -> instruction_argument_2 = record -> argument_2;
+    pnp -> instruction_argument_3 = record -> argument_3;
+    pnp -> instruction_not_before = record -> time;
+    pnp -> ready_for_next_instruction = FALSE;
+    pnp -> instruction_to_execute = record -> code;
+    return late;
+}
+
+/*
+ Function: checkReportedValue
+ ----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: compares a pick or preplace error reported by the simulator with the one recorded, printing the first few differences
+ Argument(s):
+ PnP *pnp - the shared memory segment
+ const TraceRecord *record - the recorded value
+ ReplayResult *result - counts the values checked and those different
+ Return Value: none
+ Usage: checkReportedValue(pnp, &trace -> record[i], result);
+ */
+static void checkReportedValue(PnP *pnp, const TraceRecord *record, ReplayResult *result)
+{
+    double value_1, value_2 = 0.0;
+
+    if (record -> kind == TRACE_PICK_ERROR)
+    {
+        if (record -> argument_3 < 0 || record -> argument_3 >= MAX_NUMBER_OF_NOZZLES) return;
+        value_1 = pnp -> theta_pick_error[record -> argument_3];
+    }
+    else
+    {
+        value_1 = pnp -> x_preplace_error;
+        value_2 = pnp -> y_preplace_error;
+    }
+    result -> values_checked++;
+    if (value_1 == record -> argument_1 && value_2 == record -> argument_2) return;
+    if (result -> values_different++ < REPLAY_DIFFERENCES_SHOWN)
+    {
+        if (record -> kind == TRACE_PICK_ERROR)
+        {
+            printf("Time %7.2f: pick error of nozzle %d was %.6f, recorded %.6f\n", pnp -> sim_time, record -> argument_3, value_1, record -> argument_1);
+        }
+        else
+        {
+            printf("Time %7.2f: preplace error was (%.6f, %.6f), recorded (%.6f, %.6f)\n", pnp -> sim_time, value_1, value_2,
+                   record -> argument_1, record -> argument_2);
+        }
+    }
+}
+
+/*
+ Function: replayTrace
+ ---------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ runs the simulator against a recording in place of the controller, creating a fresh shared memory segment and
+ setting up the named semaphores as Startup does. The simulator is seeded from the recording and given the
+ feeder packages the controller published, each program is
+ written to shared memory before the RUN_PROGRAM that runs it, and each reported value is checked when the controller read it: once the simulator is ready again and has
+ reached the time it was read at, or if it was read straight after an instruction was issued, before that
+ instruction is handed over.
+ Argument(s):
+ const Trace *trace - the recording
+ const char *sim_path - the simulator executable
+ double timeout - wall seconds before the replay is abandoned and the simulator killed
+ int verbose - TRUE to show the simulator output
+ ReplayResult *result - receives the outcome
+ Return Value: none, result -> result gives the outcome
+ Usage: replayTrace(&trace, sim_path, DEFAULT_REPLAY_TIMEOUT, FALSE, &result);
+ */
+void replayTrace(const Trace *trace, const char *sim_path, double timeout, int verbose, ReplayResult *result)
+{
+    char seed_str[16];
+    int status = 0, previous_kind = TRACE_INSTRUCTION;
+    long checked_up_to = 0;
+    pid_t sim_pid;
+    double start, deadline;
+    PnP *pnp;
+
+    memset(result, 0, sizeof(ReplayResult));
+    result -> result = REPLAY_SIMULATOR_EXITED;
+    result -> simulator_status = -1;
+
+    /* a fresh shared memory segment and semaphores, as Startup gives them */
+    pnp = createPnP();
+    if (pnp == MAP_FAILED)
+    {
+        perror("Shared memory creation failed");
+        return;
+    }
+    sem_unlink("/sem_Startup");
+    sem_unlink("/sem_Sim");
+    sem_unlink("/sem_Contrl");
+    sem_t *sem_Startup = sem_open("/sem_Startup", O_CREAT, 0666, 0);
+    sem_t *sem_Sim = sem_open("/sem_Sim", O_CREAT, 0666, 0);
+    sem_t *sem_Contrl = sem_open("/sem_Contrl", O_CREAT, 0666, 0);
+    if (sem_Startup == SEM_FAILED || sem_Sim == SEM_FAILED || sem_Contrl == SEM_FAILED)
+    {
+        perror("Semaphore creation failed");
+        closePnP(pnp);
+        return;
+    }
+    snprintf(seed_str, sizeof(seed_str), "%u", trace -> header.random_seed);
+    setenv(SIMULATION_SEED_ENV, seed_str, 1);
+
+    start = getWallTime();
+    deadline = start + timeout;
+    sim_pid = startSimulator(sim_path, verbose);
+    if (sim_pid < 0)
+    {
+        perror("Simulator could not be started");
+        closePnP(pnp);
+        return;
+    }
+
+    /* the replay stands in for the controller at the startup barrier */
+    while (pnp -> machine_config_published == FALSE && result -> result == REPLAY_SIMULATOR_EXITED)
+    {
+        if (getWallTime() > deadline) result -> result = REPLAY_TIMED_OUT;
+        else if (waitpid(sim_pid, &status, WNOHANG) == sim_pid) sim_pid = -1;
+        sleepSimulatedTime((double) 1 / POLL_LOOP_RATE);
+        if (sim_pid < 0) break;
+    }
+    if (pnp -> machine_config_published == TRUE)
+    {
+        for (long i = 0; i < trace -> number_of_records; i++)
+        {  //the feeder packages the controller published before the barrier
+            const TraceRecord *record = &trace -> record[i];
+
+            if (record -> kind == TRACE_FEEDER_PACKAGE && record -> argument_3 >= 0 && record -> argument_3 < MAX_NUMBER_OF_FEEDERS)
+                pnp -> feeder_package[record -> argument_3] = record -> code;
+        }
+        waitAtStartupBarrier(pnp, sem_Startup);
+        result -> result = REPLAY_OK;
+    }
+
+    for (long i = 0; i < trace -> number_of_records && result -> result == REPLAY_OK; i++)
+    {
+        const TraceRecord *record = &trace -> record[i];
+
+        if (i < checked_up_to || record -> kind == TRACE_FEEDER_PACKAGE) continue;  // a value already checked with the instruction before it, or published at startup
+        result -> result = waitForSimulator(pnp, sim_pid, deadline, record -> time, record -> kind >= TRACE_PICK_ERROR);
+        if (result -> result != REPLAY_OK) break;
+        switch (record -> kind)
+        {
+            case TRACE_PROGRAM_STEP:
+                if (previous_kind != TRACE_PROGRAM_STEP) pnp -> program.length = 0;
+                if (pnp -> program.length < MAX_PROGRAM_LENGTH)
+                {
+                    ProgramStep *step = &pnp -> program.step[pnp -> program.length++];
+
+                    step -> opcode = record -> code;
+                    step -> argument_1 = record -> argument_1;
+                    step -> argument_2 = record -> argument_2;
+                    step -> argument_3 = record -> argument_3;
+                    step -> target = record -> target;
+                }
+                break;
+            case TRACE_INSTRUCTION:
+                /* values read straight after the instruction was issued were read before the simulator took it */
+                for (checked_up_to = i + 1; checked_up_to < trace -> number_of_records; checked_up_to++)
+                {
+                    const TraceRecord *value = &trace -> record[checked_up_to];
+
+                    if (value -> kind < TRACE_PICK_ERROR || value -> time != record -> time) break;
+                    checkReportedValue(pnp, value, result);
+                }
+                if (replayInstruction(pnp, record)) result -> late_instructions++;
+                result -> instructions++;
+                break;
+            case TRACE_PICK_ERROR:
+            case TRACE_PREPLACE_ERROR:
+                checkReportedValue(pnp, record, result);
+                break;
+        }
+        previous_kind = record -> kind;
+    }
+    if (result -> result == REPLAY_OK) result -> result = waitForSimulator(pnp, sim_pid, deadline, pnp -> sim_time, TRUE);
+    result -> simulation_time = pnp -> sim_time;
+
+    /* let the simulator finish as the controller would, else stop it */
+    if (sim_pid > 0)
+    {
+        if (result -> result == REPLAY_OK)
+        {
+            pnp -> quit = TRUE;
+            sem_post(sem_Contrl);
+        }
+        else
+        {
+            kill(sim_pid, SIGKILL);
+        }
+        if (waitpid(sim_pid, &status, 0) == sim_pid && WIFEXITED(status)) result -> simulator_status = WEXITSTATUS(status);
+    }
+    else if (WIFEXITED(status))
+    {
+        result -> simulator_status = WEXITSTATUS(status);
+    }
+    result -> wall_time = getWallTime() - start;
+    if (result -> result == REPLAY_OK && result -> simulator_status != SIMULATOR_EXIT_CODE) result -> result = REPLAY_SIMULATOR_EXITED;
+    if (verbose) fflush(stdout);
+    printf("Boards completed %lu, parts placed %lu, parts dropped %lu\n", pnp -> simulator_stats.boards_completed,
+           pnp -> simulator_stats.parts_placed, pnp -> simulator_stats.parts_dropped);
+
+    sem_close(sem_Startup);
+    sem_close(sem_Sim);
+    sem_close(sem_Contrl);
+    sem_unlink("/sem_Startup");
+    sem_unlink("/sem_Sim");
+    sem_unlink("/sem_Contrl");
+    closePnP(pnp);
+}
+
+
+int main(int argc, char *argv[])
+{
+    char sim_path[PATH_MAX], time_scale_str[32];
+    double time_scale = MAX_TIME_SCALE, timeout = DEFAULT_REPLAY_TIMEOUT;
+    int verbose = FALSE, time_scale_given = FALSE, option, res;
+    ReplayResult result;
+    Trace trace;
+
+    while ((option = getopt(argc, argv, "t:T:v")) != -1)
+    {
+        res = 1;
+
+        switch (option)
+        {
+            case 't': res = sscanf(optarg, "%lf", &time_scale) == 1 && time_scale >= 1.0 && time_scale <= MAX_TIME_SCALE; time_scale_given = TRUE; break;
+            case 'T': res = sscanf(optarg, "%lf", &timeout) == 1 && timeout > 0.0; break;
+            case 'v': verbose = TRUE; break;
+            default: res = 0; break;
+        }
+        if (res != 1)
+        {
+            fprintf(stderr, "Usage: %s [-t time scale, 1 to %.0f] [-T timeout seconds] [-v] recording\n", argv[0], MAX_TIME_SCALE);
+            exit(1);
+        }
+    }
+    if (argc - optind != 1)
+    {
+        fprintf(stderr, "Usage: %s [-t time scale, 1 to %.0f] [-T timeout seconds] [-v] recording\n", argv[0], MAX_TIME_SCALE);
+        exit(1);
+    }
+
+    res = readTrace(argv[optind], &trace);
+    if (res != TRACE_READ)
+    {
+        fprintf(stderr, res == TRACE_NOT_PRESENT ? "Recording %s cannot be read\n" : "%s is not a recording from this version of the controller\n", argv[optind]);
+        exit(2);
+    }
+    getExecutablePath("Assgn2_2024_Simulator", "../Assgn2_2024_Simulator/bin/Release/Assgn2_2024_Simulator", sim_path);
+    if (access(sim_path, X_OK) != 0)
+    {
+        fprintf(stderr, "Simulator not found, set %s to the directory holding it\n", BIN_DIR_ENV);
+        exit(2);
+    }
+    if (time_scale_given || getenv(TIME_SCALE_ENV) == NULL)
+    {
+        snprintf(time_scale_str, sizeof(time_scale_str), "%g", time_scale);
+        setenv(TIME_SCALE_ENV, time_scale_str, 1);
+    }
+    setenv(ANALYTICS_FILE_ENV, "none", 0);
+
+    printf("Replaying %ld records of %s, seed %u, time scale %g\n", trace.number_of_records, argv[optind],
+           trace.header.random_seed, getTimeScale());
+    replayTrace(&trace, sim_path, timeout, verbose, &result);
+    printf("Instructions %ld (%ld handed over late), reported values checked %ld, different %ld\n", result.instructions,
+           result.late_instructions, result.values_checked, result.values_different);
+    printf("Simulated %.2f s in %.2f s wall time\n", result.simulation_time, result.wall_time);
+    free(trace.record);
+
+    if (result.result == REPLAY_TIMED_OUT) printf("Replay timed out\n");
+    else if (result.result != REPLAY_OK) printf("Simulator exited before the end of the recording, status %d\n", result.simulator_status);
+    else if (result.values_different > 0 || result.late_instructions > 0) printf("Replay diverged from the recording\n");
+    else printf("Replay matched the recording\n");
+    if (result.result != REPLAY_OK) return 3;
+    return result.values_different > 0 || result.late_instructions > 0 ? 4 : 0;
+}
@@ -0,0 +1,59 @@
+/*
+ *
+ * pnpReplay.h - declarations for the replay driver, which feeds an instruction stream recorded by the
+ * controller back to the simulator
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <limits.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include "../Assgn2_2024_Controller/pnpControl.h"
+
+#define ANALYTICS_FILE_ENV "PNP_ANALYTICS"
+#define DEFAULT_REPLAY_TIMEOUT 600.0   // wall seconds before the replay is abandoned
+#define REPLAY_SPIN_TIME 0.002          // wall seconds before a record is due within which the replay spins rather than sleeps
+#define REPLAY_DIFFERENCES_SHOWN 10    // differences in the reported values printed, the rest are only counted
+
+#define SIMULATOR_EXIT_CODE 20         // the exit code of the simulator when it finishes normally
+
+#define TRACE_READ 0
+#define TRACE_NOT_PRESENT -1
+#define TRACE_WRONG_FORMAT -2          // not a recording, or one from another format or shared memory layout
+
+#define REPLAY_OK 0
+#define REPLAY_TIMED_OUT -1
+#define REPLAY_SIMULATOR_EXITED -2     // the simulator ended before the recording did
+
+typedef struct
+{
+    TraceHeader header;
+    TraceRecord *record;
+    long number_of_records;
+
+} Trace;
+
+typedef struct
+{
+    int result;                  // REPLAY_OK, ...
+    int simulator_status;        // exit code, else -1 if killed
+    long instructions;           // handed to the simulator
+    long late_instructions;      // handed over after the time they were recorded at, so perhaps taken a poll loop late
+    long values_checked;         // pick and preplace errors compared with those recorded
+    long values_different;
+    double simulation_time;
+    double wall_time;
+
+} ReplayResult;
+
+int readTrace(const char*, Trace*);
+
+void replayTrace(const Trace*, const char*, double, int, ReplayResult*);
@@ -0,0 +1,426 @@
+/*
+ *
+ * pnpAnalytics.c - placement accuracy and yield analytics for the pick and place machine simulator.
+ *
+ * As each part is placed it is matched to its target from the centroid file, which the controller publishes in
+ * shared memory, through a hash grid of the target positions, and its position and rotation errors are added to
+ * running totals for the board, its feeder and its nozzle. Nothing is kept per placement but a line of the CSV
+ * report, so each placement costs the same however large the board. As the PCB is unloaded the targets never
+ * placed are added to the CSV report, and a JSON report of the totals is written, with the process capability
+ * (Cpk) of the placements against the placement tolerance in the machine description.
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include "pnpSim.h"
+
+/*
+ Function: addRunningValue
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: adds a value to running statistics, updating the mean and spread in one pass (Welford's method)
+ Argument(s):
+ RunningStats *stats - the running statistics
+ double value - the value to add
+ Return Value: none
+ Usage: addRunningValue(&analytics -> x_error, x - target -> x);
+ */
+void addRunningValue(RunningStats *stats, double value)
+{
+
+    double delta = value - stats -> mean;
+
+    if (stats -> n == 0 || value < stats -> min) stats -> min = value;
+    if (stats -> n == 0 || value > stats -> max) stats -> max = value;
+    stats -> n++;
+    stats -> mean += delta / stats -> n;
+    stats -> m2 += delta * (value - stats -> mean);
+
+}
+
+/*
+ Function: getRunningStandardDeviation
+ -------------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: gets the sample standard deviation of the values added to running statistics
+ Argument(s):
+ const RunningStats *stats - the running statistics
+ Return Value: the standard deviation, 0 for fewer than two values
+ Usage: double sd = getRunningStandardDeviation(&analytics -> x_error);
+ */
+double getRunningStandardDeviation(const RunningStats *stats)
+{
+
+    if (stats -> n < 2) return 0.0;
+    return sqrt(stats -> m2 / (stats -> n - 1));
+
+}
+
+/*
+ Function: startPlacementAnalytics
+ ---------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ starts the analytics of a board as it is loaded: clears the totals, builds a hash grid of the targets keyed on
+ their positions quantised to ANALYTICS_MATCH_RADIUS, and starts the CSV report, named from ANALYTICS_FILE_ENV
+ Argument(s):
+ PlacementAnalytics *analytics - the analytics of the board
+ const PlacementTarget targets[] - the placements on the board, published by the controller
+ int number_of_targets - the number of placements
+ const MachineConfig *machine - the machine description, for the placement tolerance
+ double load_time - the simulation time the PCB was loaded at
+ Return Value: none
+ Usage: startPlacementAnalytics(&analytics, pnp -> target, pnp -> number_of_targets, &machine, pcb_load_time);
+ */
+void startPlacementAnalytics(PlacementAnalytics *analytics, const PlacementTarget targets[], int number_of_targets,
+                             const MachineConfig *machine, double load_time)
+{
+
+    const char *file_name = getenv(ANALYTICS_FILE_ENV);
+    char csv_name[ANALYTICS_FILE_NAME_LENGTH + 8];
+
+    if (analytics -> csv != NULL) fclose(analytics -> csv);  // a board loaded without the last being unloaded
+    memset(analytics, 0, sizeof(PlacementAnalytics));
+    if (number_of_targets < 0) number_of_targets = 0;
+    if (number_of_targets > MAX_NUMBER_OF_COMPONENTS_TO_PLACE) number_of_targets = MAX_NUMBER_OF_COMPONENTS_TO_PLACE;
+    analytics -> number_of_targets = number_of_targets;
+    memcpy(analytics -> target, targets, number_of_targets * sizeof(PlacementTarget));
+    analytics -> placement_tolerance = machine -> placement_tolerance;
+    analytics -> rotation_tolerance = machine -> rotation_tolerance;
+    analytics -> load_time = load_time;
+
+    for (int i = 0; i < FEEDER_INDEX_BUCKETS; i++)
+    {
+        analytics -> target_in_bucket[i] = NO_TARGET;
+    }
+    for (int i = 0; i < number_of_targets; i++)
+    {
+        long cell_x = lround(targets[i].x / ANALYTICS_MATCH_RADIUS);
+        long cell_y = lround(targets[i].y / ANALYTICS_MATCH_RADIUS);
+        int bucket = getFeederIndexBucket(cell_x, cell_y);
+
+        /* linear probing, there are always empty buckets since FEEDER_INDEX_BUCKETS > MAX_NUMBER_OF_COMPONENTS_TO_PLACE */
+        while (analytics -> target_in_bucket[bucket] != NO_TARGET)
+        {
+            bucket = (bucket + 1) & (FEEDER_INDEX_BUCKETS - 1);
+        }
+        analytics -> cell_x[bucket] = cell_x;
+        analytics -> cell_y[bucket] = cell_y;
+        analytics -> target_in_bucket[bucket] = i;
+    }
+
+    if (file_name == NULL || file_name[0] == '\0') file_name = ANALYTICS_FILE;
+    if (strcmp(file_name, "none") == 0) return;
+    snprintf(analytics -> file_name, sizeof(analytics -> file_name), "%s", file_name);
+    snprintf(csv_name, sizeof(csv_name), "%s.csv", analytics -> file_name);
+    analytics -> csv = fopen(csv_name, "w");
+    if (analytics -> csv != NULL)
+    {
+        fprintf(analytics -> csv, "designation,feeder,nozzle,status,time,x_target,y_target,theta_target,x_actual,y_actual,theta_actual,"
+                                  "x_error,y_error,position_error,rotation_error,in_spec\n");
+    }
+
+}
+
+/*
+ Function: findPlacementTarget
+ -----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ finds the nearest target not yet placed for a feeder, within ANALYTICS_MATCH_RADIUS of a placement. Only the
+ grid cells next to the placement's are probed, so the search does not depend on the number of targets.
+ Argument(s):
+ const PlacementAnalytics *analytics - the analytics of the board
+ int feeder - the feeder the part came from
+ double x - the placement, in board coordinates
+ double y
+ Return Value: the target, else NO_TARGET
+ Usage: int target = findPlacementTarget(analytics, feeder, x, y);
+ */
+static int findPlacementTarget(const PlacementAnalytics *analytics, int feeder, double x, double y)
+{
+
+    long placement_cell_x = lround(x / ANALYTICS_MATCH_RADIUS), placement_cell_y = lround(y / ANALYTICS_MATCH_RADIUS);
+    double nearest_distance = ANALYTICS_MATCH_RADIUS;
+    int nearest = NO_TARGET;
+
+    for (long cell_x = placement_cell_x - 1; cell_x <= placement_cell_x + 1; cell_x++)
+    {
+        for (long cell_y = placement_cell_y - 1; cell_y <= placement_cell_y + 1; cell_y++)
+        {
+            int bucket = getFeederIndexBucket(cell_x, cell_y);
+
+            while (analytics -> target_in_bucket[bucket] != NO_TARGET)
+            {
+                int i = analytics -> target_in_bucket[bucket];
+                double distance = hypot(x - analytics -> target[i].x, y - analytics -> target[i].y);
+
+                if (analytics -> cell_x[bucket] == cell_x && analytics -> cell_y[bucket] == cell_y && analytics -> target_placed[i] == FALSE
+                    && analytics -> target[i].feeder == feeder && distance <= nearest_distance)
+                {
+                    nearest = i;
+                    nearest_distance = distance;
+                }
+                bucket = (bucket + 1) & (FEEDER_INDEX_BUCKETS - 1);
+            }
+        }
+    }
+    return nearest;
+
+}
+
+/*
+ Function: recordPlacement
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ matches a part that has been placed to its target, adds its errors to the totals for the board, its feeder and
+ its nozzle, and writes it to the CSV report. A part that matches no target is counted, and reported, as unmatched.
+ Argument(s):
+ PlacementAnalytics *analytics - the analytics of the board
+ int feeder - the feeder the part came from
+ int nozzle - the nozzle that placed it
+ double x - where it was placed, in board coordinates
+ double y
+ double theta - its rotation on the board, degrees
+ double sim_time - the current simulation time
+ Return Value: the target it was matched to, else NO_TARGET
+ Usage: recordPlacement(&analytics, nozzle_picked_part[nozzle], nozzle, x_actual, y_actual, theta_actual, sim_time);
+ */
+int recordPlacement(PlacementAnalytics *analytics, int feeder, int nozzle, double x, double y, double theta, double sim_time)
+{
+
+    int target = findPlacementTarget(analytics, feeder, x, y);
+    PlacementGroupStats *feeder_stats = feeder >= 0 && feeder < MAX_NUMBER_OF_FEEDERS ? &analytics -> feeder[feeder] : NULL;
+    PlacementGroupStats *nozzle_stats = nozzle >= 0 && nozzle < MAX_NUMBER_OF_NOZZLES ? &analytics -> nozzle[nozzle] : NULL;
+    const PlacementTarget *t;
+    double x_error, y_error, position_error, rotation_error;
+    int in_spec;
+
+    analytics -> placed++;
+    if (feeder_stats != NULL) feeder_stats -> placed++;
+    if (nozzle_stats != NULL) nozzle_stats -> placed++;
+
+    if (target == NO_TARGET)
+    {
+        analytics -> unmatched++;
+        if (analytics -> csv != NULL)
+        {
+            fprintf(analytics -> csv, ",%d,%d,unmatched,%.2f,,,,%.3f,%.3f,%.2f,,,,,0\n", feeder, nozzle, sim_time, x, y, theta);
+        }
+        return NO_TARGET;
+    }
+
+    t = &analytics -> target[target];
+    analytics -> target_placed[target] = TRUE;
+    x_error = x - t -> x;
+    y_error = y - t -> y;
+    position_error = hypot(x_error, y_error);
+    rotation_error = fmod(theta - t -> theta + 540.0, 360.0) - 180.0;  // the shortest way round, -180 to 180 degrees
+    if (rotation_error < -180.0) rotation_error += 360.0;
+    in_spec = fabs(x_error) <= analytics -> placement_tolerance && fabs(y_error) <= analytics -> placement_tolerance
+              && fabs(rotation_error) <= analytics -> rotation_tolerance;
+
+    addRunningValue(&analytics -> x_error, x_error);
+    addRunningValue(&analytics -> y_error, y_error);
+    addRunningValue(&analytics -> position_error, position_error);
+    addRunningValue(&analytics -> rotation_error, rotation_error);
+    analytics -> in_spec += in_spec;
+    for (PlacementGroupStats *group = feeder_stats; group != NULL; group = group == feeder_stats ? nozzle_stats : NULL)
+    {
+        addRunningValue(&group -> position_error, position_error);
+        addRunningValue(&group -> rotation_error, fabs(rotation_error));
+        group -> in_spec += in_spec;
+    }
+
+    if (analytics -> csv != NULL)
+    {
+        fprintf(analytics -> csv, "%s,%d,%d,placed,%.2f,%.3f,%.3f,%.2f,%.3f,%.3f,%.2f,%.4f,%.4f,%.4f,%.3f,%d\n", t -> designation, feeder, nozzle, sim_time,
+                t -> x, t -> y, t -> theta, x, y, theta, x_error, y_error, position_error, rotation_error, in_spec);
+    }
+    return target;
+
+}
+
+/*
+ Function: recordDrop
+ --------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: counts a part dropped from a nozzle against the board, its feeder and the nozzle
+ Argument(s):
+ PlacementAnalytics *analytics - the analytics of the board
+ int feeder - the feeder the part came from
+ int nozzle - the nozzle that dropped it
+ Return Value: none
+ Usage: recordDrop(&analytics, nozzle_picked_part[nozzle], nozzle);
+ */
+void recordDrop(PlacementAnalytics *analytics, int feeder, int nozzle)
+{
+
+    analytics -> dropped++;
+    if (feeder >= 0 && feeder < MAX_NUMBER_OF_FEEDERS) analytics -> feeder[feeder].dropped++;
+    if (nozzle >= 0 && nozzle < MAX_NUMBER_OF_NOZZLES) analytics -> nozzle[nozzle].dropped++;
+
+}
+
+/*
+ Function: writeErrorStats
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ writes the statistics of one kind of placement error to the JSON report, with its process capability against
+ a tolerance either side of zero, Cpk = (tolerance - |mean|) / (3 * standard deviation), or null if there is no spread
+ beyond rounding
+ Argument(s):
+ FILE *fp - the JSON report
+ const char *name - the name of the error
+ const RunningStats *stats - its running statistics
+ double tolerance - the tolerance, else 0 for no Cpk
+ Return Value: none
+ Usage: writeErrorStats(fp, "x_error", &analytics -> x_error, analytics -> placement_tolerance);
+ */
+static void writeErrorStats(FILE *fp, const char *name, const RunningStats *stats, double tolerance)
+{
+
+    double sd = getRunningStandardDeviation(stats);
+
+    fprintf(fp, "  \"%s\": {\"n\": %lu, \"mean\": %.4f, \"sd\": %.4f, \"min\": %.4f, \"max\": %.4f", name, stats -> n, stats -> mean, sd, stats -> min, stats -> max);
+    if (tolerance > 0.0 && sd > ANALYTICS_NO_SPREAD) fprintf(fp, ", \"cpk\": %.3f},\n", (tolerance - fabs(stats -> mean)) / (3.0 * sd));
+    else if (tolerance > 0.0) fprintf(fp, ", \"cpk\": null},\n");
+    else fprintf(fp, "},\n");
+
+}
+
+/*
+ Function: writeGroupStats
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ writes the totals of the placements from one feeder, or by one nozzle, to the JSON report. The errors are null
+ when none of the placements matched a target.
+ Argument(s):
+ FILE *fp - the JSON report
+ const char *key - "feeder" or "nozzle"
+ const char *name - the feeder number or nozzle name
+ const PlacementGroupStats *group - the totals
+ int last - TRUE for the last of the list
+ Return Value: none
+ Usage: writeGroupStats(fp, "nozzle", machine -> nozzle_name[i], &analytics -> nozzle[i], i == machine -> number_of_nozzles - 1);
+ */
+static void writeGroupStats(FILE *fp, const char *key, const char *name, const PlacementGroupStats *group, int last)
+{
+
+    unsigned long attempts = group -> placed + group -> dropped;
+
+    fprintf(fp, "    {\"%s\": \"%s\", \"placed\": %lu, \"dropped\": %lu, \"in_spec\": %lu, \"drop_rate\": %.4f, ",
+            key, name, group -> placed, group -> dropped, group -> in_spec, attempts > 0 ? (double) group -> dropped / attempts : 0.0);
+    if (group -> position_error.n > 0)
+    {
+        fprintf(fp, "\"position_error_mean\": %.4f, \"position_error_max\": %.4f, \"rotation_error_mean\": %.3f, \"rotation_error_max\": %.3f}%s\n",
+                group -> position_error.mean, group -> position_error.max, group -> rotation_error.mean, group -> rotation_error.max, last == TRUE ? "" : ",");
+    }
+    else fprintf(fp, "\"position_error_mean\": null, \"position_error_max\": null, \"rotation_error_mean\": null, \"rotation_error_max\": null}%s\n",
+                 last == TRUE ? "" : ",");  // no placement matched a target, so there is no error to give
+
+}
+
+/*
+ Function: finishPlacementAnalytics
+ ----------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ finishes the analytics of a board as it is unloaded: adds the targets never placed to the CSV report and closes
+ it, then writes the totals for the board, each feeder used and each nozzle to the JSON report
+ Argument(s):
+ PlacementAnalytics *analytics - the analytics of the board
+ const MachineConfig *machine - the machine description, for the nozzle names
+ double unload_time - the simulation time the PCB was unloaded at
+ Return Value: none
+ Usage: finishPlacementAnalytics(&analytics, &machine, sim_time);
+ */
+void finishPlacementAnalytics(PlacementAnalytics *analytics, const MachineConfig *machine, double unload_time)
+{
+
+    char json_name[ANALYTICS_FILE_NAME_LENGTH + 8], name[NOZZLE_NAME_LENGTH + 8];
+    unsigned long missing = 0, attempts = analytics -> placed + analytics -> dropped;
+    int last_feeder = -1;
+    FILE *fp;
+
+    for (int i = 0; i < analytics -> number_of_targets; i++)
+    {
+        if (analytics -> target_placed[i] == TRUE) continue;
+        missing++;
+        if (analytics -> csv != NULL)
+        {
+            fprintf(analytics -> csv, "%s,%d,,missing,,%.3f,%.3f,%.2f,,,,,,,,0\n", analytics -> target[i].designation, analytics -> target[i].feeder,
+                    analytics -> target[i].x, analytics -> target[i].y, analytics -> target[i].theta);
+        }
+    }
+    if (analytics -> csv != NULL) fclose(analytics -> csv);
+    analytics -> csv = NULL;
+    if (analytics -> file_name[0] == '\0') return;
+
+    snprintf(json_name, sizeof(json_name), "%s.json", analytics -> file_name);
+    fp = fopen(json_name, "w");
+    if (fp == NULL) return;
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"format_version\": 1,\n");
+    fprintf(fp, "  \"load_time\": %.2f,\n", analytics -> load_time);
+    fprintf(fp, "  \"unload_time\": %.2f,\n", unload_time);
+    fprintf(fp, "  \"placement_tolerance\": %g,\n", analytics -> placement_tolerance);
+    fprintf(fp, "  \"rotation_tolerance\": %g,\n", analytics -> rotation_tolerance);
+    fprintf(fp, "  \"targets\": %d,\n", analytics -> number_of_targets);
+    fprintf(fp, "  \"placed\": %lu,\n", analytics -> placed);
+    fprintf(fp, "  \"unmatched\": %lu,\n", analytics -> unmatched);
+    fprintf(fp, "  \"missing\": %lu,\n", missing);
+    fprintf(fp, "  \"dropped\": %lu,\n", analytics -> dropped);
+    fprintf(fp, "  \"in_spec\": %lu,\n", analytics -> in_spec);
+    fprintf(fp, "  \"yield\": %.4f,\n", analytics -> number_of_targets > 0 ? (double) analytics -> in_spec / analytics -> number_of_targets : 0.0);
+    fprintf(fp, "  \"drop_rate\": %.4f,\n", attempts > 0 ? (double) analytics -> dropped / attempts : 0.0);
+    writeErrorStats(fp, "x_error", &analytics -> x_error, analytics -> placement_tolerance);
+    writeErrorStats(fp, "y_error", &analytics -> y_error, analytics -> placement_tolerance);
+    writeErrorStats(fp, "rotation_error", &analytics -> rotation_error, analytics -> rotation_tolerance);
+    writeErrorStats(fp, "position_error", &analytics -> position_error, 0.0);
+
+    for (int i = 0; i < MAX_NUMBER_OF_FEEDERS; i++)
+    {
+        if (analytics -> feeder[i].placed + analytics -> feeder[i].dropped > 0) last_feeder = i;
+    }
+    fprintf(fp, "  \"feeders\": [\n");
+    for (int i = 0; i <= last_feeder; i++)
+    {
+        if (analytics -> feeder[i].placed + analytics -> feeder[i].dropped == 0) continue;
+        snprintf(name, sizeof(name), "%d", i);
+        writeGroupStats(fp, "feeder", name, &analytics -> feeder[i], i == last_feeder);
+    }
+    fprintf(fp, "  ],\n");
+    fprintf(fp, "  \"nozzles\": [\n");
+    for (int i = 0; i < machine -> number_of_nozzles; i++)
+    {
+        writeGroupStats(fp, "nozzle", machine -> nozzle_name[i], &analytics -> nozzle[i], i == machine -> number_of_nozzles - 1);
+    }
+    fprintf(fp, "  ]\n}\n");
+    fclose(fp);
+
+}
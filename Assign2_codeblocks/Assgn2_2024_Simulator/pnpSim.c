@@ -2,7 +2,7 @@
  *
  * pnpSim.c - simulates the pick and place machine operation
  *
- * This program creates a shared memory segment with the controller via a memory mapped file
+ * This program shares a memory segment with the controller, created by Startup
  *
  * Platform: Any POSIX compliant platform
  * Intended for and tested on: Cygwin 64 bit
@@ -19,9 +19,9 @@
 int main(int argc, char *argv[])
 {
 
-    char Sim_str_array[145];
+    LogLine log_line;
     char *strFromSim;
-    int writeSimToDisplayFd = atoi(argv[1]);  // the file descriptor to write from Simulator to Display
+    int writeSimToDisplayFd = atoi(argv[1]);  // the file descriptor to write to when not started with a log ring to the Display
     sem_t *sem_Sim = sem_open("/sem_Sim", 0);
     sem_t *sem_Startup = sem_open("/sem_Startup", 0);
     sem_t *sem_Contrl = sem_open("/sem_Contrl", 0);
@@ -30,47 +30,112 @@ int main(int argc, char *argv[])
     PnP *pnp;
 
     PlacedPart placedPart[MAX_NUMBER_OF_COMPONENTS_TO_PLACE];
+    static PlacementAnalytics analytics;  // too large for the stack
 
     double sim_time = 0.0, instruction_finish_time = 0.0;
-    double x = HOME_X, y = HOME_Y, x_target = 0.0, y_target = 0.0, x_preplace_error = 0.0, y_preplace_error = 0.0, controller_del_x = 0.0, controller_del_y = 0.0;
-    double theta_pick_error[NUMBER_OF_NOZZLES] = {0.0, 0.0, 0.0}, controller_theta = 0.0, theta_actual[NUMBER_OF_NOZZLES] = {0.0, 0.0, 0.0};
-    int nozzle = CENTRE_NOZZLE;
-    int nozzle_down[NUMBER_OF_NOZZLES] = {FALSE, FALSE, FALSE};
-    int nozzle_vacuum[NUMBER_OF_NOZZLES] = {FALSE, FALSE, FALSE};
-    int nozzle_picked_part[NUMBER_OF_NOZZLES] = {NO_PICKED_PART, NO_PICKED_PART, NO_PICKED_PART};
+    double pcb_load_time = NO_PCB_TIME, pcb_unload_time = NO_PCB_TIME;  // when the board went in and came out, for the cycle time
+    double instruction_start_time = 0.0, handshake_start_time = 0.0;    // for the running totals in shared memory
+    MachineConfig machine;
+    ComponentLibrary library;
+    FeederIndex feeder_index;
+    FeederStatus feeder_status[MAX_NUMBER_OF_FEEDERS];
+    BoardTransform board;
+    InstructionSequence sequence;
+    MicroProgram program;
+    double x, y, x_target = 0.0, y_target = 0.0, x_preplace_error = 0.0, y_preplace_error = 0.0, controller_del_x = 0.0, controller_del_y = 0.0;
+    double x_nominal, y_nominal;            // where the head was last sent, which decides whether it is over the board
+    double x_head_error, y_head_error;      // how far from where it is sent the gantry stops over the board, the same every time
+    double theta_pick_error[MAX_NUMBER_OF_NOZZLES], controller_theta = 0.0, theta_actual[MAX_NUMBER_OF_NOZZLES];
+    double x_path[FLY_OVER_PATH_POINTS], y_path[FLY_OVER_PATH_POINTS], path_start_time = 0.0;
+    int number_of_nozzles, nozzle = 0;
+    int nozzle_down[MAX_NUMBER_OF_NOZZLES];
+    int nozzle_vacuum[MAX_NUMBER_OF_NOZZLES];
+    int nozzle_picked_part[MAX_NUMBER_OF_NOZZLES];
+    int nozzle_package[MAX_NUMBER_OF_NOZZLES];   // the package of the part the nozzle was last lowered to pick or place
+    int nozzle_placing[MAX_NUMBER_OF_NOZZLES];   // TRUE if it was lowered to place the part, so is raised at the place speed
+    int feeder_package[MAX_NUMBER_OF_FEEDERS];
     int instruction_being_executed = NO_INSTRUCTION;
     int number_of_placed_parts = 0, number_of_dropped_parts = 0;
+    int number_of_empty_feeders = 0, pick_attempted;
+    int sequence_step = NO_SEQUENCE_STEP;  // the step of the sequence being executed, if the instruction came from a sequence
     int photo_direction;
+    int machine_config_res, component_library_res;
+    unsigned int seed;
 
-    srand(time(0));
+    srand(seed = getSimulationSeed());
+    openDisplayLog(LOG_SOURCE_SIMULATOR, writeSimToDisplayFd);
 
-    /* initialize file for memory mapping */
-    int fd = open(MEMORY_MAPPED_FILE, (O_CREAT | O_RDWR), 0666);
-    if (fd < 0)
+    /* read the machine description, falling back to the original machine if there is no machine config file */
+    machine_config_res = getMachineConfigFileContents(getMachineConfigFileName(), &machine);
+    if (machine_config_res != MACHINE_CONFIG_FILE_PRESENT_AND_READ && machine_config_res != MACHINE_CONFIG_FILE_NOT_PRESENT)
     {
-        perror("creation/opening of memory mapped file failed");
-        exit(1);
+        formatLogMessage(&log_line, sim_time, "Problem with machine config file, error code ");
+        addLogInteger(&log_line, machine_config_res);
+        addLogText(&log_line, "\n");
+        writeDisplayLog(log_line.text);
+        exit(3);
+    }
+    /* and the handling of each footprint, falling back to the machine's timings for every part if there is no library */
+    component_library_res = getComponentLibraryFileContents(getComponentLibraryFileName(), &machine, &library);
+    if (component_library_res != COMPONENT_LIBRARY_FILE_PRESENT_AND_READ && component_library_res != COMPONENT_LIBRARY_FILE_NOT_PRESENT)
+    {
+        formatLogMessage(&log_line, sim_time, "Problem with component library file, error code ");
+        addLogInteger(&log_line, component_library_res);
+        addLogText(&log_line, "\n");
+        writeDisplayLog(log_line.text);
+        exit(3);
+    }
+    buildFeederIndex(&feeder_index, &machine);
+    resetFeederBank(feeder_status, &machine);
+    setIdentityBoardTransform(&board);
+    setRandomHeadPositioningError(&x_head_error, &y_head_error);
+    clearSequence(&sequence);
+    program.running = FALSE;
+    number_of_nozzles = machine.number_of_nozzles;
+    x = x_nominal = machine.home_x;
+    y = y_nominal = machine.home_y;
+    for (int i = 0; i < MAX_NUMBER_OF_NOZZLES; i++)
+    {
+        theta_pick_error[i] = 0.0;
+        theta_actual[i] = 0.0;
+        nozzle_down[i] = FALSE;
+        nozzle_vacuum[i] = FALSE;
+        nozzle_picked_part[i] = NO_PICKED_PART;
+        nozzle_package[i] = NO_PACKAGE;
+        nozzle_placing[i] = FALSE;
     }
-    ftruncate(fd, sizeof(PnP));
 
-    /* map the file to memory */
-    pnp = (PnP *)mmap(0, sizeof(PnP), (PROT_READ | PROT_WRITE), MAP_SHARED, fd, (off_t)0);
+    /* map the shared memory segment */
+    pnp = openPnP(TRUE);
     if (pnp == MAP_FAILED)
     {
-        perror("memory mapping of file failed");
-        close(fd);
+        perror("opening/memory mapping of the shared memory segment failed");
         exit(2);
     }
+    if (isPnPLayoutValid(pnp) == FALSE)
+    {
+        fprintf(stderr, "The shared memory segment has layout version %u of %u bytes, the simulator version %d of %d bytes\n",
+                pnp -> layout_version, pnp -> layout_size, PNP_LAYOUT_VERSION, (int) sizeof(PnP));
+        exit(3);
+    }
 
     /* reset the pick and place machine*/
     resetPnP(pnp, sim_time);
 
-    //wait for Startup to finish spawning other processes
-    sem_wait(sem_Startup);
-    sprintf(Sim_str_array, "Time: %7.2f  Pick and place machine simulation started successfully!\n", sim_time);
-    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
-
-    const char nozzle_name[3][10] = {"Left", "Centre", "Right"};
+    /* publish the machine description once so that the controller works from the same feeders, head and timings */
+    pnp -> machine = machine;
+    pnp -> library = library;
+    pnp -> random_seed = seed;
+    memcpy(pnp -> feeder_status, feeder_status, sizeof(feeder_status));
+    pnp -> head_x = x;
+    pnp -> head_y = y;
+    pnp -> machine_config_published = TRUE;
+
+    //wait for the controller to be ready too, then start together
+    waitAtStartupBarrier(pnp, sem_Startup);
+    memcpy(feeder_package, pnp -> feeder_package, sizeof(feeder_package));  // published by the controller before the barrier
+    formatLogMessage(&log_line, sim_time, "Pick and place machine simulation started successfully!\n");
+    writeDisplayLog(log_line.text);
 
     /*
      * loop continuously until simulator is to quit
@@ -85,6 +150,9 @@ int main(int argc, char *argv[])
          * If there is no instruction currently being executed, this code checks whether there
          * is a new instruction pending from the controller, and if so, determines the instruction
          * finish time based upon the type of instruction and possibly the parameters of that instruction.
+         * While a sequence instruction (e.g. MOVE_CORRECT_LOWER) is running, the instruction is instead
+         * the next step of the sequence, and while a micro-program is running, it is the next instruction
+         * of the program.
          *
          * It also signals that there is currently an instruction being executed back to the controller
          * so that the controller waits to issue any further instructions.
@@ -92,16 +160,73 @@ int main(int argc, char *argv[])
         if (instruction_being_executed == NO_INSTRUCTION)
         {
 
-            int new_instruction = pnp -> instruction_to_execute;
+            int new_instruction, argument_3, from_program = FALSE;
+            double argument_1, argument_2;
+
+            sequence_step = getNextSequenceStep(&sequence, &new_instruction, &argument_1, &argument_2, &argument_3);
+            if (sequence_step != NO_SEQUENCE_STEP)
+            {
+                if (new_instruction == AMEND_BY_PREPLACE_ERROR)
+                {   /* the correction comes from the lookdown photo taken by the previous step */
+                    new_instruction = AMEND_HEAD_POSITION;
+                    argument_1 = -x_preplace_error;
+                    argument_2 = -y_preplace_error;
+                }
+            }
+            else if (program.running == TRUE)
+            {
+                ProgramStep program_step;
+                int program_res = getNextProgramInstruction(&program, &machine, feeder_status, nozzle_picked_part, sim_time, &program_step);
+
+                new_instruction = NO_INSTRUCTION;
+                if (program_res == PROGRAM_RUNNING)
+                {
+                    new_instruction = program_step.opcode;
+                    argument_1 = program_step.argument_1;
+                    argument_2 = program_step.argument_2;
+                    argument_3 = program_step.argument_3;
+                    from_program = TRUE;
+                }
+                else if (program_res != PROGRAM_WAITING)
+                {
+                    program.running = FALSE;
+                    pnp -> ready_for_next_instruction = TRUE;
+                    handshake_start_time = sim_time;
+                    formatLogMessage(&log_line, sim_time, "Program ");
+                    addLogText(&log_line, program_res == PROGRAM_FINISHED ? "finished" : "FAULTED");
+                    addLogText(&log_line, " after ");
+                    addLogInteger(&log_line, program.steps_executed);
+                    addLogText(&log_line, " steps\n");
+                    writeDisplayLog(log_line.text);
+                }
+                pnp -> program.program_counter = program.program_counter;
+                pnp -> program.steps_executed = program.steps_executed;
+                pnp -> program.status = program_res;
+            }
+            else
+            {
+                new_instruction = pnp -> instruction_to_execute;
+                if (sim_time <= pnp -> instruction_not_before) new_instruction = NO_INSTRUCTION;  // a replayed instruction, handed over early
+                argument_1 = pnp -> instruction_argument_1;
+                argument_2 = pnp -> instruction_argument_2;
+                argument_3 = pnp -> instruction_argument_3;
+                if (new_instruction != NO_INSTRUCTION && handshake_start_time != NO_HANDSHAKE)
+                {
+                    recordHandshake(&pnp -> simulator_stats, sim_time - handshake_start_time);
+                    handshake_start_time = NO_HANDSHAKE;
+                }
+            }
 
             if (new_instruction == LOAD_PCB)
             {
                 pnp -> ready_for_next_instruction = FALSE;
                 pnp -> instruction_to_execute = NO_INSTRUCTION;
                 instruction_being_executed = LOAD_PCB;
-                instruction_finish_time = sim_time + PCB_LOAD_UNLOAD_TIME;
-                sprintf(Sim_str_array, "Time: %7.2f  PCB about to be loaded into pick and place machine\n", sim_time);
-                write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                instruction_finish_time = sim_time + machine.pcb_load_unload_time;
+                pcb_load_time = sim_time;
+                pcb_unload_time = NO_PCB_TIME;
+                formatLogMessage(&log_line, sim_time, "PCB about to be loaded into pick and place machine\n");
+                writeDisplayLog(log_line.text);
             }
 
             if (new_instruction == UNLOAD_PCB)
@@ -109,186 +234,323 @@ int main(int argc, char *argv[])
                 pnp -> ready_for_next_instruction = FALSE;
                 pnp -> instruction_to_execute = NO_INSTRUCTION;
                 instruction_being_executed = UNLOAD_PCB;
-                instruction_finish_time = sim_time + PCB_LOAD_UNLOAD_TIME;
-                sprintf(Sim_str_array, "Time: %7.2f  PCB about to be unloaded\n", sim_time);
-                write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                instruction_finish_time = sim_time + machine.pcb_load_unload_time;
+                formatLogMessage(&log_line, sim_time, "PCB about to be unloaded\n");
+                writeDisplayLog(log_line.text);
             }
 
             if (new_instruction == MOVE_HEAD)
             {
-                x_target = pnp -> instruction_argument_1;
-                y_target = pnp -> instruction_argument_2;
-                if (nozzle_down[LEFT_NOZZLE] == FALSE && nozzle_down[CENTRE_NOZZLE] == FALSE && nozzle_down[RIGHT_NOZZLE] == FALSE)
+                x_target = argument_1;
+                y_target = argument_2;
+                if (isAnyNozzleDown(nozzle_down, number_of_nozzles) == FALSE)
                 {
-                    if (x_target >= MIN_X && x_target <= MAX_X && y_target >= MIN_Y && y_target <= MAX_Y)
+                    if (x_target >= machine.min_x && x_target <= machine.max_x && y_target >= machine.min_y && y_target <= machine.max_y)
                     {
                         pnp -> ready_for_next_instruction = FALSE;
                         pnp -> instruction_to_execute = NO_INSTRUCTION;
                         instruction_being_executed = MOVE_HEAD;
-                        instruction_finish_time = sim_time + (double)sqrt(pow((x - x_target), 2) + pow((y - y_target), 2)) / HEAD_FULL_SPEED;
-                        sprintf(Sim_str_array, "Time: %7.2f  Head moving from (%.2f, %.2f) to (%.2f, %.2f)\n", sim_time, x, y, x_target, y_target);
-                        write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                        instruction_finish_time = sim_time + (double)sqrt(pow((x - x_target), 2) + pow((y - y_target), 2)) / machine.head_full_speed;
+                        formatHeadMoveLog(&log_line, sim_time, x, y, x_target, y_target, "\n");
+                        writeDisplayLog(log_line.text);
                     }
                     else
                     {
-                        sprintf(Sim_str_array, "Time: %7.2f  Bad MOVE_HEAD command: destination out of range\n", sim_time);
-                        write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                        formatLogMessage(&log_line, sim_time, "Bad MOVE_HEAD command: destination out of range\n");
+                        writeDisplayLog(log_line.text);
                     }
                 }
                 else
                 {
-                    sprintf(Sim_str_array, "Time: %7.2f  Bad MOVE_HEAD command: one or more nozzles down\n", sim_time);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    formatLogMessage(&log_line, sim_time, "Bad MOVE_HEAD command: one or more nozzles down\n");
+                    writeDisplayLog(log_line.text);
                 }
 
             }
 
             else if (new_instruction == ROTATE_NOZZLE)
             {
-                nozzle = pnp -> instruction_argument_3;
-                if (nozzle >= LEFT_NOZZLE && nozzle <= RIGHT_NOZZLE)
+                nozzle = argument_3;
+                if (nozzle >= 0 && nozzle < number_of_nozzles)
                 {
                     pnp -> ready_for_next_instruction = FALSE;
                     pnp -> instruction_to_execute = NO_INSTRUCTION;
                     instruction_being_executed = ROTATE_NOZZLE;
-                    controller_theta = pnp -> instruction_argument_1;
-                    instruction_finish_time = sim_time + (double)abs(controller_theta) / NOZZLE_ROTATE_SPEED;
+                    controller_theta = argument_1;
+                    instruction_finish_time = sim_time + (double)abs(controller_theta) / machine.nozzle_rotate_speed;
 
-                    sprintf(Sim_str_array, "Time: %7.2f  %s nozzle being rotated by %.2f degrees\n", sim_time, nozzle_name[nozzle], controller_theta);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    formatNozzleLog(&log_line, sim_time, machine.nozzle_name[nozzle], "being rotated by ");
+                    addLogFixed(&log_line, controller_theta, 0, 2);
+                    addLogText(&log_line, " degrees\n");
+                    writeDisplayLog(log_line.text);
                 }
                 else
                 {
-                    sprintf(Sim_str_array, "Time: %7.2f  Bad ROTATE_NOZZLE command: nozzle out of range\n", sim_time);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    formatLogMessage(&log_line, sim_time, "Bad ROTATE_NOZZLE command: nozzle out of range\n");
+                    writeDisplayLog(log_line.text);
                 }
 
             }
             else if (new_instruction == LOWER_NOZZLE)
             {
-                nozzle = pnp -> instruction_argument_3;
-                if (nozzle >= LEFT_NOZZLE && nozzle <= RIGHT_NOZZLE)
+                nozzle = argument_3;
+                if (nozzle >= 0 && nozzle < number_of_nozzles)
                 {
                     pnp -> ready_for_next_instruction = FALSE;
                     pnp -> instruction_to_execute = NO_INSTRUCTION;
                     instruction_being_executed = LOWER_NOZZLE;
-                    instruction_finish_time = sim_time + NOZZLE_LOWER_TIME;
-                    sprintf(Sim_str_array, "Time: %7.2f  %s nozzle being lowered\n", sim_time, nozzle_name[nozzle]);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    nozzle_package[nozzle] = getNozzlePackage(&feeder_index, &machine, feeder_package, nozzle_picked_part, x, y, nozzle);
+                    nozzle_placing[nozzle] = nozzle_picked_part[nozzle] != NO_PICKED_PART;
+                    instruction_finish_time = sim_time + getPackageInstructionTime(&library, &machine, nozzle_package[nozzle], LOWER_NOZZLE, nozzle_placing[nozzle]);
+                    formatNozzleLog(&log_line, sim_time, machine.nozzle_name[nozzle], "being lowered\n");
+                    writeDisplayLog(log_line.text);
                 }
                 else
                 {
-                    sprintf(Sim_str_array, "Time: %7.2f  Bad LOWER_NOZZLE command: nozzle out of range\n", sim_time);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    formatLogMessage(&log_line, sim_time, "Bad LOWER_NOZZLE command: nozzle out of range\n");
+                    writeDisplayLog(log_line.text);
                 }
             }
             else if (new_instruction == RAISE_NOZZLE)
             {
-                nozzle = pnp -> instruction_argument_3;
-                if (nozzle >= LEFT_NOZZLE && nozzle <= RIGHT_NOZZLE)
+                nozzle = argument_3;
+                if (nozzle >= 0 && nozzle < number_of_nozzles)
                 {
                     pnp -> ready_for_next_instruction = FALSE;
                     pnp -> instruction_to_execute = NO_INSTRUCTION;
                     instruction_being_executed = RAISE_NOZZLE;
-                    instruction_finish_time = sim_time + NOZZLE_RAISE_TIME;
-                    sprintf(Sim_str_array, "Time: %7.2f  %s nozzle being raised\n", sim_time, nozzle_name[nozzle]);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    instruction_finish_time = sim_time + getPackageInstructionTime(&library, &machine, nozzle_package[nozzle], RAISE_NOZZLE, nozzle_placing[nozzle]);
+                    formatNozzleLog(&log_line, sim_time, machine.nozzle_name[nozzle], "being raised\n");
+                    writeDisplayLog(log_line.text);
                 }
                 else
                 {
-                    sprintf(Sim_str_array, "Time: %7.2f  Bad RAISE_NOZZLE command: nozzle out of range\n", sim_time);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    formatLogMessage(&log_line, sim_time, "Bad RAISE_NOZZLE command: nozzle out of range\n");
+                    writeDisplayLog(log_line.text);
                 }
             }
             else if (new_instruction == APPLY_VACUUM)
             {
-                nozzle = pnp -> instruction_argument_3;
-                if (nozzle >= LEFT_NOZZLE && nozzle <= RIGHT_NOZZLE)
+                nozzle = argument_3;
+                if (nozzle >= 0 && nozzle < number_of_nozzles)
                 {
                     pnp -> ready_for_next_instruction = FALSE;
                     pnp -> instruction_to_execute = NO_INSTRUCTION;
                     instruction_being_executed = APPLY_VACUUM;
-                    instruction_finish_time = sim_time + VACUUM_APPLY_TIME;
-                    sprintf(Sim_str_array, "Time: %7.2f  %s nozzle is about to apply vacuum\n", sim_time, nozzle_name[nozzle]);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    instruction_finish_time = sim_time + getPackageInstructionTime(&library, &machine,
+                        getNozzlePackage(&feeder_index, &machine, feeder_package, nozzle_picked_part, x, y, nozzle), APPLY_VACUUM, FALSE);
+                    formatNozzleLog(&log_line, sim_time, machine.nozzle_name[nozzle], "is about to apply vacuum\n");
+                    writeDisplayLog(log_line.text);
                 }
                 else
                 {
-                    sprintf(Sim_str_array, "Time: %7.2f  Bad APPLY_VACUUM command: nozzle out of range\n", sim_time);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    formatLogMessage(&log_line, sim_time, "Bad APPLY_VACUUM command: nozzle out of range\n");
+                    writeDisplayLog(log_line.text);
                 }
             }
             else if (new_instruction == RELEASE_VACUUM)
             {
-                nozzle = pnp -> instruction_argument_3;
-                if (nozzle >= LEFT_NOZZLE && nozzle <= RIGHT_NOZZLE)
+                nozzle = argument_3;
+                if (nozzle >= 0 && nozzle < number_of_nozzles)
                 {
                     pnp -> ready_for_next_instruction = FALSE;
                     pnp -> instruction_to_execute = NO_INSTRUCTION;
                     instruction_being_executed = RELEASE_VACUUM;
-                    instruction_finish_time = sim_time + VACUUM_RELEASE_TIME;
-                    sprintf(Sim_str_array, "Time: %7.2f  %s nozzle is about to release vacuum\n", sim_time, nozzle_name[nozzle]);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    instruction_finish_time = sim_time + getPackageInstructionTime(&library, &machine,
+                        getNozzlePackage(&feeder_index, &machine, feeder_package, nozzle_picked_part, x, y, nozzle), RELEASE_VACUUM, TRUE);
+                    formatNozzleLog(&log_line, sim_time, machine.nozzle_name[nozzle], "is about to release vacuum\n");
+                    writeDisplayLog(log_line.text);
                  }
                 else
                 {
-                    sprintf(Sim_str_array, "Time: %7.2f  Bad RELEASE_VACUUM command: nozzle out of range\n", sim_time);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    formatLogMessage(&log_line, sim_time, "Bad RELEASE_VACUUM command: nozzle out of range\n");
+                    writeDisplayLog(log_line.text);
                 }
             }
             else if (new_instruction == TAKE_PHOTO)
             {
-                photo_direction = pnp -> instruction_argument_3;
+                photo_direction = argument_3;
                 if (photo_direction == PHOTO_LOOKUP || photo_direction == PHOTO_LOOKDOWN)
                 {
                     pnp -> ready_for_next_instruction = FALSE;
                     pnp -> instruction_to_execute = NO_INSTRUCTION;
                     instruction_being_executed = TAKE_PHOTO;
-                    instruction_finish_time = sim_time + PHOTO_TAKE_TIME;
+                    instruction_finish_time = sim_time + machine.photo_take_time;
                     if (photo_direction == PHOTO_LOOKUP)
                     {
-                        sprintf(Sim_str_array, "Time: %7.2f  Photo about to be taken by lookup camera\n", sim_time);
-                        write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                        formatLogMessage(&log_line, sim_time, "Photo about to be taken by lookup camera\n");
+                        writeDisplayLog(log_line.text);
                     }
                     else
                     {
-                        sprintf(Sim_str_array, "Time: %7.2f  Photo about to be taken by lookdown camera\n", sim_time);
-                        write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                        formatLogMessage(&log_line, sim_time, "Photo about to be taken by lookdown camera\n");
+                        writeDisplayLog(log_line.text);
                     }
                 }
                 else
                 {
-                    sprintf(Sim_str_array, "Time: %7.2f  Bad TAKE_PHOTO command: specified camera is not Lookup or Lookdown\n", sim_time);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    formatLogMessage(&log_line, sim_time, "Bad TAKE_PHOTO command: specified camera is not Lookup or Lookdown\n");
+                    writeDisplayLog(log_line.text);
                 }
             }
             else if (new_instruction == AMEND_HEAD_POSITION)
             {
-                controller_del_x = pnp -> instruction_argument_1;
-                controller_del_y = pnp -> instruction_argument_2;
-                if (nozzle_down[LEFT_NOZZLE] == FALSE && nozzle_down[CENTRE_NOZZLE] == FALSE && nozzle_down[RIGHT_NOZZLE] == FALSE)
+                controller_del_x = argument_1;
+                controller_del_y = argument_2;
+                if (isAnyNozzleDown(nozzle_down, number_of_nozzles) == FALSE)
                 {
-                    if (x + controller_del_x >= MIN_X && x + controller_del_x <= MAX_X && y + controller_del_y >= MIN_Y && y + controller_del_y <= MAX_Y)
+                    if (x + controller_del_x >= machine.min_x && x + controller_del_x <= machine.max_x && y + controller_del_y >= machine.min_y && y + controller_del_y <= machine.max_y)
                     {
                         pnp -> ready_for_next_instruction = FALSE;
                         pnp -> instruction_to_execute = NO_INSTRUCTION;
                         instruction_being_executed = AMEND_HEAD_POSITION;
-                        instruction_finish_time = sim_time + (double)sqrt(pow((controller_del_x), 2) + pow((controller_del_y), 2)) / HEAD_FULL_SPEED;
-                        sprintf(Sim_str_array, "Time: %7.2f  Head moving from (%.2f, %.2f) to (%.2f, %.2f)\n", sim_time, x, y, x + controller_del_x, y + controller_del_y);
-                        write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                        instruction_finish_time = sim_time + (double)sqrt(pow((controller_del_x), 2) + pow((controller_del_y), 2)) / machine.head_full_speed;
+                        formatHeadMoveLog(&log_line, sim_time, x, y, x + controller_del_x, y + controller_del_y, "\n");
+                        writeDisplayLog(log_line.text);
                     }
                     else
                     {
-                        sprintf(Sim_str_array, "Time: %7.2f  Bad AMEND_HEAD_POSITION command: destination out of range\n", sim_time);
-                        write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                        formatLogMessage(&log_line, sim_time, "Bad AMEND_HEAD_POSITION command: destination out of range\n");
+                        writeDisplayLog(log_line.text);
                     }
                 }
                 else
                 {
-                    sprintf(Sim_str_array, "Time: %7.2f  Bad AMEND_HEAD_POSITION command: one or more nozzles down\n", sim_time);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    formatLogMessage(&log_line, sim_time, "Bad AMEND_HEAD_POSITION command: one or more nozzles down\n");
+                    writeDisplayLog(log_line.text);
                 }
             }
+            else if (new_instruction == MOVE_HEAD_VIA_CAMERA)
+            {
+                x_target = argument_1;
+                y_target = argument_2;
+                /*
+                 * the head sweeps its row of nozzles across the lookup camera, from the first nozzle to the last
+                 * or the other way round, whichever end is nearer, then carries on to the target
+                 */
+                x_path[0] = x;
+                y_path[0] = y;
+                x_path[1] = machine.lookup_camera_x - machine.nozzle_x_offset[0];
+                y_path[1] = machine.lookup_camera_y - machine.nozzle_y_offset[0];
+                x_path[2] = machine.lookup_camera_x - machine.nozzle_x_offset[number_of_nozzles - 1];
+                y_path[2] = machine.lookup_camera_y - machine.nozzle_y_offset[number_of_nozzles - 1];
+                if (hypot(x_path[1] - x, y_path[1] - y) > hypot(x_path[2] - x, y_path[2] - y))
+                {
+                    x_path[1] = x_path[2];
+                    y_path[1] = y_path[2];
+                    x_path[2] = machine.lookup_camera_x - machine.nozzle_x_offset[0];
+                    y_path[2] = machine.lookup_camera_y - machine.nozzle_y_offset[0];
+                }
+                x_path[3] = x_target;
+                y_path[3] = y_target;
+                if (machine.lookup_camera_fly_over == FALSE)
+                {
+                    formatLogMessage(&log_line, sim_time, "Bad MOVE_HEAD_VIA_CAMERA command: lookup camera cannot take photos in flight\n");
+                    writeDisplayLog(log_line.text);
+                }
+                else if (isAnyNozzleDown(nozzle_down, number_of_nozzles) == TRUE)
+                {
+                    formatLogMessage(&log_line, sim_time, "Bad MOVE_HEAD_VIA_CAMERA command: one or more nozzles down\n");
+                    writeDisplayLog(log_line.text);
+                }
+                else if (x_target < machine.min_x || x_target > machine.max_x || y_target < machine.min_y || y_target > machine.max_y
+                         || x_path[1] < machine.min_x || x_path[1] > machine.max_x || y_path[1] < machine.min_y || y_path[1] > machine.max_y
+                         || x_path[2] < machine.min_x || x_path[2] > machine.max_x || y_path[2] < machine.min_y || y_path[2] > machine.max_y)
+                {
+                    formatLogMessage(&log_line, sim_time, "Bad MOVE_HEAD_VIA_CAMERA command: destination or camera sweep out of range\n");
+                    writeDisplayLog(log_line.text);
+                }
+                else
+                {
+                    double path_length = 0.0;
+                    for (int i = 1; i < FLY_OVER_PATH_POINTS; i++) path_length += hypot(x_path[i] - x_path[i - 1], y_path[i] - y_path[i - 1]);
+                    pnp -> ready_for_next_instruction = FALSE;
+                    pnp -> instruction_to_execute = NO_INSTRUCTION;
+                    instruction_being_executed = MOVE_HEAD_VIA_CAMERA;
+                    path_start_time = sim_time;
+                    instruction_finish_time = sim_time + path_length / machine.head_full_speed;
+                    formatHeadMoveLog(&log_line, sim_time, x, y, x_target, y_target, " via lookup camera\n");
+                    writeDisplayLog(log_line.text);
+                }
+            }
+            else if (new_instruction == MOVE_CORRECT_LOWER)
+            {
+                nozzle = argument_3;
+                if (nozzle >= 0 && nozzle < number_of_nozzles)
+                {   /* carried out as a sequence of the simpler instructions, without a handshake with the controller between them */
+                    pnp -> ready_for_next_instruction = FALSE;
+                    pnp -> instruction_to_execute = NO_INSTRUCTION;
+                    clearSequence(&sequence);
+                    addSequenceStep(&sequence, MOVE_HEAD, argument_1, argument_2, 0);
+                    addSequenceStep(&sequence, TAKE_PHOTO, 0.0, 0.0, PHOTO_LOOKDOWN);
+                    addSequenceStep(&sequence, AMEND_BY_PREPLACE_ERROR, 0.0, 0.0, 0);
+                    addSequenceStep(&sequence, LOWER_NOZZLE, 0.0, 0.0, nozzle);
+                    pnp -> sequence_report.number_of_steps = sequence.length;
+                    for (int i = 0; i < sequence.length; i++)
+                    {
+                        pnp -> sequence_report.instruction[i] = sequence.instruction[i] == AMEND_BY_PREPLACE_ERROR ? AMEND_HEAD_POSITION : sequence.instruction[i];
+                        pnp -> sequence_report.result[i] = SEQUENCE_STEP_NOT_RUN;
+                        pnp -> sequence_report.finish_time[i] = 0.0;
+                    }
+                    formatLogMessage(&log_line, sim_time, "Moving to ");
+                    addLogPoint(&log_line, argument_1, argument_2, 2);
+                    addLogText(&log_line, ", correcting and lowering ");
+                    addLogText(&log_line, machine.nozzle_name[nozzle]);
+                    addLogText(&log_line, " nozzle\n");
+                    writeDisplayLog(log_line.text);
+                }
+                else
+                {
+                    formatLogMessage(&log_line, sim_time, "Bad MOVE_CORRECT_LOWER command: nozzle out of range\n");
+                    writeDisplayLog(log_line.text);
+                }
+            }
+
+            else if (new_instruction == RUN_PROGRAM && program.running == FALSE)
+            {
+                pnp -> instruction_to_execute = NO_INSTRUCTION;
+                if (loadProgram(&program, &pnp -> program) == TRUE)
+                {
+                    pnp -> ready_for_next_instruction = FALSE;
+                    pnp -> program.status = PROGRAM_RUNNING;
+                    pnp -> program.program_counter = 0;
+                    pnp -> program.steps_executed = 0;
+                    pnp -> program.instructions_rejected = 0;
+                    formatLogMessage(&log_line, sim_time, "Running program of ");
+                    addLogInteger(&log_line, program.length);
+                    addLogText(&log_line, " steps\n");
+                    writeDisplayLog(log_line.text);
+                }
+                else
+                {
+                    pnp -> program.status = PROGRAM_FAULTED;
+                    formatLogMessage(&log_line, sim_time, "Bad RUN_PROGRAM command: not a valid program\n");
+                    writeDisplayLog(log_line.text);
+                }
+            }
+
+            /* the program can branch on whether its last instruction was rejected */
+            if (from_program == TRUE)
+            {
+                program.last_rejected = instruction_being_executed == NO_INSTRUCTION && isSequenceRunning(&sequence) == FALSE;
+                if (program.last_rejected == TRUE) pnp -> program.instructions_rejected++;
+            }
+
+            /* a step of a sequence which is not valid abandons the rest of the sequence */
+            if (sequence_step != NO_SEQUENCE_STEP && instruction_being_executed == NO_INSTRUCTION)
+            {
+                pnp -> sequence_report.result[sequence_step] = SEQUENCE_STEP_REJECTED;
+                pnp -> sequence_report.finish_time[sequence_step] = sim_time;
+                clearSequence(&sequence);
+                sequence_step = NO_SEQUENCE_STEP;
+                program.last_rejected = TRUE;
+                if (program.running == FALSE)
+                {
+                    pnp -> ready_for_next_instruction = TRUE;
+                    handshake_start_time = sim_time;
+                }
+            }
+            instruction_start_time = sim_time;
         }
         /*
          * If there is an instruction currently being executed, this code checks whether the
@@ -301,110 +563,132 @@ int main(int argc, char *argv[])
          */
         else if (sim_time >= instruction_finish_time)
         {
-            int feeder;
+            int feeder, pick_res, fiducial;
+            pick_attempted = FALSE;
             switch(instruction_being_executed)
             {
                 case LOAD_PCB:
-                    sprintf(Sim_str_array, "Time: %7.2f  PCB has been loaded\n", sim_time);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    setRandomBoardTransform(&board, &machine);
+                    startPlacementAnalytics(&analytics, pnp -> target, pnp -> number_of_targets, &machine, pcb_load_time);
+                    formatLogMessage(&log_line, sim_time, "PCB has been loaded, offset ");
+                    addLogPoint(&log_line, board.offset_x, board.offset_y, 2);
+                    addLogText(&log_line, " rotation ");
+                    addLogFixed(&log_line, board.rotation, 0, 3);
+                    addLogText(&log_line, " degrees scale ");
+                    addLogFixed(&log_line, board.scale, 0, 5);
+                    addLogText(&log_line, "\n");
+                    writeDisplayLog(log_line.text);
                     break;
 
                 case UNLOAD_PCB:
-                    sprintf(Sim_str_array, "Time: %7.2f  PCB has been unloaded\n", sim_time);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    pcb_unload_time = sim_time;
+                    pnp -> simulator_stats.boards_completed++;
+                    finishPlacementAnalytics(&analytics, &machine, sim_time);
+                    formatLogMessage(&log_line, sim_time, "Placement analytics: ");
+                    addLogInteger(&log_line, analytics.in_spec);
+                    addLogText(&log_line, " of ");
+                    addLogInteger(&log_line, analytics.number_of_targets);
+                    addLogText(&log_line, " parts within tolerance, ");
+                    addLogInteger(&log_line, analytics.dropped);
+                    addLogText(&log_line, " dropped, mean position error ");
+                    addLogFixed(&log_line, analytics.position_error.mean, 0, 3);
+                    addLogText(&log_line, "\n");
+                    writeDisplayLog(log_line.text);
+                    formatLogMessage(&log_line, sim_time, "PCB has been unloaded\n");
+                    writeDisplayLog(log_line.text);
                     sem_post(sem_Sim); // the controller waits for the simulator to finish this task before terminating
                     break;
 
                 case MOVE_HEAD:
-                    x = x_target;
-                    y = y_target;
-                    sprintf(Sim_str_array, "Time: %7.2f  Head arrived at nominal location (%.2f, %.2f)\n", sim_time, x, y);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    x = x_nominal = x_target;
+                    y = y_nominal = y_target;
+                    if (isHeadOverBoard(&machine, x_nominal, y_nominal) == TRUE)
+                    {   /* over the board, only a lookdown photo shows where the head really is */
+                        x = x + x_head_error;
+                        y = y + y_head_error;
+                    }
+                    formatLogMessage(&log_line, sim_time, "Head arrived at nominal location ");
+                    addLogPoint(&log_line, x_target, y_target, 2);
+                    addLogText(&log_line, "\n");
+                    writeDisplayLog(log_line.text);
                     break;
 
                 case ROTATE_NOZZLE:
                     theta_actual[nozzle] = theta_actual[nozzle] + controller_theta;
-                    sprintf(Sim_str_array, "Time: %7.2f  %s nozzle finished rotating by %.2f degrees, effective rotation including misalignment theta_error=%.2f degrees is %.2f degrees\n",
-                            sim_time, nozzle_name[nozzle], controller_theta, theta_pick_error[nozzle], theta_actual[nozzle]);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    formatNozzleLog(&log_line, sim_time, machine.nozzle_name[nozzle], "finished rotating by ");
+                    addLogFixed(&log_line, controller_theta, 0, 2);
+                    addLogText(&log_line, " degrees, effective rotation including misalignment theta_error=");
+                    addLogFixed(&log_line, theta_pick_error[nozzle], 0, 2);
+                    addLogText(&log_line, " degrees is ");
+                    addLogFixed(&log_line, theta_actual[nozzle], 0, 2);
+                    addLogText(&log_line, " degrees\n");
+                    writeDisplayLog(log_line.text);
                     break;
 
                 case LOWER_NOZZLE:
                     nozzle_down[nozzle] = TRUE;
-                    sprintf(Sim_str_array, "Time: %7.2f  %s nozzle lowered\n", sim_time, nozzle_name[nozzle]);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
-                    /* code for when part is being picked up from tape feeder */
-                    feeder = getTapeFeederNumberAtLocation(x + (nozzle - CENTRE_NOZZLE) * NOZZLE_X_SEPARATION,y);
-                    if (nozzle_vacuum[nozzle] == TRUE
-                        && nozzle_picked_part[nozzle] == NO_PICKED_PART
-                        && feeder != NO_TAPE_FEEDER_AT_THIS_LOCATION)
-                    {
-                        nozzle_picked_part[nozzle] = feeder;
-                        sprintf(Sim_str_array, "Time: %7.2f  %s nozzle has picked up part from feeder %d\n", sim_time, nozzle_name[nozzle], feeder);
-                        write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
-                    }
-                    else if (nozzle_vacuum[nozzle] == TRUE
-                            && nozzle_picked_part[nozzle] == NO_PICKED_PART)
-                    {
-                        sprintf(Sim_str_array, "Time: %7.2f  No tape feeder underneath nozzle %s when vacuum applied so no part picked up\n", sim_time, nozzle_name[nozzle]);
-                        write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
-                    }
+                    formatNozzleLog(&log_line, sim_time, machine.nozzle_name[nozzle], "lowered\n");
+                    writeDisplayLog(log_line.text);
+                    /* part is picked up from a tape feeder if the vacuum was already applied */
+                    if (nozzle_vacuum[nozzle] == TRUE && nozzle_picked_part[nozzle] == NO_PICKED_PART) pick_attempted = TRUE;
                     break;
 
                 case RAISE_NOZZLE:
                     nozzle_down[nozzle] = FALSE;
-                    sprintf(Sim_str_array, "Time: %7.2f  %s nozzle raised\n", sim_time, nozzle_name[nozzle]);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    formatNozzleLog(&log_line, sim_time, machine.nozzle_name[nozzle], "raised\n");
+                    writeDisplayLog(log_line.text);
                     break;
 
                 case APPLY_VACUUM:
                     nozzle_vacuum[nozzle] = TRUE;
-                    sprintf(Sim_str_array, "Time: %7.2f  %s nozzle now has vacuum applied\n", sim_time, nozzle_name[nozzle]);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
-                    /* code for when part is being picked up from tape feeder */
-                    feeder = getTapeFeederNumberAtLocation(x + (nozzle - CENTRE_NOZZLE) * NOZZLE_X_SEPARATION,y);
-                    if (nozzle_down[nozzle] == TRUE
-                        && nozzle_picked_part[nozzle] == NO_PICKED_PART
-                        && feeder != NO_TAPE_FEEDER_AT_THIS_LOCATION)
-                    {
-                        nozzle_picked_part[nozzle] = feeder;
-                        sprintf(Sim_str_array, "Time: %7.2f  %s nozzle has picked up part from feeder %d\n", sim_time, nozzle_name[nozzle], feeder);
-                        write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
-                    }
-                    else if (nozzle_down[nozzle] == TRUE && nozzle_picked_part[nozzle] == NO_PICKED_PART)
-                    {
-                        sprintf(Sim_str_array, "Time: %7.2f  No tape feeder underneath nozzle %s when vacuum applied so no part picked up\n", sim_time, nozzle_name[nozzle]);
-                        write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
-                    }
+                    formatNozzleLog(&log_line, sim_time, machine.nozzle_name[nozzle], "now has vacuum applied\n");
+                    writeDisplayLog(log_line.text);
+                    /* part is picked up from a tape feeder if the nozzle was already lowered */
+                    if (nozzle_down[nozzle] == TRUE && nozzle_picked_part[nozzle] == NO_PICKED_PART) pick_attempted = TRUE;
                     break;
 
                 case RELEASE_VACUUM:
                     nozzle_vacuum[nozzle] = FALSE;
-                    sprintf(Sim_str_array, "Time: %7.2f  %s nozzle now has vacuum released\n", sim_time, nozzle_name[nozzle]);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
-                    /* code for when part is being placed on PCB */
+                    formatNozzleLog(&log_line, sim_time, machine.nozzle_name[nozzle], "now has vacuum released\n");
+                    writeDisplayLog(log_line.text);
+                    /* code for when part is being placed on PCB, the placement is recorded in board coordinates */
                     if (nozzle_down[nozzle] == TRUE
                         && nozzle_picked_part[nozzle] != NO_PICKED_PART
-                        && x >= 0.0 && y >= 0.0)
+                        && isHeadOverBoard(&machine, x_nominal, y_nominal) == TRUE)
                     {
-                        sprintf(Sim_str_array, "Time: %7.2f  %s nozzle has placed part from feeder %d at (%.2f, %.2f) with rotation %.2f degrees\n",
-                               sim_time, nozzle_name[nozzle], nozzle_picked_part[nozzle], x, y, theta_actual[nozzle]);
-                        write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
-                        placedPart[number_of_placed_parts].x_actual = x;
-                        placedPart[number_of_placed_parts].y_actual = y;
-                        placedPart[number_of_placed_parts].theta_actual = theta_actual[nozzle];
+                        machineToBoard(&board, x, y, &placedPart[number_of_placed_parts].x_actual, &placedPart[number_of_placed_parts].y_actual);
+                        placedPart[number_of_placed_parts].theta_actual = theta_actual[nozzle] - board.rotation;
+                        formatNozzleLog(&log_line, sim_time, machine.nozzle_name[nozzle], "has placed part from feeder ");
+                        addLogInteger(&log_line, nozzle_picked_part[nozzle]);
+                        addLogText(&log_line, " at ");
+                        addLogPoint(&log_line, placedPart[number_of_placed_parts].x_actual, placedPart[number_of_placed_parts].y_actual, 2);
+                        addLogText(&log_line, " with rotation ");
+                        addLogFixed(&log_line, placedPart[number_of_placed_parts].theta_actual, 0, 2);
+                        addLogText(&log_line, " degrees\n");
+                        writeDisplayLog(log_line.text);
                         placedPart[number_of_placed_parts].feeder = nozzle_picked_part[nozzle];
+                        recordPlacement(&analytics, nozzle_picked_part[nozzle], nozzle, placedPart[number_of_placed_parts].x_actual,
+                                        placedPart[number_of_placed_parts].y_actual, placedPart[number_of_placed_parts].theta_actual, sim_time);
                         number_of_placed_parts++;
+                        pnp -> simulator_stats.parts_placed++;
                         strFromSim = "\nSummary of placed parts so far:\n";
-                        write(writeSimToDisplayFd, strFromSim, strlen(strFromSim));
+                        writeDisplayLog(strFromSim);
                         for (int i = 0; i < number_of_placed_parts; i++)
                         {
-                            sprintf(Sim_str_array, "Part %d from feeder %d placed at (%.2f, %.2f) with rotation %.2f degrees\n", i,
-                                   placedPart[i].feeder, placedPart[i].x_actual, placedPart[i].y_actual, placedPart[i].theta_actual);
-                            write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                            clearLogLine(&log_line);
+                            addLogText(&log_line, "Part ");
+                            addLogInteger(&log_line, i);
+                            addLogText(&log_line, " from feeder ");
+                            addLogInteger(&log_line, placedPart[i].feeder);
+                            addLogText(&log_line, " placed at ");
+                            addLogPoint(&log_line, placedPart[i].x_actual, placedPart[i].y_actual, 2);
+                            addLogText(&log_line, " with rotation ");
+                            addLogFixed(&log_line, placedPart[i].theta_actual, 0, 2);
+                            addLogText(&log_line, " degrees\n");
+                            writeDisplayLog(log_line.text);
                         }
                         strFromSim = "\n";
-                        write(writeSimToDisplayFd, strFromSim, strlen(strFromSim));
+                        writeDisplayLog(strFromSim);
                         nozzle_picked_part[nozzle] = NO_PICKED_PART;
 
                         /* reset pick and preplace alignment error values after part placed */
@@ -417,50 +701,77 @@ int main(int argc, char *argv[])
                         theta_actual[nozzle] = 0.0;
 
                     }
-                    /* code for when part is dropped from a height */
-                    else if (nozzle_down[nozzle] == FALSE
-                             && nozzle_picked_part[nozzle] != NO_PICKED_PART)
+                    /* code for when part is dropped from a height, or let go of anywhere but over the board */
+                    else if (nozzle_picked_part[nozzle] != NO_PICKED_PART)
                     {
-                        sprintf(Sim_str_array, "Time: %7.2f  %s nozzle has DROPPED part from feeder %d at (%.2f, %.2f)\n", sim_time, nozzle_name[nozzle], nozzle_picked_part[nozzle], x, y);
-                        write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                        formatNozzleLog(&log_line, sim_time, machine.nozzle_name[nozzle], "has DROPPED part from feeder ");
+                        addLogInteger(&log_line, nozzle_picked_part[nozzle]);
+                        addLogText(&log_line, " at ");
+                        addLogPoint(&log_line, x, y, 2);
+                        addLogText(&log_line, "\n");
+                        writeDisplayLog(log_line.text);
                         number_of_dropped_parts++;
+                        pnp -> simulator_stats.parts_dropped++;
+                        recordDrop(&analytics, nozzle_picked_part[nozzle], nozzle);
                         nozzle_picked_part[nozzle] = NO_PICKED_PART;
                     }
                     break;
 
                 case TAKE_PHOTO:
                     /* code for when lookup camera is used to take photos to discover pick misalignment */
-                    if (photo_direction == PHOTO_LOOKUP && x == LOOKUP_CAMERA_X && y == LOOKUP_CAMERA_Y)
+                    if (photo_direction == PHOTO_LOOKUP && x == machine.lookup_camera_x && y == machine.lookup_camera_y)
                     {
-                        sprintf(Sim_str_array, "Time: %7.2f  Photo taken by lookup camera\n", sim_time);
-                        write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
-                        for (int i = 0; i < NUMBER_OF_NOZZLES; i++)
+                        formatLogMessage(&log_line, sim_time, "Photo taken by lookup camera\n");
+                        writeDisplayLog(log_line.text);
+                        for (int i = 0; i < number_of_nozzles; i++)
                         {
                             if (nozzle_picked_part[i] != NO_PICKED_PART)
                             {
                                 theta_pick_error[i] = MAX_THETA_PICK_MISALIGNMENT * (double)rand()/RAND_MAX - MAX_THETA_PICK_MISALIGNMENT / 2;
                                 theta_actual[i] = theta_pick_error[i];
 
-                                sprintf(Sim_str_array, "Time: %7.2f  Picked part on %s nozzle has misalignment theta_error=%.2f degrees\n", sim_time, nozzle_name[i], theta_pick_error[i]);
-                                write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                                formatLogMessage(&log_line, sim_time, "Picked part on ");
+                                addLogText(&log_line, machine.nozzle_name[i]);
+                                addLogText(&log_line, " nozzle has misalignment theta_error=");
+                                addLogFixed(&log_line, theta_pick_error[i], 0, 2);
+                                addLogText(&log_line, " degrees\n");
+                                writeDisplayLog(log_line.text);
 
                                 pnp -> theta_pick_error[i] = theta_pick_error[i];
                             }
                         }
                      }
-                     else if (photo_direction == PHOTO_LOOKDOWN && x >= 0.0 && y >= 0.0)
-                     {
-                        sprintf(Sim_str_array, "Time: %7.2f  Photo taken by lookdown camera\n", sim_time);
-                        write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
-
-                        x_preplace_error = MAX_X_PREPLACE_MISALIGNMENT * (double)rand()/RAND_MAX - MAX_X_PREPLACE_MISALIGNMENT / 2;
-                        y_preplace_error = MAX_Y_PREPLACE_MISALIGNMENT * (double)rand()/RAND_MAX - MAX_Y_PREPLACE_MISALIGNMENT / 2;
+                     else if (photo_direction == PHOTO_LOOKDOWN && isHeadOverBoard(&machine, x_nominal, y_nominal) == TRUE)
+                     {  /* code for when lookdown camera is over the board, a board fiducial in view also gives where the board is without moving the head */
+                        double board_x, board_y;
+                        fiducial = getFiducialInView(&machine, &board, x, y);
+                        pnp -> fiducial_in_view = fiducial;
+                        if (fiducial != NO_FIDUCIAL)
+                        {
+                            double fiducial_x, fiducial_y;
+                            boardToMachine(&board, machine.fiducial_x[fiducial], machine.fiducial_y[fiducial], &fiducial_x, &fiducial_y);
+                            pnp -> fiducial_offset_x = fiducial_x - x;
+                            pnp -> fiducial_offset_y = fiducial_y - y;
+                            formatLogMessage(&log_line, sim_time, "Photo taken by lookdown camera, fiducial ");
+                            addLogInteger(&log_line, fiducial);
+                            addLogText(&log_line, " is at offset ");
+                            addLogPoint(&log_line, pnp -> fiducial_offset_x, pnp -> fiducial_offset_y, 3);
+                            addLogText(&log_line, " from the head\n");
+                        }
+                        else formatLogMessage(&log_line, sim_time, "Photo taken by lookdown camera\n");
+                        writeDisplayLog(log_line.text);
 
-                        sprintf(Sim_str_array, "Time: %7.2f  Head has preplace misalignment x_error=%.2f y_error=%.2f\n", sim_time, x_preplace_error, y_preplace_error);
-                        write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                        /* the error seen is the head positioning error plus how far the board position under the head has moved */
+                        boardToMachine(&board, x_nominal, y_nominal, &board_x, &board_y);
+                        x_preplace_error = x - board_x;
+                        y_preplace_error = y - board_y;
 
-                        x = x + x_preplace_error;
-                        y = y + y_preplace_error;
+                        formatLogMessage(&log_line, sim_time, "Head has preplace misalignment x_error=");
+                        addLogFixed(&log_line, x_preplace_error, 0, 2);
+                        addLogText(&log_line, " y_error=");
+                        addLogFixed(&log_line, y_preplace_error, 0, 2);
+                        addLogText(&log_line, "\n");
+                        writeDisplayLog(log_line.text);
 
                         pnp -> x_preplace_error = x_preplace_error;
                         pnp -> y_preplace_error = y_preplace_error;
@@ -468,37 +779,172 @@ int main(int argc, char *argv[])
                      }
                      break;
 
+                case MOVE_HEAD_VIA_CAMERA:
+                    /* the strobe fires as each nozzle holding a part passes closest to the centre of the lookup camera */
+                    for (int i = 0; i < number_of_nozzles; i++)
+                    {
+                        if (nozzle_picked_part[i] != NO_PICKED_PART)
+                        {
+                            double crossing = NO_CAMERA_CROSSING, path_so_far = 0.0;
+                            for (int j = 1; j < FLY_OVER_PATH_POINTS && crossing == NO_CAMERA_CROSSING; j++)
+                            {
+                                crossing = getCameraCrossingDistance(x_path[j - 1] + machine.nozzle_x_offset[i], y_path[j - 1] + machine.nozzle_y_offset[i],
+                                                                     x_path[j] + machine.nozzle_x_offset[i], y_path[j] + machine.nozzle_y_offset[i],
+                                                                     machine.lookup_camera_x, machine.lookup_camera_y, machine.lookup_camera_window);
+                                if (crossing != NO_CAMERA_CROSSING) crossing += path_so_far;
+                                path_so_far += hypot(x_path[j] - x_path[j - 1], y_path[j] - y_path[j - 1]);
+                            }
+                            if (crossing != NO_CAMERA_CROSSING)
+                            {
+                                theta_pick_error[i] = MAX_THETA_PICK_MISALIGNMENT * (double)rand()/RAND_MAX - MAX_THETA_PICK_MISALIGNMENT / 2;
+                                theta_actual[i] = theta_pick_error[i];
+                                pnp -> theta_pick_error[i] = theta_pick_error[i];
+                                formatLogMessage(&log_line, path_start_time + crossing / machine.head_full_speed, "Photo taken in flight of part on ");
+                                addLogText(&log_line, machine.nozzle_name[i]);
+                                addLogText(&log_line, " nozzle, misalignment theta_error=");
+                                addLogFixed(&log_line, theta_pick_error[i], 0, 2);
+                                addLogText(&log_line, " degrees\n");
+                            }
+                            else
+                            {
+                                formatLogMessage(&log_line, sim_time, "Part on ");
+                                addLogText(&log_line, machine.nozzle_name[i]);
+                                addLogText(&log_line, " nozzle did not pass over the lookup camera\n");
+                            }
+                            writeDisplayLog(log_line.text);
+                        }
+                    }
+                    x = x_nominal = x_target;
+                    y = y_nominal = y_target;
+                    if (isHeadOverBoard(&machine, x_nominal, y_nominal) == TRUE)
+                    {
+                        x = x + x_head_error;
+                        y = y + y_head_error;
+                    }
+                    formatLogMessage(&log_line, sim_time, "Head arrived at nominal location ");
+                    addLogPoint(&log_line, x_target, y_target, 2);
+                    addLogText(&log_line, "\n");
+                    writeDisplayLog(log_line.text);
+                    break;
+
                 case AMEND_HEAD_POSITION:
                     x = x + controller_del_x;
                     y = y + controller_del_y;
-                    sprintf(Sim_str_array, "Time: %7.2f  Head position amended to (%.2f, %.2f)\n", sim_time, x, y);
-                    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
+                    formatLogMessage(&log_line, sim_time, "Head position amended to ");
+                    addLogPoint(&log_line, x, y, 2);
+                    addLogText(&log_line, "\n");
+                    writeDisplayLog(log_line.text);
                     break;
             }
 
+            /* code for when part is being picked up from tape feeder */
+            if (pick_attempted == TRUE)
+            {
+                feeder = getTapeFeederNumberAtLocation(&feeder_index, x + machine.nozzle_x_offset[nozzle], y + machine.nozzle_y_offset[nozzle]);
+                if (feeder == NO_TAPE_FEEDER_AT_THIS_LOCATION)
+                {
+                    formatLogMessage(&log_line, sim_time, "No tape feeder underneath nozzle ");
+                    addLogText(&log_line, machine.nozzle_name[nozzle]);
+                    addLogText(&log_line, " when vacuum applied so no part picked up\n");
+                    writeDisplayLog(log_line.text);
+                }
+                else
+                {
+                    pick_res = pickPartFromFeeder(&feeder_status[feeder], &machine, feeder, sim_time);
+                    if (pick_res == FEEDER_PICK_OK || pick_res == FEEDER_PICK_OK_REEL_NOW_EMPTY)
+                    {
+                        nozzle_picked_part[nozzle] = feeder;
+                        formatNozzleLog(&log_line, sim_time, machine.nozzle_name[nozzle], "has picked up part from feeder ");
+                        addLogInteger(&log_line, feeder);
+                        addLogText(&log_line, ", tape advancing ");
+                        addLogFixed(&log_line, machine.feeder_pitch[feeder], 0, 1);
+                        addLogText(&log_line, " mm\n");
+                        writeDisplayLog(log_line.text);
+                    }
+                    if (pick_res == FEEDER_PICK_OK_REEL_NOW_EMPTY)
+                    {
+                        number_of_empty_feeders++;
+                        postFeederEvent(pnp, FEEDER_EVENT_EMPTY, feeder, sim_time);
+                        formatLogMessage(&log_line, sim_time, "Feeder ");
+                        addLogInteger(&log_line, feeder);
+                        addLogText(&log_line, " is EMPTY, new reel will be spliced on at ");
+                        addLogFixed(&log_line, feeder_status[feeder].ready_time, 0, 2);
+                        addLogText(&log_line, "\n");
+                        writeDisplayLog(log_line.text);
+                    }
+                    else if (pick_res == FEEDER_PICK_TAPE_NOT_ADVANCED)
+                    {
+                        formatLogMessage(&log_line, sim_time, "Feeder ");
+                        addLogInteger(&log_line, feeder);
+                        addLogText(&log_line, " tape still advancing when vacuum applied so no part picked up\n");
+                        writeDisplayLog(log_line.text);
+                    }
+                    else if (pick_res == FEEDER_PICK_REEL_EMPTY)
+                    {
+                        formatLogMessage(&log_line, sim_time, "Feeder ");
+                        addLogInteger(&log_line, feeder);
+                        addLogText(&log_line, " is empty when vacuum applied so no part picked up\n");
+                        writeDisplayLog(log_line.text);
+                    }
+                    pnp -> feeder_status[feeder] = feeder_status[feeder];
+                }
+            }
+
             /* update shared memory for instruction related variables */
+            recordInstruction(&pnp -> simulator_stats, instruction_being_executed, sim_time - instruction_start_time);
             instruction_being_executed = NO_INSTRUCTION;
-            pnp -> ready_for_next_instruction = TRUE;
+            pnp -> head_x = x;
+            pnp -> head_y = y;
+            if (sequence_step != NO_SEQUENCE_STEP)
+            {
+                pnp -> sequence_report.result[sequence_step] = SEQUENCE_STEP_DONE;
+                pnp -> sequence_report.finish_time[sequence_step] = sim_time;
+                sequence_step = NO_SEQUENCE_STEP;
+            }
+            if (isSequenceRunning(&sequence) == FALSE && program.running == FALSE)
+            {
+                pnp -> ready_for_next_instruction = TRUE;
+                handshake_start_time = sim_time;
+            }
             //sem_post(sem_Sim); // allowing the Controller to access the shared memory for next instruction
         }
 
-        sleepMilliseconds((long) 1000 / POLL_LOOP_RATE);
+        /* splice new reels onto empty feeders once the operator has had time to do so */
+        while (number_of_empty_feeders > 0)
+        {
+            int feeder = spliceNextEmptyFeeder(feeder_status, &machine, sim_time);
+            if (feeder == NO_SPLICED_FEEDER) break;
+            number_of_empty_feeders--;
+            pnp -> feeder_status[feeder] = feeder_status[feeder];
+            postFeederEvent(pnp, FEEDER_EVENT_SPLICED, feeder, sim_time);
+            formatLogMessage(&log_line, sim_time, "New reel of ");
+            addLogInteger(&log_line, feeder_status[feeder].parts_remaining);
+            addLogText(&log_line, " parts spliced onto feeder ");
+            addLogInteger(&log_line, feeder);
+            addLogText(&log_line, "\n");
+            writeDisplayLog(log_line.text);
+        }
+
+        sleepSimulatedTime((double) 1 / POLL_LOOP_RATE);
         sim_time += (double) 1 / POLL_LOOP_RATE;
 
         /* update shared memory for simulation time (since this must always be updated every poll cycle) */
 
         pnp -> sim_time = sim_time;
+        pnp -> simulator_heartbeat++;
     }
     // if program is terminated early, need to wait for controller to terminate first
     sem_wait(sem_Contrl);
-    sprintf(Sim_str_array, "Time: %7.2f  Terminating...\n", sim_time);
-    write(writeSimToDisplayFd, Sim_str_array, strlen(Sim_str_array));
-    close(writeSimToDisplayFd);
-    /* unmap memory and close file descriptor before exit */
-    sleep(1);
+    snprintf(log_line.text, sizeof(log_line.text), SIMULATION_SUMMARY_FORMAT, sim_time, number_of_placed_parts, number_of_dropped_parts,
+            pcb_load_time, pcb_unload_time);
+    writeDisplayLog(log_line.text);
+    formatLogMessage(&log_line, sim_time, "Terminating...\n");
+    writeDisplayLog(log_line.text);
+    closeDisplayLog();
+    /* unmap memory before exit */
     resetPnP(pnp, 0.0);
     munmap(pnp, sizeof(PnP));
-    close(fd);
+    removePnP();
     sem_close(sem_Startup);
     sem_close(sem_Sim);
     sem_close(sem_Contrl);
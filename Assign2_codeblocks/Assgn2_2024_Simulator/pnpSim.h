@@ -14,98 +14,40 @@
 #include <unistd.h>
 #include <time.h>
 #include <math.h>
+#include <string.h>
+#include "../Assgn2_2024_Common/pnpShared.h"
 
-#define MEMORY_MAPPED_FILE "pnp_shared_file"
-
-#define MAX_NUMBER_OF_COMPONENTS_TO_PLACE 100
-
-#define HOME_X 0.0
-#define HOME_Y 0.0
-
-#define MIN_X -200.0
-#define MIN_Y -200.0
-#define MAX_X +1000.0
-#define MAX_Y +1000.0
-
-#define NUMBER_OF_FEEDERS 10
-#define NO_PICKED_PART -1
-#define NO_TAPE_FEEDER_AT_THIS_LOCATION -1
-#define FDR_0_X +50.0
-#define FDR_1_X +150.0
-#define FDR_2_X +250.0
-#define FDR_3_X +350.0
-#define FDR_4_X +450.0
-#define FDR_5_X +550.0
-#define FDR_6_X +650.0
-#define FDR_7_X +750.0
-#define FDR_8_X +850.0
-#define FDR_9_X +950.0
-#define FDR_0_Y -100.0
-#define FDR_1_Y -100.0
-#define FDR_2_Y -100.0
-#define FDR_3_Y -100.0
-#define FDR_4_Y -100.0
-#define FDR_5_Y -100.0
-#define FDR_6_Y -100.0
-#define FDR_7_Y -100.0
-#define FDR_8_Y -100.0
-#define FDR_9_Y -100.0
-
-#define LOOKUP_CAMERA_X -100
-#define LOOKUP_CAMERA_Y +100
-#define PHOTO_LOOKUP 0
-#define PHOTO_LOOKDOWN 1
 #define MAX_THETA_PICK_MISALIGNMENT 10   // maximum of +or-5 degrees misalignment
 #define MAX_X_PREPLACE_MISALIGNMENT 20   // maximum of +or-10 units misalignment
 #define MAX_Y_PREPLACE_MISALIGNMENT 20   // maximum of +or-10 units misalignment
+#define BOARD_EDGE_MARGIN 20.0           // the head is over the board this far beyond its edge, more than the head positioning error
 
 #define POLL_LOOP_RATE 100               // poll loops per second - must be more than the controller
 
-#define TRUE 1
-#define FALSE 0
-
-#define NUMBER_OF_NOZZLES 3
-#define LEFT_NOZZLE 0
-#define CENTRE_NOZZLE 1
-#define RIGHT_NOZZLE 2
-
-#define NOZZLE_X_SEPARATION 20
-
-#define NO_INSTRUCTION 0
-#define MOVE_HEAD 1
-#define ROTATE_NOZZLE 2
-#define LOWER_NOZZLE 3
-#define RAISE_NOZZLE 4
-#define APPLY_VACUUM 5
-#define RELEASE_VACUUM 6
-#define TAKE_PHOTO 7
-#define AMEND_HEAD_POSITION 8
-#define LOAD_PCB 9
-#define UNLOAD_PCB 10
-
-#define HEAD_FULL_SPEED 1000.0    // 1000 units per second
-#define NOZZLE_ROTATE_SPEED 360.0 // 360 degrees per second
-#define NOZZLE_LOWER_TIME 0.1     // 0.1 seconds
-#define NOZZLE_RAISE_TIME 0.1     // 0.1 seconds
-#define VACUUM_APPLY_TIME 0.05    // 0.05 seconds
-#define VACUUM_RELEASE_TIME 0.05  // 0.05 seconds
-#define PHOTO_TAKE_TIME 0.05      // 0.05 seconds
-#define PCB_LOAD_UNLOAD_TIME 1.5   // 1.5 seconds
+#define FEEDER_INDEX_BUCKETS 1024        // power of two, at least twice MAX_NUMBER_OF_FEEDERS to keep probe chains short
+#define FEEDER_INDEX_CELL_SIZE 1.0       // feeder positions are quantised onto a grid of this pitch
+#define FEEDER_LOCATION_TOLERANCE 0.01   // a nozzle within this distance (in x and y) of a feeder is over that feeder
+#define EMPTY_FEEDER_INDEX_BUCKET -1
 
-typedef struct
-{
-    int ready_for_next_instruction;
-    double sim_time;
-    double theta_pick_error[NUMBER_OF_NOZZLES];
-    double x_preplace_error;
-    double y_preplace_error;
-    int instruction_to_execute;
-    double instruction_argument_1;
-    double instruction_argument_2;
-    int instruction_argument_3;
-    int quit;
-
-} PnP;
+#define FEEDER_PICK_OK 0
+#define FEEDER_PICK_OK_REEL_NOW_EMPTY 1  // the part picked was the last on the reel
+#define FEEDER_PICK_TAPE_NOT_ADVANCED -1 // the tape is still indexing after the previous pick
+#define FEEDER_PICK_REEL_EMPTY -2        // waiting for a new reel to be spliced
+#define NO_SPLICED_FEEDER -1
+
+#define AMEND_BY_PREPLACE_ERROR 100      // sequence step only, amends the head position to cancel the error seen by the last lookdown photo
+
+#define NO_CAMERA_CROSSING -1.0
+#define FLY_OVER_PATH_POINTS 4           // start, sweep into the camera, sweep out of the camera, target
+
+#define ANALYTICS_FILE_ENV "PNP_ANALYTICS"  // base name of the placement analytics reports, or "none" for no reports
+#define ANALYTICS_FILE "pnp_analytics"     // the reports are written to <base name>.csv and <base name>.json
+#define ANALYTICS_FILE_NAME_LENGTH 256
+#define ANALYTICS_MATCH_RADIUS 5.0       // a placement further than this from every unplaced target for its feeder is unmatched
+#define ANALYTICS_NO_SPREAD 1e-9         // a standard deviation this small is rounding, so gives no Cpk
+#define NO_TARGET -1
+
+#define NO_HANDSHAKE -1.0                // the simulator is busy, or has already taken the controller's next instruction
 
 typedef struct
 {
@@ -116,11 +58,148 @@ typedef struct
 
 } PlacedPart;
 
+typedef struct
+{
+    int length;
+    int next;                                // the step to carry out next
+    int instruction[MAX_SEQUENCE_LENGTH];
+    double argument_1[MAX_SEQUENCE_LENGTH];
+    double argument_2[MAX_SEQUENCE_LENGTH];
+    int argument_3[MAX_SEQUENCE_LENGTH];
+
+} InstructionSequence;
+
+typedef struct
+{
+    int length;
+    ProgramStep step[MAX_PROGRAM_LENGTH];
+    int running;
+    int program_counter;
+    int index;                               // the index register, for loops
+    int last_rejected;                       // TRUE if the simulator rejected the last instruction of the program
+    int steps_executed;
+
+} MicroProgram;
+
+typedef struct
+{
+    long cell_x[FEEDER_INDEX_BUCKETS];
+    long cell_y[FEEDER_INDEX_BUCKETS];
+    double feeder_x[FEEDER_INDEX_BUCKETS];
+    double feeder_y[FEEDER_INDEX_BUCKETS];
+    int feeder[FEEDER_INDEX_BUCKETS];
+
+} FeederIndex;
+
+/* count, mean, sum of squared deviations from the mean (Welford), smallest and largest of a stream of values */
+typedef struct
+{
+    unsigned long n;
+    double mean;
+    double m2;
+    double min;
+    double max;
+
+} RunningStats;
+
+typedef struct
+{
+    unsigned long placed;
+    unsigned long dropped;
+    unsigned long in_spec;
+    RunningStats position_error;             // distance from the target
+    RunningStats rotation_error;             // absolute, degrees
+
+} PlacementGroupStats;
+
+/* the placements of one board judged against their targets, kept as running totals so each placement costs O(1) */
+typedef struct
+{
+    int number_of_targets;
+    PlacementTarget target[MAX_NUMBER_OF_COMPONENTS_TO_PLACE];
+    int target_placed[MAX_NUMBER_OF_COMPONENTS_TO_PLACE];
+    long cell_x[FEEDER_INDEX_BUCKETS];       // hash grid of the targets, as the feeder index
+    long cell_y[FEEDER_INDEX_BUCKETS];
+    int target_in_bucket[FEEDER_INDEX_BUCKETS];
+    double placement_tolerance;
+    double rotation_tolerance;
+    char file_name[ANALYTICS_FILE_NAME_LENGTH];  // the base name, empty for no reports
+    FILE *csv;
+    double load_time;
+    unsigned long placed;
+    unsigned long dropped;
+    unsigned long unmatched;                 // placed nowhere near a target for their feeder
+    unsigned long in_spec;
+    RunningStats x_error;
+    RunningStats y_error;
+    RunningStats position_error;
+    RunningStats rotation_error;
+    PlacementGroupStats feeder[MAX_NUMBER_OF_FEEDERS];
+    PlacementGroupStats nozzle[MAX_NUMBER_OF_NOZZLES];
+
+} PlacementAnalytics;
+
 void resetPnP(PnP*, double);
 
 void sleepMilliseconds(long ms);
 
-int getTapeFeederNumberAtLocation(double, double);
+int getFeederIndexBucket(long, long);
+
+void buildFeederIndex(FeederIndex*, const MachineConfig*);
+
+int getTapeFeederNumberAtLocation(const FeederIndex*, double, double);
+
+int getNozzlePackage(const FeederIndex*, const MachineConfig*, const int[], const int[], double, double, int);
+
+void resetFeederBank(FeederStatus[MAX_NUMBER_OF_FEEDERS], const MachineConfig*);
+
+int pickPartFromFeeder(FeederStatus*, const MachineConfig*, int, double);
+
+int spliceNextEmptyFeeder(FeederStatus[MAX_NUMBER_OF_FEEDERS], const MachineConfig*, double);
+
+void postFeederEvent(PnP*, int, int, double);
+
+void recordInstruction(SimulatorStats*, int, double);
+
+void recordHandshake(SimulatorStats*, double);
+
+double getCameraCrossingDistance(double, double, double, double, double, double, double);
+
+void setRandomBoardTransform(BoardTransform*, const MachineConfig*);
+
+int getFiducialInView(const MachineConfig*, const BoardTransform*, double, double);
+
+int isHeadOverBoard(const MachineConfig*, double, double);
+
+void setRandomHeadPositioningError(double*, double*);
+
+void clearSequence(InstructionSequence*);
+
+int addSequenceStep(InstructionSequence*, int, double, double, int);
+
+int isSequenceRunning(const InstructionSequence*);
+
+int getNextSequenceStep(InstructionSequence*, int*, double*, double*, int*);
+
+int loadProgram(MicroProgram*, const ProgramArea*);
+
+int getNextProgramInstruction(MicroProgram*, const MachineConfig*, const FeederStatus[], const int[], double, ProgramStep*);
+
+void addRunningValue(RunningStats*, double);
+
+double getRunningStandardDeviation(const RunningStats*);
+
+void startPlacementAnalytics(PlacementAnalytics*, const PlacementTarget[], int, const MachineConfig*, double);
+
+int recordPlacement(PlacementAnalytics*, int, int, double, double, double, double);
+
+void recordDrop(PlacementAnalytics*, int, int);
+
+void finishPlacementAnalytics(PlacementAnalytics*, const MachineConfig*, double);
+
+int isAnyNozzleDown(int[MAX_NUMBER_OF_NOZZLES], int);
+
+unsigned int getSimulationSeed();
 
 
 
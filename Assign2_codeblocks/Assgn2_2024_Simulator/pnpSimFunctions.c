@@ -14,7 +14,7 @@
  ------------------
  Written by Jason Brown
  Date: 30/03/2024
- Version 1.0
+ Version 1.6
  Purpose: resets the fields of a PnP struct
  Argument(s):
  PnP *pnp - pointer to the pick and place machine system to be reset
@@ -27,7 +27,7 @@ void resetPnP(PnP *pnp, double init_sim_time)
 
     pnp -> sim_time = init_sim_time;
     pnp -> ready_for_next_instruction = TRUE;
-    for (int i = 0; i < NUMBER_OF_NOZZLES; i++)
+    for (int i = 0; i < MAX_NUMBER_OF_NOZZLES; i++)
     {
         pnp -> theta_pick_error[i] = 0.0;
     }
@@ -37,7 +37,21 @@ void resetPnP(PnP *pnp, double init_sim_time)
     pnp -> instruction_argument_1 = 0.0;
     pnp -> instruction_argument_2 = 0.0;
     pnp -> instruction_argument_3 = 0;
+    pnp -> instruction_not_before = NO_INSTRUCTION_HOLD;
     pnp -> quit = FALSE;
+    pnp -> machine_config_published = FALSE;
+    pnp -> number_of_feeder_events = 0;
+    pnp -> fiducial_in_view = NO_FIDUCIAL;
+    pnp -> fiducial_offset_x = 0.0;
+    pnp -> fiducial_offset_y = 0.0;
+    pnp -> sequence_report.number_of_steps = 0;
+    pnp -> program.length = 0;
+    pnp -> program.status = PROGRAM_IDLE;
+    pnp -> parties_ready = 0;
+    for (int i = 0; i < MAX_NUMBER_OF_FEEDERS; i++)
+    {   /* until the controller says what is loaded on each feeder */
+        pnp -> feeder_package[i] = NO_PACKAGE;
+    }
 
 }
 
@@ -65,36 +79,728 @@ void sleepMilliseconds(long ms)
 
 }
 
+/*
+ Function: getFeederIndexBucket
+ ------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: hashes a quantised grid cell to the first bucket of the feeder index to probe
+ Argument(s):
+ long cell_x - the x grid cell
+ long cell_y - the y grid cell
+ Return Value: a bucket number from 0 to FEEDER_INDEX_BUCKETS-1
+ Usage: int bucket = getFeederIndexBucket(cell_x, cell_y);
+ */
+int getFeederIndexBucket(long cell_x, long cell_y)
+{
+
+    unsigned long hash = (unsigned long)cell_x * 73856093UL ^ (unsigned long)cell_y * 19349663UL;
+
+    return (int)(hash & (FEEDER_INDEX_BUCKETS - 1));
+
+}
+
+/*
+ Function: buildFeederIndex
+ --------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: builds a hash grid of the tape feeder positions, keyed on the position quantised
+ to FEEDER_INDEX_CELL_SIZE, so that the feeder under a nozzle can be found in constant time
+ however many feeders are fitted. Should be called once after the machine description is read.
+ Argument(s):
+ FeederIndex *feeder_index - the index to build
+ const MachineConfig *machine - the machine description holding the feeder positions
+ Return Value: none
+ Usage: buildFeederIndex(&feeder_index, &machine);
+ */
+void buildFeederIndex(FeederIndex *feeder_index, const MachineConfig *machine)
+{
+
+    for (int i = 0; i < FEEDER_INDEX_BUCKETS; i++)
+    {
+        feeder_index -> feeder[i] = EMPTY_FEEDER_INDEX_BUCKET;
+    }
+
+    for (int i = 0; i < machine -> number_of_feeders; i++)
+    {
+        long cell_x = lround(machine -> feeder_x[i] / FEEDER_INDEX_CELL_SIZE);
+        long cell_y = lround(machine -> feeder_y[i] / FEEDER_INDEX_CELL_SIZE);
+        int bucket = getFeederIndexBucket(cell_x, cell_y);
+
+        /* linear probing, there are always empty buckets since FEEDER_INDEX_BUCKETS > MAX_NUMBER_OF_FEEDERS */
+        while (feeder_index -> feeder[bucket] != EMPTY_FEEDER_INDEX_BUCKET)
+        {
+            bucket = (bucket + 1) & (FEEDER_INDEX_BUCKETS - 1);
+        }
+        feeder_index -> cell_x[bucket] = cell_x;
+        feeder_index -> cell_y[bucket] = cell_y;
+        feeder_index -> feeder_x[bucket] = machine -> feeder_x[i];
+        feeder_index -> feeder_y[bucket] = machine -> feeder_y[i];
+        feeder_index -> feeder[bucket] = i;
+    }
+
+}
+
 /*
  Function: getTapeFeederNumberAtLocation
  ---------------------------------------
  Written by Jason Brown
  Date: 30/03/2024
- Version 1.0
+ Version 2.0
  Purpose: find the number of the tape feeder at the location with
- co-ordinates (x,y), else return NO_TAPE_FEEDER_AT_THIS_LOCATION (-1)
- if there is no tape feeder at
- that location
+ co-ordinates (x,y), to within FEEDER_LOCATION_TOLERANCE, else return
+ NO_TAPE_FEEDER_AT_THIS_LOCATION (-1) if there is no tape feeder at
+ that location. Only the grid cells within the tolerance of (x,y) are
+ probed (at most four), so the lookup does not depend on the number of feeders.
  Argument(s):
+ const FeederIndex *feeder_index - the index built from the feeder positions by buildFeederIndex
  double x - x co-ordinate
  double y - y co-ordinate
  Return Value: the number of the tape feeder at the location with
  co-ordinates (x,y), else NO_TAPE_FEEDER_AT_THIS_LOCATION (-1)
  if there is no tape feeder at that location
- Usage: int tape_feed_number = getTapeFeederNumberAtLocation(x,y);
+ Usage: int tape_feed_number = getTapeFeederNumberAtLocation(&feeder_index, x, y);
  */
-int getTapeFeederNumberAtLocation(double x, double y)
+int getTapeFeederNumberAtLocation(const FeederIndex *feeder_index, double x, double y)
 {
 
-    const double TAPE_FEEDER_X[NUMBER_OF_FEEDERS] = {FDR_0_X, FDR_1_X, FDR_2_X, FDR_3_X, FDR_4_X, FDR_5_X, FDR_6_X, FDR_7_X, FDR_8_X, FDR_9_X};
-    const double TAPE_FEEDER_Y[NUMBER_OF_FEEDERS] = {FDR_0_Y, FDR_1_Y, FDR_2_Y, FDR_3_Y, FDR_4_Y, FDR_5_Y, FDR_6_Y, FDR_7_Y, FDR_8_Y, FDR_9_Y};
+    long first_cell_x = lround((x - FEEDER_LOCATION_TOLERANCE) / FEEDER_INDEX_CELL_SIZE);
+    long last_cell_x = lround((x + FEEDER_LOCATION_TOLERANCE) / FEEDER_INDEX_CELL_SIZE);
+    long first_cell_y = lround((y - FEEDER_LOCATION_TOLERANCE) / FEEDER_INDEX_CELL_SIZE);
+    long last_cell_y = lround((y + FEEDER_LOCATION_TOLERANCE) / FEEDER_INDEX_CELL_SIZE);
 
-    for (int i = 0; i < NUMBER_OF_FEEDERS; i++)
+    for (long cell_x = first_cell_x; cell_x <= last_cell_x; cell_x++)
     {
+        for (long cell_y = first_cell_y; cell_y <= last_cell_y; cell_y++)
+        {
+            int bucket = getFeederIndexBucket(cell_x, cell_y);
 
-        if (x == TAPE_FEEDER_X[i] && y == TAPE_FEEDER_Y[i]) return i;
-
+            while (feeder_index -> feeder[bucket] != EMPTY_FEEDER_INDEX_BUCKET)
+            {
+                if (feeder_index -> cell_x[bucket] == cell_x && feeder_index -> cell_y[bucket] == cell_y
+                    && fabs(x - feeder_index -> feeder_x[bucket]) <= FEEDER_LOCATION_TOLERANCE
+                    && fabs(y - feeder_index -> feeder_y[bucket]) <= FEEDER_LOCATION_TOLERANCE) return feeder_index -> feeder[bucket];
+                bucket = (bucket + 1) & (FEEDER_INDEX_BUCKETS - 1);
+            }
+        }
     }
     return NO_TAPE_FEEDER_AT_THIS_LOCATION;
 
 }
+
+/*
+ Function: getNozzlePackage
+ --------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ finds the package of the part a nozzle is handling: the part it holds, else the part in the pick position of
+ the feeder underneath it, so that picking and placing are timed for the part
+ Argument(s):
+ const FeederIndex *feeder_index - the index built from the feeder positions by buildFeederIndex
+ const MachineConfig *machine - the machine description, for the nozzle offsets
+ const int feeder_package[] - the package loaded on each feeder, as published by the controller
+ const int nozzle_picked_part[] - the feeder the part on each nozzle came from, else NO_PICKED_PART
+ double x, y - the position of the head
+ int nozzle - the nozzle
+ Return Value: the package of the part, else NO_PACKAGE (-1) if there is none or it is not in the component library
+ Usage: int package = getNozzlePackage(&feeder_index, &machine, feeder_package, nozzle_picked_part, x, y, nozzle);
+ */
+int getNozzlePackage(const FeederIndex *feeder_index, const MachineConfig *machine, const int feeder_package[],
+                     const int nozzle_picked_part[], double x, double y, int nozzle)
+{
+
+    int feeder = nozzle_picked_part[nozzle];
+
+    if (feeder == NO_PICKED_PART) feeder = getTapeFeederNumberAtLocation(feeder_index, x + machine -> nozzle_x_offset[nozzle], y + machine -> nozzle_y_offset[nozzle]);
+    if (feeder == NO_TAPE_FEEDER_AT_THIS_LOCATION) return NO_PACKAGE;
+    return feeder_package[feeder];
+
+}
+
+/*
+ Function: resetFeederBank
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: loads a full reel onto every feeder, with the first part already in the pick position
+ Argument(s):
+ FeederStatus feeder_status[] - the status of each feeder
+ const MachineConfig *machine - the machine description giving the reel size of each feeder
+ Return Value: none
+ Usage: resetFeederBank(feeder_status, &machine);
+ */
+void resetFeederBank(FeederStatus feeder_status[MAX_NUMBER_OF_FEEDERS], const MachineConfig *machine)
+{
+
+    for (int i = 0; i < MAX_NUMBER_OF_FEEDERS; i++)
+    {
+        if (machine -> feeder_parts_per_reel[i] == 0) feeder_status[i].parts_remaining = FEEDER_PARTS_UNLIMITED;
+        else feeder_status[i].parts_remaining = machine -> feeder_parts_per_reel[i];
+        feeder_status[i].ready_time = 0.0;
+        feeder_status[i].number_of_picks = 0;
+        feeder_status[i].number_of_splices = 0;
+    }
+
+}
+
+/*
+ Function: pickPartFromFeeder
+ ----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: takes the part in the pick position of a feeder if the tape has finished advancing and
+ the reel is not empty, then starts advancing the tape to the next part. Once the last part on
+ the reel has been picked the feeder is unavailable until a new reel has been spliced on, which
+ takes machine -> splice_time.
+ Argument(s):
+ FeederStatus *feeder_status - the status of the feeder being picked from
+ const MachineConfig *machine - the machine description
+ int feeder - the feeder number
+ double sim_time - the current simulation time
+ Return Value:
+ one of:
+ FEEDER_PICK_OK (0)
+ FEEDER_PICK_OK_REEL_NOW_EMPTY (1)
+ FEEDER_PICK_TAPE_NOT_ADVANCED (-1)
+ FEEDER_PICK_REEL_EMPTY (-2)
+ Usage: int res = pickPartFromFeeder(&feeder_status[feeder], &machine, feeder, sim_time);
+ */
+int pickPartFromFeeder(FeederStatus *feeder_status, const MachineConfig *machine, int feeder, double sim_time)
+{
+
+    if (feeder_status -> parts_remaining == 0) return FEEDER_PICK_REEL_EMPTY;
+    if (sim_time < feeder_status -> ready_time) return FEEDER_PICK_TAPE_NOT_ADVANCED;
+
+    feeder_status -> number_of_picks++;
+    if (feeder_status -> parts_remaining != FEEDER_PARTS_UNLIMITED) feeder_status -> parts_remaining--;
+    if (feeder_status -> parts_remaining == 0)
+    {
+        feeder_status -> ready_time = sim_time + machine -> splice_time;
+        return FEEDER_PICK_OK_REEL_NOW_EMPTY;
+    }
+    feeder_status -> ready_time = sim_time + machine -> feeder_advance_time[feeder];
+    return FEEDER_PICK_OK;
+
+}
+
+/*
+ Function: spliceNextEmptyFeeder
+ -------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: finds an empty feeder whose new reel has finished being spliced on, and refills it.
+ Call repeatedly until NO_SPLICED_FEEDER is returned to refill every such feeder.
+ Argument(s):
+ FeederStatus feeder_status[] - the status of each feeder
+ const MachineConfig *machine - the machine description
+ double sim_time - the current simulation time
+ Return Value: the number of the feeder refilled, else NO_SPLICED_FEEDER (-1)
+ Usage: while ((feeder = spliceNextEmptyFeeder(feeder_status, &machine, sim_time)) != NO_SPLICED_FEEDER) {...}
+ */
+int spliceNextEmptyFeeder(FeederStatus feeder_status[MAX_NUMBER_OF_FEEDERS], const MachineConfig *machine, double sim_time)
+{
+
+    for (int i = 0; i < machine -> number_of_feeders; i++)
+    {
+        if (feeder_status[i].parts_remaining == 0 && sim_time >= feeder_status[i].ready_time)
+        {
+            feeder_status[i].parts_remaining = machine -> feeder_parts_per_reel[i];
+            feeder_status[i].number_of_splices++;
+            return i;
+        }
+    }
+    return NO_SPLICED_FEEDER;
+
+}
+
+/*
+ Function: postFeederEvent
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: reports a feeder event to the controller through the event queue in shared memory.
+ The queue holds the last FEEDER_EVENT_QUEUE_LENGTH events, and the event is written before
+ the count is incremented so that the controller never reads a half written event.
+ Argument(s):
+ PnP *pnp - pointer to the shared pick and place machine system
+ int type - FEEDER_EVENT_EMPTY or FEEDER_EVENT_SPLICED
+ int feeder - the feeder number
+ double sim_time - the current simulation time
+ Return Value: none
+ Usage: postFeederEvent(pnp, FEEDER_EVENT_EMPTY, feeder, sim_time);
+ */
+void postFeederEvent(PnP *pnp, int type, int feeder, double sim_time)
+{
+
+    FeederEvent *event = &pnp -> feeder_event[pnp -> number_of_feeder_events % FEEDER_EVENT_QUEUE_LENGTH];
+
+    event -> type = type;
+    event -> feeder = feeder;
+    event -> time = sim_time;
+    __sync_synchronize();
+    pnp -> number_of_feeder_events++;
+
+}
+
+/*
+ Function: recordInstruction
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: adds an instruction that has finished to the running totals in shared memory
+ Argument(s):
+ SimulatorStats *stats - the simulator's running totals in shared memory
+ int instruction - the instruction, e.g. MOVE_HEAD
+ double duration - the simulation time it took
+ Return Value: none
+ Usage: recordInstruction(&pnp -> simulator_stats, instruction_being_executed, sim_time - instruction_start_time);
+ */
+void recordInstruction(SimulatorStats *stats, int instruction, double duration)
+{
+
+    if (instruction <= NO_INSTRUCTION || instruction >= NUMBER_OF_INSTRUCTIONS) return;
+    stats -> instruction_count[instruction]++;
+    stats -> instruction_time[instruction] += duration;
+
+}
+
+/*
+ Function: recordHandshake
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ adds the time from the simulator finishing an instruction to it taking the controller's next one to the
+ running totals in shared memory, in the first bucket of HANDSHAKE_BUCKET_LIMITS it fits
+ Argument(s):
+ SimulatorStats *stats - the simulator's running totals in shared memory
+ double latency - the simulation time the handshake took
+ Return Value: none
+ Usage: recordHandshake(&pnp -> simulator_stats, sim_time - handshake_start_time);
+ */
+void recordHandshake(SimulatorStats *stats, double latency)
+{
+
+    static const double bucket_limit[NUMBER_OF_HANDSHAKE_BUCKETS] = HANDSHAKE_BUCKET_LIMITS;
+    int bucket = 0;
+
+    while (bucket < NUMBER_OF_HANDSHAKE_BUCKETS && latency > bucket_limit[bucket] + 1e-9) bucket++;  // sim_time is a sum of poll periods
+    stats -> handshake_bucket[bucket]++;
+    stats -> handshake_time += latency;
+    stats -> handshake_count++;
+
+}
+
+/*
+ Function: getCameraCrossingDistance
+ -----------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: determines whether a nozzle moving in a straight line passes through the field of view of
+ the lookup camera, and if so how far along the line it is closest to the camera centre (which is
+ where the strobe fires to take the photo in flight)
+ Argument(s):
+ double x_from, y_from - the start of the line
+ double x_to, y_to - the end of the line
+ double camera_x, camera_y - the centre of the camera
+ double window - the radius of the field of view of the camera
+ Return Value: the distance from the start of the line to the point nearest the camera, else
+ NO_CAMERA_CROSSING (-1.0) if the line does not pass within window of the camera
+ Usage: double d = getCameraCrossingDistance(x, y, x_target, y_target, machine.lookup_camera_x, machine.lookup_camera_y, machine.lookup_camera_window);
+ */
+double getCameraCrossingDistance(double x_from, double y_from, double x_to, double y_to, double camera_x, double camera_y, double window)
+{
+
+    double dx = x_to - x_from, dy = y_to - y_from;
+    double length = sqrt(dx * dx + dy * dy);
+    double along = 0.0;
+
+    if (length > 0.0)
+    {   /* project the camera centre onto the line, clamped to the ends of the line */
+        along = ((camera_x - x_from) * dx + (camera_y - y_from) * dy) / length;
+        if (along < 0.0) along = 0.0;
+        if (along > length) along = length;
+        if (hypot(x_from + dx * along / length - camera_x, y_from + dy * along / length - camera_y) > window) return NO_CAMERA_CROSSING;
+    }
+    else if (hypot(x_from - camera_x, y_from - camera_y) > window) return NO_CAMERA_CROSSING;
+    return along;
+
+}
+
+/*
+ Function: setRandomBoardTransform
+ ---------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: chooses where a newly loaded board sits in the machine, with a random offset, rotation and
+ scale error up to the limits given in the machine description
+ Argument(s):
+ BoardTransform *board - set to the position of the board
+ const MachineConfig *machine - the machine description
+ Return Value: none
+ Usage: setRandomBoardTransform(&board, &machine);
+ */
+void setRandomBoardTransform(BoardTransform *board, const MachineConfig *machine)
+{
+
+    board -> offset_x = machine -> board_max_offset * (2.0 * rand() / RAND_MAX - 1.0);
+    board -> offset_y = machine -> board_max_offset * (2.0 * rand() / RAND_MAX - 1.0);
+    board -> rotation = machine -> board_max_rotation * (2.0 * rand() / RAND_MAX - 1.0);
+    board -> scale = 1.0 + machine -> board_max_scale_error * (2.0 * rand() / RAND_MAX - 1.0);
+
+}
+
+/*
+ Function: getFiducialInView
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: finds the board fiducial, if any, in the field of view of the lookdown camera
+ Argument(s):
+ const MachineConfig *machine - the machine description giving the fiducial positions on the board
+ const BoardTransform *board - the position of the board in the machine
+ double x, y - the position of the head
+ Return Value: the number of the fiducial in view, else NO_FIDUCIAL (-1)
+ Usage: int fiducial = getFiducialInView(&machine, &board, x, y);
+ */
+int getFiducialInView(const MachineConfig *machine, const BoardTransform *board, double x, double y)
+{
+
+    double fiducial_x, fiducial_y;
+
+    for (int i = 0; i < machine -> number_of_fiducials; i++)
+    {
+        boardToMachine(board, machine -> fiducial_x[i], machine -> fiducial_y[i], &fiducial_x, &fiducial_y);
+        if (hypot(fiducial_x - x, fiducial_y - y) <= machine -> lookdown_camera_window) return i;
+    }
+    return NO_FIDUCIAL;
+
+}
+
+/*
+ Function: isHeadOverBoard
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ finds whether the head, sent to a position, is over the board rather than the feeders or the lookup camera.
+ The board lies at x >= 0 and y >= 0, widened by BOARD_EDGE_MARGIN and how far out the board may be loaded,
+ so that a placement near the edge of the board still counts when the controller corrects for the board
+ position or the head positioning error.
+ Argument(s):
+ const MachineConfig *machine - the machine description giving the board load error
+ double x, y - the position the head was sent to
+ Return Value: TRUE if the head is over the board, else FALSE
+ Usage: if (isHeadOverBoard(&machine, x_nominal, y_nominal) == TRUE) {...}
+ */
+int isHeadOverBoard(const MachineConfig *machine, double x, double y)
+{
+
+    double margin = BOARD_EDGE_MARGIN + machine -> board_max_offset;
+
+    return x >= -margin && y >= -margin;
+
+}
+
+/*
+ Function: setRandomHeadPositioningError
+ ---------------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ sets how far from where it is sent the gantry stops the head over the board. The gantry is repeatable, so the
+ error is the same on every move: a lookdown photo at each placement or fitting the board to its fiducials
+ both take it out.
+ Argument(s):
+ double *x_error, *y_error - receive the positioning error, within +or-half MAX_X/Y_PREPLACE_MISALIGNMENT
+ Return Value: none
+ Usage: setRandomHeadPositioningError(&x_head_error, &y_head_error);
+ */
+void setRandomHeadPositioningError(double *x_error, double *y_error)
+{
+
+    *x_error = MAX_X_PREPLACE_MISALIGNMENT * (double)rand()/RAND_MAX - MAX_X_PREPLACE_MISALIGNMENT / 2;
+    *y_error = MAX_Y_PREPLACE_MISALIGNMENT * (double)rand()/RAND_MAX - MAX_Y_PREPLACE_MISALIGNMENT / 2;
+
+}
+
+/*
+ Function: clearSequence
+ -----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: empties an instruction sequence, abandoning any steps not yet carried out
+ Argument(s):
+ InstructionSequence *sequence - the sequence to clear
+ Return Value: none
+ Usage: clearSequence(&sequence);
+ */
+void clearSequence(InstructionSequence *sequence)
+{
+
+    sequence -> length = 0;
+    sequence -> next = 0;
+
+}
+
+/*
+ Function: addSequenceStep
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: adds an instruction to the end of an instruction sequence
+ Argument(s):
+ InstructionSequence *sequence - the sequence to add to
+ int instruction - the instruction, e.g. MOVE_HEAD
+ double argument_1, argument_2, int argument_3 - the instruction arguments, as they would be passed in shared memory
+ Return Value: TRUE (1) if the step was added, FALSE (0) if the sequence is full
+ Usage: addSequenceStep(&sequence, TAKE_PHOTO, 0.0, 0.0, PHOTO_LOOKDOWN);
+ */
+int addSequenceStep(InstructionSequence *sequence, int instruction, double argument_1, double argument_2, int argument_3)
+{
+
+    if (sequence -> length >= MAX_SEQUENCE_LENGTH) return FALSE;
+    sequence -> instruction[sequence -> length] = instruction;
+    sequence -> argument_1[sequence -> length] = argument_1;
+    sequence -> argument_2[sequence -> length] = argument_2;
+    sequence -> argument_3[sequence -> length] = argument_3;
+    sequence -> length++;
+    return TRUE;
+
+}
+
+/*
+ Function: isSequenceRunning
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: determines whether an instruction sequence has steps still to be carried out
+ Argument(s):
+ const InstructionSequence *sequence - the sequence
+ Return Value: TRUE (1) if there are steps still to carry out, otherwise FALSE (0)
+ Usage: if (isSequenceRunning(&sequence) == FALSE) pnp -> ready_for_next_instruction = TRUE;
+ */
+int isSequenceRunning(const InstructionSequence *sequence)
+{
+
+    return sequence -> next < sequence -> length;
+
+}
+
+/*
+ Function: getNextSequenceStep
+ -----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: takes the next step from an instruction sequence
+ Argument(s):
+ InstructionSequence *sequence - the sequence
+ int *instruction - set to the instruction of the step
+ double *argument_1, *argument_2, int *argument_3 - set to the arguments of the step
+ Return Value: the number of the step taken, else NO_SEQUENCE_STEP (-1) if the sequence has finished
+ Usage: int step = getNextSequenceStep(&sequence, &new_instruction, &argument_1, &argument_2, &argument_3);
+ */
+int getNextSequenceStep(InstructionSequence *sequence, int *instruction, double *argument_1, double *argument_2, int *argument_3)
+{
+
+    int step = sequence -> next;
+
+    if (step >= sequence -> length) return NO_SEQUENCE_STEP;
+    *instruction = sequence -> instruction[step];
+    *argument_1 = sequence -> argument_1[step];
+    *argument_2 = sequence -> argument_2[step];
+    *argument_3 = sequence -> argument_3[step];
+    sequence -> next++;
+    return step;
+
+}
+
+/*
+ Function: loadProgram
+ ---------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: copies a micro-program from the program area of shared memory, checking that every step is an
+ instruction or program opcode and that every jump stays within the program, and sets it running
+ Argument(s):
+ MicroProgram *program - the program to load
+ const ProgramArea *area - the program area written by the controller
+ Return Value: TRUE (1) if the program was loaded, FALSE (0) if it is not a valid program
+ Usage: if (loadProgram(&program, &pnp -> program) == TRUE) {...}
+ */
+int loadProgram(MicroProgram *program, const ProgramArea *area)
+{
+
+    int length = area -> length, opcode, target;
+
+    program -> running = FALSE;
+    if (length < 1 || length > MAX_PROGRAM_LENGTH) return FALSE;
+    for (int i = 0; i < length; i++)
+    {
+        program -> step[i] = area -> step[i];
+        opcode = program -> step[i].opcode;
+        target = program -> step[i].target;
+        if ((opcode < MOVE_HEAD || opcode >= RUN_PROGRAM) && (opcode < PROGRAM_END || opcode > PROGRAM_LOOP)) return FALSE;
+        if ((opcode == PROGRAM_JUMP || opcode == PROGRAM_JUMP_IF_REJECTED || opcode == PROGRAM_JUMP_IF_NOZZLE_EMPTY || opcode == PROGRAM_LOOP)
+            && (target < 0 || target > length)) return FALSE;
+    }
+    program -> length = length;
+    program -> program_counter = 0;
+    program -> index = 0;
+    program -> last_rejected = FALSE;
+    program -> steps_executed = 0;
+    program -> running = TRUE;
+    return TRUE;
+
+}
+
+/*
+ Function: getNextProgramInstruction
+ -----------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: runs a micro-program on to its next instruction, carrying out any jumps, loops and index register
+ steps on the way, with PROGRAM_INDEX replaced by the index register
+ Argument(s):
+ MicroProgram *program - the running program
+ const MachineConfig *machine - the machine, for the number of feeders and nozzles
+ const FeederStatus feeder_status[] - the feeder bank, for PROGRAM_WAIT_FOR_FEEDER
+ const int nozzle_picked_part[] - the part held by each nozzle, for PROGRAM_JUMP_IF_NOZZLE_EMPTY
+ double sim_time - the current simulation time
+ ProgramStep *next - set to the instruction to carry out next
+ Return Value: one of:
+ PROGRAM_RUNNING (1) - *next is the instruction to carry out
+ PROGRAM_WAITING (2) - waiting for a feeder, there is no instruction to carry out yet
+ PROGRAM_FINISHED (3) - the program has ended
+ PROGRAM_FAULTED (-1) - the program referred to a feeder or nozzle which does not exist, ran too many steps,
+ or looped without reaching an instruction
+ Usage: int res = getNextProgramInstruction(&program, &machine, feeder_status, nozzle_picked_part, sim_time, &step);
+ */
+int getNextProgramInstruction(MicroProgram *program, const MachineConfig *machine, const FeederStatus feeder_status[],
+                              const int nozzle_picked_part[], double sim_time, ProgramStep *next)
+{
+
+    int operand, next_step;
+
+    for (int control_steps = 0; control_steps <= MAX_PROGRAM_LENGTH; control_steps++)
+    {
+        if (program -> program_counter >= program -> length) return PROGRAM_FINISHED;
+        if (program -> steps_executed >= MAX_PROGRAM_STEPS_EXECUTED) return PROGRAM_FAULTED;
+        *next = program -> step[program -> program_counter];
+        if (next -> argument_3 == PROGRAM_INDEX) next -> argument_3 = program -> index;
+        operand = next -> argument_3;
+        next_step = program -> program_counter + 1;
+
+        switch (next -> opcode)
+        {
+            case PROGRAM_END:
+                return PROGRAM_FINISHED;
+
+            case PROGRAM_JUMP:
+                next_step = next -> target;
+                break;
+
+            case PROGRAM_JUMP_IF_REJECTED:
+                if (program -> last_rejected == TRUE) next_step = next -> target;
+                break;
+
+            case PROGRAM_JUMP_IF_NOZZLE_EMPTY:
+                if (operand < 0 || operand >= machine -> number_of_nozzles) return PROGRAM_FAULTED;
+                if (nozzle_picked_part[operand] == NO_PICKED_PART) next_step = next -> target;
+                break;
+
+            case PROGRAM_WAIT_FOR_FEEDER:
+                if (operand < 0 || operand >= machine -> number_of_feeders) return PROGRAM_FAULTED;
+                if (feeder_status[operand].parts_remaining == 0 || sim_time < feeder_status[operand].ready_time) return PROGRAM_WAITING;
+                break;
+
+            case PROGRAM_SET_INDEX:
+                program -> index = operand;
+                break;
+
+            case PROGRAM_LOOP:
+                program -> index++;
+                if (program -> index < operand) next_step = next -> target;
+                break;
+
+            default:    // an instruction, carried out by the simulator as if it had come from the controller
+                program -> program_counter = next_step;
+                program -> steps_executed++;
+                return PROGRAM_RUNNING;
+        }
+        program -> program_counter = next_step;
+        program -> steps_executed++;
+    }
+    return PROGRAM_FAULTED;
+
+}
+
+/*
+ Function: isAnyNozzleDown
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: checks whether any of the nozzles on the head are currently lowered
+ Argument(s):
+ int nozzle_down[] - the lowered state of each nozzle
+ int number_of_nozzles - the number of nozzles on the head
+ Return Value: TRUE (1) if one or more nozzles are down, otherwise FALSE (0)
+ Usage: if (isAnyNozzleDown(nozzle_down, number_of_nozzles) == FALSE) ...
+ */
+int isAnyNozzleDown(int nozzle_down[MAX_NUMBER_OF_NOZZLES], int number_of_nozzles)
+{
+
+    for (int i = 0; i < number_of_nozzles; i++)
+    {
+        if (nozzle_down[i] == TRUE) return TRUE;
+    }
+    return FALSE;
+
+}
+
+/*
+ Function: getSimulationSeed
+ ---------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ gets the seed of the simulated pick, preplace and board errors, from the SIMULATION_SEED_ENV environment
+ variable if it is set, as when replaying a recording, else from the clock
+ Argument(s): none
+ Return Value: the seed
+ Usage: srand(seed = getSimulationSeed());
+ */
+unsigned int getSimulationSeed()
+{
+
+    const char *value = getenv(SIMULATION_SEED_ENV);
+    unsigned int seed;
+
+    if (value != NULL && sscanf(value, "%u", &seed) == 1) return seed;
+    return (unsigned int) time(0);
+
+}
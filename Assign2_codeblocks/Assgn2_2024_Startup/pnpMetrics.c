@@ -0,0 +1,340 @@
+/*
+ *
+ * pnpMetrics.c - the metrics endpoint of Startup. When METRICS_ENV is set, Startup listens on a local TCP port
+ * or Unix socket and answers each HTTP request with the running totals the simulator and controller keep in
+ * shared memory, in the Prometheus text format, so a running machine can be scraped like any other.
+ *
+ * The endpoint is served from Startup's poll loop rather than a thread of its own: scrapes are rare, and each
+ * is answered from shared memory without locking, so a scrape never holds up the simulator or controller.
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "pnpMetrics.h"
+
+#define METRICS_ADDRESS_LENGTH 108         // the longest Unix socket path
+#define METRICS_REQUEST_SIZE 1024
+
+static char metrics_socket_path[METRICS_ADDRESS_LENGTH];  // removed again when the endpoint is closed
+
+static const char log_source_name[NUMBER_OF_LOG_SOURCES][11] = {"startup", "simulator", "controller"};
+
+/*
+ Function: openMetricsEndpoint
+ -----------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ opens the socket given in METRICS_ENV for scrapers to connect to: a Unix socket if it is a path, else a TCP
+ port given as "port" or "address:port", on METRICS_DEFAULT_ADDRESS when no address is given. Use 0.0.0.0 as
+ the address to be scraped from other machines. The socket does not block, so it can be polled.
+ Argument(s): none
+ Return Value: the listening socket, else NO_METRICS_ENDPOINT if METRICS_ENV is not set or the socket could not be opened
+ Usage: metrics_fd = openMetricsEndpoint();
+ */
+int openMetricsEndpoint()
+{
+
+    const char *value = getenv(METRICS_ENV), *port;
+    char address[METRICS_ADDRESS_LENGTH];
+    int fd, on = 1;
+
+    if (value == NULL || value[0] == '\0') return NO_METRICS_ENDPOINT;
+
+    if (strchr(value, '/') != NULL)
+    {
+        struct sockaddr_un unix_address;
+
+        memset(&unix_address, 0, sizeof(unix_address));
+        unix_address.sun_family = AF_UNIX;
+        snprintf(unix_address.sun_path, sizeof(unix_address.sun_path), "%s", value);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return NO_METRICS_ENDPOINT;
+        unlink(unix_address.sun_path);  // left behind by a run that did not finish
+        if (bind(fd, (struct sockaddr *) &unix_address, sizeof(unix_address)) != 0)
+        {
+            close(fd);
+            return NO_METRICS_ENDPOINT;
+        }
+        snprintf(metrics_socket_path, sizeof(metrics_socket_path), "%s", unix_address.sun_path);
+    }
+    else
+    {
+        struct sockaddr_in inet_address;
+
+        port = strrchr(value, ':');
+        snprintf(address, sizeof(address), "%.*s", port != NULL ? (int) (port - value) : 0, value);
+        port = port != NULL ? port + 1 : value;
+
+        memset(&inet_address, 0, sizeof(inet_address));
+        inet_address.sin_family = AF_INET;
+        inet_address.sin_port = htons(atoi(port));
+        if (atoi(port) <= 0 || inet_pton(AF_INET, address[0] != '\0' ? address : METRICS_DEFAULT_ADDRESS, &inet_address.sin_addr) != 1)
+        {
+            errno = EINVAL;
+            return NO_METRICS_ENDPOINT;
+        }
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return NO_METRICS_ENDPOINT;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (bind(fd, (struct sockaddr *) &inet_address, sizeof(inet_address)) != 0)
+        {
+            close(fd);
+            return NO_METRICS_ENDPOINT;
+        }
+    }
+
+    if (listen(fd, METRICS_BACKLOG) != 0)
+    {
+        closeMetricsEndpoint(fd);
+        return NO_METRICS_ENDPOINT;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);  // not inherited by the Display, Simulator and Controller
+    return fd;
+
+}
+
+/*
+ Function: appendMetrics
+ -----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: adds formatted text to the end of a page of metrics, as much as fits
+ Argument(s):
+ char *buffer - the page
+ size_t size - the size of the buffer
+ size_t *length - the length of the page so far, updated
+ const char *format - printf format, followed by its arguments
+ Return Value: none
+ Usage: appendMetrics(buffer, size, &length, "pnp_parts_placed_total %lu\n", stats -> parts_placed);
+ */
+static void appendMetrics(char *buffer, size_t size, size_t *length, const char *format, ...)
+{
+
+    va_list arguments;
+    int written;
+
+    if (*length >= size - 1) return;
+    va_start(arguments, format);
+    written = vsnprintf(buffer + *length, size - *length, format, arguments);
+    va_end(arguments);
+    if (written > 0) *length += (size_t) written < size - *length ? (size_t) written : size - *length - 1;
+
+}
+
+/*
+ Function: formatMetrics
+ -----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ writes the running totals kept in shared memory as a page of metrics in the Prometheus text format. Times are
+ in simulation seconds, so they are the same whatever the time scale the run is at. The totals are read without
+ locking, so a scrape taken as an instruction finishes may see it counted in one total and not yet in another.
+ Argument(s):
+ const PnP *pnp - the shared memory segment
+ const LogRing *log_ring - the log ring, else NULL
+ char *buffer - receives the page
+ size_t size - the size of the buffer
+ Return Value: the length of the page
+ Usage: length = formatMetrics(pnp, log_ring, buffer, sizeof(buffer));
+ */
+int formatMetrics(const PnP *pnp, const LogRing *log_ring, char *buffer, size_t size)
+{
+
+    static const double bucket_limit[NUMBER_OF_HANDSHAKE_BUCKETS] = HANDSHAKE_BUCKET_LIMITS;
+    const SimulatorStats *sim = &pnp -> simulator_stats;
+    const ControllerStats *controller = &pnp -> controller_stats;
+    unsigned long handshakes = 0;
+    size_t length = 0;
+    int number_of_states = controller -> number_of_states;
+
+    appendMetrics(buffer, size, &length, "# HELP pnp_simulation_time_seconds Simulation time reached.\n"
+                                         "# TYPE pnp_simulation_time_seconds gauge\n"
+                                         "pnp_simulation_time_seconds %.3f\n", pnp -> sim_time);
+    appendMetrics(buffer, size, &length, "# HELP pnp_parts_placed_total Parts placed on a PCB.\n"
+                                         "# TYPE pnp_parts_placed_total counter\n"
+                                         "pnp_parts_placed_total %lu\n", sim -> parts_placed);
+    appendMetrics(buffer, size, &length, "# HELP pnp_parts_dropped_total Parts dropped from a nozzle.\n"
+                                         "# TYPE pnp_parts_dropped_total counter\n"
+                                         "pnp_parts_dropped_total %lu\n", sim -> parts_dropped);
+    appendMetrics(buffer, size, &length, "# HELP pnp_boards_completed_total PCBs unloaded.\n"
+                                         "# TYPE pnp_boards_completed_total counter\n"
+                                         "pnp_boards_completed_total %lu\n", sim -> boards_completed);
+
+    appendMetrics(buffer, size, &length, "# HELP pnp_instructions_total Instructions carried out by the simulator, including the steps of sequences and programs.\n"
+                                         "# TYPE pnp_instructions_total counter\n");
+    for (int i = NO_INSTRUCTION + 1; i < NUMBER_OF_INSTRUCTIONS; i++)
+    {
+        appendMetrics(buffer, size, &length, "pnp_instructions_total{instruction=\"%s\"} %lu\n", getInstructionName(i), sim -> instruction_count[i]);
+    }
+    appendMetrics(buffer, size, &length, "# HELP pnp_instruction_seconds_total Simulation time spent carrying out instructions.\n"
+                                         "# TYPE pnp_instruction_seconds_total counter\n");
+    for (int i = NO_INSTRUCTION + 1; i < NUMBER_OF_INSTRUCTIONS; i++)
+    {
+        appendMetrics(buffer, size, &length, "pnp_instruction_seconds_total{instruction=\"%s\"} %.3f\n", getInstructionName(i), sim -> instruction_time[i]);
+    }
+
+    appendMetrics(buffer, size, &length, "# HELP pnp_handshake_latency_seconds Simulation time from an instruction finishing to the controller's next one being taken.\n"
+                                         "# TYPE pnp_handshake_latency_seconds histogram\n");
+    for (int i = 0; i < NUMBER_OF_HANDSHAKE_BUCKETS; i++)
+    {
+        handshakes += sim -> handshake_bucket[i];
+        appendMetrics(buffer, size, &length, "pnp_handshake_latency_seconds_bucket{le=\"%g\"} %lu\n", bucket_limit[i], handshakes);
+    }
+    handshakes += sim -> handshake_bucket[NUMBER_OF_HANDSHAKE_BUCKETS];
+    appendMetrics(buffer, size, &length, "pnp_handshake_latency_seconds_bucket{le=\"+Inf\"} %lu\n"
+                                         "pnp_handshake_latency_seconds_sum %.3f\n"
+                                         "pnp_handshake_latency_seconds_count %lu\n", handshakes, sim -> handshake_time, handshakes);
+
+    if (number_of_states > MAX_CONTROLLER_STATES) number_of_states = MAX_CONTROLLER_STATES;
+    appendMetrics(buffer, size, &length, "# HELP pnp_controller_state The state the controller is in.\n"
+                                         "# TYPE pnp_controller_state gauge\n");
+    for (int i = 0; i < number_of_states; i++)
+    {
+        appendMetrics(buffer, size, &length, "pnp_controller_state{state=\"%.*s\"} %d\n", CONTROLLER_STATE_NAME_LENGTH, controller -> state_name[i], controller -> state == i);
+    }
+    appendMetrics(buffer, size, &length, "# HELP pnp_controller_state_seconds_total Simulation time the controller has spent in each state.\n"
+                                         "# TYPE pnp_controller_state_seconds_total counter\n");
+    for (int i = 0; i < number_of_states; i++)
+    {
+        appendMetrics(buffer, size, &length, "pnp_controller_state_seconds_total{state=\"%.*s\"} %.3f\n", CONTROLLER_STATE_NAME_LENGTH, controller -> state_name[i], controller -> state_time[i]);
+    }
+
+    if (log_ring != NULL)
+    {
+        appendMetrics(buffer, size, &length, "# HELP pnp_log_messages_dropped_total Display messages dropped as the log ring was full.\n"
+                                             "# TYPE pnp_log_messages_dropped_total counter\n");
+        for (int i = 0; i < NUMBER_OF_LOG_SOURCES; i++)
+        {
+            appendMetrics(buffer, size, &length, "pnp_log_messages_dropped_total{source=\"%s\"} %lu\n", log_source_name[i], log_ring -> dropped[i]);
+        }
+    }
+    return (int) length;
+
+}
+
+/*
+ Function: sendAll
+ -----------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: sends the whole of a buffer to a scraper, giving up if it stops taking it
+ Argument(s):
+ int fd - the scraper's connection
+ const char *buffer - what to send
+ size_t length - its length
+ Return Value: none
+ Usage: sendAll(client, buffer, length);
+ */
+static void sendAll(int fd, const char *buffer, size_t length)
+{
+
+    while (length > 0)
+    {
+        ssize_t sent = send(fd, buffer, length, MSG_NOSIGNAL);
+
+        if (sent <= 0 && errno == EINTR) continue;
+        if (sent <= 0) return;
+        buffer += sent;
+        length -= sent;
+    }
+
+}
+
+/*
+ Function: serveMetrics
+ ----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ answers every scraper waiting on the metrics endpoint with a page of metrics, or 404 Not Found for anything but
+ / and /metrics, then closes the connection. Called once every poll loop of Startup. A scraper that is slow to
+ send its request or take the reply holds Startup up for at most METRICS_REQUEST_TIMEOUT.
+ Argument(s):
+ int fd - the listening socket, from openMetricsEndpoint
+ const PnP *pnp - the shared memory segment
+ const LogRing *log_ring - the log ring, else NULL
+ Return Value: none
+ Usage: serveMetrics(metrics_fd, pnp, log_ring);
+ */
+void serveMetrics(int fd, const PnP *pnp, const LogRing *log_ring)
+{
+
+    static char page[METRICS_BUFFER_SIZE];
+    char request[METRICS_REQUEST_SIZE], header[256];
+    struct timeval timeout = {0, METRICS_REQUEST_TIMEOUT * 1000};
+    int client;
+
+    if (fd == NO_METRICS_ENDPOINT) return;
+    while ((client = accept(fd, NULL, NULL)) >= 0)
+    {
+        struct pollfd request_ready = {client, POLLIN, 0};
+        ssize_t request_length = 0;
+        int length;
+
+        fcntl(client, F_SETFL, fcntl(client, F_GETFL) & ~O_NONBLOCK);
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        if (poll(&request_ready, 1, METRICS_REQUEST_TIMEOUT) > 0)
+        {
+            request_length = recv(client, request, sizeof(request) - 1, 0);
+        }
+        request[request_length > 0 ? request_length : 0] = '\0';
+
+        if (strncmp(request, "GET / ", 6) == 0 || strncmp(request, "GET /metrics", 12) == 0)
+        {
+            length = formatMetrics(pnp, log_ring, page, sizeof(page));
+            snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", length);
+            sendAll(client, header, strlen(header));
+            sendAll(client, page, length);
+        }
+        else
+        {
+            snprintf(header, sizeof(header), "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            sendAll(client, header, strlen(header));
+        }
+        close(client);
+    }
+
+}
+
+/*
+ Function: closeMetricsEndpoint
+ ------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: closes the metrics endpoint, removing its Unix socket if it had one
+ Argument(s):
+ int fd - the listening socket, from openMetricsEndpoint
+ Return Value: none
+ Usage: closeMetricsEndpoint(metrics_fd);
+ */
+void closeMetricsEndpoint(int fd)
+{
+
+    if (fd == NO_METRICS_ENDPOINT) return;
+    close(fd);
+    if (metrics_socket_path[0] != '\0') unlink(metrics_socket_path);
+    metrics_socket_path[0] = '\0';
+
+}
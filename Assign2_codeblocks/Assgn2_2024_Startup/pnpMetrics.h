@@ -0,0 +1,31 @@
+/*
+ *
+ * pnpMetrics.h - declarations for the metrics endpoint of Startup, which serves the running totals kept in
+ * shared memory by the simulator and controller to a Prometheus scraper
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#ifndef PNP_METRICS_H
+#define PNP_METRICS_H
+
+#include "../Assgn2_2024_Common/pnpShared.h"
+
+#define METRICS_ENV "PNP_METRICS"          // "[address:]port" for a TCP endpoint, or the path of a Unix socket; unset for none
+#define METRICS_DEFAULT_ADDRESS "127.0.0.1"
+#define METRICS_BACKLOG 8
+#define METRICS_BUFFER_SIZE 32768          // the largest page of metrics
+#define METRICS_REQUEST_TIMEOUT 100        // milliseconds given to a scraper to send its request, and to take the reply
+#define NO_METRICS_ENDPOINT -1
+
+int openMetricsEndpoint();
+
+int formatMetrics(const PnP*, const LogRing*, char*, size_t);
+
+void serveMetrics(int, const PnP*, const LogRing*);
+
+void closeMetricsEndpoint(int);
+
+#endif
@@ -4,219 +4,740 @@
 * By: Kate Bowater
 * Student #: U1019160
 *
-* This file creates forks and pipes for communication
-* between the Display, Simulator, and Controller
+* This file creates forks and the log ring for communication
+* between the Display, Simulator, and Controller, then
+* supervises them until the run is over. Each child is
+* reaped with waitpid as it exits, and the Simulator and
+* Controller heartbeats in shared memory are watched so
+* that a stalled process is noticed. A Display that dies
+* or stops reading the log ring is restarted, a Simulator or
+* Controller that crashes or stalls is restarted with its
+* partner, and anything else tears the run down cleanly.
+* In a headless run (PNP_DISPLAY=file or none) there is
+* no Display: Startup empties the log ring itself, into a
+* rotated log file or nowhere, and prints only a progress
+* line every few seconds and the simulation summary.
+* With PNP_METRICS set, the running totals the Simulator and
+* Controller keep in shared memory are served to Prometheus
+* scrapers from the poll loop as well (see pnpMetrics.c).
 *
 ************************************************
 */
 
-#include <stdlib.h>
-#include <stdio.h>
-#include <unistd.h>
-#include <sys/types.h>
-#include <sys/wait.h>
-#include <string.h>
-#include <semaphore.h>
-#include <fcntl.h>
-#include <sys/mman.h>
-
-#define NUMBER_OF_CHILDREN 3
-#define CHILD 0
-#define FORK_FAILED -1
-#define READ 0
-#define WRITE 1
-#define MEMORY_MAPPED_FILE "pid_shared_file"
-
-int pipe_Startup_to_Display[2];  //[0] for read, [1] for write
-int pipe_Simulator_to_Display[2];
-int pipe_Controller_to_Display[2];
-
-typedef struct
-{
-    int display_pid;
-    int sim_pid;
-    int contrl_pid;
-} PID_store;
+#include "pnpStart.h"
 
-int main()
+LogRing *log_ring;  //written to by Startup, the Simulator and Controller, read by the Display
+int log_ring_finished = FALSE;
+int display_mode = DISPLAY_TERMINAL;
+
+FILE *log_sink = NULL;  //the log file of a headless run, NULL when its messages are discarded
+char log_sink_path[PATH_MAX];
+long log_sink_bytes = 0, log_sink_rotate_bytes = LOG_ROTATE_SIZE * 1024L * 1024L;
+int log_sink_rotations = 0, log_sink_compress = FALSE;
+unsigned long messages_logged = 0;  //taken off the log ring by Startup in a headless run
+double sim_time_reached = 0.0;  //the simulator resets its time when it finishes, so the summary's is kept
+
+PnP *pnp;  //only the heartbeats and running totals are read, the simulator and controller own the rest
+int metrics_fd = NO_METRICS_ENDPOINT;
+sem_t *sem_Startup, *sem_Sim, *sem_Contrl;
+
+ChildProcess children[NUMBER_OF_CHILDREN] = {{"Display", NO_PROCESS, DISPLAY_EXIT_CODE},
+                                             {"Simulator", NO_PROCESS, SIMULATOR_EXIT_CODE},
+                                             {"Controller", NO_PROCESS, CONTROLLER_EXIT_CODE}};
+
+char display_path[PATH_MAX], sim_path[PATH_MAX], contrl_path[PATH_MAX];  //found before forking so every child uses the same layout
+char logFallbackFdStr[10];  //where the simulator and controller write if they cannot open the log ring
+
+struct termios saved_term;  //put back if the controller is killed before it can restore the terminal itself
+int terminal_saved = FALSE;
+volatile sig_atomic_t stop_requested = 0;  //the signal Startup was asked to stop with
+
+/*
+ Function: getWallTime
+ ---------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: gets the real time, which the supervision limits are measured in whatever the simulation time scale
+ Argument(s): none
+ Return Value: seconds from an arbitrary fixed point
+ Usage: double now = getWallTime();
+ */
+double getWallTime()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ Function: requestStop
+ ---------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: signal handler which asks the supervisor to tear the run down
+ Argument(s):
+ int signal_number - the signal received
+ Return Value: none
+ Usage: sigaction(SIGINT, &action, NULL); with action.sa_handler = requestStop
+ */
+void requestStop(int signal_number)
+{
+    stop_requested = signal_number;
+}
+
+/*
+ Function: reportToDisplay
+ -------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.2
+ Purpose:
+ writes a message from Startup to the Display through the log ring. While the Display is not running, or once
+ the log ring has been finished at the end of the run, the message is printed straight to the terminal instead.
+ A headless run writing a log file gets it in both.
+ Argument(s):
+ const char *format, ... - the message, as for printf
+ Return Value: none
+ Usage: reportToDisplay("Controller process created with PID %d\n", pid);
+ */
+void reportToDisplay(const char *format, ...)
 {
-    PID_store *pid_store;
+    char Startup_str_array[200];
+    va_list arguments;
 
-        /* initialize file for memory mapping */
-    int PID_memoryfile = open(MEMORY_MAPPED_FILE, (O_CREAT | O_RDWR), 0666);
-    if (PID_memoryfile < 0)
+    va_start(arguments, format);
+    vsnprintf(Startup_str_array, sizeof(Startup_str_array), format, arguments);
+    va_end(arguments);
+
+    if (log_ring_finished == FALSE && (children[DISPLAY].pid != NO_PROCESS || display_mode == DISPLAY_FILE))
     {
-        perror("creation/opening of PID_memoryfile failed");
-        exit(1);
+        writeLogMessage(log_ring, LOG_SOURCE_STARTUP, Startup_str_array);  //a headless run keeps Startup's messages in the log file too
     }
-    ftruncate(PID_memoryfile, sizeof(PID_store));
-
-    /* map the file to memory */
-    pid_store = (PID_store *)mmap(0, sizeof(PID_store), (PROT_READ | PROT_WRITE), MAP_SHARED, PID_memoryfile, (off_t)0);
-    if (pid_store == MAP_FAILED)
+    if (children[DISPLAY].pid == NO_PROCESS || log_ring_finished == TRUE)
     {
-        perror("memory mapping of PID_memoryfile failed");
-        close(PID_memoryfile);
-        exit(2);
+        printf("STARTUP\n%s", Startup_str_array);
+        fflush(stdout);
     }
+}
 
-    //named semaphore creation
-    sem_t *sem_Startup = sem_open("/sem_Startup", O_CREAT, 0666, 1);
-    sem_t *sem_Sim = sem_open("/sem_Sim", O_CREAT, 0666, 0);
-    sem_t *sem_Contrl = sem_open("/sem_Contrl", O_CREAT, 0666, 0);
-    sem_t *sem_Display = sem_open("/sem_Display", O_CREAT, 0666, 0);
+/*
+ Function: openMachineSemaphores
+ -------------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ creates the named semaphores shared by the simulator and controller, replacing any left over from an earlier
+ run or from a simulator and controller that have just been stopped, so they always start from the same values
+ Argument(s): none
+ Return Value: none
+ Usage: openMachineSemaphores();
+ */
+void openMachineSemaphores()
+{
+    if (sem_Startup != NULL) sem_close(sem_Startup);
+    if (sem_Sim != NULL) sem_close(sem_Sim);
+    if (sem_Contrl != NULL) sem_close(sem_Contrl);
+    sem_unlink("/sem_Startup");
+    sem_unlink("/sem_Sim");
+    sem_unlink("/sem_Contrl");
+
+    sem_Startup = sem_open("/sem_Startup", O_CREAT, 0666, 0);  // posted by the startup barrier
+    sem_Sim = sem_open("/sem_Sim", O_CREAT, 0666, 0);
+    sem_Contrl = sem_open("/sem_Contrl", O_CREAT, 0666, 0);
 
     if (sem_Startup == SEM_FAILED || sem_Sim == SEM_FAILED || sem_Contrl == SEM_FAILED)
     {
         perror("Semaphore creation failed");
         exit(6);
     }
+}
+
+/*
+ Function: startChild
+ --------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ forks and overlays one of the child processes and reports its PID to the Display, without waiting for it, so
+ the children all start together. They all inherit the log ring, which outlives any of them, so that any child
+ can be started again and carry on where the last one left off.
+ Argument(s):
+ int which - DISPLAY, SIMULATOR or CONTROLLER
+ Return Value: none
+ Usage: startChild(DISPLAY);
+ */
+void startChild(int which)
+{
+    pid_t return_pid = fork();
+    //using switch to organise the child and parent processes
+    switch (return_pid)
+    {
+        case CHILD:
+            if (which == DISPLAY)
+            {
+                execl(display_path, "Assgn2_2024_Display", (char *) NULL);  //display reads the log ring named in its environment
+                perror("Display overlay failed");
+                exit(5);
+            }
+
+            if (which == SIMULATOR)
+            {
+                execl(sim_path, "Assgn2_2024_Simulator", logFallbackFdStr, (char *) NULL);
+                perror("Simulator overlay failed");
+                exit(5);
+            }
+
+            if (which == CONTROLLER)
+            {
+                execl(contrl_path, "Assgn2_2024_Controller", logFallbackFdStr, (char *) NULL);
+                perror("Controller overlay failed");
+                exit(5);
+            }
+            exit(5);
+
+        case FORK_FAILED:
+            perror("Fork failed: ");
+            exit(5);
+
+        // the Startup process continues here as the parent
+        default:
+            children[which].pid = return_pid;
+            children[which].finished = FALSE;
+            children[which].start_time = getWallTime();
+            children[which].heartbeat = 0;
+            children[which].heartbeat_time = children[which].start_time;
+            reportToDisplay("%s process created with PID %d\n", children[which].name, return_pid);
+    }
+}
+
+/*
+ Function: startMachine
+ ----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.1
+ Purpose:
+ starts the simulator and controller together on a cleared shared memory segment and fresh semaphores, so
+ a restarted pair does not see the quit flag, handshake, heartbeats or startup barrier of the pair before it.
+ They wait for each other at the startup barrier, so Startup does not need to release them.
+ Argument(s): none
+ Return Value: none
+ Usage: startMachine();
+ */
+void startMachine()
+{
+    initialisePnP(pnp);
+    openMachineSemaphores();
+    startChild(SIMULATOR);
+    startChild(CONTROLLER);
+}
+
+/*
+ Function: stopChild
+ -------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ stops a child process, asking it to terminate and killing it if it has not exited within TERMINATE_GRACE
+ seconds, then reaps it. A stopped controller cannot restore the terminal settings itself, so Startup does.
+ Argument(s):
+ int which - DISPLAY, SIMULATOR or CONTROLLER
+ Return Value: none
+ Usage: stopChild(SIMULATOR);
+ */
+void stopChild(int which)
+{
+    ChildProcess *child = &children[which];
+    double deadline = getWallTime() + TERMINATE_GRACE;
+    pid_t pid = child -> pid;
+    int Status;
+
+    if (pid == NO_PROCESS) return;
+
+    kill(pid, SIGTERM);
+    kill(pid, SIGCONT);  // a stopped process only sees SIGTERM once it is continued
+    while (waitpid(pid, &Status, WNOHANG) == 0)
+    {
+        if (getWallTime() > deadline)
+        {
+            kill(pid, SIGKILL);
+            waitpid(pid, &Status, 0);
+            break;
+        }
+        sleepMilliseconds(1000 / POLL_LOOP_RATE);
+    }
+    child -> pid = NO_PROCESS;
+    reportToDisplay("%s with PID %d stopped\n", child -> name, pid);
+
+    if (which == CONTROLLER && terminal_saved == TRUE) tcsetattr(STDIN_FILENO, TCSANOW, &saved_term);
+}
+
+/*
+ Function: checkHeartbeat
+ ------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ checks the heartbeat of the simulator or controller. The heartbeat starts once the process reaches its
+ poll loop and is then bumped on every pass, so one that has not started within START_TIMEOUT or has not
+ moved for STALL_TIMEOUT seconds belongs to a process that is not making progress.
+ Argument(s):
+ int which - SIMULATOR or CONTROLLER
+ unsigned int heartbeat - its heartbeat as now read from shared memory
+ double now - the wall time
+ Return Value: CHILD_RUNNING, CHILD_NOT_STARTED or CHILD_STALLED
+ Usage: if (checkHeartbeat(SIMULATOR, pnp -> simulator_heartbeat, now) == CHILD_STALLED) ...
+ */
+int checkHeartbeat(int which, unsigned int heartbeat, double now)
+{
+    ChildProcess *child = &children[which];
+
+    if (heartbeat != child -> heartbeat)
+    {
+        child -> heartbeat = heartbeat;
+        child -> heartbeat_time = now;
+        return CHILD_RUNNING;
+    }
+    if (heartbeat == 0)
+    {
+        return now - child -> start_time > START_TIMEOUT ? CHILD_NOT_STARTED : CHILD_RUNNING;
+    }
+    return now - child -> heartbeat_time > STALL_TIMEOUT ? CHILD_STALLED : CHILD_RUNNING;
+}
+
+/*
+ Function: getDisplayMode
+ ------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: gets how the output of the run is shown, from the DISPLAY_MODE_ENV environment variable
+ Argument(s): none
+ Return Value: DISPLAY_TERMINAL, DISPLAY_FILE or DISPLAY_NONE
+ Usage: display_mode = getDisplayMode();
+ */
+int getDisplayMode()
+{
+    const char *value = getenv(DISPLAY_MODE_ENV);
+
+    if (value == NULL || value[0] == '\0' || strcmp(value, "terminal") == 0) return DISPLAY_TERMINAL;
+    if (strcmp(value, "file") == 0) return DISPLAY_FILE;
+    if (strcmp(value, "none") == 0) return DISPLAY_NONE;
+    printf("STARTUP\nUnknown %s \"%s\", using the terminal\n", DISPLAY_MODE_ENV, value);
+    return DISPLAY_TERMINAL;
+}
+
+/*
+ Function: openLogSink
+ ---------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ sets up where a headless run's messages go. In DISPLAY_FILE mode the log file named by LOG_FILE_ENV is
+ opened with a large buffer, so that it is written in big blocks rather than a line at a time, and the
+ rotation size and compression are read from LOG_ROTATE_SIZE_ENV and LOG_COMPRESS_ENV.
+ Argument(s):
+ int mode - DISPLAY_FILE or DISPLAY_NONE
+ Return Value: 0, else -1 if the log file could not be opened
+ Usage: if (openLogSink(display_mode) != 0) exit(5);
+ */
+int openLogSink(int mode)
+{
+    const char *path = getenv(LOG_FILE_ENV), *rotate_size = getenv(LOG_ROTATE_SIZE_ENV), *compress = getenv(LOG_COMPRESS_ENV);
+    double megabytes;
+
+    if (mode != DISPLAY_FILE) return 0;
+
+    snprintf(log_sink_path, sizeof(log_sink_path), "%s", path != NULL && path[0] != '\0' ? path : LOG_FILE);
+    if (rotate_size != NULL && sscanf(rotate_size, "%lf", &megabytes) == 1 && megabytes > 0.0)
+    {
+        log_sink_rotate_bytes = (long) (megabytes * 1024.0 * 1024.0);
+    }
+    log_sink_compress = compress != NULL && compress[0] != '\0' && strcmp(compress, "0") != 0;
+
+    log_sink = fopen(log_sink_path, "w");
+    if (log_sink == NULL) return -1;
+    setvbuf(log_sink, NULL, _IOFBF, LOG_FILE_BUFFER_SIZE);
+    return 0;
+}
+
+/*
+ Function: rotateLogSink
+ -----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ moves the full log file aside as <log file>.<n>, counting up from 1, and starts a new one. The rotated file is
+ compressed by a gzip process of its own when asked for, so the run does not wait for it, and only the last
+ LOG_FILES_KEPT rotated files are kept.
+ Argument(s): none
+ Return Value: none
+ Usage: if (log_sink_bytes >= log_sink_rotate_bytes) rotateLogSink();
+ */
+static void rotateLogSink()
+{
+    char rotated[PATH_MAX + 16], oldest[PATH_MAX + 16];
+
+    fclose(log_sink);
+    log_sink_rotations++;
+    snprintf(rotated, sizeof(rotated), "%s.%d", log_sink_path, log_sink_rotations);
+    rename(log_sink_path, rotated);
+
+    if (log_sink_compress == TRUE && fork() == CHILD)
+    {
+        execlp("gzip", "gzip", "-f", rotated, (char *) NULL);
+        _exit(127);  //left uncompressed, gzip is not installed
+    }
+    if (log_sink_rotations > LOG_FILES_KEPT)
+    {
+        snprintf(oldest, sizeof(oldest), "%s.%d", log_sink_path, log_sink_rotations - LOG_FILES_KEPT);
+        remove(oldest);
+        snprintf(oldest, sizeof(oldest), "%s.%d.gz", log_sink_path, log_sink_rotations - LOG_FILES_KEPT);
+        remove(oldest);
+    }
+
+    log_sink = fopen(log_sink_path, "w");
+    if (log_sink != NULL) setvbuf(log_sink, NULL, _IOFBF, LOG_FILE_BUFFER_SIZE);
+    log_sink_bytes = 0;
+}
+
+/*
+ Function: writeLogSink
+ ----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: writes a message to the log file as the Display would print it, rotating the file when it is full
+ Argument(s):
+ const LogMessage *message - the message, in its slot in the log ring
+ Return Value: none
+ Usage: writeLogSink(message);
+ */
+void writeLogSink(const LogMessage *message)
+{
+    static const char source_name[NUMBER_OF_LOG_SOURCES][12] = {"STARTUP\n", "SIMULATOR\n", "CONTROLLER\n"};
+    int source = message -> source >= 0 && message -> source < NUMBER_OF_LOG_SOURCES ? message -> source : LOG_SOURCE_STARTUP;
+
+    if (log_sink == NULL) return;
+    fputs(source_name[source], log_sink);
+    fwrite(message -> text, 1, message -> length, log_sink);
+    log_sink_bytes += strlen(source_name[source]) + message -> length;
+    if (log_sink_bytes >= log_sink_rotate_bytes) rotateLogSink();
+}
+
+/*
+ Function: closeLogSink
+ ----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose: writes out what is left in the log file's buffer and closes it
+ Argument(s): none
+ Return Value: none
+ Usage: closeLogSink();
+ */
+void closeLogSink()
+{
+    if (log_sink != NULL) fclose(log_sink);
+    log_sink = NULL;
+}
 
-    char *strFromStartup;
-    char Startup_str_array[100];
-    char pipeStartupToDisplayReadFdStr[10];  //used to allow display end of pipe to read from startup process
-    char pipeSimToDisplayReadFdStr[10];  //used to allow display end of pipe to read from simulator process
-    char pipeContrlToDisplayReadFdStr[10];  //used to allow display end of pipe to read from controller process
-    char pipeSimToDisplayWriteFdStr[10];  // used to allow simulator to write to display pipe
-    char pipeContrlToDisplayWriteFdStr[10]; // used to allow controller to write to display pipe
+/*
+ Function: drainLogRing
+ ----------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ takes everything waiting off the log ring in a headless run, in place of the Display, and writes it to the
+ log sink. The simulation summary is also printed, as it is what a batch run is for.
+ Argument(s): none
+ Return Value: the number of messages taken off
+ Usage: drainLogRing();
+ */
+unsigned long drainLogRing()
+{
+    const LogMessage *message;
+    unsigned long count = 0;
+    double time, load_time, unload_time;
+    int placed, dropped;
 
+    while ((message = peekLogMessage(log_ring)) != NULL)
+    {
+        writeLogSink(message);
+        if (message -> source == LOG_SOURCE_SIMULATOR && sscanf(message -> text, SIMULATION_SUMMARY_SCAN_FORMAT,
+            &time, &placed, &dropped, &load_time, &unload_time) == NUMBER_OF_FIELDS_IN_SIMULATION_SUMMARY)
+        {
+            printf("SIMULATOR\n%.*s", message -> length, message -> text);
+            sim_time_reached = time;
+        }
+        releaseLogMessage(log_ring);
+        count++;
+    }
+    messages_logged += count;
+    return count;
+}
+
+/*
+ Function: reportProgress
+ ------------------------
+ Written by Kate Bowater
+ Date: 19/10/2026
+ Version 1.0
+ Purpose:
+ prints the progress line of a headless run: the simulation time reached, how much faster than real time
+ it is running, and the messages logged and dropped
+ Argument(s):
+ double now - the wall time
+ double start_time - the wall time the run started
+ int final - TRUE for the line printed at the end of the run
+ Return Value: none
+ Usage: reportProgress(now, start_time, FALSE);
+ */
+void reportProgress(double now, double start_time, int final)
+{
+    unsigned long dropped = log_ring -> skipped;
+    double elapsed = now - start_time;
+
+    if (pnp -> sim_time > sim_time_reached) sim_time_reached = pnp -> sim_time;
+
+    for (int source = 0; source < NUMBER_OF_LOG_SOURCES; source++) dropped += log_ring -> dropped[source];
+    printf("STARTUP\n%s  Time: %7.2f  %.1f s elapsed, %.1fx real time, %lu messages logged (%.0f/s), %lu dropped\n",
+           final == TRUE ? "Finished" : "Progress", sim_time_reached, elapsed, elapsed > 0.0 ? sim_time_reached / elapsed : 0.0,
+           messages_logged, elapsed > 0.0 ? messages_logged / elapsed : 0.0, dropped);
+    fflush(stdout);
+}
+
+int main()
+{
     int Status; //for parent to monitor the status of child
+    int finishing = FALSE, failed = FALSE, display_restarts = 0, machine_restarts = 0;
+    unsigned long display_read = 0;
+    double finish_time = 0.0, display_progress_time, start_time, progress_time;
+    struct sigaction action;
+
+    /*
+     * create the simulator and controller's shared memory, inherited by them across fork and exec,
+     * to clear it before they start and watch their heartbeats
+     */
+    pnp = createPnP();
+    if (pnp == MAP_FAILED)
+    {
+        perror("creation/memory mapping of the shared memory segment failed");
+        exit(2);
+    }
+
+    //named semaphore creation
+    openMachineSemaphores();
+
+    // stop the run cleanly when asked to, rather than leaving the children behind
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    sigaction(SIGHUP, &action, NULL);
+    if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved_term) == 0) terminal_saved = TRUE;
+
+    getExecutablePath("Assgn2_2024_Display", "..\\Assgn2_2024_Display\\bin\\Release\\Assgn2_2024_Display", display_path);
+    getExecutablePath("Assgn2_2024_Simulator", "..\\Assgn2_2024_Simulator\\bin\\Release\\Assgn2_2024_Simulator", sim_path);
+    getExecutablePath("Assgn2_2024_Controller", "..\\Assgn2_2024_Controller\\bin\\Release\\Assgn2_2024_Controller", contrl_path);
 
-    //set up pipes before fork
-    if (pipe(pipe_Startup_to_Display) < 0 || pipe(pipe_Simulator_to_Display) < 0 || pipe(pipe_Controller_to_Display) < 0)
+    //set up the log ring to the Display before fork, so every child inherits it
+    log_ring = createLogRing();
+    if (log_ring == NULL)
     {
-        perror("Pipe creation failed");
+        perror("Log ring creation failed");
         exit(5);
     }
-    //setting up pipe to be non-blocking so display can continue reading from other pipes
-    if (fcntl(pipe_Startup_to_Display[READ], F_SETFL, O_NONBLOCK) < 0) {
-        perror("Pipe non-blocking failed");
+    sprintf(logFallbackFdStr, "%d", STDOUT_FILENO);
+
+    //serve the running totals in shared memory to scrapers, if asked to
+    metrics_fd = openMetricsEndpoint();
+    if (metrics_fd != NO_METRICS_ENDPOINT) printf("STARTUP\nServing metrics on %s\n", getenv(METRICS_ENV));
+    else if (getenv(METRICS_ENV) != NULL && getenv(METRICS_ENV)[0] != '\0') perror("Metrics endpoint creation failed, continuing without");
+
+    //a headless run has no Display, Startup takes the messages off the log ring itself
+    display_mode = getDisplayMode();
+    if (openLogSink(display_mode) != 0)
+    {
+        perror("Log file creation failed");
         exit(5);
     }
 
-    // string creation for read end of pipe, to allow overlayed process to read or write
-    sprintf(pipeStartupToDisplayReadFdStr, "%d", pipe_Startup_to_Display[READ]);
-    sprintf(pipeSimToDisplayReadFdStr, "%d", pipe_Simulator_to_Display[READ]);
-    sprintf(pipeContrlToDisplayReadFdStr, "%d", pipe_Controller_to_Display[READ]);
-    sprintf(pipeSimToDisplayWriteFdStr, "%d", pipe_Simulator_to_Display[WRITE]);
-    sprintf(pipeContrlToDisplayWriteFdStr, "%d", pipe_Controller_to_Display[WRITE]);
+    if (display_mode == DISPLAY_TERMINAL) startChild(DISPLAY);
+    startMachine();
+    reportToDisplay("Process spawning complete\n");
+    reportToDisplay("Supervising children until they terminate\n");
+    display_progress_time = start_time = progress_time = getWallTime();
 
-    for (int count = 0; count < NUMBER_OF_CHILDREN; count++)
+    /*
+     * supervise the children until all have exited, reaping each as it exits and checking the
+     * simulator and controller heartbeats and the Display backlog on every poll loop
+     */
+    while (children[DISPLAY].pid != NO_PROCESS || children[SIMULATOR].pid != NO_PROCESS || children[CONTROLLER].pid != NO_PROCESS)
     {
-        pid_t return_pid = fork();
-        //using switch to organise the child and parent processes
-        switch (return_pid)
+        double now = getWallTime();
+        int restart_display = FALSE, restart_machine = FALSE, tear_down = FALSE;
+        pid_t pid;
+
+        if (stop_requested != 0 && finishing == FALSE)
         {
-            case CHILD:
-                if (count == 0)  //first child is the display process
-                {
-                    pid_store -> display_pid = getpid(); // save the child pid to the shared memory
-                    close(pipe_Startup_to_Display[WRITE]); //display will only be reading through the pipes
-                    close(pipe_Simulator_to_Display[WRITE]);
-                    close(pipe_Controller_to_Display[WRITE]);
-                    sem_post(sem_Display); // allow parent process to continue and read the pid from shared memory
-                    execl("..\\Assgn2_2024_Display\\bin\\Release\\Assgn2_2024_Display", "Assgn2_2024_Display", pipeStartupToDisplayReadFdStr,
-                          pipeSimToDisplayReadFdStr, pipeContrlToDisplayReadFdStr, (char *) NULL);
-                    perror("Display overlay failed");
-                    exit(5);
-                }
-
-                if(count == 1)  // second child is the simulator
-                {
-                    pid_store -> sim_pid = getpid();  //store pid to shared memory
-                    close(pipe_Startup_to_Display[WRITE]);  //Simulator overlayed does not need this pipe
-                    close(pipe_Simulator_to_Display[READ]);  //Simulator will only write to pipe
-                    //close(pipe_Startup_to_Display[READ]);  // this pipe is already closed by the parent before spawning this child
-                    close(pipe_Controller_to_Display[READ]);  //does not need access to the controller pipe
-                    close(pipe_Controller_to_Display[WRITE]);
-                    sem_post(sem_Sim);  //allow parent process to continue so it can access pid in shared memory
-                    execl("..\\Assgn2_2024_Simulator\\bin\\Release\\Assgn2_2024_Simulator", "Assgn2_2024_Simulator", pipeSimToDisplayWriteFdStr, (char *) NULL);
-                    perror("Simulator overlay failed");
-                    exit(5);
-                }
-
-                if(count == 2)  // final child is the Controller
-                {
-                    pid_store -> contrl_pid = getpid();  // store the controller pid
-                    close(pipe_Startup_to_Display[WRITE]);  //Controller process overlayed does not need this pipe
-                    close(pipe_Controller_to_Display[READ]);  //Controller will only write to pipe
-                    //close(pipe_Simulator_to_Display[READ]);  //these pipes were already closed by the parent before spawning
-                    //close(pipe_Simulator_to_Display[WRITE]);
-                    sem_post(sem_Contrl);  //allow startup process to continue
-                    execl("..\\Assgn2_2024_Controller\\bin\\Release\\Assgn2_2024_Controller", "Assgn2_2024_Controller", pipeContrlToDisplayWriteFdStr, (char *) NULL);
-                    perror("Controller overlay failed");
-                    exit(5);
-                }
-
-
-            case FORK_FAILED:
-                perror("Fork failed: ");
-                exit(5);
+            reportToDisplay("Stopped by signal %d\n", (int) stop_requested);
+            tear_down = TRUE;
+        }
+
+        /* reap any child that has exited, in whatever order they exit */
+        while ((pid = waitpid(-1, &Status, WNOHANG)) > 0)
+        {
+            int which;
+
+            for (which = 0; which < NUMBER_OF_CHILDREN && children[which].pid != pid; which++);
+            if (which == NUMBER_OF_CHILDREN) continue;
+
+            children[which].pid = NO_PROCESS;
+            if (WIFEXITED(Status))
+            {
+                reportToDisplay("%s with PID %d terminated with status code %d\n", children[which].name, pid, WEXITSTATUS(Status));
+                children[which].finished = WEXITSTATUS(Status) == children[which].expected_exit_code;
+            }
+            else
+            {
+                reportToDisplay("%s with PID %d was killed by signal %d\n", children[which].name, pid, WTERMSIG(Status));
+            }
+
+            if (finishing == TRUE || children[which].finished == TRUE) continue;
+            if (which == DISPLAY) restart_display = TRUE;
+            else if (WIFSIGNALED(Status)) restart_machine = TRUE;  // crashed, which may not happen again
+            else tear_down = TRUE;  // the process gave up with an error of its own, which a restart would repeat
+        }
+
+        /* the simulator and controller bump their heartbeats on every pass of their poll loops */
+        for (int which = SIMULATOR; which <= CONTROLLER && finishing == FALSE; which++)
+        {
+            if (children[which].pid == NO_PROCESS) continue;
+
+            int res = checkHeartbeat(which, which == SIMULATOR ? pnp -> simulator_heartbeat : pnp -> controller_heartbeat, now);
+            if (res == CHILD_STALLED)
+            {
+                reportToDisplay("%s with PID %d has stalled, no heartbeat for %.0f seconds\n", children[which].name, children[which].pid, STALL_TIMEOUT);
+                restart_machine = TRUE;
+            }
+            else if (res == CHILD_NOT_STARTED)
+            {
+                reportToDisplay("%s with PID %d did not start within %.0f seconds\n", children[which].name, children[which].pid, START_TIMEOUT);
+                tear_down = TRUE;
+            }
+        }
+
+        /*
+         * the Display is stalled if messages are waiting for it and it has not printed one for a while.
+         * The simulator and controller never wait for it, so meanwhile they carry on and their messages are dropped
+         */
+        unsigned long backlog = getLogBacklog(log_ring);
+        if (backlog == 0 || log_ring -> head != display_read) display_progress_time = now;
+        display_read = log_ring -> head;
+        if (finishing == FALSE && children[DISPLAY].pid != NO_PROCESS && now - display_progress_time > STALL_TIMEOUT)
+        {
+            stopChild(DISPLAY);
+            reportToDisplay("Display had stalled with %lu messages unread for %.0f seconds\n", backlog, STALL_TIMEOUT);
+            restart_display = TRUE;
+        }
+
+        if (display_mode != DISPLAY_TERMINAL)
+        {
+            drainLogRing();
+            if (now - progress_time > PROGRESS_INTERVAL)
+            {
+                reportProgress(now, start_time, FALSE);
+                progress_time = now;
+            }
+        }
+
+        if (stop_requested != 0) restart_display = restart_machine = FALSE;
+
+        if (restart_display == TRUE && tear_down == FALSE)
+        {
+            if (display_restarts < MAX_DISPLAY_RESTARTS)
+            {
+                display_restarts++;
+                reportToDisplay("Restarting the Display (restart %d of %d)\n", display_restarts, MAX_DISPLAY_RESTARTS);
+                startChild(DISPLAY);
+                display_progress_time = now;
+            }
+            else tear_down = TRUE;  // nothing would show the run
+        }
+
+        if (restart_machine == TRUE && tear_down == FALSE)
+        {
+            // once the controller has finished the board is done, and a restart would start it again
+            if (machine_restarts < MAX_MACHINE_RESTARTS && children[CONTROLLER].finished == FALSE)
+            {
+                machine_restarts++;
+                stopChild(SIMULATOR);
+                stopChild(CONTROLLER);
+                reportToDisplay("Restarting the Simulator and Controller (restart %d of %d)\n", machine_restarts, MAX_MACHINE_RESTARTS);
+                startMachine();
+            }
+            else tear_down = TRUE;
+        }
+
+        if (tear_down == TRUE && finishing == FALSE)
+        {
+            reportToDisplay("Tearing down the run\n");
+            stopChild(SIMULATOR);
+            stopChild(CONTROLLER);
+            failed = TRUE;
+        }
+
+        /*
+         * once the simulator and controller have gone, the log ring is finished to allow the Display
+         * to terminate, and it is given a little while to print what is left
+         */
+        if (finishing == FALSE && children[SIMULATOR].pid == NO_PROCESS && children[CONTROLLER].pid == NO_PROCESS)
+        {
+            finishing = TRUE;
+            finish_time = now;
+            if (display_mode != DISPLAY_TERMINAL)
+            {
+                drainLogRing();
+                closeLogSink();
+                reportProgress(now, start_time, TRUE);
+            }
+            finishLogRing(log_ring);
+            log_ring_finished = TRUE;
+        }
+        if (finishing == TRUE && children[DISPLAY].pid != NO_PROCESS && now - finish_time > DISPLAY_EXIT_GRACE)
+        {
+            stopChild(DISPLAY);
+        }
+
+        serveMetrics(metrics_fd, pnp, log_ring);
+
+        //a headless run wakes early when messages are written, so that the log ring does not fill up
+        if (display_mode != DISPLAY_TERMINAL && finishing == FALSE) waitForLogMessage(log_ring, 1.0 / POLL_LOOP_RATE);
+        else sleepMilliseconds(1000 / POLL_LOOP_RATE);
+    }
 
-            // the Startup process continues here as the parent
-            default:
-                if(count == 0) // after spawning display, startup and monitor comes here
-                {
-                    sem_wait(sem_Display);  // wait until display process has stored the pid to shared memory
-                    int DisplayPID = pid_store -> display_pid;
-                    sprintf(Startup_str_array, "Display process created with PID %d\n", DisplayPID);
-                    write(pipe_Startup_to_Display[WRITE], Startup_str_array, strlen(Startup_str_array));
-                    close(pipe_Startup_to_Display[READ]); //parent will only write to pipe, so close read end
-                }
-
-                if(count == 1) //after spawning simulator
-                {
-                    sem_wait(sem_Sim);  // wait until the simulator has stored its pid to shared memory
-                    int SimPID = pid_store -> sim_pid;
-                    sprintf(Startup_str_array, "Simulator process created with PID %d\n", SimPID);
-                    write(pipe_Startup_to_Display[WRITE], Startup_str_array, strlen(Startup_str_array));
-                    close(pipe_Simulator_to_Display[READ]);  //does not need access to the simulator pipe
-                    close(pipe_Simulator_to_Display[WRITE]);
-                }
-
-                if(count == 2)  // after spawning controller
-                {
-                    sem_wait(sem_Contrl);  // wait until controller has stored its pid to shared memory
-                    int ContrlPID = pid_store -> contrl_pid;
-                    sprintf(Startup_str_array, "Controller process created with PID %d\n", ContrlPID);
-                    write(pipe_Startup_to_Display[WRITE], Startup_str_array, strlen(Startup_str_array));
-                    close(pipe_Controller_to_Display[READ]);  //does not need access to the controller pipe
-                    close(pipe_Controller_to_Display[WRITE]);
-                }
-
-        }     // end switch
-    }//end for loop
-
-    strFromStartup = "Process spawning complete\n";
-    write(pipe_Startup_to_Display[WRITE], strFromStartup, strlen(strFromStartup));
-    strFromStartup = "Waiting for children to terminate\n";
-    write(pipe_Startup_to_Display[WRITE], strFromStartup, strlen(strFromStartup));
-    sem_post(sem_Startup); // Controller and Simulator wait for this to prevent race conditions
-
-    munmap(pid_store, sizeof(PID_store)); // memory mapped file no longer needed
-    close(PID_memoryfile);
-
-   // waiting for children to terminate. Prints the PID and exit status of each.
-   // The controller always terminates first followed by Simulator
-    pid_t Contrl_pid = wait(&Status);
-    sprintf(Startup_str_array, "Controller with PID %d terminated with status code %d\n", Contrl_pid, Status>>8);
-    write(pipe_Startup_to_Display[WRITE], Startup_str_array, strlen(Startup_str_array));
-    pid_t Sim_pid = wait(&Status);
-    sprintf(Startup_str_array, "Simulator with PID %d terminated with status code %d\n", Sim_pid, Status>>8);
-    write(pipe_Startup_to_Display[WRITE], Startup_str_array, strlen(Startup_str_array));
-
-    // Display pipe needs to be closed to allow Display process to terminate
-    close(pipe_Startup_to_Display[WRITE]);
-    pid_t Display_pid = wait(&Status);
-    printf("STARTUP\nDisplay with PID %d terminated with status code %d\n", Display_pid, Status>>8);
     printf("STARTUP\nProgram has ended. Press any key to exit.\n");
+    closeMetricsEndpoint(metrics_fd);
+    closePnP(pnp);
+    closeLogRing(log_ring);
+    sem_unlink(LOG_DOORBELL);
     sem_close(sem_Startup);
     sem_unlink("/sem_Startup");
     sem_close(sem_Sim);
     sem_unlink("/sem_Sim");
     sem_close(sem_Contrl);
     sem_unlink("/sem_Contrl");
-    sem_close(sem_Display);
-    sem_unlink("/sem_Display");
-    exit(0);
+    exit(failed == TRUE ? SUPERVISOR_FAILED_EXIT_CODE : 0);
 }//end main
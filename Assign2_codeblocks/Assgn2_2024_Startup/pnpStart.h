@@ -1,6 +1,105 @@
+/*
+ *
+ * pnpStart.h - declarations for the Startup process, which spawns the Display, Simulator and Controller
+ * and supervises them until the run is over
+ *
+ * Platform: Any POSIX compliant platform
+ * Intended for and tested on: Cygwin 64 bit
+ *
+ */
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <termios.h>
+#include "../Assgn2_2024_Common/pnpShared.h"
+#include "pnpMetrics.h"
 
 #define POLL_LOOP_RATE 50          // poll loops per second
 
+#define NUMBER_OF_CHILDREN 3
+#define CHILD 0
+#define FORK_FAILED -1
+
+/* headless runs, for accelerated batches where printing to a terminal would hold the run back */
+#define DISPLAY_MODE_ENV "PNP_DISPLAY"             // "terminal" (the default), "file" or "none"
+#define LOG_FILE_ENV "PNP_LOG_FILE"                // the file the "file" mode writes, LOG_FILE by default
+#define LOG_ROTATE_SIZE_ENV "PNP_LOG_ROTATE_MB"    // the size the log file is rotated at, LOG_ROTATE_SIZE by default
+#define LOG_COMPRESS_ENV "PNP_LOG_COMPRESS"        // set to 1 to compress rotated log files with gzip
+#define DISPLAY_TERMINAL 0         // the Display prints everything
+#define DISPLAY_FILE 1             // no Display, Startup writes everything to the log file
+#define DISPLAY_NONE 2             // no Display, and everything is discarded
+#define LOG_FILE "pnp_log.txt"
+#define LOG_ROTATE_SIZE 16         // megabytes
+#define LOG_FILES_KEPT 8           // rotated log files kept, the oldest is removed
+#define LOG_FILE_BUFFER_SIZE (1 << 20)
+#define PROGRESS_INTERVAL 5.0      // wall seconds between progress lines in a headless run
+
+#define DISPLAY 0                  // the children, in the order they are spawned
+#define SIMULATOR 1
+#define CONTROLLER 2
+
+#define NO_PROCESS -1
+#define DISPLAY_EXIT_CODE 10       // the exit codes of the children when they finish normally
+#define SIMULATOR_EXIT_CODE 20
+#define CONTROLLER_EXIT_CODE 30
+#define SUPERVISOR_FAILED_EXIT_CODE 7  // Startup's exit code when the run was torn down after a failure
+
+/* supervision limits, all in real (wall clock) seconds whatever the time scale */
+#define START_TIMEOUT 30.0         // a simulator or controller with no heartbeat by now has not started
+#define STALL_TIMEOUT 10.0         // a heartbeat that has not changed for this long is a stalled process
+#define TERMINATE_GRACE 2.0        // time given to a process to exit after SIGTERM before it is killed
+#define DISPLAY_EXIT_GRACE 5.0     // time given to the Display to finish printing once the log ring is finished
+#define MAX_DISPLAY_RESTARTS 3
+#define MAX_MACHINE_RESTARTS 2     // restarts of the simulator and controller, which always restart together
+
+#define CHILD_RUNNING 0
+#define CHILD_NOT_STARTED -1       // no heartbeat within START_TIMEOUT
+#define CHILD_STALLED -2           // heartbeat stopped for STALL_TIMEOUT
+
+typedef struct
+{
+    const char *name;          // as reported to the Display, e.g. "Simulator"
+    pid_t pid;                 // NO_PROCESS once it has exited
+    int expected_exit_code;    // DISPLAY_EXIT_CODE, ...
+    int finished;              // TRUE once it has exited with expected_exit_code
+    double start_time;         // wall time it was started
+    unsigned int heartbeat;    // the last heartbeat seen in shared memory
+    double heartbeat_time;     // wall time the heartbeat last changed
+
+} ChildProcess;
+
+double getWallTime();
+
+void reportToDisplay(const char*, ...);
+
+void openMachineSemaphores();
+
+void startChild(int);
+
+void startMachine();
+
+void stopChild(int);
+
+int getDisplayMode();
+
+int openLogSink(int);
+
+void writeLogSink(const LogMessage*);
+
+void closeLogSink();
+
+unsigned long drainLogRing();
+
+void reportProgress(double, double, int);
+
+int checkHeartbeat(int, unsigned int, double);
 
 /*
  Function: sleepMilliseconds